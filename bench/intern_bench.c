@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "intern.h"
+
+/* Fits "characters/hero_<SIZE_MAX>/walk" and its NUL. */
+#define PR_BENCH_ID_STRIDE 48u
+#define PR_BENCH_LINEAR_MAX 20000u
+
+static double pr_bench_now_ms(void)
+{
+    struct timespec ts;
+
+    if (timespec_get(&ts, TIME_UTC) != TIME_UTC) {
+        return 0.0;
+    }
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static char *pr_bench_make_ids(size_t count)
+{
+    char *ids;
+    size_t i;
+
+    ids = (char *)malloc(count * PR_BENCH_ID_STRIDE);
+    if (ids == NULL) {
+        return NULL;
+    }
+    for (i = 0u; i < count; ++i) {
+        (void)snprintf(
+            ids + i * PR_BENCH_ID_STRIDE,
+            PR_BENCH_ID_STRIDE,
+            "characters/hero_%zu/walk",
+            i
+        );
+    }
+    return ids;
+}
+
+/* Mirrors the strcmp scan the build string table used before interning. */
+static double pr_bench_linear_ms(const char *ids, size_t count)
+{
+    const char **values;
+    size_t value_count;
+    size_t i;
+    double start;
+    double elapsed;
+
+    values = (const char **)malloc(count * sizeof(values[0]));
+    if (values == NULL) {
+        return -1.0;
+    }
+
+    value_count = 0u;
+    start = pr_bench_now_ms();
+    for (i = 0u; i < count; ++i) {
+        const char *id;
+        size_t j;
+
+        id = ids + i * PR_BENCH_ID_STRIDE;
+        for (j = 0u; j < value_count; ++j) {
+            if (strcmp(values[j], id) == 0) {
+                break;
+            }
+        }
+        if (j == value_count) {
+            values[value_count] = id;
+            value_count += 1u;
+        }
+    }
+    elapsed = pr_bench_now_ms() - start;
+
+    free(values);
+    return elapsed;
+}
+
+static int pr_bench_run(size_t count)
+{
+    pr_intern_pool_t pool;
+    char *ids;
+    size_t i;
+    double start;
+    double insert_ms;
+    double dedup_ms;
+    double find_ms;
+    double linear_ms;
+    uint32_t handle;
+
+    ids = pr_bench_make_ids(count);
+    if (ids == NULL) {
+        return 0;
+    }
+
+    pr_intern_pool_init(&pool);
+
+    start = pr_bench_now_ms();
+    for (i = 0u; i < count; ++i) {
+        if (!pr_intern_pool_add(&pool, ids + i * PR_BENCH_ID_STRIDE, &handle)) {
+            goto fail;
+        }
+    }
+    insert_ms = pr_bench_now_ms() - start;
+
+    start = pr_bench_now_ms();
+    for (i = 0u; i < count; ++i) {
+        if (
+            !pr_intern_pool_add(&pool, ids + i * PR_BENCH_ID_STRIDE, &handle) ||
+            handle != (uint32_t)i
+        ) {
+            goto fail;
+        }
+    }
+    dedup_ms = pr_bench_now_ms() - start;
+
+    start = pr_bench_now_ms();
+    for (i = 0u; i < count; ++i) {
+        if (
+            !pr_intern_pool_find(&pool, ids + i * PR_BENCH_ID_STRIDE, &handle) ||
+            handle != (uint32_t)i
+        ) {
+            goto fail;
+        }
+    }
+    find_ms = pr_bench_now_ms() - start;
+
+    linear_ms = -1.0;
+    if (count <= PR_BENCH_LINEAR_MAX) {
+        linear_ms = pr_bench_linear_ms(ids, count);
+    }
+
+    printf(
+        "%10zu %12.3f %12.3f %12.3f %10.1f %12zu",
+        count,
+        insert_ms,
+        dedup_ms,
+        find_ms,
+        find_ms * 1000000.0 / (double)count,
+        pool.byte_count
+    );
+    if (linear_ms >= 0.0) {
+        printf(" %14.3f\n", linear_ms);
+    } else {
+        printf(" %14s\n", "-");
+    }
+
+    pr_intern_pool_free(&pool);
+    free(ids);
+    return 1;
+
+fail:
+    pr_intern_pool_free(&pool);
+    free(ids);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_count;
+    size_t count;
+
+    max_count = 1000000u;
+    if (argc > 1) {
+        max_count = (size_t)strtoull(argv[1], NULL, 10);
+        if (max_count == 0u) {
+            fprintf(stderr, "usage: %s [max_ids]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf(
+        "%10s %12s %12s %12s %10s %12s %14s\n",
+        "ids",
+        "insert_ms",
+        "dedup_ms",
+        "find_ms",
+        "find_ns",
+        "arena_bytes",
+        "linear_ms"
+    );
+    for (count = 1000u; count <= max_count; count *= 10u) {
+        if (!pr_bench_run(count)) {
+            fprintf(stderr, "benchmark failed at %zu ids\n", count);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include <stdio.h>
+
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    pr_bench_options_t options;
+    pr_status_t status;
+
+    if (!pr_bench_parse_args(argc, argv, 1, &options)) {
+        fprintf(stderr, "usage: %s [options]\n", argv[0]);
+        pr_bench_print_options(stderr);
+        return 2;
+    }
+
+    status = pr_bench_run(&options);
+    if (status != PR_STATUS_OK) {
+        fprintf(stderr, "benchmark failed: %s\n", pr_status_string(status));
+        return 1;
+    }
+    return 0;
+}
@@ -33,20 +33,112 @@ typedef struct pr_diagnostic {
 
 typedef void (*pr_diag_sink_fn)(const pr_diagnostic_t *diag, void *user_data);
 
+/* Pixel storage of one atlas page. Block formats store 4x4 texel blocks in
+ * row-major block order, ready for GPU upload. 16-bit formats are
+ * little-endian words with red in the high bits (RGB565: 5-6-5, RGBA4444:
+ * 4 bits each, alpha lowest). R8 keeps one channel, RA8 two (red, alpha),
+ * for grayscale pages uploaded as R8/RG8 textures. INDEXED8 stores one
+ * byte per texel indexing the page's palette of up to 256 RGBA8 colors.
+ */
+typedef enum pr_page_format {
+    PR_PAGE_FORMAT_RGBA8 = 0,
+    PR_PAGE_FORMAT_BC1,
+    PR_PAGE_FORMAT_BC3,
+    PR_PAGE_FORMAT_BC7,
+    PR_PAGE_FORMAT_ETC2_RGB,
+    PR_PAGE_FORMAT_ETC2_RGBA,
+    PR_PAGE_FORMAT_RGB565,
+    PR_PAGE_FORMAT_RGBA4444,
+    PR_PAGE_FORMAT_R8,
+    PR_PAGE_FORMAT_RA8,
+    PR_PAGE_FORMAT_INDEXED8
+} pr_page_format_t;
+
+/* Manifest spelling of `format` ("rgba8", "bc7", ...). */
+const char *pr_page_format_name(pr_page_format_t format);
+
+/* Lossless compression applied to a page's stored data. */
+typedef enum pr_page_compression {
+    PR_PAGE_COMPRESSION_NONE = 0,
+    PR_PAGE_COMPRESSION_LZ
+} pr_page_compression_t;
+
+/* Manifest spelling of `compression` ("none", "lz"). */
+const char *pr_page_compression_name(pr_page_compression_t compression);
+
+/* Transfer function of a page's color channels; alpha is always linear. */
+typedef enum pr_color_space {
+    PR_COLOR_SPACE_SRGB = 0,
+    PR_COLOR_SPACE_LINEAR
+} pr_color_space_t;
+
+/* Manifest spelling of `color_space` ("srgb", "linear"). */
+const char *pr_color_space_name(pr_color_space_t color_space);
+
+/* Whether a page's color channels are already multiplied by alpha. */
+typedef enum pr_alpha_mode {
+    PR_ALPHA_MODE_STRAIGHT = 0,
+    PR_ALPHA_MODE_PREMULTIPLIED
+} pr_alpha_mode_t;
+
+/* "straight" or "premultiplied". */
+const char *pr_alpha_mode_name(pr_alpha_mode_t alpha_mode);
+
+/* How pages relate. ARRAY pages all share one size, format and level count,
+ * so they can be uploaded as the layers of a 2D texture array; a frame's
+ * page is then its layer.
+ */
+typedef enum pr_atlas_layout {
+    PR_ATLAS_LAYOUT_PAGES = 0,
+    PR_ATLAS_LAYOUT_ARRAY
+} pr_atlas_layout_t;
+
+/* Manifest spelling of `layout` ("pages", "array"). */
+const char *pr_atlas_layout_name(pr_atlas_layout_t layout);
+
 typedef struct pr_build_options {
     const char *manifest_path;
     const char *output_override;
     const char *debug_output_override;
     int pretty_debug_json;
     int strict_mode;
+    int no_manifest_cache;
+    /* Replace the manifest's atlas.format / atlas.encode_quality /
+     * atlas.compression for this build, e.g. one build per target platform
+     * from the same manifest.
+     */
+    const char *format_override;
+    const char *encode_quality_override;
+    const char *compression_override;
 } pr_build_options_t;
 
+/* `used_pixels` counts frame pixels placed on the page, excluding padding;
+ * `wasted_pixels` is the rest of the `width * height` page. `data_bytes` is
+ * the page's size in the package in its stored `format`.
+ */
+typedef struct pr_build_page_stats {
+    unsigned int width;
+    unsigned int height;
+    unsigned int frame_count;
+    unsigned long long used_pixels;
+    unsigned long long wasted_pixels;
+    double occupancy;
+    pr_page_format_t format;
+    unsigned long long data_bytes;
+} pr_build_page_stats_t;
+
+/* Pointers stay valid until the next pr_build_package call. */
 typedef struct pr_build_result {
     const char *package_path;
     const char *debug_output_path;
     unsigned int atlas_page_count;
     unsigned int sprite_count;
     unsigned int animation_count;
+    const pr_build_page_stats_t *atlas_pages;
+    unsigned long long atlas_used_pixels;
+    unsigned long long atlas_total_pixels;
+    double atlas_occupancy;
+    double pack_time_ms;
 } pr_build_result_t;
 
 pr_status_t pr_validate_manifest_file(
@@ -55,6 +147,16 @@ pr_status_t pr_validate_manifest_file(
     void *diag_user_data
 );
 
+/* Like pr_validate_manifest_file, and additionally resolves every sprite
+ * frame and animation key against the real image sizes. Only PNG headers are
+ * read, so no pixels are decoded.
+ */
+pr_status_t pr_validate_manifest_file_deep(
+    const char *manifest_path,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data
+);
+
 pr_status_t pr_build_package(
     const pr_build_options_t *options,
     pr_diag_sink_fn diag_sink,
@@ -0,0 +1,34 @@
+#ifndef PACKRAT_PROFILER_H
+#define PACKRAT_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Zone and counter names are static strings; the pointers stay valid for the
+ * life of the process, so they can be handed straight to profilers that key
+ * zones by string address.
+ *
+ * Callbacks run on the thread that called into packrat, and zones nest:
+ * every `zone_begin` is matched by a `zone_end` with the same name before
+ * its parent zone ends, including on error paths.
+ */
+typedef struct pr_profiler_hooks {
+    void (*zone_begin)(const char *name, void *user_data);
+    void (*zone_end)(const char *name, void *user_data);
+    void (*counter)(const char *name, double value, void *user_data);
+    void *user_data;
+} pr_profiler_hooks_t;
+
+/* Installs process-wide hooks (copied), or removes them when `hooks` is NULL.
+ * Any callback may be NULL. Call it while no build or package open is in
+ * flight. With no hooks installed each instrumentation point is a single
+ * branch on a NULL pointer.
+ */
+void pr_profiler_set_hooks(const pr_profiler_hooks_t *hooks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
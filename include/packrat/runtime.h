@@ -17,6 +17,9 @@ typedef enum pr_loop_mode {
     PR_LOOP_PING_PONG
 } pr_loop_mode_t;
 
+/* `atlas_page` is the frame's layer when the atlas layout is
+ * PR_ATLAS_LAYOUT_ARRAY.
+ */
 typedef struct pr_sprite_frame {
     unsigned int atlas_page;
     unsigned int x;
@@ -58,6 +61,23 @@ pr_status_t pr_package_open_memory(
 );
 void pr_package_close(pr_package_t *package);
 
+/* Open flag that verifies the CRC-32C of every chunk and fails with
+ * PR_STATUS_PARSE_ERROR on a mismatch. Plain opens skip the checksums.
+ */
+#define PR_PACKAGE_OPEN_VERIFY_CHECKSUMS 1u
+
+pr_status_t pr_package_open_file_ex(
+    const char *path,
+    unsigned int flags,
+    pr_package_t **out_package
+);
+pr_status_t pr_package_open_memory_ex(
+    const void *data,
+    size_t size,
+    unsigned int flags,
+    pr_package_t **out_package
+);
+
 const pr_sprite_t *pr_package_find_sprite(
     const pr_package_t *package,
     const char *sprite_id
@@ -85,7 +105,40 @@ pr_status_t pr_package_resolve_sprite_binding(
     const pr_animation_t **out_animation
 );
 
+/* `row_bytes` spans one row of pixels, or one row of 4x4 blocks for block
+ * formats. `data_size` is the uncompressed size, 0 for pages stored without
+ * data; `stored_size` is what the page takes in the package after
+ * `compression`. `tile_size` is non-zero when the page was compressed in
+ * square tiles that decode independently. `level_count` is the number of mip
+ * levels stored for the page, 1 without mipmaps. `color_space` and
+ * `alpha_mode` say how the texels are encoded, e.g. to pick an sRGB texture
+ * format and a premultiplied blend mode. `palette_count` is the size of an
+ * indexed8 page's palette, 0 for other formats.
+ */
+typedef struct pr_atlas_page_info {
+    unsigned int width;
+    unsigned int height;
+    pr_page_format_t format;
+    unsigned int row_bytes;
+    size_t data_size;
+    pr_page_compression_t compression;
+    size_t stored_size;
+    unsigned int tile_size;
+    unsigned int level_count;
+    pr_color_space_t color_space;
+    pr_alpha_mode_t alpha_mode;
+    unsigned int palette_count;
+} pr_atlas_page_info_t;
+
 unsigned int pr_package_atlas_page_count(const pr_package_t *package);
+
+/* PR_ATLAS_LAYOUT_PAGES for packages built before layouts existed. */
+pr_atlas_layout_t pr_package_atlas_layout(const pr_package_t *package);
+
+/* RGBA8 pixels of a page. Returns NULL for pages stored in another format
+ * (use pr_package_atlas_page_data for those) and for compressed pages that
+ * have not been decompressed yet.
+ */
 const unsigned char *pr_package_atlas_page_pixels(
     const pr_package_t *package,
     unsigned int index,
@@ -94,6 +147,116 @@ const unsigned char *pr_package_atlas_page_pixels(
     unsigned int *out_stride
 );
 
+/* Uncompressed bytes of a page in any format, e.g. BC7 blocks for direct
+ * upload as a compressed texture. Returns NULL for an invalid index, a page
+ * without data, or a compressed page that has not been decompressed yet;
+ * `out_info` is filled in for any valid index.
+ */
+const void *pr_package_atlas_page_data(
+    const pr_package_t *package,
+    unsigned int index,
+    pr_atlas_page_info_t *out_info
+);
+
+/* Like pr_package_atlas_page_data for one mip level; level 0 is the page
+ * itself, and each level halves the one above down to 1x1. `out_info`
+ * describes the level, except `level_count`, which is the page's.
+ */
+const void *pr_package_atlas_page_level_data(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    pr_atlas_page_info_t *out_info
+);
+
+/* Index plane of one mip level of an indexed8 page, one byte per texel, and
+ * the page's palette of `*out_palette_count` RGBA8 colors, shared by all its
+ * levels. Returns NULL for other formats and, like
+ * pr_package_atlas_page_level_data, for compressed levels that have not been
+ * decompressed yet.
+ */
+const unsigned char *pr_package_atlas_page_indexed(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    const unsigned char **out_palette,
+    unsigned int *out_palette_count,
+    pr_atlas_page_info_t *out_info
+);
+
+/* Writes `count` RGBA8 texels to `dst` by looking each index up in
+ * `palette`. Indices past `palette_count` become transparent black.
+ */
+void pr_indexed_expand_rgba(
+    const unsigned char *indices,
+    size_t count,
+    const unsigned char *palette,
+    unsigned int palette_count,
+    unsigned char *dst
+);
+
+/* Decompresses every compressed page and mip level in parallel into buffers
+ * owned by the package, after which pr_package_atlas_page_data/_pixels and
+ * pr_package_atlas_page_level_data return them.
+ * Pages already decompressed are skipped. Must not run concurrently with
+ * other calls on the same package.
+ *
+ * Returns `PR_STATUS_PARSE_ERROR` when a page's data is corrupt.
+ */
+pr_status_t pr_package_decompress_pages(pr_package_t *package);
+
+/* Writes one page's uncompressed data to `dst`, which must hold the page
+ * info's `data_size` bytes. Works for any page, compressed or not, and does
+ * not change the package, so separate buffers can be filled concurrently.
+ */
+pr_status_t pr_package_read_page_data(
+    const pr_package_t *package,
+    unsigned int index,
+    void *dst,
+    size_t dst_size
+);
+
+/* pr_package_read_page_data for one mip level. */
+pr_status_t pr_package_read_page_level_data(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    void *dst,
+    size_t dst_size
+);
+
+/* Writes mip `level` of every page of an array layout to `dst`, layer after
+ * layer, each the page info's `data_size` bytes, ready for one texture array
+ * upload. Layers are decompressed in parallel when needed, and like
+ * pr_package_read_page_data the package is not changed.
+ *
+ * Returns `PR_STATUS_INVALID_ARGUMENT` for other layouts and when `dst_size`
+ * cannot hold every layer.
+ */
+pr_status_t pr_package_read_atlas_array(
+    const pr_package_t *package,
+    unsigned int level,
+    void *dst,
+    size_t dst_size
+);
+
+/* Copies a frame's pixels to `dst`, `dst_stride` bytes per row, in the
+ * page's own format (e.g. 2 bytes per pixel for RGB565 pages, palette
+ * indices for indexed8 pages). Only the
+ * tiles the frame overlaps are decoded for tiled pages; other compressed
+ * pages are decoded whole into a temporary buffer. Like
+ * pr_package_read_page_data it does not change the package.
+ *
+ * Returns `PR_STATUS_INVALID_ARGUMENT` for block-format pages and frames
+ * outside their page.
+ */
+pr_status_t pr_package_read_frame_pixels(
+    const pr_package_t *package,
+    const pr_sprite_frame_t *frame,
+    void *dst,
+    size_t dst_stride
+);
+
 unsigned int pr_package_sprite_count(const pr_package_t *package);
 const pr_sprite_t *pr_package_sprite_at(
     const pr_package_t *package,
@@ -106,6 +269,111 @@ const pr_animation_t *pr_package_animation_at(
     unsigned int index
 );
 
+/* Binary patches between two versions of a package (`.prpd` files). The
+ * new package is cut into parts (header and chunk table, chunks, page
+ * levels, compressed tiles and bands of rows of uncompressed levels); parts
+ * whose bytes also occur in the old package are copied from it and the rest
+ * is stored in the patch, so packages built with stable placements
+ * (`atlas.incremental`) differ by little more than the frames that changed.
+ *
+ * pr_package_diff needs two valid packages. Buffers it and pr_package_patch
+ * return are released with pr_package_patch_free.
+ */
+pr_status_t pr_package_diff(
+    const void *old_data,
+    size_t old_size,
+    const void *new_data,
+    size_t new_size,
+    void **out_patch,
+    size_t *out_patch_size
+);
+
+/* Rebuilds the new package from the old one. Returns
+ * `PR_STATUS_VALIDATION_ERROR` when `old_data` is not the package the patch
+ * was made from (or the result does not match the recorded hash) and
+ * `PR_STATUS_PARSE_ERROR` for a malformed patch.
+ */
+pr_status_t pr_package_patch(
+    const void *old_data,
+    size_t old_size,
+    const void *patch_data,
+    size_t patch_size,
+    void **out_data,
+    size_t *out_size
+);
+
+void pr_package_patch_free(void *data);
+
+/* File versions of the two calls above; `out_*_size` (optional) receives
+ * the size of the written file.
+ */
+pr_status_t pr_package_diff_files(
+    const char *old_path,
+    const char *new_path,
+    const char *patch_path,
+    size_t *out_patch_size
+);
+pr_status_t pr_package_patch_files(
+    const char *old_path,
+    const char *patch_path,
+    const char *out_path,
+    size_t *out_size
+);
+
+#define PR_PACKAGE_STATS_MAX_CHUNKS 16u
+
+typedef struct pr_package_chunk_stats {
+    char id[5];
+    unsigned long long bytes;
+    double parse_ms;
+} pr_package_chunk_stats_t;
+
+/* Memory and timing for one open package.
+ *
+ * - `file_bytes`: the package bytes read from disk or copied from memory
+ * - `metadata_bytes`: parsed tables (strings, sprites, frames, animations,
+ *   page views) and the package object itself
+ * - `pixel_bytes`: atlas page data as stored; it points into the file
+ *   bytes, so it is part of `file_bytes` rather than an extra allocation
+ * - `decompressed_bytes`: buffers held for decompressed pages
+ * - `total_bytes`: heap held by the package (`file_bytes + metadata_bytes +
+ *   decompressed_bytes`)
+ *
+ * `read_ms` is the file read or memory copy and `parse_ms` the chunk table
+ * plus every chunk parse; `chunks` lists each chunk in table order with its
+ * own parse time (zero for chunks the runtime does not parse).
+ *
+ * Lookup counters are only maintained when the library is compiled with
+ * PACKRAT_RUNTIME_COUNTERS; otherwise `counters_enabled` is 0 and they stay
+ * zero. They are not synchronized, so concurrent lookups may undercount.
+ */
+typedef struct pr_package_stats {
+    unsigned long long file_bytes;
+    unsigned long long metadata_bytes;
+    unsigned long long pixel_bytes;
+    unsigned long long decompressed_bytes;
+    unsigned long long total_bytes;
+    double open_ms;
+    double read_ms;
+    double parse_ms;
+    unsigned int chunk_count;
+    pr_package_chunk_stats_t chunks[PR_PACKAGE_STATS_MAX_CHUNKS];
+    int counters_enabled;
+    unsigned long long sprite_lookups;
+    unsigned long long sprite_hits;
+    unsigned long long sprite_misses;
+    unsigned long long animation_lookups;
+    unsigned long long animation_hits;
+    unsigned long long animation_misses;
+    unsigned long long atlas_page_accesses;
+} pr_package_stats_t;
+
+pr_status_t pr_package_get_stats(
+    const pr_package_t *package,
+    pr_package_stats_t *out_stats
+);
+void pr_package_reset_counters(pr_package_t *package);
+
 #ifdef __cplusplus
 }
 #endif
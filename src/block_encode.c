@@ -0,0 +1,1445 @@
+#include "block_encode.h"
+
+#include <float.h>
+#include <string.h>
+
+#include "page_format.h"
+#include "parallel.h"
+#include "profiler.h"
+
+/* Endpoint fitting shared by the BC formats: the endpoints start at the
+ * extremes of the block along its principal axis, then get a least-squares
+ * refinement against the chosen indices per extra pass (one for "balanced",
+ * two for "best"). The best candidate is kept, so refinement never makes a
+ * block worse.
+ */
+
+typedef struct pr_block_encode_job {
+    pr_page_format_t format;
+    pr_encode_quality_t quality;
+    const unsigned char *rgba;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t blocks_x;
+    uint32_t block_bytes;
+    unsigned char *out;
+} pr_block_encode_job_t;
+
+static const int PR_BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+static const int PR_BC7_WEIGHTS4[16] = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+static float pr_block_clamp255(float value)
+{
+    if (value < 0.0f) {
+        return 0.0f;
+    }
+    if (value > 255.0f) {
+        return 255.0f;
+    }
+    return value;
+}
+
+static void pr_block_load(
+    const pr_block_encode_job_t *job,
+    uint32_t block_x,
+    uint32_t block_y,
+    unsigned char texels[16][4]
+)
+{
+    uint32_t x;
+    uint32_t y;
+
+    for (y = 0u; y < 4u; ++y) {
+        uint32_t src_y;
+
+        src_y = block_y * 4u + y;
+        if (src_y >= job->height) {
+            src_y = job->height - 1u;
+        }
+        for (x = 0u; x < 4u; ++x) {
+            uint32_t src_x;
+
+            src_x = block_x * 4u + x;
+            if (src_x >= job->width) {
+                src_x = job->width - 1u;
+            }
+            memcpy(
+                texels[y * 4u + x],
+                job->rgba + (size_t)src_y * job->stride + (size_t)src_x * 4u,
+                4u
+            );
+        }
+    }
+}
+
+/* Fits a line through the texels with `mask[i]` set, over the first
+ * `channels` channels, and returns its extremes. Uniform blocks get two equal
+ * endpoints.
+ */
+static void pr_block_fit_endpoints(
+    const unsigned char texels[16][4],
+    const unsigned char *mask,
+    int channels,
+    float out_e0[4],
+    float out_e1[4]
+)
+{
+    float mean[4];
+    float cov[4][4];
+    float axis[4];
+    float t_min;
+    float t_max;
+    float length;
+    int count;
+    int i;
+    int c;
+    int k;
+    int iter;
+
+    memset(mean, 0, sizeof(mean));
+    memset(cov, 0, sizeof(cov));
+    count = 0;
+    for (i = 0; i < 16; ++i) {
+        if (mask != NULL && mask[i] == 0u) {
+            continue;
+        }
+        for (c = 0; c < channels; ++c) {
+            mean[c] += (float)texels[i][c];
+        }
+        count += 1;
+    }
+    if (count == 0) {
+        memset(out_e0, 0, sizeof(float) * 4u);
+        memset(out_e1, 0, sizeof(float) * 4u);
+        return;
+    }
+    for (c = 0; c < channels; ++c) {
+        mean[c] /= (float)count;
+    }
+
+    for (i = 0; i < 16; ++i) {
+        float d[4];
+
+        if (mask != NULL && mask[i] == 0u) {
+            continue;
+        }
+        for (c = 0; c < channels; ++c) {
+            d[c] = (float)texels[i][c] - mean[c];
+        }
+        for (c = 0; c < channels; ++c) {
+            for (k = 0; k < channels; ++k) {
+                cov[c][k] += d[c] * d[k];
+            }
+        }
+    }
+
+    /* Power iteration, seeded with the covariance row of the channel with the
+     * most variance (the diagonal can sit in the null space when channels are
+     * anti-correlated). Only the direction matters, so each step rescales by
+     * the largest component instead of normalizing.
+     */
+    k = 0;
+    for (c = 1; c < channels; ++c) {
+        if (cov[c][c] > cov[k][k]) {
+            k = c;
+        }
+    }
+    for (c = 0; c < channels; ++c) {
+        axis[c] = cov[k][c];
+    }
+    for (iter = 0; iter < 8; ++iter) {
+        float next[4];
+        float scale;
+
+        scale = 0.0f;
+        for (c = 0; c < channels; ++c) {
+            next[c] = 0.0f;
+            for (k = 0; k < channels; ++k) {
+                next[c] += cov[c][k] * axis[k];
+            }
+            scale = (next[c] > scale) ? next[c] : ((-next[c] > scale) ? -next[c] : scale);
+        }
+        if (scale <= FLT_EPSILON) {
+            break;
+        }
+        for (c = 0; c < channels; ++c) {
+            axis[c] = next[c] / scale;
+        }
+    }
+
+    length = 0.0f;
+    for (c = 0; c < channels; ++c) {
+        length += axis[c] * axis[c];
+    }
+    if (length <= FLT_EPSILON) {
+        for (c = 0; c < 4; ++c) {
+            out_e0[c] = (c < channels) ? mean[c] : 0.0f;
+            out_e1[c] = out_e0[c];
+        }
+        return;
+    }
+
+    t_min = FLT_MAX;
+    t_max = -FLT_MAX;
+    for (i = 0; i < 16; ++i) {
+        float t;
+
+        if (mask != NULL && mask[i] == 0u) {
+            continue;
+        }
+        t = 0.0f;
+        for (c = 0; c < channels; ++c) {
+            t += ((float)texels[i][c] - mean[c]) * axis[c];
+        }
+        t /= length;
+        t_min = (t < t_min) ? t : t_min;
+        t_max = (t > t_max) ? t : t_max;
+    }
+    for (c = 0; c < 4; ++c) {
+        if (c < channels) {
+            out_e0[c] = pr_block_clamp255(mean[c] + axis[c] * t_min);
+            out_e1[c] = pr_block_clamp255(mean[c] + axis[c] * t_max);
+        } else {
+            out_e0[c] = 0.0f;
+            out_e1[c] = 0.0f;
+        }
+    }
+}
+
+/* Least-squares endpoints for fixed indices, where texel i is reconstructed
+ * as `w[i] * e0 + (1 - w[i]) * e1`. Returns 0 when the system is singular.
+ */
+static int pr_block_refine_endpoints(
+    const unsigned char texels[16][4],
+    const unsigned char *mask,
+    const float weights[16],
+    int channels,
+    float out_e0[4],
+    float out_e1[4]
+)
+{
+    float aa;
+    float ab;
+    float bb;
+    float rhs0[4];
+    float rhs1[4];
+    float det;
+    int i;
+    int c;
+
+    aa = 0.0f;
+    ab = 0.0f;
+    bb = 0.0f;
+    memset(rhs0, 0, sizeof(rhs0));
+    memset(rhs1, 0, sizeof(rhs1));
+    for (i = 0; i < 16; ++i) {
+        float w;
+
+        if (mask != NULL && mask[i] == 0u) {
+            continue;
+        }
+        w = weights[i];
+        aa += w * w;
+        ab += w * (1.0f - w);
+        bb += (1.0f - w) * (1.0f - w);
+        for (c = 0; c < channels; ++c) {
+            rhs0[c] += w * (float)texels[i][c];
+            rhs1[c] += (1.0f - w) * (float)texels[i][c];
+        }
+    }
+
+    det = aa * bb - ab * ab;
+    if (det > -1e-4f && det < 1e-4f) {
+        return 0;
+    }
+    det = 1.0f / det;
+    for (c = 0; c < channels; ++c) {
+        out_e0[c] = pr_block_clamp255((bb * rhs0[c] - ab * rhs1[c]) * det);
+        out_e1[c] = pr_block_clamp255((aa * rhs1[c] - ab * rhs0[c]) * det);
+    }
+    return 1;
+}
+
+static uint16_t pr_bc1_pack565(const float color[4])
+{
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+
+    r = (uint32_t)(color[0] * (31.0f / 255.0f) + 0.5f);
+    g = (uint32_t)(color[1] * (63.0f / 255.0f) + 0.5f);
+    b = (uint32_t)(color[2] * (31.0f / 255.0f) + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void pr_bc1_unpack565(uint16_t value, int out[3])
+{
+    int r;
+    int g;
+    int b;
+
+    r = (value >> 11) & 31;
+    g = (value >> 5) & 63;
+    b = value & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+/* Picks indices for one 565 endpoint pair and returns the squared error. The
+ * endpoints are reordered for the mode: c0 > c1 selects four colors, c0 <= c1
+ * three colors plus transparent black (index 3), used when `punch_through`.
+ */
+static uint32_t pr_bc1_choose_indices(
+    const unsigned char texels[16][4],
+    const unsigned char opaque[16],
+    int punch_through,
+    uint16_t *io_c0,
+    uint16_t *io_c1,
+    unsigned char indices[16]
+)
+{
+    int palette[4][3];
+    int color_count;
+    uint32_t error;
+    int i;
+    int c;
+
+    if ((punch_through != 0 && *io_c0 > *io_c1) || (punch_through == 0 && *io_c0 < *io_c1)) {
+        uint16_t swap;
+
+        swap = *io_c0;
+        *io_c0 = *io_c1;
+        *io_c1 = swap;
+    }
+
+    pr_bc1_unpack565(*io_c0, palette[0]);
+    pr_bc1_unpack565(*io_c1, palette[1]);
+    if (punch_through != 0) {
+        for (c = 0; c < 3; ++c) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+        color_count = 3;
+    } else if (*io_c0 == *io_c1) {
+        /* Equal endpoints decode as three-color mode, so index 3 is off limits. */
+        color_count = 1;
+    } else {
+        for (c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        color_count = 4;
+    }
+
+    error = 0u;
+    for (i = 0; i < 16; ++i) {
+        uint32_t best_error;
+        int best;
+        int k;
+
+        if (opaque[i] == 0u) {
+            indices[i] = 3u;
+            continue;
+        }
+        best = 0;
+        best_error = UINT32_MAX;
+        for (k = 0; k < color_count; ++k) {
+            uint32_t e;
+
+            e = 0u;
+            for (c = 0; c < 3; ++c) {
+                int d;
+
+                d = (int)texels[i][c] - palette[k][c];
+                e += (uint32_t)(d * d);
+            }
+            if (e < best_error) {
+                best_error = e;
+                best = k;
+            }
+        }
+        indices[i] = (unsigned char)best;
+        error += best_error;
+    }
+    return error;
+}
+
+static void pr_encode_bc1_color(
+    const unsigned char texels[16][4],
+    int punch_through,
+    int passes,
+    unsigned char out[8]
+)
+{
+    static const float weights4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    static const float weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+    unsigned char opaque[16];
+    unsigned char indices[16];
+    unsigned char best_indices[16];
+    uint16_t best_c0;
+    uint16_t best_c1;
+    uint32_t best_error;
+    uint32_t packed;
+    float e0[4];
+    float e1[4];
+    int opaque_count;
+    int pass;
+    int i;
+
+    opaque_count = 0;
+    for (i = 0; i < 16; ++i) {
+        opaque[i] = (unsigned char)(punch_through == 0 || texels[i][3] >= 128u);
+        opaque_count += opaque[i];
+    }
+    if (opaque_count == 16) {
+        punch_through = 0;
+    }
+
+    pr_block_fit_endpoints(texels, opaque, 3, e0, e1);
+    best_c0 = 0u;
+    best_c1 = 0u;
+    best_error = UINT32_MAX;
+    memset(best_indices, 3, sizeof(best_indices));
+    for (pass = 0; pass < passes && opaque_count > 0; ++pass) {
+        float weights[16];
+        uint16_t c0;
+        uint16_t c1;
+        uint32_t error;
+
+        c0 = pr_bc1_pack565(e0);
+        c1 = pr_bc1_pack565(e1);
+        error = pr_bc1_choose_indices(texels, opaque, punch_through, &c0, &c1, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_c0 = c0;
+            best_c1 = c1;
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+        if (error == 0u) {
+            break;
+        }
+
+        for (i = 0; i < 16; ++i) {
+            weights[i] = (punch_through != 0) ? weights3[indices[i]] : weights4[indices[i]];
+        }
+        if (!pr_block_refine_endpoints(texels, opaque, weights, 3, e0, e1)) {
+            break;
+        }
+    }
+
+    packed = 0u;
+    for (i = 0; i < 16; ++i) {
+        packed |= (uint32_t)best_indices[i] << (2 * i);
+    }
+    out[0] = (unsigned char)(best_c0 & 0xFFu);
+    out[1] = (unsigned char)(best_c0 >> 8);
+    out[2] = (unsigned char)(best_c1 & 0xFFu);
+    out[3] = (unsigned char)(best_c1 >> 8);
+    out[4] = (unsigned char)(packed & 0xFFu);
+    out[5] = (unsigned char)((packed >> 8) & 0xFFu);
+    out[6] = (unsigned char)((packed >> 16) & 0xFFu);
+    out[7] = (unsigned char)(packed >> 24);
+}
+
+/* BC3 alpha half (the BC4 layout): alpha endpoints at the block min/max with
+ * eight interpolated levels.
+ */
+static void pr_encode_bc3_alpha(const unsigned char texels[16][4], unsigned char out[8])
+{
+    int palette[8];
+    uint64_t packed;
+    int a_min;
+    int a_max;
+    int i;
+    int k;
+
+    a_min = 255;
+    a_max = 0;
+    for (i = 0; i < 16; ++i) {
+        a_min = (texels[i][3] < a_min) ? texels[i][3] : a_min;
+        a_max = (texels[i][3] > a_max) ? texels[i][3] : a_max;
+    }
+
+    out[0] = (unsigned char)a_max;
+    out[1] = (unsigned char)a_min;
+    if (a_max == a_min) {
+        memset(out + 2, 0, 6u);
+        return;
+    }
+
+    palette[0] = a_max;
+    palette[1] = a_min;
+    for (k = 1; k < 7; ++k) {
+        palette[k + 1] = ((7 - k) * a_max + k * a_min) / 7;
+    }
+
+    packed = 0u;
+    for (i = 0; i < 16; ++i) {
+        int best;
+        int best_error;
+
+        best = 0;
+        best_error = 256;
+        for (k = 0; k < 8; ++k) {
+            int d;
+
+            d = texels[i][3] - palette[k];
+            d = (d < 0) ? -d : d;
+            if (d < best_error) {
+                best_error = d;
+                best = k;
+            }
+        }
+        packed |= (uint64_t)best << (3 * i);
+    }
+    for (i = 0; i < 6; ++i) {
+        out[2 + i] = (unsigned char)((packed >> (8 * i)) & 0xFFu);
+    }
+}
+
+static int pr_bc7_interpolate(int a, int b, int weight)
+{
+    return ((64 - weight) * a + weight * b + 32) >> 6;
+}
+
+/* 7-bit endpoint plus shared p-bit. Fully transparent and fully opaque
+ * endpoints keep their exact alpha, so sprite edges do not bleed.
+ */
+static void pr_bc7_quantize_endpoint(const float color[4], int out_q[4], int *out_p)
+{
+    int p;
+    int p_first;
+    int p_last;
+    int c;
+    float best_error;
+
+    p_first = (color[3] >= 255.0f) ? 1 : 0;
+    p_last = (color[3] <= 0.0f) ? 0 : 1;
+    best_error = FLT_MAX;
+    for (p = p_first; p <= p_last; ++p) {
+        int q[4];
+        float error;
+
+        error = 0.0f;
+        for (c = 0; c < 4; ++c) {
+            float d;
+
+            q[c] = (int)((color[c] - (float)p) * 0.5f + 0.5f);
+            q[c] = (q[c] < 0) ? 0 : ((q[c] > 127) ? 127 : q[c]);
+            d = (float)(q[c] * 2 + p) - color[c];
+            error += d * d;
+        }
+        if (p == p_first || error < best_error) {
+            best_error = error;
+            memcpy(out_q, q, sizeof(q));
+            *out_p = p;
+        }
+    }
+}
+
+static uint32_t pr_bc7_choose_indices(
+    const unsigned char texels[16][4],
+    const int q0[4],
+    int p0,
+    const int q1[4],
+    int p1,
+    unsigned char indices[16]
+)
+{
+    int palette[16][4];
+    uint32_t error;
+    int i;
+    int k;
+    int c;
+
+    for (k = 0; k < 16; ++k) {
+        for (c = 0; c < 4; ++c) {
+            int a;
+            int b;
+
+            a = q0[c] * 2 + p0;
+            b = q1[c] * 2 + p1;
+            palette[k][c] = pr_bc7_interpolate(a, b, PR_BC7_WEIGHTS4[k]);
+        }
+    }
+
+    error = 0u;
+    for (i = 0; i < 16; ++i) {
+        uint32_t best_error;
+        int best;
+
+        best = 0;
+        best_error = UINT32_MAX;
+        for (k = 0; k < 16; ++k) {
+            uint32_t e;
+
+            e = 0u;
+            for (c = 0; c < 4; ++c) {
+                int d;
+
+                d = (int)texels[i][c] - palette[k][c];
+                e += (uint32_t)(d * d);
+            }
+            if (e < best_error) {
+                best_error = e;
+                best = k;
+            }
+        }
+        indices[i] = (unsigned char)best;
+        error += best_error;
+    }
+    return error;
+}
+
+static void pr_bc7_put_bits(unsigned char out[16], uint32_t *io_bit, uint32_t bit_count, uint32_t value)
+{
+    uint32_t i;
+
+    for (i = 0u; i < bit_count; ++i) {
+        if (((value >> i) & 1u) != 0u) {
+            out[*io_bit >> 3] |= (unsigned char)(1u << (*io_bit & 7u));
+        }
+        *io_bit += 1u;
+    }
+}
+
+/* BC7 mode 6: one subset, 7-bit RGBA endpoints with a p-bit each, and 4-bit
+ * indices. Best for opaque blocks and blocks whose alpha follows the color.
+ */
+static uint32_t pr_encode_bc7_mode6(
+    const unsigned char texels[16][4],
+    int passes,
+    unsigned char out[16]
+)
+{
+    unsigned char indices[16];
+    unsigned char best_indices[16];
+    int best_q0[4];
+    int best_q1[4];
+    int best_p0;
+    int best_p1;
+    uint32_t best_error;
+    uint32_t bit;
+    float e0[4];
+    float e1[4];
+    int pass;
+    int i;
+    int c;
+
+    /* e0 is index 0, so fit with the refine convention (w = weight of e0). */
+    pr_block_fit_endpoints(texels, NULL, 4, e0, e1);
+    best_error = UINT32_MAX;
+    best_p0 = 0;
+    best_p1 = 0;
+    memset(best_q0, 0, sizeof(best_q0));
+    memset(best_q1, 0, sizeof(best_q1));
+    memset(best_indices, 0, sizeof(best_indices));
+    for (pass = 0; pass < passes; ++pass) {
+        float weights[16];
+        int q0[4];
+        int q1[4];
+        int p0;
+        int p1;
+        uint32_t error;
+
+        pr_bc7_quantize_endpoint(e0, q0, &p0);
+        pr_bc7_quantize_endpoint(e1, q1, &p1);
+        error = pr_bc7_choose_indices(texels, q0, p0, q1, p1, indices);
+        if (error < best_error) {
+            best_error = error;
+            memcpy(best_q0, q0, sizeof(q0));
+            memcpy(best_q1, q1, sizeof(q1));
+            best_p0 = p0;
+            best_p1 = p1;
+            memcpy(best_indices, indices, sizeof(indices));
+        }
+        if (error == 0u) {
+            break;
+        }
+
+        for (i = 0; i < 16; ++i) {
+            weights[i] = 1.0f - (float)PR_BC7_WEIGHTS4[indices[i]] / 64.0f;
+        }
+        if (!pr_block_refine_endpoints(texels, NULL, weights, 4, e0, e1)) {
+            break;
+        }
+    }
+
+    /* The anchor (texel 0) index drops its top bit, so it must be < 8. */
+    if (best_indices[0] >= 8u) {
+        int swap_q[4];
+        int swap_p;
+
+        memcpy(swap_q, best_q0, sizeof(swap_q));
+        memcpy(best_q0, best_q1, sizeof(swap_q));
+        memcpy(best_q1, swap_q, sizeof(swap_q));
+        swap_p = best_p0;
+        best_p0 = best_p1;
+        best_p1 = swap_p;
+        for (i = 0; i < 16; ++i) {
+            best_indices[i] = (unsigned char)(15u - best_indices[i]);
+        }
+    }
+
+    memset(out, 0, 16u);
+    bit = 0u;
+    pr_bc7_put_bits(out, &bit, 7u, 1u << 6);
+    for (c = 0; c < 4; ++c) {
+        pr_bc7_put_bits(out, &bit, 7u, (uint32_t)best_q0[c]);
+        pr_bc7_put_bits(out, &bit, 7u, (uint32_t)best_q1[c]);
+    }
+    pr_bc7_put_bits(out, &bit, 1u, (uint32_t)best_p0);
+    pr_bc7_put_bits(out, &bit, 1u, (uint32_t)best_p1);
+    pr_bc7_put_bits(out, &bit, 3u, best_indices[0]);
+    for (i = 1; i < 16; ++i) {
+        pr_bc7_put_bits(out, &bit, 4u, best_indices[i]);
+    }
+    return best_error;
+}
+
+static uint32_t pr_bc7_mode5_color_indices(
+    const unsigned char texels[16][4],
+    const int q0[3],
+    const int q1[3],
+    unsigned char indices[16]
+)
+{
+    int palette[4][3];
+    uint32_t error;
+    int i;
+    int k;
+    int c;
+
+    for (c = 0; c < 3; ++c) {
+        int a;
+        int b;
+
+        a = (q0[c] << 1) | (q0[c] >> 6);
+        b = (q1[c] << 1) | (q1[c] >> 6);
+        for (k = 0; k < 4; ++k) {
+            palette[k][c] = pr_bc7_interpolate(a, b, PR_BC7_WEIGHTS2[k]);
+        }
+    }
+
+    error = 0u;
+    for (i = 0; i < 16; ++i) {
+        uint32_t best_error;
+        int best;
+
+        best = 0;
+        best_error = UINT32_MAX;
+        for (k = 0; k < 4; ++k) {
+            uint32_t e;
+
+            e = 0u;
+            for (c = 0; c < 3; ++c) {
+                int d;
+
+                d = (int)texels[i][c] - palette[k][c];
+                e += (uint32_t)(d * d);
+            }
+            if (e < best_error) {
+                best_error = e;
+                best = k;
+            }
+        }
+        indices[i] = (unsigned char)best;
+        error += best_error;
+    }
+    return error;
+}
+
+/* BC7 mode 5 (no channel rotation): 7-bit RGB and 8-bit alpha endpoints with
+ * separate 2-bit index sets, for blocks where alpha varies independently of
+ * color, such as sprite silhouettes against transparent texels.
+ */
+static uint32_t pr_encode_bc7_mode5(
+    const unsigned char texels[16][4],
+    int passes,
+    unsigned char out[16]
+)
+{
+    unsigned char color_indices[16];
+    unsigned char best_color_indices[16];
+    unsigned char alpha_indices[16];
+    int best_q0[3];
+    int best_q1[3];
+    int alpha_palette[4];
+    int a0;
+    int a1;
+    uint32_t best_error;
+    uint32_t alpha_error;
+    uint32_t bit;
+    float e0[4];
+    float e1[4];
+    int pass;
+    int i;
+    int k;
+    int c;
+
+    pr_block_fit_endpoints(texels, NULL, 3, e0, e1);
+    best_error = UINT32_MAX;
+    memset(best_q0, 0, sizeof(best_q0));
+    memset(best_q1, 0, sizeof(best_q1));
+    memset(best_color_indices, 0, sizeof(best_color_indices));
+    for (pass = 0; pass < passes; ++pass) {
+        float weights[16];
+        int q0[3];
+        int q1[3];
+        uint32_t error;
+
+        for (c = 0; c < 3; ++c) {
+            q0[c] = (int)(e0[c] * (127.0f / 255.0f) + 0.5f);
+            q1[c] = (int)(e1[c] * (127.0f / 255.0f) + 0.5f);
+        }
+        error = pr_bc7_mode5_color_indices(texels, q0, q1, color_indices);
+        if (error < best_error) {
+            best_error = error;
+            memcpy(best_q0, q0, sizeof(q0));
+            memcpy(best_q1, q1, sizeof(q1));
+            memcpy(best_color_indices, color_indices, sizeof(color_indices));
+        }
+        if (error == 0u) {
+            break;
+        }
+
+        for (i = 0; i < 16; ++i) {
+            weights[i] = 1.0f - (float)PR_BC7_WEIGHTS2[color_indices[i]] / 64.0f;
+        }
+        if (!pr_block_refine_endpoints(texels, NULL, weights, 3, e0, e1)) {
+            break;
+        }
+    }
+
+    a0 = 255;
+    a1 = 0;
+    for (i = 0; i < 16; ++i) {
+        a0 = (texels[i][3] < a0) ? texels[i][3] : a0;
+        a1 = (texels[i][3] > a1) ? texels[i][3] : a1;
+    }
+    for (k = 0; k < 4; ++k) {
+        alpha_palette[k] = pr_bc7_interpolate(a0, a1, PR_BC7_WEIGHTS2[k]);
+    }
+    alpha_error = 0u;
+    for (i = 0; i < 16; ++i) {
+        int best;
+        int best_error_a;
+
+        best = 0;
+        best_error_a = 256;
+        for (k = 0; k < 4; ++k) {
+            int d;
+
+            d = texels[i][3] - alpha_palette[k];
+            d = (d < 0) ? -d : d;
+            if (d < best_error_a) {
+                best_error_a = d;
+                best = k;
+            }
+        }
+        alpha_indices[i] = (unsigned char)best;
+        alpha_error += (uint32_t)(best_error_a * best_error_a);
+    }
+
+    /* Both anchors drop their top index bit. */
+    if (best_color_indices[0] >= 2u) {
+        int swap_q[3];
+
+        memcpy(swap_q, best_q0, sizeof(swap_q));
+        memcpy(best_q0, best_q1, sizeof(swap_q));
+        memcpy(best_q1, swap_q, sizeof(swap_q));
+        for (i = 0; i < 16; ++i) {
+            best_color_indices[i] = (unsigned char)(3u - best_color_indices[i]);
+        }
+    }
+    if (alpha_indices[0] >= 2u) {
+        int swap_a;
+
+        swap_a = a0;
+        a0 = a1;
+        a1 = swap_a;
+        for (i = 0; i < 16; ++i) {
+            alpha_indices[i] = (unsigned char)(3u - alpha_indices[i]);
+        }
+    }
+
+    memset(out, 0, 16u);
+    bit = 0u;
+    pr_bc7_put_bits(out, &bit, 6u, 1u << 5);
+    pr_bc7_put_bits(out, &bit, 2u, 0u);
+    for (c = 0; c < 3; ++c) {
+        pr_bc7_put_bits(out, &bit, 7u, (uint32_t)best_q0[c]);
+        pr_bc7_put_bits(out, &bit, 7u, (uint32_t)best_q1[c]);
+    }
+    pr_bc7_put_bits(out, &bit, 8u, (uint32_t)a0);
+    pr_bc7_put_bits(out, &bit, 8u, (uint32_t)a1);
+    pr_bc7_put_bits(out, &bit, 1u, best_color_indices[0]);
+    for (i = 1; i < 16; ++i) {
+        pr_bc7_put_bits(out, &bit, 2u, best_color_indices[i]);
+    }
+    pr_bc7_put_bits(out, &bit, 1u, alpha_indices[0]);
+    for (i = 1; i < 16; ++i) {
+        pr_bc7_put_bits(out, &bit, 2u, alpha_indices[i]);
+    }
+    return best_error + alpha_error;
+}
+
+static void pr_encode_bc7_block(
+    const unsigned char texels[16][4],
+    int passes,
+    unsigned char out[16]
+)
+{
+    unsigned char candidate[16];
+    uint32_t error;
+    int i;
+
+    error = pr_encode_bc7_mode6(texels, passes, out);
+    for (i = 1; i < 16 && error > 0u; ++i) {
+        if (texels[i][3] != texels[0][3]) {
+            if (pr_encode_bc7_mode5(texels, passes, candidate) < error) {
+                memcpy(out, candidate, sizeof(candidate));
+            }
+            break;
+        }
+    }
+}
+
+/* ETC2 color: emitted as individual or differential blocks, the ETC1
+ * subset every ETC2 decoder accepts. Each half-block gets a base color and
+ * one of eight intensity tables; the presets widen the base color search
+ * around the half-block average.
+ */
+static const int PR_ETC_MODIFIERS[8][4] = {
+    { 2, 8, -2, -8 },
+    { 5, 17, -5, -17 },
+    { 9, 29, -9, -29 },
+    { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 },
+    { 24, 80, -24, -80 },
+    { 33, 106, -33, -106 },
+    { 47, 183, -47, -183 }
+};
+
+static const int PR_EAC_MODIFIERS[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+typedef struct pr_etc_half {
+    int base[3];
+    int table;
+    uint32_t error;
+    unsigned char indices[16];
+} pr_etc_half_t;
+
+static int pr_etc_clamp(int value)
+{
+    return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+/* Texel i (row-major) belongs to half 1 when it is in the right columns, or
+ * the bottom rows when the block is flipped.
+ */
+static int pr_etc_in_half(int i, int flip, int half)
+{
+    int position;
+
+    position = (flip != 0) ? (i / 4) : (i % 4);
+    return (position >= 2) == (half != 0);
+}
+
+/* Tables whose larger modifier is closest to the half's largest luma offset
+ * from the base do best; "fast" and "balanced" only try one or two tables on
+ * either side of that estimate.
+ */
+static const int PR_ETC_TABLE_REACH[3] = { 1, 2, 8 };
+
+static void pr_etc_fit_half(
+    const unsigned char texels[16][4],
+    const int members[8],
+    const int color[3],
+    int table_reach,
+    pr_etc_half_t *io_best
+)
+{
+    int spread;
+    int center;
+    int table;
+    int i;
+
+    spread = 0;
+    for (i = 0; i < 8; ++i) {
+        const unsigned char *texel;
+        int offset;
+
+        texel = texels[members[i]];
+        offset = ((int)texel[0] + (int)texel[1] + (int)texel[2] - color[0] - color[1] - color[2]) / 3;
+        offset = (offset < 0) ? -offset : offset;
+        spread = (offset > spread) ? offset : spread;
+    }
+    center = 0;
+    for (table = 1; table < 8; ++table) {
+        int distance;
+        int center_distance;
+
+        distance = PR_ETC_MODIFIERS[table][1] - spread;
+        center_distance = PR_ETC_MODIFIERS[center][1] - spread;
+        if ((distance < 0 ? -distance : distance) < (center_distance < 0 ? -center_distance : center_distance)) {
+            center = table;
+        }
+    }
+
+    for (table = 0; table < 8; ++table) {
+        int palette[4][3];
+        unsigned char indices[8];
+        uint32_t error;
+        int k;
+
+        if (table < center - table_reach || table > center + table_reach) {
+            continue;
+        }
+        for (k = 0; k < 4; ++k) {
+            palette[k][0] = pr_etc_clamp(color[0] + PR_ETC_MODIFIERS[table][k]);
+            palette[k][1] = pr_etc_clamp(color[1] + PR_ETC_MODIFIERS[table][k]);
+            palette[k][2] = pr_etc_clamp(color[2] + PR_ETC_MODIFIERS[table][k]);
+        }
+
+        error = 0u;
+        for (i = 0; i < 8 && error < io_best->error; ++i) {
+            const unsigned char *texel;
+            uint32_t best_error;
+            int best;
+
+            texel = texels[members[i]];
+            best = 0;
+            best_error = UINT32_MAX;
+            for (k = 0; k < 4; ++k) {
+                int dr;
+                int dg;
+                int db;
+                uint32_t e;
+
+                dr = palette[k][0] - (int)texel[0];
+                dg = palette[k][1] - (int)texel[1];
+                db = palette[k][2] - (int)texel[2];
+                e = (uint32_t)(dr * dr + dg * dg + db * db);
+                if (e < best_error) {
+                    best_error = e;
+                    best = k;
+                }
+            }
+            indices[i] = (unsigned char)best;
+            error += best_error;
+        }
+        if (error < io_best->error) {
+            io_best->error = error;
+            io_best->table = table;
+            for (i = 0; i < 8; ++i) {
+                io_best->indices[members[i]] = indices[i];
+            }
+        }
+    }
+}
+
+/* Base color offsets tried around the half-block average: "fast" keeps the
+ * average, "balanced" also steps along the gray axis, "best" adds single
+ * channel steps.
+ */
+static const int PR_ETC_BASE_STEPS[][3] = {
+    { 0, 0, 0 },
+    { -1, -1, -1 },
+    { 1, 1, 1 },
+    { -1, 0, 0 },
+    { 1, 0, 0 },
+    { 0, -1, 0 },
+    { 0, 1, 0 },
+    { 0, 0, -1 },
+    { 0, 0, 1 }
+};
+
+static const int PR_ETC_BASE_STEP_COUNTS[3] = { 1, 3, 9 };
+
+/* Best quantized base color for one half, at 4 (individual) or 5
+ * (differential) bits per channel.
+ */
+static void pr_etc_search_half(
+    const unsigned char texels[16][4],
+    int flip,
+    int half,
+    int bits,
+    pr_encode_quality_t quality,
+    pr_etc_half_t *out_half
+)
+{
+    int members[8];
+    int sum[3];
+    int center[3];
+    int max_value;
+    int member_count;
+    int step;
+    int i;
+    int c;
+
+    member_count = 0;
+    sum[0] = 0;
+    sum[1] = 0;
+    sum[2] = 0;
+    for (i = 0; i < 16; ++i) {
+        if (pr_etc_in_half(i, flip, half)) {
+            members[member_count++] = i;
+            for (c = 0; c < 3; ++c) {
+                sum[c] += texels[i][c];
+            }
+        }
+    }
+
+    max_value = (1 << bits) - 1;
+    for (c = 0; c < 3; ++c) {
+        center[c] = (sum[c] * max_value + 255 * 4) / (255 * 8);
+    }
+
+    out_half->error = UINT32_MAX;
+    for (step = 0; step < PR_ETC_BASE_STEP_COUNTS[quality]; ++step) {
+        int quantized[3];
+        int color[3];
+        uint32_t previous_error;
+
+        for (c = 0; c < 3; ++c) {
+            quantized[c] = center[c] + PR_ETC_BASE_STEPS[step][c];
+            quantized[c] = (quantized[c] < 0) ? 0 :
+                ((quantized[c] > max_value) ? max_value : quantized[c]);
+            color[c] = (bits == 4) ?
+                ((quantized[c] << 4) | quantized[c]) :
+                ((quantized[c] << 3) | (quantized[c] >> 2));
+        }
+
+        previous_error = out_half->error;
+        pr_etc_fit_half(texels, members, color, PR_ETC_TABLE_REACH[quality], out_half);
+        if (out_half->error < previous_error) {
+            memcpy(out_half->base, quantized, sizeof(quantized));
+        }
+    }
+}
+
+static void pr_encode_etc2_color(
+    const unsigned char texels[16][4],
+    pr_encode_quality_t quality,
+    unsigned char out[8]
+)
+{
+    pr_etc_half_t halves[2];
+    pr_etc_half_t best_halves[2];
+    uint32_t best_error;
+    uint32_t high;
+    uint32_t low;
+    int best_flip;
+    int best_differential;
+    int flip;
+    int i;
+    int c;
+
+    best_error = UINT32_MAX;
+    best_flip = 0;
+    best_differential = 0;
+    memset(best_halves, 0, sizeof(best_halves));
+    for (flip = 0; flip < 2; ++flip) {
+        int clamped;
+
+        pr_etc_search_half(texels, flip, 0, 4, quality, &halves[0]);
+        pr_etc_search_half(texels, flip, 1, 4, quality, &halves[1]);
+        if (halves[0].error + halves[1].error < best_error) {
+            best_error = halves[0].error + halves[1].error;
+            best_flip = flip;
+            best_differential = 0;
+            memcpy(best_halves, halves, sizeof(halves));
+        }
+
+        /* Differential bases must sit within -4..3 of each other; a second
+         * base out of reach is pulled in and its half refit.
+         */
+        pr_etc_search_half(texels, flip, 0, 5, quality, &halves[0]);
+        pr_etc_search_half(texels, flip, 1, 5, quality, &halves[1]);
+        clamped = 0;
+        for (c = 0; c < 3; ++c) {
+            int delta;
+
+            delta = halves[1].base[c] - halves[0].base[c];
+            if (delta < -4 || delta > 3) {
+                halves[1].base[c] = halves[0].base[c] + ((delta < 0) ? -4 : 3);
+                clamped = 1;
+            }
+        }
+        if (clamped != 0) {
+            int members[8];
+            int color[3];
+            int j;
+
+            for (c = 0; c < 3; ++c) {
+                color[c] = (halves[1].base[c] << 3) | (halves[1].base[c] >> 2);
+            }
+            for (i = 0, j = 0; i < 16; ++i) {
+                if (pr_etc_in_half(i, flip, 1)) {
+                    members[j++] = i;
+                }
+            }
+            halves[1].error = UINT32_MAX;
+            pr_etc_fit_half(texels, members, color, PR_ETC_TABLE_REACH[quality], &halves[1]);
+        }
+        if (halves[0].error + halves[1].error < best_error) {
+            best_error = halves[0].error + halves[1].error;
+            best_flip = flip;
+            best_differential = 1;
+            memcpy(best_halves, halves, sizeof(halves));
+        }
+    }
+
+    if (best_differential != 0) {
+        high = ((uint32_t)best_halves[0].base[0] << 27) |
+            ((uint32_t)(best_halves[1].base[0] - best_halves[0].base[0]) & 7u) << 24 |
+            ((uint32_t)best_halves[0].base[1] << 19) |
+            ((uint32_t)(best_halves[1].base[1] - best_halves[0].base[1]) & 7u) << 16 |
+            ((uint32_t)best_halves[0].base[2] << 11) |
+            ((uint32_t)(best_halves[1].base[2] - best_halves[0].base[2]) & 7u) << 8;
+    } else {
+        high = ((uint32_t)best_halves[0].base[0] << 28) |
+            ((uint32_t)best_halves[1].base[0] << 24) |
+            ((uint32_t)best_halves[0].base[1] << 20) |
+            ((uint32_t)best_halves[1].base[1] << 16) |
+            ((uint32_t)best_halves[0].base[2] << 12) |
+            ((uint32_t)best_halves[1].base[2] << 8);
+    }
+    high |= ((uint32_t)best_halves[0].table << 5) |
+        ((uint32_t)best_halves[1].table << 2) |
+        ((uint32_t)best_differential << 1) |
+        (uint32_t)best_flip;
+
+    /* Pixel indices are numbered column-major; the MSBs sit in the upper half. */
+    low = 0u;
+    for (i = 0; i < 16; ++i) {
+        uint32_t index;
+        int position;
+
+        index = best_halves[pr_etc_in_half(i, best_flip, 1)].indices[i];
+        position = (i % 4) * 4 + (i / 4);
+        low |= ((index >> 1) << (16 + position)) | ((index & 1u) << position);
+    }
+
+    for (i = 0; i < 4; ++i) {
+        out[i] = (unsigned char)(high >> (24 - 8 * i));
+        out[4 + i] = (unsigned char)(low >> (24 - 8 * i));
+    }
+}
+
+static uint32_t pr_eac_fit(
+    const unsigned char texels[16][4],
+    int base,
+    int multiplier,
+    int table,
+    uint32_t error_limit,
+    uint64_t *out_indices
+)
+{
+    uint64_t indices;
+    uint32_t error;
+    int i;
+
+    indices = 0u;
+    error = 0u;
+    for (i = 0; i < 16 && error < error_limit; ++i) {
+        int best;
+        int best_error;
+        int k;
+
+        best = 0;
+        best_error = 256 * 256;
+        for (k = 0; k < 8; ++k) {
+            int d;
+
+            d = pr_etc_clamp(base + PR_EAC_MODIFIERS[table][k] * multiplier) - (int)texels[i][3];
+            if (d * d < best_error) {
+                best_error = d * d;
+                best = k;
+            }
+        }
+        indices |= (uint64_t)best << (45 - 3 * ((i % 4) * 4 + (i / 4)));
+        error += (uint32_t)best_error;
+    }
+    *out_indices = indices;
+    return error;
+}
+
+/* EAC alpha: a base value, multiplier and modifier table per block with
+ * 3-bit indices. The base and multiplier start from the table's range fit to
+ * the block's alpha range; the presets widen the search around that start.
+ */
+static void pr_encode_eac_alpha(
+    const unsigned char texels[16][4],
+    pr_encode_quality_t quality,
+    unsigned char out[8]
+)
+{
+    uint64_t best_bits;
+    uint32_t best_error;
+    int a_min;
+    int a_max;
+    int base_reach;
+    int multiplier_reach;
+    int table;
+    int i;
+
+    a_min = 255;
+    a_max = 0;
+    for (i = 0; i < 16; ++i) {
+        a_min = (texels[i][3] < a_min) ? texels[i][3] : a_min;
+        a_max = (texels[i][3] > a_max) ? texels[i][3] : a_max;
+    }
+
+    /* Table 13 has a zero modifier, so flat alpha is stored exactly. */
+    best_bits = ((uint64_t)a_min << 56) | ((uint64_t)1u << 52) | ((uint64_t)13u << 48);
+    for (i = 0; i < 16; ++i) {
+        best_bits |= (uint64_t)4u << (45 - 3 * i);
+    }
+    best_error = (a_min == a_max) ? 0u : UINT32_MAX;
+
+    base_reach = (quality == PR_ENCODE_QUALITY_FAST) ? 0 : ((quality == PR_ENCODE_QUALITY_BEST) ? 4 : 1);
+    multiplier_reach = (quality == PR_ENCODE_QUALITY_FAST) ? 0 : 1;
+    for (table = 0; table < 16 && best_error > 0u; ++table) {
+        int low;
+        int high;
+        int multiplier_start;
+        int base_start;
+        int multiplier;
+
+        low = PR_EAC_MODIFIERS[table][3];
+        high = PR_EAC_MODIFIERS[table][7];
+        multiplier_start = ((a_max - a_min) + (high - low) / 2) / (high - low);
+        base_start = (a_max + a_min + 1) / 2 - (multiplier_start * (high + low)) / 2;
+        for (
+            multiplier = multiplier_start - multiplier_reach;
+            multiplier <= multiplier_start + multiplier_reach;
+            ++multiplier
+        ) {
+            int base;
+
+            if (multiplier < 1 || multiplier > 15) {
+                continue;
+            }
+            for (base = base_start - base_reach; base <= base_start + base_reach; ++base) {
+                uint64_t indices;
+                uint32_t error;
+
+                if (base < 0 || base > 255) {
+                    continue;
+                }
+                error = pr_eac_fit(texels, base, multiplier, table, best_error, &indices);
+                if (error < best_error) {
+                    best_error = error;
+                    best_bits = ((uint64_t)base << 56) |
+                        ((uint64_t)multiplier << 52) |
+                        ((uint64_t)table << 48) |
+                        indices;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < 8; ++i) {
+        out[i] = (unsigned char)(best_bits >> (56 - 8 * i));
+    }
+}
+
+static void pr_block_encode_row(void *user_data, size_t block_y)
+{
+    const pr_block_encode_job_t *job;
+    unsigned char texels[16][4];
+    /* The encoders take the block read-only; C11 needs the const view made
+     * explicit for pointers to arrays.
+     */
+    const unsigned char (*block)[4];
+    unsigned char *dst;
+    uint32_t block_x;
+    int passes;
+
+    job = (const pr_block_encode_job_t *)user_data;
+    passes = 1 + (int)job->quality;
+    dst = job->out + block_y * (size_t)job->blocks_x * job->block_bytes;
+    block = (const unsigned char (*)[4])texels;
+    for (block_x = 0u; block_x < job->blocks_x; ++block_x) {
+        pr_block_load(job, block_x, (uint32_t)block_y, texels);
+        switch (job->format) {
+        case PR_PAGE_FORMAT_BC1:
+            pr_encode_bc1_color(block, 1, passes, dst);
+            break;
+        case PR_PAGE_FORMAT_BC3:
+            pr_encode_bc3_alpha(block, dst);
+            pr_encode_bc1_color(block, 0, passes, dst + 8);
+            break;
+        case PR_PAGE_FORMAT_BC7:
+            pr_encode_bc7_block(block, passes, dst);
+            break;
+        case PR_PAGE_FORMAT_ETC2_RGB:
+            pr_encode_etc2_color(block, job->quality, dst);
+            break;
+        case PR_PAGE_FORMAT_ETC2_RGBA:
+            pr_encode_eac_alpha(block, job->quality, dst);
+            pr_encode_etc2_color(block, job->quality, dst + 8);
+            break;
+        default:
+            break;
+        }
+        dst += job->block_bytes;
+    }
+}
+
+int pr_block_encode_page(
+    pr_page_format_t format,
+    pr_encode_quality_t quality,
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t stride,
+    unsigned char *out
+)
+{
+    pr_block_encode_job_t job;
+
+    if (rgba == NULL || out == NULL || width == 0u || height == 0u) {
+        return 0;
+    }
+
+    job.format = format;
+    job.quality = quality;
+    job.rgba = rgba;
+    job.width = width;
+    job.height = height;
+    job.stride = stride;
+    job.blocks_x = (width + 3u) / 4u;
+    job.block_bytes = pr_page_format_block_bytes(format);
+    job.out = out;
+    if (job.block_bytes == 0u) {
+        return 0;
+    }
+
+    PR_PROFILE_BEGIN("pr_block_encode_page");
+    pr_parallel_for((size_t)((height + 3u) / 4u), pr_block_encode_row, &job);
+    PR_PROFILE_END("pr_block_encode_page");
+    return 1;
+}
@@ -0,0 +1,25 @@
+#ifndef PACKRAT_BLOCK_ENCODE_H
+#define PACKRAT_BLOCK_ENCODE_H
+
+#include <stdint.h>
+
+#include "page_format.h"
+
+/* Encodes an RGBA8 page into the 4x4 blocks of a block `format`. `out` must
+ * hold the `pr_page_format_layout` data size. Edge blocks of pages that are
+ * not a multiple of 4 repeat the last row/column. Rows of blocks are encoded
+ * in parallel, and the output does not depend on the thread count.
+ *
+ * Returns 0 for formats that are not block formats.
+ */
+int pr_block_encode_page(
+    pr_page_format_t format,
+    pr_encode_quality_t quality,
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t stride,
+    unsigned char *out
+);
+
+#endif
@@ -15,11 +15,30 @@
 #include <direct.h>
 #endif
 
+#include "block_encode.h"
+#include "build_stages.h"
+#include "checksum.h"
+#include "color.h"
+#include "intern.h"
+#include "lz.h"
 #include "manifest.h"
+#include "mipmap.h"
+#include "pack_lock.h"
+#include "page_format.h"
+#include "palette.h"
+#include "parallel.h"
+#include "pixel_encode.h"
+#include "profiler.h"
+#include "timer.h"
 
 #define PR_CHUNK_COUNT_V0 5u
-#define PR_PACKAGE_VERSION_MAJOR 1u
+#define PR_PACKAGE_VERSION_MAJOR 2u
 #define PR_PACKAGE_VERSION_MINOR 0u
+#define PR_PACKAGE_HEADER_SIZE 64u
+#define PR_PACKAGE_CHUNK_ENTRY_SIZE 40u
+#define PR_PACKAGE_ALIGNMENT 64u
+#define PR_PACKAGE_CHUNK_FLAG_CHECKSUM 1u
+#define PR_PACKAGE_CHUNK_CODEC_NONE 0u
 
 #define PR_CHUNK_FORMAT_STRS "STRS"
 #define PR_CHUNK_FORMAT_TXTR "TXTR"
@@ -27,12 +46,19 @@
 #define PR_CHUNK_FORMAT_ANIM "ANIM"
 #define PR_CHUNK_FORMAT_INDX "INDX"
 
+/* v2 adds a format code to every page record; v9 aligns level data. */
+#define PR_TXTR_VERSION 9u
+#define PR_TXTR_DATA_ALIGNMENT 64u
+
+#define PR_BUILD_PATH_MAX 1024u
+
 #define PR_IMAGE_FORMAT_UNKNOWN 0u
 #define PR_IMAGE_FORMAT_PNG 1u
 
 typedef struct pr_build_result_storage {
-    char package_path[PR_MANIFEST_PATH_MAX];
-    char debug_output_path[PR_MANIFEST_PATH_MAX];
+    char package_path[PR_BUILD_PATH_MAX];
+    char debug_output_path[PR_BUILD_PATH_MAX];
+    pr_build_page_stats_t *page_stats;
 } pr_build_result_storage_t;
 
 typedef struct pr_byte_buffer {
@@ -47,14 +73,8 @@ typedef struct pr_chunk_payload {
     size_t size;
 } pr_chunk_payload_t;
 
-typedef struct pr_string_table {
-    char **values;
-    size_t count;
-    size_t capacity;
-} pr_string_table_t;
-
 typedef struct pr_imported_image {
-    char resolved_path[PR_MANIFEST_PATH_MAX];
+    char *resolved_path;
     uint32_t width;
     uint32_t height;
     uint64_t source_bytes;
@@ -99,6 +119,8 @@ typedef struct pr_resolved_frame {
     uint32_t v0_milli;
     uint32_t u1_milli;
     uint32_t v1_milli;
+    pr_color_space_t color_space;
+    pr_alpha_mode_t alpha_mode;
 } pr_resolved_frame_t;
 
 typedef struct pr_pack_page {
@@ -111,6 +133,11 @@ typedef struct pr_pack_page {
     uint32_t shelf_h;
     uint32_t final_w;
     uint32_t final_h;
+    uint32_t frame_count;
+    uint64_t used_pixels;
+    pr_color_space_t color_space;
+    pr_alpha_mode_t alpha_mode;
+    pr_page_format_t format;
 } pr_pack_page_t;
 
 typedef struct pr_resolved_animation {
@@ -215,7 +242,7 @@ static int pr_make_directory_if_missing(const char *path)
 
 static int pr_ensure_parent_directories(const char *file_path)
 {
-    char working[PR_MANIFEST_PATH_MAX];
+    char *working;
     size_t i;
     size_t len;
 
@@ -224,7 +251,8 @@ static int pr_ensure_parent_directories(const char *file_path)
     }
 
     len = strlen(file_path);
-    if (len >= sizeof(working)) {
+    working = (char *)malloc(len + 1u);
+    if (working == NULL) {
         return 0;
     }
     memcpy(working, file_path, len + 1u);
@@ -239,11 +267,13 @@ static int pr_ensure_parent_directories(const char *file_path)
         saved = working[i];
         working[i] = '\0';
         if (working[0] != '\0' && !pr_make_directory_if_missing(working)) {
+            free(working);
             return 0;
         }
         working[i] = saved;
     }
 
+    free(working);
     return 1;
 }
 
@@ -262,119 +292,62 @@ static int pr_has_prpk_extension(const char *path)
     return (strcmp(path + (len - 5u), ".prpk") == 0) ? 1 : 0;
 }
 
-static int pr_manifest_directory(
-    const char *manifest_path,
-    char *out_dir,
-    size_t out_dir_size
-)
-{
-    const char *last_sep;
-    const char *cursor;
-    size_t len;
-
-    if (
-        manifest_path == NULL ||
-        out_dir == NULL ||
-        out_dir_size == 0u
-    ) {
-        return 0;
-    }
-
-    last_sep = NULL;
-    for (cursor = manifest_path; *cursor != '\0'; ++cursor) {
-        if (pr_is_path_separator(*cursor)) {
-            last_sep = cursor;
-        }
-    }
-
-    if (last_sep == NULL) {
-        return pr_copy_string(out_dir, out_dir_size, ".");
-    }
-
-    len = (size_t)(last_sep - manifest_path);
-    if (len == 0u) {
-        if (out_dir_size < 2u) {
-            return 0;
-        }
-        out_dir[0] = '/';
-        out_dir[1] = '\0';
-        return 1;
-    }
-    if (len >= out_dir_size) {
-        return 0;
-    }
-
-    memcpy(out_dir, manifest_path, len);
-    out_dir[len] = '\0';
-    return 1;
-}
-
-static int pr_join_paths(
-    const char *base,
-    const char *tail,
-    char *out_path,
-    size_t out_path_size
-)
+static char *pr_join_paths(const char *base, size_t base_len, const char *tail)
 {
-    size_t base_len;
     size_t tail_len;
     int need_sep;
-    size_t needed;
+    char *joined;
 
-    if (
-        base == NULL ||
-        tail == NULL ||
-        out_path == NULL ||
-        out_path_size == 0u
-    ) {
-        return 0;
+    if (base == NULL || tail == NULL) {
+        return NULL;
     }
 
-    base_len = strlen(base);
     tail_len = strlen(tail);
     need_sep = (base_len > 0u && !pr_is_path_separator(base[base_len - 1u])) ? 1 : 0;
 
-    needed = base_len + (size_t)need_sep + tail_len + 1u;
-    if (needed > out_path_size) {
-        return 0;
+    joined = (char *)malloc(base_len + (size_t)need_sep + tail_len + 1u);
+    if (joined == NULL) {
+        return NULL;
     }
 
-    memcpy(out_path, base, base_len);
+    memcpy(joined, base, base_len);
     if (need_sep != 0) {
-        out_path[base_len] = '/';
-        memcpy(out_path + base_len + 1u, tail, tail_len + 1u);
-    } else {
-        memcpy(out_path + base_len, tail, tail_len + 1u);
+        joined[base_len] = '/';
     }
-    return 1;
+    memcpy(joined + base_len + (size_t)need_sep, tail, tail_len + 1u);
+    return joined;
 }
 
-static int pr_resolve_image_path(
-    const char *manifest_path,
-    const char *image_path,
-    char *out_path,
-    size_t out_path_size
-)
+/* Returns a heap-allocated path for `image_path` relative to the directory
+ * containing the manifest that declared it.
+ */
+static char *pr_resolve_image_path(const char *manifest_path, const char *image_path)
 {
-    char manifest_dir[PR_MANIFEST_PATH_MAX];
+    const char *last_sep;
+    const char *cursor;
 
-    if (
-        manifest_path == NULL ||
-        image_path == NULL ||
-        out_path == NULL ||
-        out_path_size == 0u
-    ) {
-        return 0;
+    if (manifest_path == NULL || image_path == NULL) {
+        return NULL;
     }
 
     if (pr_is_absolute_path(image_path)) {
-        return pr_copy_string(out_path, out_path_size, image_path);
+        return pr_join_paths("", 0u, image_path);
     }
 
-    if (!pr_manifest_directory(manifest_path, manifest_dir, sizeof(manifest_dir))) {
-        return 0;
+    last_sep = NULL;
+    for (cursor = manifest_path; *cursor != '\0'; ++cursor) {
+        if (pr_is_path_separator(*cursor)) {
+            last_sep = cursor;
+        }
+    }
+
+    if (last_sep == NULL) {
+        return pr_join_paths(".", 1u, image_path);
     }
-    return pr_join_paths(manifest_dir, image_path, out_path, out_path_size);
+    if (last_sep == manifest_path) {
+        return pr_join_paths("/", 1u, image_path);
+    }
+    return pr_join_paths(manifest_path, (size_t)(last_sep - manifest_path), image_path);
 }
 
 static unsigned char *pr_read_binary_file(const char *path, size_t *out_size)
@@ -606,6 +579,71 @@ static int pr_decode_png_rgba_file(
     return 1;
 }
 
+static uint32_t pr_read_u32_be(const unsigned char *bytes)
+{
+    return ((uint32_t)bytes[0] << 24) |
+        ((uint32_t)bytes[1] << 16) |
+        ((uint32_t)bytes[2] << 8) |
+        (uint32_t)bytes[3];
+}
+
+/* Reads only the signature and IHDR chunk, which the PNG spec requires to
+ * come first, so image dimensions are known without inflating any pixels.
+ */
+static int pr_read_png_header_file(
+    const char *path,
+    uint32_t *out_width,
+    uint32_t *out_height,
+    int *out_read_failed
+)
+{
+    FILE *file;
+    unsigned char header[24];
+    size_t read_size;
+    uint32_t width;
+    uint32_t height;
+
+    if (path == NULL || out_width == NULL || out_height == NULL || out_read_failed == NULL) {
+        return 0;
+    }
+
+    *out_width = 0u;
+    *out_height = 0u;
+    *out_read_failed = 0;
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        *out_read_failed = 1;
+        return 0;
+    }
+    read_size = fread(header, 1u, sizeof(header), file);
+    if (ferror(file) != 0) {
+        *out_read_failed = 1;
+        (void)fclose(file);
+        return 0;
+    }
+    (void)fclose(file);
+
+    if (
+        read_size != sizeof(header) ||
+        png_sig_cmp((png_const_bytep)header, 0, 8u) != 0 ||
+        pr_read_u32_be(header + 8) != 13u ||
+        memcmp(header + 12, "IHDR", 4u) != 0
+    ) {
+        return 0;
+    }
+
+    width = pr_read_u32_be(header + 16);
+    height = pr_read_u32_be(header + 20);
+    if (width == 0u || height == 0u || width > 0x7FFFFFFFu || height > 0x7FFFFFFFu) {
+        return 0;
+    }
+
+    *out_width = width;
+    *out_height = height;
+    return 1;
+}
+
 static void pr_imported_images_free(pr_imported_image_t *images, size_t count)
 {
     size_t i;
@@ -614,6 +652,8 @@ static void pr_imported_images_free(pr_imported_image_t *images, size_t count)
         return;
     }
     for (i = 0u; i < count; ++i) {
+        free(images[i].resolved_path);
+        images[i].resolved_path = NULL;
         free(images[i].pixels);
         images[i].pixels = NULL;
         images[i].pixel_bytes = 0u;
@@ -661,7 +701,7 @@ static pr_status_t pr_import_manifest_images(
         size_t byte_size;
 
         image = &manifest->images[i];
-        if (image->has_path == 0 || image->path[0] == '\0') {
+        if (image->has_path == 0 || pr_manifest_string(manifest, image->path)[0] == '\0') {
             pr_emit_diag(
                 diag_sink,
                 diag_user_data,
@@ -669,17 +709,16 @@ static pr_status_t pr_import_manifest_images(
                 "Image path is missing during import stage.",
                 manifest_path,
                 "build.images.path_missing",
-                image->id
+                pr_manifest_string(manifest, image->id)
             );
             continue;
         }
 
-        if (!pr_resolve_image_path(
-                manifest_path,
-                image->path,
-                images[i].resolved_path,
-                sizeof(images[i].resolved_path)
-            )) {
+        images[i].resolved_path = pr_resolve_image_path(
+            pr_manifest_entry_path(manifest, image->file, manifest_path),
+            pr_manifest_string(manifest, image->path)
+        );
+        if (images[i].resolved_path == NULL) {
             pr_emit_diag(
                 diag_sink,
                 diag_user_data,
@@ -687,7 +726,7 @@ static pr_status_t pr_import_manifest_images(
                 "Failed to resolve image path.",
                 manifest_path,
                 "build.images.path_resolve_failed",
-                image->id
+                pr_manifest_string(manifest, image->id)
             );
             continue;
         }
@@ -702,7 +741,7 @@ static pr_status_t pr_import_manifest_images(
                 "Failed to read image file.",
                 images[i].resolved_path,
                 "build.images.read_failed",
-                image->id
+                pr_manifest_string(manifest, image->id)
             );
             continue;
         }
@@ -725,7 +764,7 @@ static pr_status_t pr_import_manifest_images(
                 "Unsupported image format or invalid PNG data.",
                 images[i].resolved_path,
                 "build.images.format_unsupported",
-                image->id
+                pr_manifest_string(manifest, image->id)
             );
             continue;
         }
@@ -745,6 +784,231 @@ static pr_status_t pr_import_manifest_images(
     return PR_STATUS_OK;
 }
 
+typedef struct pr_premultiply_batch {
+    const pr_manifest_t *manifest;
+    pr_imported_image_t *images;
+    /* 256x256 lookup tables indexed by pr_color_space_t. */
+    const unsigned char *tables[2];
+} pr_premultiply_batch_t;
+
+static void pr_premultiply_batch_run(void *user_data, size_t index)
+{
+    pr_premultiply_batch_t *batch;
+    const pr_manifest_image_t *image;
+    pr_imported_image_t *imported;
+    pr_color_space_t color_space;
+    uint32_t row;
+
+    batch = (pr_premultiply_batch_t *)user_data;
+    image = &batch->manifest->images[index];
+    imported = &batch->images[index];
+    if (image->premultiply_alpha == 0 || imported->pixels == NULL) {
+        return;
+    }
+    if (!pr_color_space_from_name(
+            pr_manifest_string(batch->manifest, image->color_space),
+            &color_space
+        )) {
+        color_space = PR_COLOR_SPACE_SRGB;
+    }
+    for (row = 0u; row < imported->height; ++row) {
+        pr_color_premultiply_rgba(
+            imported->pixels + (size_t)row * imported->row_bytes,
+            (size_t)imported->width,
+            batch->tables[color_space]
+        );
+    }
+}
+
+/* Applies `premultiply_alpha` to decoded images, one image per task. The
+ * lookup tables are only built for color spaces that need them.
+ */
+static pr_status_t pr_premultiply_imported_images(
+    const pr_manifest_t *manifest,
+    pr_imported_image_t *images
+)
+{
+    pr_premultiply_batch_t batch;
+    unsigned char *tables[2];
+    size_t i;
+
+    tables[0] = NULL;
+    tables[1] = NULL;
+    for (i = 0u; i < manifest->image_count; ++i) {
+        pr_color_space_t color_space;
+
+        if (manifest->images[i].premultiply_alpha == 0) {
+            continue;
+        }
+        if (!pr_color_space_from_name(
+                pr_manifest_string(manifest, manifest->images[i].color_space),
+                &color_space
+            )) {
+            color_space = PR_COLOR_SPACE_SRGB;
+        }
+        if (tables[color_space] != NULL) {
+            continue;
+        }
+        tables[color_space] = (unsigned char *)malloc(256u * 256u);
+        if (tables[color_space] == NULL) {
+            free(tables[0]);
+            free(tables[1]);
+            return PR_STATUS_ALLOCATION_FAILED;
+        }
+        pr_color_premultiply_table(color_space, tables[color_space]);
+    }
+    if (tables[0] == NULL && tables[1] == NULL) {
+        return PR_STATUS_OK;
+    }
+
+    batch.manifest = manifest;
+    batch.images = images;
+    batch.tables[0] = tables[0];
+    batch.tables[1] = tables[1];
+    pr_parallel_for(manifest->image_count, pr_premultiply_batch_run, &batch);
+    free(tables[0]);
+    free(tables[1]);
+    return PR_STATUS_OK;
+}
+
+typedef struct pr_image_header_batch {
+    pr_imported_image_t *images;
+    unsigned char *read_failed;
+} pr_image_header_batch_t;
+
+static void pr_image_header_batch_run(void *user_data, size_t index)
+{
+    pr_image_header_batch_t *batch;
+    pr_imported_image_t *image;
+    int read_failed;
+
+    batch = (pr_image_header_batch_t *)user_data;
+    image = &batch->images[index];
+    if (image->resolved_path == NULL) {
+        return;
+    }
+
+    if (pr_read_png_header_file(
+            image->resolved_path,
+            &image->width,
+            &image->height,
+            &read_failed
+        )) {
+        image->format = PR_IMAGE_FORMAT_PNG;
+    }
+    batch->read_failed[index] = (read_failed != 0) ? 1u : 0u;
+}
+
+/* Same contract and diagnostics as pr_import_manifest_images, but only the
+ * dimensions are filled in: `pixels` stays NULL. Headers are read in parallel
+ * and diagnostics are reported afterwards in manifest order.
+ */
+static pr_status_t pr_import_manifest_image_headers(
+    const char *manifest_path,
+    const pr_manifest_t *manifest,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data,
+    pr_imported_image_t **out_images
+)
+{
+    pr_imported_image_t *images;
+    pr_image_header_batch_t batch;
+    size_t i;
+    int had_io_error;
+    int had_error;
+
+    if (
+        manifest_path == NULL ||
+        manifest == NULL ||
+        out_images == NULL
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    *out_images = NULL;
+    if (manifest->image_count == 0u) {
+        return PR_STATUS_OK;
+    }
+
+    images = (pr_imported_image_t *)calloc(
+        manifest->image_count,
+        sizeof(images[0])
+    );
+    batch.read_failed = (unsigned char *)calloc(manifest->image_count, 1u);
+    if (images == NULL || batch.read_failed == NULL) {
+        free(images);
+        free(batch.read_failed);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    batch.images = images;
+
+    for (i = 0u; i < manifest->image_count; ++i) {
+        const pr_manifest_image_t *image;
+
+        image = &manifest->images[i];
+        if (image->has_path == 0 || pr_manifest_string(manifest, image->path)[0] == '\0') {
+            continue;
+        }
+        images[i].resolved_path = pr_resolve_image_path(
+            pr_manifest_entry_path(manifest, image->file, manifest_path),
+            pr_manifest_string(manifest, image->path)
+        );
+    }
+
+    pr_parallel_for(manifest->image_count, pr_image_header_batch_run, &batch);
+
+    had_io_error = 0;
+    had_error = 0;
+    for (i = 0u; i < manifest->image_count; ++i) {
+        const pr_manifest_image_t *image;
+        const char *message;
+        const char *file;
+        const char *code;
+
+        image = &manifest->images[i];
+        if (images[i].format == PR_IMAGE_FORMAT_PNG) {
+            continue;
+        }
+
+        had_error = 1;
+        file = images[i].resolved_path;
+        if (image->has_path == 0 || pr_manifest_string(manifest, image->path)[0] == '\0') {
+            message = "Image path is missing during import stage.";
+            file = manifest_path;
+            code = "build.images.path_missing";
+        } else if (images[i].resolved_path == NULL) {
+            message = "Failed to resolve image path.";
+            file = manifest_path;
+            code = "build.images.path_resolve_failed";
+        } else if (batch.read_failed[i] != 0u) {
+            had_io_error = 1;
+            message = "Failed to read image file.";
+            code = "build.images.read_failed";
+        } else {
+            message = "Unsupported image format or invalid PNG data.";
+            code = "build.images.format_unsupported";
+        }
+        pr_emit_diag(
+            diag_sink,
+            diag_user_data,
+            PR_DIAG_ERROR,
+            message,
+            file,
+            code,
+            pr_manifest_string(manifest, image->id)
+        );
+    }
+
+    free(batch.read_failed);
+    if (had_error != 0) {
+        pr_imported_images_free(images, manifest->image_count);
+        return (had_io_error != 0) ? PR_STATUS_IO_ERROR : PR_STATUS_VALIDATION_ERROR;
+    }
+
+    *out_images = images;
+    return PR_STATUS_OK;
+}
+
 static int pr_reserve_array(
     void **buffer,
     size_t *capacity,
@@ -894,119 +1158,60 @@ static int pr_byte_buffer_append_u64_le(pr_byte_buffer_t *buffer, uint64_t value
     return pr_byte_buffer_append(buffer, bytes, sizeof(bytes));
 }
 
-static void pr_string_table_init(pr_string_table_t *table)
+/* Appends zero bytes until the size is a multiple of `alignment`. */
+static int pr_byte_buffer_pad(pr_byte_buffer_t *buffer, size_t alignment)
 {
-    if (table == NULL) {
-        return;
+    size_t padded;
+
+    if (buffer == NULL || alignment == 0u) {
+        return 0;
+    }
+    padded = ((buffer->size + alignment - 1u) / alignment) * alignment;
+    if (!pr_byte_buffer_reserve(buffer, padded)) {
+        return 0;
     }
-    memset(table, 0, sizeof(*table));
+
+    memset(buffer->data + buffer->size, 0, padded - buffer->size);
+    buffer->size = padded;
+    return 1;
 }
 
-static void pr_string_table_free(pr_string_table_t *table)
+static uint32_t *pr_handle_index_map_create(size_t handle_count)
 {
-    size_t i;
-
-    if (table == NULL) {
-        return;
-    }
+    uint32_t *map;
 
-    for (i = 0u; i < table->count; ++i) {
-        free(table->values[i]);
+    map = (uint32_t *)malloc((handle_count == 0u ? 1u : handle_count) * sizeof(map[0]));
+    if (map == NULL) {
+        return NULL;
     }
-    free(table->values);
-    table->values = NULL;
-    table->count = 0u;
-    table->capacity = 0u;
+    memset(map, 0xFF, (handle_count == 0u ? 1u : handle_count) * sizeof(map[0]));
+    return map;
 }
 
-static int pr_string_table_add(
-    pr_string_table_t *table,
-    const char *value,
-    uint32_t *out_index
+static long pr_handle_index_map_find(
+    const pr_intern_pool_t *pool,
+    const uint32_t *map,
+    size_t map_count,
+    const char *value
 )
 {
-    size_t i;
-    char *copied;
-
-    if (table == NULL || value == NULL || out_index == NULL) {
-        return 0;
-    }
+    uint32_t handle;
 
-    for (i = 0u; i < table->count; ++i) {
-        if (strcmp(table->values[i], value) == 0) {
-            *out_index = (uint32_t)i;
-            return 1;
-        }
+    if (pool == NULL || map == NULL || value == NULL) {
+        return -1;
     }
-
-    if (table->count + 1u > table->capacity) {
-        size_t new_capacity;
-        char **grown;
-
-        new_capacity = (table->capacity == 0u) ? 16u : table->capacity * 2u;
-        grown = (char **)realloc(table->values, new_capacity * sizeof(table->values[0]));
-        if (grown == NULL) {
-            return 0;
-        }
-        table->values = grown;
-        table->capacity = new_capacity;
+    if (!pr_intern_pool_find(pool, value, &handle) || (size_t)handle >= map_count) {
+        return -1;
     }
-
-    copied = (char *)malloc(strlen(value) + 1u);
-    if (copied == NULL) {
-        return 0;
+    if (map[handle] == 0xFFFFFFFFu) {
+        return -1;
     }
-    memcpy(copied, value, strlen(value) + 1u);
-
-    table->values[table->count] = copied;
-    *out_index = (uint32_t)table->count;
-    table->count += 1u;
-    return 1;
+    return (long)map[handle];
 }
 
-static long pr_find_image_index(const pr_manifest_t *manifest, const char *image_id)
+static uint32_t pr_pivot_to_milli(double pivot)
 {
-    size_t i;
-
-    if (manifest == NULL || image_id == NULL) {
-        return -1;
-    }
-
-    for (i = 0u; i < manifest->image_count; ++i) {
-        if (manifest->images[i].has_id == 0) {
-            continue;
-        }
-        if (strcmp(manifest->images[i].id, image_id) == 0) {
-            return (long)i;
-        }
-    }
-
-    return -1;
-}
-
-static long pr_find_sprite_index(const pr_manifest_t *manifest, const char *sprite_id)
-{
-    size_t i;
-
-    if (manifest == NULL || sprite_id == NULL) {
-        return -1;
-    }
-
-    for (i = 0u; i < manifest->sprite_count; ++i) {
-        if (manifest->sprites[i].has_id == 0) {
-            continue;
-        }
-        if (strcmp(manifest->sprites[i].id, sprite_id) == 0) {
-            return (long)i;
-        }
-    }
-
-    return -1;
-}
-
-static uint32_t pr_pivot_to_milli(double pivot)
-{
-    long value;
+    long value;
 
     if (pivot < 0.0) {
         pivot = 0.0;
@@ -1072,6 +1277,8 @@ static pr_status_t pr_resolve_sprite_frames(
     size_t frame_count;
     size_t frame_capacity;
     size_t sprite_index;
+    size_t i;
+    int bounds_error_count;
 
     if (
         manifest == NULL ||
@@ -1105,6 +1312,7 @@ static pr_status_t pr_resolve_sprite_frames(
     frames = NULL;
     frame_count = 0u;
     frame_capacity = 0u;
+    bounds_error_count = 0;
 
     for (sprite_index = 0u; sprite_index < manifest->sprite_count; ++sprite_index) {
         const pr_manifest_sprite_t *sprite;
@@ -1144,8 +1352,7 @@ static pr_status_t pr_resolve_sprite_frames(
             h = (sprite->has_h != 0 && sprite->h > 0) ? (uint32_t)sprite->h : image->height;
 
             if (x + w > image->width || y + h > image->height) {
-                free(frames);
-                free(sprites);
+                bounds_error_count += 1;
                 pr_emit_diag(
                     diag_sink,
                     diag_user_data,
@@ -1153,9 +1360,9 @@ static pr_status_t pr_resolve_sprite_frames(
                     "Single sprite source rectangle exceeds source image bounds.",
                     image->resolved_path,
                     "build.sprite.single_rect_oob",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
-                return PR_STATUS_VALIDATION_ERROR;
+                continue;
             }
 
             memset(&frame, 0, sizeof(frame));
@@ -1174,7 +1381,9 @@ static pr_status_t pr_resolve_sprite_frames(
             }
         } else if (sprite->mode == PR_MANIFEST_SPRITE_MODE_RECTS) {
             size_t rect_index;
+            int rect_oob;
 
+            rect_oob = 0;
             for (rect_index = 0u; rect_index < sprite->rect_count; ++rect_index) {
                 const pr_manifest_sprite_rect_t *rect;
                 pr_resolved_frame_t frame;
@@ -1190,8 +1399,7 @@ static pr_status_t pr_resolve_sprite_frames(
                 h = (uint32_t)rect->h;
 
                 if (x + w > image->width || y + h > image->height) {
-                    free(frames);
-                    free(sprites);
+                    rect_oob = 1;
                     pr_emit_diag(
                         diag_sink,
                         diag_user_data,
@@ -1199,9 +1407,9 @@ static pr_status_t pr_resolve_sprite_frames(
                         "Rect sprite source rectangle exceeds source image bounds.",
                         image->resolved_path,
                         "build.sprite.rect_oob",
-                        sprite->id
+                        pr_manifest_string(manifest, sprite->id)
                     );
-                    return PR_STATUS_VALIDATION_ERROR;
+                    break;
                 }
 
                 memset(&frame, 0, sizeof(frame));
@@ -1219,6 +1427,11 @@ static pr_status_t pr_resolve_sprite_frames(
                     return PR_STATUS_ALLOCATION_FAILED;
                 }
             }
+            if (rect_oob != 0) {
+                bounds_error_count += 1;
+                frame_count = (size_t)resolved->first_frame;
+                continue;
+            }
         } else if (sprite->mode == PR_MANIFEST_SPRITE_MODE_GRID) {
             uint32_t margin_x;
             uint32_t margin_y;
@@ -1245,8 +1458,7 @@ static pr_status_t pr_resolve_sprite_frames(
             cell_h = (uint32_t)sprite->cell_h;
 
             if (image->width < margin_x + cell_w || image->height < margin_y + cell_h) {
-                free(frames);
-                free(sprites);
+                bounds_error_count += 1;
                 pr_emit_diag(
                     diag_sink,
                     diag_user_data,
@@ -1254,9 +1466,9 @@ static pr_status_t pr_resolve_sprite_frames(
                     "Grid sprite has no valid cells in source image.",
                     image->resolved_path,
                     "build.sprite.grid_no_cells",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
-                return PR_STATUS_VALIDATION_ERROR;
+                continue;
             }
 
             cols = 1u + (image->width - margin_x - cell_w) / (cell_w + spacing_x);
@@ -1265,8 +1477,7 @@ static pr_status_t pr_resolve_sprite_frames(
             frame_start = (sprite->has_frame_start != 0 && sprite->frame_start > 0) ?
                 (uint32_t)sprite->frame_start : 0u;
             if (frame_start >= total_cells) {
-                free(frames);
-                free(sprites);
+                bounds_error_count += 1;
                 pr_emit_diag(
                     diag_sink,
                     diag_user_data,
@@ -1274,9 +1485,9 @@ static pr_status_t pr_resolve_sprite_frames(
                     "Grid sprite frame_start exceeds available cell count.",
                     image->resolved_path,
                     "build.sprite.grid_frame_start_oob",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
-                return PR_STATUS_VALIDATION_ERROR;
+                continue;
             }
 
             if (sprite->has_frame_count != 0) {
@@ -1286,8 +1497,7 @@ static pr_status_t pr_resolve_sprite_frames(
             }
 
             if (frame_start + frame_count_target > total_cells) {
-                free(frames);
-                free(sprites);
+                bounds_error_count += 1;
                 pr_emit_diag(
                     diag_sink,
                     diag_user_data,
@@ -1295,9 +1505,9 @@ static pr_status_t pr_resolve_sprite_frames(
                     "Grid sprite frame range exceeds available cell count.",
                     image->resolved_path,
                     "build.sprite.grid_frame_count_oob",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
-                return PR_STATUS_VALIDATION_ERROR;
+                continue;
             }
 
             for (i = 0u; i < frame_count_target; ++i) {
@@ -1342,12 +1552,35 @@ static pr_status_t pr_resolve_sprite_frames(
                 "Sprite resolved to zero frames.",
                 manifest_path,
                 "build.sprite.zero_frames",
-                sprite->id
+                pr_manifest_string(manifest, sprite->id)
             );
             return PR_STATUS_VALIDATION_ERROR;
         }
     }
 
+    if (bounds_error_count > 0) {
+        free(frames);
+        free(sprites);
+        return PR_STATUS_VALIDATION_ERROR;
+    }
+
+    /* Frames keep their image's color space and alpha mode; the packer only
+     * shares a page between frames that agree on both.
+     */
+    for (i = 0u; i < frame_count; ++i) {
+        const pr_manifest_image_t *image;
+
+        image = &manifest->images[sprites[frames[i].sprite_index].source_image_index];
+        if (!pr_color_space_from_name(
+                pr_manifest_string(manifest, image->color_space),
+                &frames[i].color_space
+            )) {
+            frames[i].color_space = PR_COLOR_SPACE_SRGB;
+        }
+        frames[i].alpha_mode = (image->premultiply_alpha != 0) ?
+            PR_ALPHA_MODE_PREMULTIPLIED : PR_ALPHA_MODE_STRAIGHT;
+    }
+
     *out_sprites = sprites;
     *out_sprite_count = manifest->sprite_count;
     *out_frames = frames;
@@ -1447,12 +1680,53 @@ static int pr_pack_item_compare(const void *lhs, const void *rhs)
     return 0;
 }
 
-static pr_status_t pr_pack_resolved_frames(
+static pr_atlas_layout_t pr_manifest_atlas_layout(const pr_manifest_t *manifest)
+{
+    pr_atlas_layout_t layout;
+
+    if (!pr_atlas_layout_from_name(pr_manifest_string(manifest, manifest->atlas.layout), &layout)) {
+        return PR_ATLAS_LAYOUT_PAGES;
+    }
+    return layout;
+}
+
+/* Padded cell size of a frame: padding on every side, then whole mip cells
+ * so frames stay apart in the first few mip levels.
+ */
+static uint32_t pr_pack_frame_extent(uint32_t size, uint32_t padding, uint32_t cell)
+{
+    uint32_t extent;
+
+    extent = size + padding * 2u;
+    return (extent + cell - 1u) / cell * cell;
+}
+
+static uint32_t pr_pack_cell_size(const pr_manifest_t *manifest)
+{
+    return (manifest->atlas.mipmaps != 0) ? PR_MIPMAP_ALIGN : 1u;
+}
+
+static void pr_pack_page_init(
+    pr_pack_page_t *page,
+    const pr_manifest_t *manifest,
+    pr_color_space_t color_space,
+    pr_alpha_mode_t alpha_mode
+)
+{
+    memset(page, 0, sizeof(*page));
+    page->max_w = (uint32_t)manifest->atlas.max_page_width;
+    page->max_h = (uint32_t)manifest->atlas.max_page_height;
+    page->color_space = color_space;
+    page->alpha_mode = alpha_mode;
+}
+
+/* Fresh shelf pack of `items` (already sorted) into new pages. */
+static pr_status_t pr_pack_items_shelf(
     const pr_manifest_t *manifest,
     pr_resolved_frame_t *frames,
-    size_t frame_count,
-    pr_diag_sink_fn diag_sink,
-    void *diag_user_data,
+    const pr_pack_item_t *items,
+    size_t item_count,
+    uint32_t padding,
     pr_pack_page_t **out_pages,
     size_t *out_page_count
 )
@@ -1460,76 +1734,26 @@ static pr_status_t pr_pack_resolved_frames(
     pr_pack_page_t *pages;
     size_t page_count;
     size_t page_capacity;
-    pr_pack_item_t *items;
     size_t i;
-    uint32_t padding;
 
-    if (
-        manifest == NULL ||
-        (frame_count > 0u && frames == NULL) ||
-        out_pages == NULL ||
-        out_page_count == NULL
-    ) {
-        return PR_STATUS_INVALID_ARGUMENT;
-    }
-
-    *out_pages = NULL;
-    *out_page_count = 0u;
-    if (frame_count == 0u) {
-        return PR_STATUS_OK;
-    }
-
-    padding = (manifest->atlas.padding > 0) ? (uint32_t)manifest->atlas.padding : 0u;
     pages = NULL;
     page_count = 0u;
     page_capacity = 0u;
-    items = (pr_pack_item_t *)calloc(frame_count, sizeof(items[0]));
-    if (items == NULL) {
-        return PR_STATUS_ALLOCATION_FAILED;
-    }
-
-    for (i = 0u; i < frame_count; ++i) {
-        uint32_t padded_w;
-        uint32_t padded_h;
-
-        padded_w = frames[i].source_w + padding * 2u;
-        padded_h = frames[i].source_h + padding * 2u;
-        if (
-            padded_w > (uint32_t)manifest->atlas.max_page_width ||
-            padded_h > (uint32_t)manifest->atlas.max_page_height
-        ) {
-            free(items);
-            pr_emit_diag(
-                diag_sink,
-                diag_user_data,
-                PR_DIAG_ERROR,
-                "Frame is too large for atlas page constraints.",
-                NULL,
-                "build.atlas.frame_too_large",
-                NULL
-            );
-            return PR_STATUS_VALIDATION_ERROR;
-        }
-        items[i].frame_index = (uint32_t)i;
-        items[i].padded_w = padded_w;
-        items[i].padded_h = padded_h;
-        items[i].area = (uint64_t)padded_w * (uint64_t)padded_h;
-        items[i].sprite_index = frames[i].sprite_index;
-        items[i].local_frame_index = frames[i].local_frame_index;
-    }
-
-    qsort(items, frame_count, sizeof(items[0]), pr_pack_item_compare);
-
-    for (i = 0u; i < frame_count; ++i) {
+    for (i = 0u; i < item_count; ++i) {
+        pr_resolved_frame_t *frame;
         size_t page_index;
-        int placed;
+        uint32_t atlas_x;
+        uint32_t atlas_y;
 
-        placed = 0;
+        frame = &frames[items[i].frame_index];
         for (page_index = 0u; page_index < page_count; ++page_index) {
-            uint32_t atlas_x;
-            uint32_t atlas_y;
-
-            if (!pr_place_frame_in_page(
+            if (
+                pages[page_index].color_space != frame->color_space ||
+                pages[page_index].alpha_mode != frame->alpha_mode
+            ) {
+                continue;
+            }
+            if (pr_place_frame_in_page(
                     &pages[page_index],
                     items[i].padded_w,
                     items[i].padded_h,
@@ -1537,39 +1761,21 @@ static pr_status_t pr_pack_resolved_frames(
                     &atlas_x,
                     &atlas_y
                 )) {
-                continue;
+                break;
             }
-
-            frames[items[i].frame_index].atlas_page = (uint32_t)page_index;
-            frames[items[i].frame_index].atlas_x = atlas_x;
-            frames[items[i].frame_index].atlas_y = atlas_y;
-            placed = 1;
-            break;
-        }
-
-        if (placed != 0) {
-            continue;
         }
 
-        if (!pr_reserve_array(
-                (void **)&pages,
-                &page_capacity,
-                page_count + 1u,
-                sizeof(pages[0])
-            )) {
-            free(items);
-            free(pages);
-            return PR_STATUS_ALLOCATION_FAILED;
-        }
-
-        memset(&pages[page_count], 0, sizeof(pages[0]));
-        pages[page_count].max_w = (uint32_t)manifest->atlas.max_page_width;
-        pages[page_count].max_h = (uint32_t)manifest->atlas.max_page_height;
-
-        {
-            uint32_t atlas_x;
-            uint32_t atlas_y;
-
+        if (page_index == page_count) {
+            if (!pr_reserve_array(
+                    (void **)&pages,
+                    &page_capacity,
+                    page_count + 1u,
+                    sizeof(pages[0])
+                )) {
+                free(pages);
+                return PR_STATUS_ALLOCATION_FAILED;
+            }
+            pr_pack_page_init(&pages[page_count], manifest, frame->color_space, frame->alpha_mode);
             if (!pr_place_frame_in_page(
                     &pages[page_count],
                     items[i].padded_w,
@@ -1578,84 +1784,778 @@ static pr_status_t pr_pack_resolved_frames(
                     &atlas_x,
                     &atlas_y
                 )) {
-                free(items);
                 free(pages);
                 return PR_STATUS_VALIDATION_ERROR;
             }
-
-            frames[items[i].frame_index].atlas_page = (uint32_t)page_count;
-            frames[items[i].frame_index].atlas_x = atlas_x;
-            frames[items[i].frame_index].atlas_y = atlas_y;
+            page_count += 1u;
         }
-        page_count += 1u;
+
+        frame->atlas_page = (uint32_t)page_index;
+        frame->atlas_x = atlas_x;
+        frame->atlas_y = atlas_y;
     }
 
-    for (i = 0u; i < page_count; ++i) {
-        uint32_t final_w;
-        uint32_t final_h;
+    *out_pages = pages;
+    *out_page_count = page_count;
+    return PR_STATUS_OK;
+}
 
-        final_w = (pages[i].used_w > 0u) ? pages[i].used_w : 1u;
-        final_h = (pages[i].used_h > 0u) ? pages[i].used_h : 1u;
-        if (manifest->atlas.power_of_two != 0) {
-            final_w = pr_round_up_pow2_u32(final_w);
-            final_h = pr_round_up_pow2_u32(final_h);
-            if (final_w > pages[i].max_w) {
-                final_w = pages[i].max_w;
-            }
-            if (final_h > pages[i].max_h) {
-                final_h = pages[i].max_h;
+/* Occupied rectangles of one page for the incremental packer, bucketed into
+ * a coarse grid so overlap tests only look at nearby frames.
+ */
+#define PR_PACK_GRID_CELL 64u
+#define PR_PACK_GRID_NONE UINT32_MAX
+
+typedef struct pr_pack_rect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+    uint32_t h;
+} pr_pack_rect_t;
+
+typedef struct pr_pack_space {
+    uint32_t max_w;
+    uint32_t max_h;
+    uint32_t grid_w;
+    uint32_t grid_h;
+    uint32_t *cell_head;
+    uint32_t *node_next;
+    uint32_t *node_rect;
+    size_t node_count;
+    size_t node_capacity;
+    size_t next_capacity;
+    pr_pack_rect_t *rects;
+    size_t rect_count;
+    size_t rect_capacity;
+    uint32_t used_w;
+    uint32_t used_h;
+    uint64_t free_area;
+    /* Smallest size that did not fit; anything at least as large is
+     * rejected without a search, since space only ever fills up.
+     */
+    uint32_t fail_w;
+    uint32_t fail_h;
+} pr_pack_space_t;
+
+static int pr_pack_space_init(pr_pack_space_t *space, uint32_t max_w, uint32_t max_h)
+{
+    size_t cell_count;
+    size_t i;
+
+    memset(space, 0, sizeof(*space));
+    space->max_w = max_w;
+    space->max_h = max_h;
+    space->free_area = (uint64_t)max_w * (uint64_t)max_h;
+    space->fail_w = UINT32_MAX;
+    space->fail_h = UINT32_MAX;
+    space->grid_w = (max_w + PR_PACK_GRID_CELL - 1u) / PR_PACK_GRID_CELL;
+    space->grid_h = (max_h + PR_PACK_GRID_CELL - 1u) / PR_PACK_GRID_CELL;
+    cell_count = (size_t)space->grid_w * (size_t)space->grid_h;
+    space->cell_head = (uint32_t *)malloc((cell_count > 0u ? cell_count : 1u) * sizeof(space->cell_head[0]));
+    if (space->cell_head == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < cell_count; ++i) {
+        space->cell_head[i] = PR_PACK_GRID_NONE;
+    }
+    return 1;
+}
+
+static void pr_pack_space_free(pr_pack_space_t *space)
+{
+    free(space->cell_head);
+    free(space->node_next);
+    free(space->node_rect);
+    free(space->rects);
+    memset(space, 0, sizeof(*space));
+}
+
+static int pr_pack_space_overlaps(const pr_pack_space_t *space, const pr_pack_rect_t *rect)
+{
+    uint32_t cell_x;
+    uint32_t cell_y;
+
+    for (cell_y = rect->y / PR_PACK_GRID_CELL; cell_y <= (rect->y + rect->h - 1u) / PR_PACK_GRID_CELL; ++cell_y) {
+        for (cell_x = rect->x / PR_PACK_GRID_CELL; cell_x <= (rect->x + rect->w - 1u) / PR_PACK_GRID_CELL; ++cell_x) {
+            uint32_t node;
+
+            node = space->cell_head[(size_t)cell_y * space->grid_w + cell_x];
+            while (node != PR_PACK_GRID_NONE) {
+                const pr_pack_rect_t *other;
+
+                other = &space->rects[space->node_rect[node]];
+                if (
+                    rect->x < other->x + other->w &&
+                    other->x < rect->x + rect->w &&
+                    rect->y < other->y + other->h &&
+                    other->y < rect->y + rect->h
+                ) {
+                    return 1;
+                }
+                node = space->node_next[node];
             }
         }
-        pages[i].final_w = final_w;
-        pages[i].final_h = final_h;
     }
+    return 0;
+}
 
-    for (i = 0u; i < frame_count; ++i) {
-        pr_pack_page_t *page;
+/* `rect` must lie inside the page and not overlap anything already added. */
+static int pr_pack_space_add(pr_pack_space_t *space, const pr_pack_rect_t *rect)
+{
+    uint32_t cell_x;
+    uint32_t cell_y;
+    uint32_t rect_index;
 
-        page = &pages[frames[i].atlas_page];
-        frames[i].atlas_w = frames[i].source_w;
-        frames[i].atlas_h = frames[i].source_h;
-        frames[i].u0_milli = (uint32_t)(((uint64_t)frames[i].atlas_x * 1000000u) / page->final_w);
-        frames[i].v0_milli = (uint32_t)(((uint64_t)frames[i].atlas_y * 1000000u) / page->final_h);
-        frames[i].u1_milli = (uint32_t)(((uint64_t)(frames[i].atlas_x + frames[i].atlas_w) * 1000000u) / page->final_w);
-        frames[i].v1_milli = (uint32_t)(((uint64_t)(frames[i].atlas_y + frames[i].atlas_h) * 1000000u) / page->final_h);
+    if (!pr_reserve_array(
+            (void **)&space->rects,
+            &space->rect_capacity,
+            space->rect_count + 1u,
+            sizeof(space->rects[0])
+        )) {
+        return 0;
     }
+    rect_index = (uint32_t)space->rect_count;
+    space->rects[space->rect_count++] = *rect;
 
-    free(items);
-    *out_pages = pages;
-    *out_page_count = page_count;
-    return PR_STATUS_OK;
+    for (cell_y = rect->y / PR_PACK_GRID_CELL; cell_y <= (rect->y + rect->h - 1u) / PR_PACK_GRID_CELL; ++cell_y) {
+        for (cell_x = rect->x / PR_PACK_GRID_CELL; cell_x <= (rect->x + rect->w - 1u) / PR_PACK_GRID_CELL; ++cell_x) {
+            uint32_t *head;
+
+            if (
+                !pr_reserve_array(
+                    (void **)&space->node_next,
+                    &space->next_capacity,
+                    space->node_count + 1u,
+                    sizeof(space->node_next[0])
+                ) ||
+                !pr_reserve_array(
+                    (void **)&space->node_rect,
+                    &space->node_capacity,
+                    space->node_count + 1u,
+                    sizeof(space->node_rect[0])
+                )
+            ) {
+                return 0;
+            }
+            head = &space->cell_head[(size_t)cell_y * space->grid_w + cell_x];
+            space->node_rect[space->node_count] = rect_index;
+            space->node_next[space->node_count] = *head;
+            *head = (uint32_t)space->node_count;
+            space->node_count += 1u;
+        }
+    }
+
+    space->free_area -= (uint64_t)rect->w * (uint64_t)rect->h;
+    if (rect->x + rect->w > space->used_w) {
+        space->used_w = rect->x + rect->w;
+    }
+    if (rect->y + rect->h > space->used_h) {
+        space->used_h = rect->y + rect->h;
+    }
+    return 1;
 }
 
-static pr_status_t pr_resolve_animations(
-    const pr_manifest_t *manifest,
-    const pr_index_maps_t *maps,
-    const pr_resolved_sprite_t *sprites,
-    size_t sprite_count,
-    pr_diag_sink_fn diag_sink,
-    void *diag_user_data,
-    pr_resolved_animation_t **out_animations,
-    size_t *out_animation_count,
-    pr_resolved_animation_key_t **out_keys,
-    size_t *out_key_count
+/* Tries the bottom-left corners next to every placed rectangle and keeps
+ * the free one that grows the used area least, then the topmost, then the
+ * leftmost.
+ */
+static int pr_pack_space_find(
+    pr_pack_space_t *space,
+    uint32_t w,
+    uint32_t h,
+    uint32_t *out_x,
+    uint32_t *out_y
 )
 {
-    pr_resolved_animation_t *animations;
-    pr_resolved_animation_key_t *keys;
-    size_t key_count;
-    size_t key_capacity;
-    size_t animation_index;
+    uint64_t best_area;
+    uint32_t best_x;
+    uint32_t best_y;
+    size_t i;
+    int found;
 
     if (
-        manifest == NULL ||
-        maps == NULL ||
-        out_animations == NULL ||
-        out_animation_count == NULL ||
-        out_keys == NULL ||
-        out_key_count == NULL
+        (uint64_t)w * (uint64_t)h > space->free_area ||
+        (w >= space->fail_w && h >= space->fail_h)
     ) {
-        return PR_STATUS_INVALID_ARGUMENT;
+        return 0;
+    }
+
+    found = 0;
+    best_area = 0u;
+    best_x = 0u;
+    best_y = 0u;
+    for (i = 0u; i <= space->rect_count * 4u; ++i) {
+        pr_pack_rect_t candidate;
+        uint64_t area;
+        uint32_t used_w;
+        uint32_t used_h;
+
+        candidate.w = w;
+        candidate.h = h;
+        if (i == 0u) {
+            candidate.x = 0u;
+            candidate.y = 0u;
+        } else {
+            const pr_pack_rect_t *rect;
+
+            rect = &space->rects[(i - 1u) / 4u];
+            switch ((i - 1u) % 4u) {
+            case 0u:
+                candidate.x = rect->x + rect->w;
+                candidate.y = rect->y;
+                break;
+            case 1u:
+                candidate.x = rect->x;
+                candidate.y = rect->y + rect->h;
+                break;
+            case 2u:
+                candidate.x = rect->x + rect->w;
+                candidate.y = 0u;
+                break;
+            default:
+                candidate.x = 0u;
+                candidate.y = rect->y + rect->h;
+                break;
+            }
+        }
+        if (candidate.x > space->max_w - w || candidate.y > space->max_h - h) {
+            continue;
+        }
+
+        used_w = (candidate.x + w > space->used_w) ? candidate.x + w : space->used_w;
+        used_h = (candidate.y + h > space->used_h) ? candidate.y + h : space->used_h;
+        area = (uint64_t)used_w * (uint64_t)used_h;
+        if (
+            found != 0 &&
+            (area > best_area ||
+                (area == best_area &&
+                    (candidate.y > best_y || (candidate.y == best_y && candidate.x >= best_x))))
+        ) {
+            continue;
+        }
+        if (pr_pack_space_overlaps(space, &candidate)) {
+            continue;
+        }
+        found = 1;
+        best_area = area;
+        best_x = candidate.x;
+        best_y = candidate.y;
+    }
+
+    if (found == 0) {
+        if ((uint64_t)w * (uint64_t)h < (uint64_t)space->fail_w * (uint64_t)space->fail_h) {
+            space->fail_w = w;
+            space->fail_h = h;
+        }
+        return 0;
+    }
+    *out_x = best_x;
+    *out_y = best_y;
+    return 1;
+}
+
+/* Incremental pack: frames whose padded size matches their lock entry stay
+ * where the lock put them, the rest go into free space on a compatible page
+ * or onto new pages. Pages left empty are dropped.
+ */
+static pr_status_t pr_pack_items_locked(
+    const pr_manifest_t *manifest,
+    pr_resolved_frame_t *frames,
+    const pr_pack_item_t *items,
+    size_t item_count,
+    uint32_t padding,
+    const pr_pack_lock_t *lock,
+    pr_pack_page_t **out_pages,
+    size_t *out_page_count
+)
+{
+    pr_pack_page_t *pages;
+    pr_pack_space_t *spaces;
+    size_t page_count;
+    size_t page_capacity;
+    size_t space_capacity;
+    uint32_t *page_remap;
+    unsigned char *kept;
+    size_t kept_page_count;
+    size_t i;
+    uint32_t cell;
+    pr_status_t status;
+
+    cell = pr_pack_cell_size(manifest);
+    pages = NULL;
+    spaces = NULL;
+    page_count = 0u;
+    page_capacity = 0u;
+    space_capacity = 0u;
+    page_remap = NULL;
+    status = PR_STATUS_ALLOCATION_FAILED;
+    kept = (unsigned char *)calloc(item_count > 0u ? item_count : 1u, sizeof(kept[0]));
+    if (kept == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    for (i = 0u; i < lock->page_count; ++i) {
+        if (
+            !pr_reserve_array((void **)&pages, &page_capacity, page_count + 1u, sizeof(pages[0])) ||
+            !pr_reserve_array((void **)&spaces, &space_capacity, page_count + 1u, sizeof(spaces[0]))
+        ) {
+            goto cleanup;
+        }
+        pr_pack_page_init(&pages[page_count], manifest, lock->pages[i].color_space, lock->pages[i].alpha_mode);
+        if (!pr_pack_space_init(&spaces[page_count], pages[page_count].max_w, pages[page_count].max_h)) {
+            goto cleanup;
+        }
+        page_count += 1u;
+    }
+
+    for (i = 0u; i < item_count; ++i) {
+        pr_resolved_frame_t *frame;
+        const pr_pack_lock_frame_t *entry;
+        pr_pack_rect_t rect;
+
+        frame = &frames[items[i].frame_index];
+        entry = pr_pack_lock_find(
+            lock,
+            pr_manifest_string(manifest, manifest->sprites[frame->sprite_index].id),
+            frame->local_frame_index
+        );
+        if (
+            entry == NULL ||
+            entry->w != items[i].padded_w ||
+            entry->h != items[i].padded_h ||
+            entry->x % cell != 0u ||
+            entry->y % cell != 0u ||
+            pages[entry->page].color_space != frame->color_space ||
+            pages[entry->page].alpha_mode != frame->alpha_mode ||
+            entry->x > pages[entry->page].max_w - entry->w ||
+            entry->y > pages[entry->page].max_h - entry->h
+        ) {
+            continue;
+        }
+        rect.x = entry->x;
+        rect.y = entry->y;
+        rect.w = entry->w;
+        rect.h = entry->h;
+        if (pr_pack_space_overlaps(&spaces[entry->page], &rect)) {
+            continue;
+        }
+        if (!pr_pack_space_add(&spaces[entry->page], &rect)) {
+            goto cleanup;
+        }
+        frame->atlas_page = entry->page;
+        frame->atlas_x = rect.x + padding;
+        frame->atlas_y = rect.y + padding;
+        kept[i] = 1u;
+    }
+
+    for (i = 0u; i < item_count; ++i) {
+        pr_resolved_frame_t *frame;
+        pr_pack_rect_t rect;
+        size_t page_index;
+
+        if (kept[i] != 0u) {
+            continue;
+        }
+        frame = &frames[items[i].frame_index];
+        rect.w = items[i].padded_w;
+        rect.h = items[i].padded_h;
+        for (page_index = 0u; page_index < page_count; ++page_index) {
+            if (
+                pages[page_index].color_space == frame->color_space &&
+                pages[page_index].alpha_mode == frame->alpha_mode &&
+                pr_pack_space_find(&spaces[page_index], rect.w, rect.h, &rect.x, &rect.y)
+            ) {
+                break;
+            }
+        }
+        if (page_index == page_count) {
+            if (
+                !pr_reserve_array((void **)&pages, &page_capacity, page_count + 1u, sizeof(pages[0])) ||
+                !pr_reserve_array((void **)&spaces, &space_capacity, page_count + 1u, sizeof(spaces[0]))
+            ) {
+                goto cleanup;
+            }
+            pr_pack_page_init(&pages[page_count], manifest, frame->color_space, frame->alpha_mode);
+            if (!pr_pack_space_init(&spaces[page_count], pages[page_count].max_w, pages[page_count].max_h)) {
+                goto cleanup;
+            }
+            page_count += 1u;
+            rect.x = 0u;
+            rect.y = 0u;
+        }
+        if (!pr_pack_space_add(&spaces[page_index], &rect)) {
+            goto cleanup;
+        }
+        frame->atlas_page = (uint32_t)page_index;
+        frame->atlas_x = rect.x + padding;
+        frame->atlas_y = rect.y + padding;
+    }
+
+    page_remap = (uint32_t *)calloc(page_count > 0u ? page_count : 1u, sizeof(page_remap[0]));
+    if (page_remap == NULL) {
+        goto cleanup;
+    }
+    kept_page_count = 0u;
+    for (i = 0u; i < page_count; ++i) {
+        if (spaces[i].rect_count == 0u) {
+            continue;
+        }
+        page_remap[i] = (uint32_t)kept_page_count;
+        pages[kept_page_count] = pages[i];
+        pages[kept_page_count].used_w = spaces[i].used_w;
+        pages[kept_page_count].used_h = spaces[i].used_h;
+        kept_page_count += 1u;
+    }
+    for (i = 0u; i < item_count; ++i) {
+        frames[items[i].frame_index].atlas_page = page_remap[frames[items[i].frame_index].atlas_page];
+    }
+
+    *out_pages = pages;
+    *out_page_count = kept_page_count;
+    pages = NULL;
+    status = PR_STATUS_OK;
+
+cleanup:
+    for (i = 0u; i < page_count; ++i) {
+        pr_pack_space_free(&spaces[i]);
+    }
+    free(spaces);
+    free(pages);
+    free(page_remap);
+    free(kept);
+    return status;
+}
+
+/* Final page sizes: the used area, rounded up to powers of two when asked.
+ * Array layers all take the size of the largest page.
+ */
+static void pr_pack_pages_finish(
+    const pr_manifest_t *manifest,
+    pr_pack_page_t *pages,
+    size_t page_count
+)
+{
+    size_t i;
+
+    for (i = 0u; i < page_count; ++i) {
+        uint32_t final_w;
+        uint32_t final_h;
+
+        final_w = (pages[i].used_w > 0u) ? pages[i].used_w : 1u;
+        final_h = (pages[i].used_h > 0u) ? pages[i].used_h : 1u;
+        if (manifest->atlas.power_of_two != 0) {
+            final_w = pr_round_up_pow2_u32(final_w);
+            final_h = pr_round_up_pow2_u32(final_h);
+            if (final_w > pages[i].max_w) {
+                final_w = pages[i].max_w;
+            }
+            if (final_h > pages[i].max_h) {
+                final_h = pages[i].max_h;
+            }
+        }
+        pages[i].final_w = final_w;
+        pages[i].final_h = final_h;
+    }
+
+    if (pr_manifest_atlas_layout(manifest) == PR_ATLAS_LAYOUT_ARRAY) {
+        uint32_t array_w;
+        uint32_t array_h;
+
+        array_w = 1u;
+        array_h = 1u;
+        for (i = 0u; i < page_count; ++i) {
+            array_w = (pages[i].final_w > array_w) ? pages[i].final_w : array_w;
+            array_h = (pages[i].final_h > array_h) ? pages[i].final_h : array_h;
+        }
+        for (i = 0u; i < page_count; ++i) {
+            pages[i].final_w = array_w;
+            pages[i].final_h = array_h;
+        }
+    }
+}
+
+static uint64_t pr_pack_pages_area(const pr_pack_page_t *pages, size_t page_count)
+{
+    uint64_t area;
+    size_t i;
+
+    area = 0u;
+    for (i = 0u; i < page_count; ++i) {
+        area += (uint64_t)pages[i].final_w * (uint64_t)pages[i].final_h;
+    }
+    return area;
+}
+
+/* Packs every frame onto pages. With a `lock` from an earlier incremental
+ * build, frames keep their old placement unless the resulting pages would
+ * cover more than `atlas.repack_threshold` percent beyond a fresh pack, in
+ * which case the fresh pack wins.
+ */
+static pr_status_t pr_pack_resolved_frames(
+    const pr_manifest_t *manifest,
+    pr_resolved_frame_t *frames,
+    size_t frame_count,
+    const pr_pack_lock_t *lock,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data,
+    pr_pack_page_t **out_pages,
+    size_t *out_page_count
+)
+{
+    pr_pack_page_t *pages;
+    size_t page_count;
+    pr_pack_item_t *items;
+    size_t i;
+    uint32_t padding;
+    uint32_t cell;
+    pr_status_t status;
+
+    if (
+        manifest == NULL ||
+        (frame_count > 0u && frames == NULL) ||
+        out_pages == NULL ||
+        out_page_count == NULL
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    *out_pages = NULL;
+    *out_page_count = 0u;
+    if (frame_count == 0u) {
+        return PR_STATUS_OK;
+    }
+
+    padding = (manifest->atlas.padding > 0) ? (uint32_t)manifest->atlas.padding : 0u;
+    cell = pr_pack_cell_size(manifest);
+    pages = NULL;
+    page_count = 0u;
+    items = (pr_pack_item_t *)calloc(frame_count, sizeof(items[0]));
+    if (items == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    for (i = 0u; i < frame_count; ++i) {
+        uint32_t padded_w;
+        uint32_t padded_h;
+
+        padded_w = pr_pack_frame_extent(frames[i].source_w, padding, cell);
+        padded_h = pr_pack_frame_extent(frames[i].source_h, padding, cell);
+        if (
+            padded_w > (uint32_t)manifest->atlas.max_page_width ||
+            padded_h > (uint32_t)manifest->atlas.max_page_height
+        ) {
+            free(items);
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_ERROR,
+                "Frame is too large for atlas page constraints.",
+                NULL,
+                "build.atlas.frame_too_large",
+                NULL
+            );
+            return PR_STATUS_VALIDATION_ERROR;
+        }
+        items[i].frame_index = (uint32_t)i;
+        items[i].padded_w = padded_w;
+        items[i].padded_h = padded_h;
+        items[i].area = (uint64_t)padded_w * (uint64_t)padded_h;
+        items[i].sprite_index = frames[i].sprite_index;
+        items[i].local_frame_index = frames[i].local_frame_index;
+    }
+
+    qsort(items, frame_count, sizeof(items[0]), pr_pack_item_compare);
+
+    status = pr_pack_items_shelf(manifest, frames, items, frame_count, padding, &pages, &page_count);
+    if (status != PR_STATUS_OK) {
+        free(items);
+        return status;
+    }
+    pr_pack_pages_finish(manifest, pages, page_count);
+
+    if (lock != NULL) {
+        pr_resolved_frame_t *fresh_frames;
+        pr_pack_page_t *locked_pages;
+        size_t locked_page_count;
+        uint64_t fresh_area;
+        uint64_t locked_area;
+
+        fresh_frames = (pr_resolved_frame_t *)malloc(frame_count * sizeof(fresh_frames[0]));
+        if (fresh_frames == NULL) {
+            free(items);
+            free(pages);
+            return PR_STATUS_ALLOCATION_FAILED;
+        }
+        memcpy(fresh_frames, frames, frame_count * sizeof(fresh_frames[0]));
+
+        status = pr_pack_items_locked(
+            manifest,
+            frames,
+            items,
+            frame_count,
+            padding,
+            lock,
+            &locked_pages,
+            &locked_page_count
+        );
+        if (status != PR_STATUS_OK) {
+            free(fresh_frames);
+            free(items);
+            free(pages);
+            return status;
+        }
+        pr_pack_pages_finish(manifest, locked_pages, locked_page_count);
+
+        fresh_area = pr_pack_pages_area(pages, page_count);
+        locked_area = pr_pack_pages_area(locked_pages, locked_page_count);
+        if (locked_area * 100u <= fresh_area * (100u + (uint64_t)manifest->atlas.repack_threshold)) {
+            free(pages);
+            pages = locked_pages;
+            page_count = locked_page_count;
+        } else {
+            memcpy(frames, fresh_frames, frame_count * sizeof(frames[0]));
+            free(locked_pages);
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_NOTE,
+                "Incremental layout exceeded atlas.repack_threshold; frames were repacked.",
+                NULL,
+                "build.atlas.repacked",
+                NULL
+            );
+        }
+        free(fresh_frames);
+    }
+
+    for (i = 0u; i < frame_count; ++i) {
+        pr_pack_page_t *page;
+
+        page = &pages[frames[i].atlas_page];
+        frames[i].atlas_w = frames[i].source_w;
+        frames[i].atlas_h = frames[i].source_h;
+        page->frame_count += 1u;
+        page->used_pixels += (uint64_t)frames[i].atlas_w * (uint64_t)frames[i].atlas_h;
+        frames[i].u0_milli = (uint32_t)(((uint64_t)frames[i].atlas_x * 1000000u) / page->final_w);
+        frames[i].v0_milli = (uint32_t)(((uint64_t)frames[i].atlas_y * 1000000u) / page->final_h);
+        frames[i].u1_milli = (uint32_t)(((uint64_t)(frames[i].atlas_x + frames[i].atlas_w) * 1000000u) / page->final_w);
+        frames[i].v1_milli = (uint32_t)(((uint64_t)(frames[i].atlas_y + frames[i].atlas_h) * 1000000u) / page->final_h);
+    }
+
+    free(items);
+    *out_pages = pages;
+    *out_page_count = page_count;
+    return PR_STATUS_OK;
+}
+
+/* Sets every page to `format`, or with `auto_format` to the smallest format
+ * that holds its frames without loss: R8 when they are gray and opaque, RA8
+ * when they are gray, RGBA8 otherwise. With `uniform` (array layouts) every
+ * page takes the format that holds all of them.
+ */
+static int pr_assign_page_formats(
+    const pr_imported_image_t *images,
+    const pr_resolved_sprite_t *sprites,
+    const pr_resolved_frame_t *frames,
+    size_t frame_count,
+    pr_pack_page_t *pages,
+    size_t page_count,
+    pr_page_format_t format,
+    int auto_format,
+    int uniform
+)
+{
+    int *gray;
+    int *opaque;
+    size_t i;
+
+    for (i = 0u; i < page_count; ++i) {
+        pages[i].format = format;
+    }
+    if (auto_format == 0 || page_count == 0u) {
+        return 1;
+    }
+
+    gray = (int *)malloc(page_count * sizeof(gray[0]));
+    opaque = (int *)malloc(page_count * sizeof(opaque[0]));
+    if (gray == NULL || opaque == NULL) {
+        free(gray);
+        free(opaque);
+        return 0;
+    }
+    for (i = 0u; i < page_count; ++i) {
+        gray[i] = 1;
+        opaque[i] = 1;
+    }
+    for (i = 0u; i < frame_count; ++i) {
+        const pr_imported_image_t *image;
+        uint32_t page_index;
+
+        page_index = frames[i].atlas_page;
+        if (gray[page_index] == 0) {
+            continue;
+        }
+        image = &images[sprites[frames[i].sprite_index].source_image_index];
+        pr_pixel_classify(
+            image->pixels + (size_t)frames[i].source_y * image->row_bytes +
+                (size_t)frames[i].source_x * 4u,
+            frames[i].source_w,
+            frames[i].source_h,
+            (size_t)image->row_bytes,
+            &gray[page_index],
+            &opaque[page_index]
+        );
+    }
+    if (uniform != 0) {
+        for (i = 1u; i < page_count; ++i) {
+            gray[0] = gray[0] && gray[i];
+            opaque[0] = opaque[0] && opaque[i];
+        }
+        for (i = 1u; i < page_count; ++i) {
+            gray[i] = gray[0];
+            opaque[i] = opaque[0];
+        }
+    }
+    for (i = 0u; i < page_count; ++i) {
+        if (gray[i] != 0) {
+            pages[i].format = (opaque[i] != 0) ? PR_PAGE_FORMAT_R8 : PR_PAGE_FORMAT_RA8;
+        } else {
+            pages[i].format = PR_PAGE_FORMAT_RGBA8;
+        }
+    }
+    free(gray);
+    free(opaque);
+    return 1;
+}
+
+static pr_status_t pr_resolve_animations(
+    const pr_manifest_t *manifest,
+    const pr_index_maps_t *maps,
+    const pr_resolved_sprite_t *sprites,
+    size_t sprite_count,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data,
+    pr_resolved_animation_t **out_animations,
+    size_t *out_animation_count,
+    pr_resolved_animation_key_t **out_keys,
+    size_t *out_key_count
+)
+{
+    pr_resolved_animation_t *animations;
+    pr_resolved_animation_key_t *keys;
+    size_t key_count;
+    size_t key_capacity;
+    size_t animation_index;
+
+    if (
+        manifest == NULL ||
+        maps == NULL ||
+        out_animations == NULL ||
+        out_animation_count == NULL ||
+        out_keys == NULL ||
+        out_key_count == NULL
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
     }
     if (
         manifest->sprite_count != sprite_count ||
@@ -1724,7 +2624,7 @@ static pr_status_t pr_resolve_animations(
                     "Animation frame index exceeds resolved sprite frame count.",
                     NULL,
                     "build.animation.frame_index_oob",
-                    animation->id
+                    pr_manifest_string(manifest, animation->id)
                 );
                 return PR_STATUS_VALIDATION_ERROR;
             }
@@ -1812,7 +2712,7 @@ static void pr_free_index_maps(pr_index_maps_t *maps)
 static int pr_build_string_table_and_maps(
     const pr_manifest_t *manifest,
     const pr_imported_image_t *imported_images,
-    pr_string_table_t *table,
+    pr_intern_pool_t *table,
     pr_index_maps_t *maps,
     pr_diag_sink_fn diag_sink,
     void *diag_user_data
@@ -1820,6 +2720,11 @@ static int pr_build_string_table_and_maps(
 {
     size_t i;
     uint32_t ignored_index;
+    uint32_t *image_by_handle;
+    uint32_t *sprite_by_handle;
+    size_t image_map_count;
+    size_t sprite_map_count;
+    int ok;
 
     if (
         manifest == NULL ||
@@ -1830,139 +2735,695 @@ static int pr_build_string_table_and_maps(
         return 0;
     }
 
-    if (!pr_string_table_add(table, manifest->package_name, &ignored_index)) {
-        return 0;
+    image_by_handle = NULL;
+    sprite_by_handle = NULL;
+    ok = 0;
+
+    if (!pr_intern_pool_reserve(
+            table,
+            1u + manifest->image_count * 2u + manifest->sprite_count + manifest->animation_count,
+            0u
+        )) {
+        return 0;
+    }
+
+    if (!pr_intern_pool_add(
+            table,
+            pr_manifest_string(manifest, manifest->package_name),
+            &ignored_index
+        )) {
+        return 0;
+    }
+
+    for (i = 0u; i < manifest->image_count; ++i) {
+        if (!pr_intern_pool_add(
+                table,
+                pr_manifest_string(manifest, manifest->images[i].id),
+                &maps->image_id_str_idx[i]
+            )) {
+            goto cleanup;
+        }
+        if (!pr_intern_pool_add(
+                table,
+                imported_images[i].resolved_path,
+                &maps->image_path_str_idx[i]
+            )) {
+            goto cleanup;
+        }
+    }
+
+    /* Map interned id handles back to the first manifest entry using them. */
+    image_map_count = table->count;
+    image_by_handle = pr_handle_index_map_create(image_map_count);
+    if (image_by_handle == NULL) {
+        goto cleanup;
+    }
+    for (i = 0u; i < manifest->image_count; ++i) {
+        uint32_t handle;
+
+        handle = maps->image_id_str_idx[i];
+        if (manifest->images[i].has_id != 0 && image_by_handle[handle] == 0xFFFFFFFFu) {
+            image_by_handle[handle] = (uint32_t)i;
+        }
+    }
+
+    for (i = 0u; i < manifest->sprite_count; ++i) {
+        long source_image_index;
+
+        if (!pr_intern_pool_add(
+                table,
+                pr_manifest_string(manifest, manifest->sprites[i].id),
+                &maps->sprite_id_str_idx[i]
+            )) {
+            goto cleanup;
+        }
+        source_image_index = pr_handle_index_map_find(
+            table,
+            image_by_handle,
+            image_map_count,
+            pr_manifest_string(manifest, manifest->sprites[i].source)
+        );
+        if (source_image_index < 0) {
+            maps->sprite_source_image_idx[i] = 0xFFFFFFFFu;
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_ERROR,
+                "Sprite source image id was not found during index mapping.",
+                NULL,
+                "build.index.sprite_source_missing",
+                pr_manifest_string(manifest, manifest->sprites[i].id)
+            );
+            goto cleanup;
+        }
+        maps->sprite_source_image_idx[i] = (uint32_t)source_image_index;
+    }
+
+    sprite_map_count = table->count;
+    sprite_by_handle = pr_handle_index_map_create(sprite_map_count);
+    if (sprite_by_handle == NULL) {
+        goto cleanup;
+    }
+    for (i = 0u; i < manifest->sprite_count; ++i) {
+        uint32_t handle;
+
+        handle = maps->sprite_id_str_idx[i];
+        if (manifest->sprites[i].has_id != 0 && sprite_by_handle[handle] == 0xFFFFFFFFu) {
+            sprite_by_handle[handle] = (uint32_t)i;
+        }
+    }
+
+    for (i = 0u; i < manifest->animation_count; ++i) {
+        long sprite_index;
+
+        if (!pr_intern_pool_add(
+                table,
+                pr_manifest_string(manifest, manifest->animations[i].id),
+                &maps->animation_id_str_idx[i]
+            )) {
+            goto cleanup;
+        }
+        sprite_index = pr_handle_index_map_find(
+            table,
+            sprite_by_handle,
+            sprite_map_count,
+            pr_manifest_string(manifest, manifest->animations[i].sprite)
+        );
+        if (sprite_index < 0) {
+            maps->animation_sprite_idx[i] = 0xFFFFFFFFu;
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_ERROR,
+                "Animation sprite id was not found during index mapping.",
+                NULL,
+                "build.index.animation_sprite_missing",
+                pr_manifest_string(manifest, manifest->animations[i].id)
+            );
+            goto cleanup;
+        }
+        maps->animation_sprite_idx[i] = (uint32_t)sprite_index;
+    }
+
+    ok = 1;
+
+cleanup:
+    free(image_by_handle);
+    free(sprite_by_handle);
+    return ok;
+}
+
+static int pr_build_chunk_strs(
+    const pr_intern_pool_t *table,
+    pr_chunk_payload_t *chunk
+)
+{
+    pr_byte_buffer_t buffer;
+    size_t i;
+
+    if (table == NULL || chunk == NULL) {
+        return 0;
+    }
+    if (table->count > 0xFFFFFFFFu || table->byte_count > 0xFFFFFFFFu) {
+        return 0;
+    }
+
+    pr_byte_buffer_init(&buffer);
+    if (
+        !pr_byte_buffer_append_u32_le(&buffer, 1u) ||
+        !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)table->count) ||
+        !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)table->byte_count)
+    ) {
+        pr_byte_buffer_free(&buffer);
+        return 0;
+    }
+
+    /* The pool arena already matches the STRS blob layout byte for byte. */
+    for (i = 0u; i < table->count; ++i) {
+        if (!pr_byte_buffer_append_u32_le(&buffer, table->offsets[i])) {
+            pr_byte_buffer_free(&buffer);
+            return 0;
+        }
+    }
+    if (
+        table->byte_count > 0u &&
+        !pr_byte_buffer_append(&buffer, table->bytes, table->byte_count)
+    ) {
+        pr_byte_buffer_free(&buffer);
+        return 0;
+    }
+
+    memcpy(chunk->id, PR_CHUNK_FORMAT_STRS, 4u);
+    chunk->bytes = buffer.data;
+    chunk->size = buffer.size;
+    return 1;
+}
+
+static uint32_t pr_atlas_sampling_code(const char *sampling)
+{
+    if (sampling != NULL && strcmp(sampling, "linear") == 0) {
+        return 1u;
+    }
+    return 0u;
+}
+
+/* One mip level of an atlas page; pages without mipmaps have level 0 only.
+ * `data` holds RGBA8 pixels until the level is encoded into the page format.
+ */
+typedef struct pr_txtr_level {
+    pr_page_format_t format;
+    uint32_t width;
+    uint32_t height;
+    unsigned char *data;
+    size_t data_bytes;
+    unsigned char *stored;
+    size_t stored_bytes;
+    uint32_t stored_tile_size;
+    unsigned char failed;
+} pr_txtr_level_t;
+
+typedef struct pr_mipmap_batch {
+    pr_txtr_level_t *levels;
+    const size_t *first_level;
+    const pr_pack_page_t *pages;
+} pr_mipmap_batch_t;
+
+/* Builds a page's levels from level 0 down, so pages run in parallel. */
+static void pr_mipmap_batch_run(void *user_data, size_t index)
+{
+    pr_mipmap_batch_t *batch;
+    size_t level;
+
+    batch = (pr_mipmap_batch_t *)user_data;
+    for (level = batch->first_level[index] + 1u; level < batch->first_level[index + 1u]; ++level) {
+        pr_txtr_level_t *out;
+
+        out = &batch->levels[level];
+        out->data_bytes = (size_t)out->width * out->height * 4u;
+        out->data = (unsigned char *)malloc(out->data_bytes);
+        if (out->data == NULL) {
+            out->failed = 1u;
+            return;
+        }
+        pr_mipmap_downsample(
+            batch->levels[level - 1u].data,
+            batch->levels[level - 1u].width,
+            batch->levels[level - 1u].height,
+            batch->pages[index].color_space,
+            batch->pages[index].alpha_mode,
+            out->data
+        );
+    }
+}
+
+typedef struct pr_palette_batch {
+    pr_txtr_level_t *levels;
+    const size_t *first_level;
+    pr_palette_t *palettes;
+} pr_palette_batch_t;
+
+/* Quantizes an indexed8 page and its mip levels to one palette, replacing
+ * each level's RGBA8 data with palette indices.
+ */
+static void pr_palette_batch_run(void *user_data, size_t index)
+{
+    pr_palette_batch_t *batch;
+    const unsigned char *images[PR_MIPMAP_MAX_LEVELS];
+    size_t pixel_counts[PR_MIPMAP_MAX_LEVELS];
+    unsigned char *indices[PR_MIPMAP_MAX_LEVELS];
+    pr_txtr_level_t *first;
+    size_t count;
+    size_t k;
+
+    batch = (pr_palette_batch_t *)user_data;
+    first = &batch->levels[batch->first_level[index]];
+    count = batch->first_level[index + 1u] - batch->first_level[index];
+    if (first->format != PR_PAGE_FORMAT_INDEXED8) {
+        return;
+    }
+    if (count == 0u || count > PR_MIPMAP_MAX_LEVELS) {
+        first->failed = 1u;
+        return;
+    }
+    for (k = 0u; k < count; ++k) {
+        images[k] = first[k].data;
+        pixel_counts[k] = (size_t)first[k].width * first[k].height;
+    }
+    if (!pr_palette_quantize(images, pixel_counts, count, &batch->palettes[index], indices)) {
+        first->failed = 1u;
+        return;
+    }
+    for (k = 0u; k < count; ++k) {
+        free(first[k].data);
+        first[k].data = indices[k];
+        first[k].data_bytes = pixel_counts[k];
+    }
+}
+
+/* Repeats a frame's edge texels `extrude` times outward: edge columns first,
+ * then whole rows, so the corners are filled as well.
+ */
+static void pr_extrude_frame(
+    unsigned char *page,
+    size_t stride,
+    const pr_resolved_frame_t *frame,
+    uint32_t extrude
+)
+{
+    unsigned char *top;
+    unsigned char *bottom;
+    size_t span;
+    uint32_t row;
+    uint32_t k;
+
+    for (row = 0u; row < frame->atlas_h; ++row) {
+        unsigned char *left;
+        unsigned char *right;
+
+        left = page + (size_t)(frame->atlas_y + row) * stride + (size_t)frame->atlas_x * 4u;
+        right = left + (size_t)(frame->atlas_w - 1u) * 4u;
+        for (k = 1u; k <= extrude; ++k) {
+            memcpy(left - (size_t)k * 4u, left, 4u);
+            memcpy(right + (size_t)k * 4u, right, 4u);
+        }
+    }
+
+    top = page + (size_t)frame->atlas_y * stride + (size_t)(frame->atlas_x - extrude) * 4u;
+    bottom = top + (size_t)(frame->atlas_h - 1u) * stride;
+    span = (size_t)(frame->atlas_w + extrude * 2u) * 4u;
+    for (k = 1u; k <= extrude; ++k) {
+        memcpy(top - (size_t)k * stride, top, span);
+        memcpy(bottom + (size_t)k * stride, bottom, span);
     }
+}
 
-    for (i = 0u; i < manifest->image_count; ++i) {
-        if (!pr_string_table_add(table, manifest->images[i].id, &maps->image_id_str_idx[i])) {
-            return 0;
-        }
-        if (!pr_string_table_add(
-                table,
-                imported_images[i].resolved_path,
-                &maps->image_path_str_idx[i]
-            )) {
-            return 0;
-        }
+/* Gives every transparent texel in the region the average color of its
+ * nearest colored neighbours, one ring at a time outward, so linear filtering
+ * at alpha edges does not pull in black. Alpha is left as is. Each texel is
+ * queued once, so the cost is linear in the region size.
+ */
+static int pr_bleed_alpha_region(
+    unsigned char *page,
+    size_t stride,
+    uint32_t region_x,
+    uint32_t region_y,
+    uint32_t width,
+    uint32_t height
+)
+{
+    unsigned char *state;
+    uint32_t *queue;
+    size_t texel_count;
+    size_t colored;
+    size_t head;
+    size_t tail;
+    uint32_t x;
+    uint32_t y;
+
+    texel_count = (size_t)width * height;
+    /* 0: transparent, 1: has a color, 2: queued for the next ring. */
+    state = (unsigned char *)calloc(texel_count, 1u);
+    /* x, y pairs. */
+    queue = (uint32_t *)malloc(texel_count * 2u * sizeof(queue[0]));
+    if (state == NULL || queue == NULL) {
+        free(state);
+        free(queue);
+        return 0;
     }
 
-    for (i = 0u; i < manifest->sprite_count; ++i) {
-        long source_image_index;
+    colored = 0u;
+    for (y = 0u; y < height; ++y) {
+        const unsigned char *row;
 
-        if (!pr_string_table_add(table, manifest->sprites[i].id, &maps->sprite_id_str_idx[i])) {
-            return 0;
-        }
-        source_image_index = pr_find_image_index(manifest, manifest->sprites[i].source);
-        if (source_image_index < 0) {
-            maps->sprite_source_image_idx[i] = 0xFFFFFFFFu;
-            pr_emit_diag(
-                diag_sink,
-                diag_user_data,
-                PR_DIAG_ERROR,
-                "Sprite source image id was not found during index mapping.",
-                NULL,
-                "build.index.sprite_source_missing",
-                manifest->sprites[i].id
-            );
-            return 0;
+        row = page + (size_t)(region_y + y) * stride + (size_t)region_x * 4u;
+        for (x = 0u; x < width; ++x) {
+            state[(size_t)y * width + x] = (row[(size_t)x * 4u + 3u] != 0u) ? 1u : 0u;
+            colored += state[(size_t)y * width + x];
         }
-        maps->sprite_source_image_idx[i] = (uint32_t)source_image_index;
     }
 
-    for (i = 0u; i < manifest->animation_count; ++i) {
-        long sprite_index;
+    /* The first ring: transparent texels next to a colored one. */
+    tail = 0u;
+    for (y = 0u; colored > 0u && colored < texel_count && y < height; ++y) {
+        for (x = 0u; x < width; ++x) {
+            uint32_t nx;
+            uint32_t ny;
+            int touches;
 
-        if (!pr_string_table_add(
-                table,
-                manifest->animations[i].id,
-                &maps->animation_id_str_idx[i]
-            )) {
-            return 0;
+            if (state[(size_t)y * width + x] != 0u) {
+                continue;
+            }
+            touches = 0;
+            for (ny = (y > 0u) ? y - 1u : 0u; !touches && ny <= y + 1u && ny < height; ++ny) {
+                for (nx = (x > 0u) ? x - 1u : 0u; nx <= x + 1u && nx < width; ++nx) {
+                    if (state[(size_t)ny * width + nx] == 1u) {
+                        touches = 1;
+                        break;
+                    }
+                }
+            }
+            if (touches) {
+                queue[tail * 2u] = x;
+                queue[tail * 2u + 1u] = y;
+                tail += 1u;
+            }
         }
-        sprite_index = pr_find_sprite_index(manifest, manifest->animations[i].sprite);
-        if (sprite_index < 0) {
-            maps->animation_sprite_idx[i] = 0xFFFFFFFFu;
-            pr_emit_diag(
-                diag_sink,
-                diag_user_data,
-                PR_DIAG_ERROR,
-                "Animation sprite id was not found during index mapping.",
-                NULL,
-                "build.index.animation_sprite_missing",
-                manifest->animations[i].id
-            );
-            return 0;
+    }
+    for (head = 0u; head < tail; ++head) {
+        state[(size_t)queue[head * 2u + 1u] * width + queue[head * 2u]] = 2u;
+    }
+
+    head = 0u;
+    while (head < tail) {
+        size_t ring_end;
+        size_t i;
+
+        ring_end = tail;
+        for (i = head; i < ring_end; ++i) {
+            uint32_t sum[3];
+            uint32_t count;
+            uint32_t nx;
+            uint32_t ny;
+            unsigned char *texel;
+
+            x = queue[i * 2u];
+            y = queue[i * 2u + 1u];
+            sum[0] = 0u;
+            sum[1] = 0u;
+            sum[2] = 0u;
+            count = 0u;
+            for (ny = (y > 0u) ? y - 1u : 0u; ny <= y + 1u && ny < height; ++ny) {
+                for (nx = (x > 0u) ? x - 1u : 0u; nx <= x + 1u && nx < width; ++nx) {
+                    const unsigned char *neighbour;
+
+                    if (state[(size_t)ny * width + nx] != 1u) {
+                        continue;
+                    }
+                    neighbour = page + (size_t)(region_y + ny) * stride + (size_t)(region_x + nx) * 4u;
+                    sum[0] += neighbour[0];
+                    sum[1] += neighbour[1];
+                    sum[2] += neighbour[2];
+                    count += 1u;
+                }
+            }
+            texel = page + (size_t)(region_y + y) * stride + (size_t)(region_x + x) * 4u;
+            texel[0] = (unsigned char)((sum[0] + count / 2u) / count);
+            texel[1] = (unsigned char)((sum[1] + count / 2u) / count);
+            texel[2] = (unsigned char)((sum[2] + count / 2u) / count);
         }
-        maps->animation_sprite_idx[i] = (uint32_t)sprite_index;
+        for (i = head; i < ring_end; ++i) {
+            state[(size_t)queue[i * 2u + 1u] * width + queue[i * 2u]] = 1u;
+        }
+        for (i = head; i < ring_end; ++i) {
+            uint32_t nx;
+            uint32_t ny;
+
+            x = queue[i * 2u];
+            y = queue[i * 2u + 1u];
+            for (ny = (y > 0u) ? y - 1u : 0u; ny <= y + 1u && ny < height; ++ny) {
+                for (nx = (x > 0u) ? x - 1u : 0u; nx <= x + 1u && nx < width; ++nx) {
+                    if (state[(size_t)ny * width + nx] == 0u) {
+                        state[(size_t)ny * width + nx] = 2u;
+                        queue[tail * 2u] = nx;
+                        queue[tail * 2u + 1u] = ny;
+                        tail += 1u;
+                    }
+                }
+            }
+        }
+        head = ring_end;
     }
 
+    free(state);
+    free(queue);
     return 1;
 }
 
-static int pr_build_chunk_strs(
-    const pr_string_table_t *table,
-    pr_chunk_payload_t *chunk
-)
-{
-    pr_byte_buffer_t buffer;
-    size_t i;
-    size_t strings_blob_bytes;
-    uint32_t running_offset;
+/* Frames own disjoint cells (the frame plus `padding` on each side), so they
+ * are processed in parallel, even on the same page.
+ */
+typedef struct pr_frame_gutter_batch {
+    pr_txtr_level_t *levels;
+    const size_t *first_level;
+    const pr_pack_page_t *pages;
+    const pr_resolved_frame_t *frames;
+    uint32_t padding;
+    uint32_t extrude;
+    int bleed_alpha;
+    unsigned char *failed;
+} pr_frame_gutter_batch_t;
 
-    if (table == NULL || chunk == NULL) {
-        return 0;
+static void pr_frame_gutter_batch_run(void *user_data, size_t index)
+{
+    pr_frame_gutter_batch_t *batch;
+    const pr_resolved_frame_t *frame;
+    const pr_pack_page_t *page;
+    unsigned char *pixels;
+    size_t stride;
+    uint32_t region_x;
+    uint32_t region_y;
+    uint32_t region_w;
+    uint32_t region_h;
+
+    batch = (pr_frame_gutter_batch_t *)user_data;
+    frame = &batch->frames[index];
+    if (frame->atlas_w == 0u || frame->atlas_h == 0u) {
+        return;
     }
-
-    strings_blob_bytes = 0u;
-    for (i = 0u; i < table->count; ++i) {
-        strings_blob_bytes += strlen(table->values[i]) + 1u;
+    page = &batch->pages[frame->atlas_page];
+    pixels = batch->levels[batch->first_level[frame->atlas_page]].data;
+    stride = (size_t)page->final_w * 4u;
+    if (batch->extrude > 0u) {
+        pr_extrude_frame(pixels, stride, frame, batch->extrude);
     }
-    if (strings_blob_bytes > 0xFFFFFFFFu) {
-        return 0;
+    /* Premultiplied texels must stay black where they are clear. */
+    if (batch->bleed_alpha == 0 || page->alpha_mode == PR_ALPHA_MODE_PREMULTIPLIED) {
+        return;
     }
 
-    pr_byte_buffer_init(&buffer);
+    region_x = frame->atlas_x - batch->padding;
+    region_y = frame->atlas_y - batch->padding;
+    region_w = frame->atlas_w + batch->padding * 2u;
+    region_h = frame->atlas_h + batch->padding * 2u;
+    region_w = (region_x + region_w > page->final_w) ? page->final_w - region_x : region_w;
+    region_h = (region_y + region_h > page->final_h) ? page->final_h - region_y : region_h;
+    if (!pr_bleed_alpha_region(pixels, stride, region_x, region_y, region_w, region_h)) {
+        batch->failed[index] = 1u;
+    }
+}
+
+typedef struct pr_page_compress_batch {
+    pr_txtr_level_t *levels;
+    uint32_t tile_size;
+} pr_page_compress_batch_t;
+
+static void pr_store_u32_le(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value & 0xFFu);
+    bytes[1] = (unsigned char)((value >> 8u) & 0xFFu);
+    bytes[2] = (unsigned char)((value >> 16u) & 0xFFu);
+    bytes[3] = (unsigned char)((value >> 24u) & 0xFFu);
+}
+
+/* Tiled pages start with `tile_count + 1` offsets into the tile data that
+ * follows the table, then each tile compressed on its own. A tile whose
+ * stored size equals its raw size is stored uncompressed. Returns the stored
+ * size, or 0 when tiling would not make the page smaller.
+ */
+static size_t pr_compress_page_tiles(
+    const pr_page_compress_batch_t *batch,
+    size_t index,
+    unsigned char *out,
+    size_t out_capacity,
+    int *out_failed
+)
+{
+    const unsigned char *page;
+    unsigned char *scratch;
+    pr_page_format_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_bytes;
+    uint32_t data_bytes;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    uint32_t tile_x;
+    uint32_t tile_y;
+    size_t table_bytes;
+    size_t cursor;
+    size_t tile_index;
+
+    *out_failed = 0;
+    page = batch->levels[index].data;
+    format = batch->levels[index].format;
+    width = batch->levels[index].width;
+    height = batch->levels[index].height;
     if (
-        !pr_byte_buffer_append_u32_le(&buffer, 1u) ||
-        !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)table->count) ||
-        !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)strings_blob_bytes)
+        !pr_page_format_layout(format, width, height, &row_bytes, &data_bytes) ||
+        !pr_page_tile_grid(width, height, batch->tile_size, &tiles_x, &tiles_y)
     ) {
-        pr_byte_buffer_free(&buffer);
-        return 0;
+        return 0u;
+    }
+    table_bytes = ((size_t)tiles_x * tiles_y + 1u) * 4u;
+    if (table_bytes >= out_capacity) {
+        return 0u;
     }
 
-    running_offset = 0u;
-    for (i = 0u; i < table->count; ++i) {
-        if (!pr_byte_buffer_append_u32_le(&buffer, running_offset)) {
-            pr_byte_buffer_free(&buffer);
-            return 0;
+    scratch = (unsigned char *)malloc(
+        (size_t)batch->tile_size * batch->tile_size * 4u
+    );
+    if (scratch == NULL) {
+        *out_failed = 1;
+        return 0u;
+    }
+
+    cursor = table_bytes;
+    tile_index = 0u;
+    pr_store_u32_le(out, 0u);
+    for (tile_y = 0u; tile_y < tiles_y; ++tile_y) {
+        for (tile_x = 0u; tile_x < tiles_x; ++tile_x) {
+            pr_page_tile_t tile;
+            size_t raw_bytes;
+            size_t tile_bytes;
+            uint32_t row;
+
+            if (!pr_page_tile_at(format, width, height, batch->tile_size, tile_x, tile_y, &tile)) {
+                free(scratch);
+                return 0u;
+            }
+            for (row = 0u; row < tile.rows; ++row) {
+                memcpy(
+                    scratch + (size_t)row * tile.row_bytes,
+                    page + (size_t)(tile.row + row) * row_bytes + tile.offset,
+                    tile.row_bytes
+                );
+            }
+            raw_bytes = (size_t)tile.rows * tile.row_bytes;
+            if (cursor >= out_capacity) {
+                free(scratch);
+                return 0u;
+            }
+            tile_bytes = pr_lz_compress(
+                scratch,
+                raw_bytes,
+                out + cursor,
+                ((out_capacity - cursor) < raw_bytes) ? (out_capacity - cursor) : raw_bytes - 1u
+            );
+            if (tile_bytes == 0u) {
+                if (raw_bytes > out_capacity - cursor) {
+                    free(scratch);
+                    return 0u;
+                }
+                memcpy(out + cursor, scratch, raw_bytes);
+                tile_bytes = raw_bytes;
+            }
+            cursor += tile_bytes;
+            tile_index += 1u;
+            pr_store_u32_le(out + tile_index * 4u, (uint32_t)(cursor - table_bytes));
         }
-        running_offset += (uint32_t)(strlen(table->values[i]) + 1u);
     }
 
-    for (i = 0u; i < table->count; ++i) {
-        size_t len;
+    free(scratch);
+    return cursor;
+}
 
-        len = strlen(table->values[i]) + 1u;
-        if (!pr_byte_buffer_append(&buffer, table->values[i], len)) {
-            pr_byte_buffer_free(&buffer);
-            return 0;
+/* Leaves `stored` NULL when compression would not make the level smaller,
+ * so the level is written as is.
+ */
+static void pr_page_compress_batch_run(void *user_data, size_t index)
+{
+    pr_page_compress_batch_t *batch;
+    pr_txtr_level_t *level;
+    unsigned char *compressed;
+    size_t compressed_bytes;
+    int failed;
+
+    batch = (pr_page_compress_batch_t *)user_data;
+    level = &batch->levels[index];
+    compressed = (unsigned char *)malloc(level->data_bytes);
+    if (compressed == NULL) {
+        level->failed = 1u;
+        return;
+    }
+    if (batch->tile_size > 0u) {
+        compressed_bytes = pr_compress_page_tiles(
+            batch,
+            index,
+            compressed,
+            level->data_bytes - 1u,
+            &failed
+        );
+        if (failed != 0) {
+            free(compressed);
+            level->failed = 1u;
+            return;
         }
+        level->stored_tile_size = (compressed_bytes > 0u) ? batch->tile_size : 0u;
+    } else {
+        compressed_bytes = pr_lz_compress(
+            level->data,
+            level->data_bytes,
+            compressed,
+            level->data_bytes - 1u
+        );
     }
-
-    memcpy(chunk->id, PR_CHUNK_FORMAT_STRS, 4u);
-    chunk->bytes = buffer.data;
-    chunk->size = buffer.size;
-    return 1;
+    if (compressed_bytes == 0u) {
+        free(compressed);
+        return;
+    }
+    level->stored = compressed;
+    level->stored_bytes = compressed_bytes;
 }
 
-static uint32_t pr_atlas_sampling_code(const char *sampling)
+static void pr_txtr_levels_free(pr_txtr_level_t *levels, size_t level_count)
 {
-    if (sampling != NULL && strcmp(sampling, "linear") == 0) {
-        return 1u;
+    size_t i;
+
+    for (i = 0u; levels != NULL && i < level_count; ++i) {
+        free(levels[i].data);
+        free(levels[i].stored);
     }
-    return 0u;
+    free(levels);
 }
 
 static int pr_build_chunk_txtr(
@@ -1974,14 +3435,20 @@ static int pr_build_chunk_txtr(
     size_t sprite_count,
     const pr_resolved_frame_t *frames,
     size_t frame_count,
+    pr_encode_quality_t encode_quality,
+    pr_page_compression_t compression,
+    uint32_t tile_size,
     pr_chunk_payload_t *chunk
 )
 {
     pr_byte_buffer_t buffer;
-    unsigned char **page_pixels;
-    size_t *page_pixel_bytes;
+    pr_txtr_level_t *levels;
+    pr_palette_t *palettes;
+    size_t *first_level;
+    size_t level_count;
     size_t i;
     size_t j;
+    uint32_t sampling_code;
 
     if (
         manifest == NULL ||
@@ -1995,14 +3462,34 @@ static int pr_build_chunk_txtr(
         return 0;
     }
 
-    page_pixels = NULL;
-    page_pixel_bytes = NULL;
-    if (page_count > 0u) {
-        page_pixels = (unsigned char **)calloc(page_count, sizeof(page_pixels[0]));
-        page_pixel_bytes = (size_t *)calloc(page_count, sizeof(page_pixel_bytes[0]));
-        if (page_pixels == NULL || page_pixel_bytes == NULL) {
-            free(page_pixels);
-            free(page_pixel_bytes);
+    sampling_code = pr_atlas_sampling_code(
+        pr_manifest_string(manifest, manifest->atlas.sampling)
+    );
+
+    /* Levels are laid out page by page; page `i` owns levels
+     * first_level[i] to first_level[i + 1] - 1.
+     */
+    first_level = (size_t *)calloc(page_count + 1u, sizeof(first_level[0]));
+    if (first_level == NULL) {
+        return 0;
+    }
+    level_count = 0u;
+    for (i = 0u; i < page_count; ++i) {
+        if (pages[i].final_w == 0u || pages[i].final_h == 0u) {
+            free(first_level);
+            return 0;
+        }
+        first_level[i] = level_count;
+        level_count += (manifest->atlas.mipmaps != 0) ?
+            (size_t)pr_mipmap_level_count(pages[i].final_w, pages[i].final_h) : 1u;
+    }
+    first_level[page_count] = level_count;
+    levels = NULL;
+    palettes = NULL;
+    if (level_count > 0u) {
+        levels = (pr_txtr_level_t *)calloc(level_count, sizeof(levels[0]));
+        if (levels == NULL) {
+            free(first_level);
             return 0;
         }
     }
@@ -2010,9 +3497,17 @@ static int pr_build_chunk_txtr(
     for (i = 0u; i < page_count; ++i) {
         size_t pixel_count;
         size_t pixel_bytes;
-
-        if (pages[i].final_w == 0u || pages[i].final_h == 0u) {
-            goto fail;
+        pr_txtr_level_t *base;
+
+        for (j = first_level[i]; j < first_level[i + 1u]; ++j) {
+            levels[j].format = pages[i].format;
+            pr_mipmap_level_size(
+                pages[i].final_w,
+                pages[i].final_h,
+                (uint32_t)(j - first_level[i]),
+                &levels[j].width,
+                &levels[j].height
+            );
         }
         if (
             !pr_mul_size((size_t)pages[i].final_w, (size_t)pages[i].final_h, &pixel_count) ||
@@ -2024,11 +3519,12 @@ static int pr_build_chunk_txtr(
             goto fail;
         }
 
-        page_pixels[i] = (unsigned char *)calloc(1u, pixel_bytes);
-        if (page_pixels[i] == NULL) {
+        base = &levels[first_level[i]];
+        base->data = (unsigned char *)calloc(1u, pixel_bytes);
+        if (base->data == NULL) {
             goto fail;
         }
-        page_pixel_bytes[i] = pixel_bytes;
+        base->data_bytes = pixel_bytes;
     }
 
     for (i = 0u; i < frame_count; ++i) {
@@ -2036,7 +3532,7 @@ static int pr_build_chunk_txtr(
         uint32_t sprite_index;
         uint32_t image_index;
         const pr_imported_image_t *source_image;
-        unsigned char *page_buffer;
+        pr_txtr_level_t *page_level;
         size_t page_stride;
         size_t src_row_bytes;
         uint32_t row;
@@ -2068,7 +3564,7 @@ static int pr_build_chunk_txtr(
             goto fail;
         }
 
-        page_buffer = page_pixels[page_index];
+        page_level = &levels[first_level[page_index]];
         page_stride = (size_t)pages[page_index].final_w * 4u;
         src_row_bytes = (size_t)frames[i].source_w * 4u;
 
@@ -2085,61 +3581,231 @@ static int pr_build_chunk_txtr(
 
             if (
                 src_offset + src_row_bytes > source_image->pixel_bytes ||
-                dst_offset + src_row_bytes > page_pixel_bytes[page_index]
+                dst_offset + src_row_bytes > page_level->data_bytes
             ) {
                 goto fail;
             }
 
             src_row = source_image->pixels + src_offset;
-            dst_row = page_buffer + dst_offset;
+            dst_row = page_level->data + dst_offset;
             memcpy(dst_row, src_row, src_row_bytes);
         }
     }
 
+    if ((manifest->atlas.extrude > 0 || manifest->atlas.bleed_alpha != 0) && frame_count > 0u) {
+        pr_frame_gutter_batch_t gutters;
+
+        gutters.levels = levels;
+        gutters.first_level = first_level;
+        gutters.pages = pages;
+        gutters.frames = frames;
+        gutters.padding = (manifest->atlas.padding > 0) ? (uint32_t)manifest->atlas.padding : 0u;
+        gutters.extrude = (manifest->atlas.extrude > 0) ? (uint32_t)manifest->atlas.extrude : 0u;
+        gutters.bleed_alpha = manifest->atlas.bleed_alpha;
+        gutters.failed = (unsigned char *)calloc(frame_count, 1u);
+        if (gutters.failed == NULL) {
+            goto fail;
+        }
+        PR_PROFILE_BEGIN("pr_fill_frame_gutters");
+        pr_parallel_for(frame_count, pr_frame_gutter_batch_run, &gutters);
+        PR_PROFILE_END("pr_fill_frame_gutters");
+        for (i = 0u; i < frame_count; ++i) {
+            if (gutters.failed[i] != 0u) {
+                free(gutters.failed);
+                goto fail;
+            }
+        }
+        free(gutters.failed);
+    }
+
+    if (level_count > page_count) {
+        pr_mipmap_batch_t mipmaps;
+
+        mipmaps.levels = levels;
+        mipmaps.first_level = first_level;
+        mipmaps.pages = pages;
+        PR_PROFILE_BEGIN("pr_generate_mipmaps");
+        pr_parallel_for(page_count, pr_mipmap_batch_run, &mipmaps);
+        PR_PROFILE_END("pr_generate_mipmaps");
+        for (i = 0u; i < level_count; ++i) {
+            if (levels[i].failed != 0u) {
+                goto fail;
+            }
+        }
+    }
+
+    for (i = 0u; i < page_count; ++i) {
+        if (pages[i].format == PR_PAGE_FORMAT_INDEXED8) {
+            break;
+        }
+    }
+    if (i < page_count) {
+        pr_palette_batch_t palette_batch;
+
+        palettes = (pr_palette_t *)calloc(page_count, sizeof(palettes[0]));
+        if (palettes == NULL) {
+            goto fail;
+        }
+        palette_batch.levels = levels;
+        palette_batch.first_level = first_level;
+        palette_batch.palettes = palettes;
+        PR_PROFILE_BEGIN("pr_build_palettes");
+        pr_parallel_for(page_count, pr_palette_batch_run, &palette_batch);
+        PR_PROFILE_END("pr_build_palettes");
+        for (i = 0u; i < level_count; ++i) {
+            if (levels[i].failed != 0u) {
+                goto fail;
+            }
+        }
+    }
+
+    for (i = 0u; i < level_count; ++i) {
+        unsigned char *encoded;
+        uint32_t row_bytes;
+        uint32_t data_bytes;
+        int encoded_ok;
+
+        if (levels[i].format == PR_PAGE_FORMAT_RGBA8 || levels[i].format == PR_PAGE_FORMAT_INDEXED8) {
+            continue;
+        }
+        if (!pr_page_format_layout(
+                levels[i].format,
+                levels[i].width,
+                levels[i].height,
+                &row_bytes,
+                &data_bytes
+            )) {
+            goto fail;
+        }
+        encoded = (unsigned char *)malloc(data_bytes);
+        if (encoded == NULL) {
+            goto fail;
+        }
+        if (pr_page_format_block_bytes(levels[i].format) > 0u) {
+            encoded_ok = pr_block_encode_page(
+                levels[i].format,
+                encode_quality,
+                levels[i].data,
+                levels[i].width,
+                levels[i].height,
+                levels[i].width * 4u,
+                encoded
+            );
+        } else {
+            encoded_ok = pr_pixel_encode_page(
+                levels[i].format,
+                manifest->atlas.dither,
+                levels[i].data,
+                levels[i].width,
+                levels[i].height,
+                levels[i].width * 4u,
+                encoded
+            );
+        }
+        if (!encoded_ok) {
+            free(encoded);
+            goto fail;
+        }
+        free(levels[i].data);
+        levels[i].data = encoded;
+        levels[i].data_bytes = data_bytes;
+    }
+
+    if (compression == PR_PAGE_COMPRESSION_LZ && level_count > 0u) {
+        pr_page_compress_batch_t compress;
+
+        compress.levels = levels;
+        compress.tile_size = tile_size;
+        PR_PROFILE_BEGIN("pr_compress_pages");
+        pr_parallel_for(level_count, pr_page_compress_batch_run, &compress);
+        PR_PROFILE_END("pr_compress_pages");
+        for (i = 0u; i < level_count; ++i) {
+            if (levels[i].failed != 0u) {
+                goto fail;
+            }
+        }
+    }
+
     pr_byte_buffer_init(&buffer);
     if (
-        !pr_byte_buffer_append_u32_le(&buffer, 1u) ||
+        !pr_byte_buffer_append_u32_le(&buffer, PR_TXTR_VERSION) ||
         !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)page_count) ||
         !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)manifest->atlas.max_page_width) ||
         !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)manifest->atlas.max_page_height) ||
         !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)manifest->atlas.padding) ||
         !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)(manifest->atlas.power_of_two != 0)) ||
-        !pr_byte_buffer_append_u32_le(&buffer, pr_atlas_sampling_code(manifest->atlas.sampling))
+        !pr_byte_buffer_append_u32_le(&buffer, sampling_code) ||
+        !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)pr_manifest_atlas_layout(manifest))
     ) {
         pr_byte_buffer_free(&buffer);
-        return 0;
+        goto fail;
     }
 
+    /* Levels that did not shrink are stored uncompressed. Pages other than
+     * indexed8 store an empty palette. Level data starts on a 64-byte chunk
+     * offset, and chunks are 64-byte aligned in the file, so page blobs can
+     * be read straight into aligned buffers.
+     */
     for (i = 0u; i < page_count; ++i) {
+        uint32_t palette_count;
+
+        palette_count = (palettes != NULL) ? palettes[i].count : 0u;
         if (
             !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)i) ||
             !pr_byte_buffer_append_u32_le(&buffer, pages[i].final_w) ||
             !pr_byte_buffer_append_u32_le(&buffer, pages[i].final_h) ||
-            !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)page_pixel_bytes[i]) ||
-            !pr_byte_buffer_append(&buffer, page_pixels[i], page_pixel_bytes[i])
+            !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)pages[i].format) ||
+            !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)(first_level[i + 1u] - first_level[i])) ||
+            !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)pages[i].color_space) ||
+            !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)pages[i].alpha_mode) ||
+            !pr_byte_buffer_append_u32_le(&buffer, palette_count) ||
+            (palette_count > 0u &&
+                !pr_byte_buffer_append(&buffer, palettes[i].colors, (size_t)palette_count * 4u))
         ) {
             pr_byte_buffer_free(&buffer);
             goto fail;
         }
+        for (j = first_level[i]; j < first_level[i + 1u]; ++j) {
+            int is_compressed;
+
+            is_compressed = levels[j].stored != NULL;
+            if (
+                !pr_byte_buffer_append_u32_le(
+                    &buffer,
+                    (uint32_t)(is_compressed ? PR_PAGE_COMPRESSION_LZ : PR_PAGE_COMPRESSION_NONE)
+                ) ||
+                !pr_byte_buffer_append_u32_le(&buffer, levels[j].stored_tile_size) ||
+                !pr_byte_buffer_append_u32_le(&buffer, (uint32_t)levels[j].data_bytes) ||
+                !pr_byte_buffer_append_u32_le(
+                    &buffer,
+                    (uint32_t)(is_compressed ? levels[j].stored_bytes : levels[j].data_bytes)
+                ) ||
+                !pr_byte_buffer_pad(&buffer, PR_TXTR_DATA_ALIGNMENT) ||
+                !pr_byte_buffer_append(
+                    &buffer,
+                    is_compressed ? levels[j].stored : levels[j].data,
+                    is_compressed ? levels[j].stored_bytes : levels[j].data_bytes
+                )
+            ) {
+                pr_byte_buffer_free(&buffer);
+                goto fail;
+            }
+        }
     }
 
     memcpy(chunk->id, PR_CHUNK_FORMAT_TXTR, 4u);
     chunk->bytes = buffer.data;
     chunk->size = buffer.size;
 
-    for (j = 0u; j < page_count; ++j) {
-        free(page_pixels[j]);
-    }
-    free(page_pixels);
-    free(page_pixel_bytes);
+    pr_txtr_levels_free(levels, level_count);
+    free(palettes);
+    free(first_level);
     return 1;
 
 fail:
-    for (j = 0u; j < page_count; ++j) {
-        free(page_pixels[j]);
-    }
-    free(page_pixels);
-    free(page_pixel_bytes);
+    pr_txtr_levels_free(levels, level_count);
+    free(palettes);
+    free(first_level);
     return 0;
 }
 
@@ -2400,6 +4066,43 @@ static int pr_write_u64_le(FILE *file, uint64_t value)
     return (fwrite(bytes, 1u, sizeof(bytes), file) == sizeof(bytes)) ? 1 : 0;
 }
 
+static int pr_write_zeros(FILE *file, size_t count)
+{
+    static const unsigned char zeros[PR_PACKAGE_ALIGNMENT];
+    size_t written;
+
+    while (count > 0u) {
+        written = (count < sizeof(zeros)) ? count : sizeof(zeros);
+        if (fwrite(zeros, 1u, written, file) != written) {
+            return 0;
+        }
+        count -= written;
+    }
+    return 1;
+}
+
+static uint64_t pr_package_align(uint64_t offset)
+{
+    return ((offset + PR_PACKAGE_ALIGNMENT - 1u) / PR_PACKAGE_ALIGNMENT) * PR_PACKAGE_ALIGNMENT;
+}
+
+typedef struct pr_chunk_checksum_batch {
+    const pr_chunk_payload_t *chunks;
+    uint32_t *checksums;
+} pr_chunk_checksum_batch_t;
+
+static void pr_chunk_checksum_batch_run(void *user_data, size_t index)
+{
+    pr_chunk_checksum_batch_t *batch;
+
+    batch = (pr_chunk_checksum_batch_t *)user_data;
+    batch->checksums[index] = pr_crc32c(0u, batch->chunks[index].bytes, batch->chunks[index].size);
+}
+
+/* Writes the v2 container: a 64-byte header, the chunk table, then every
+ * payload at a 64-byte aligned offset, with the file padded to a multiple of
+ * 64 bytes. Each table entry carries the payload's CRC-32C.
+ */
 static pr_status_t pr_write_package_with_chunks(
     const char *output_path,
     const pr_chunk_payload_t *chunks,
@@ -2409,9 +4112,12 @@ static pr_status_t pr_write_package_with_chunks(
 )
 {
     FILE *file;
-    uint32_t header_size;
-    uint64_t chunk_table_offset;
-    uint64_t payload_offset;
+    uint64_t *offsets;
+    uint32_t *checksums;
+    pr_chunk_checksum_batch_t checksum_batch;
+    uint64_t chunk_table_end;
+    uint64_t file_size;
+    uint64_t written;
     size_t i;
 
     if (
@@ -2450,48 +4156,85 @@ static pr_status_t pr_write_package_with_chunks(
         return PR_STATUS_IO_ERROR;
     }
 
-    header_size = 24u;
-    chunk_table_offset = (uint64_t)header_size;
-    payload_offset = chunk_table_offset + (uint64_t)chunk_count * 20u;
+    offsets = (uint64_t *)malloc(chunk_count * sizeof(offsets[0]));
+    checksums = (uint32_t *)malloc(chunk_count * sizeof(checksums[0]));
+    if (offsets == NULL || checksums == NULL) {
+        free(offsets);
+        free(checksums);
+        (void)fclose(file);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    checksum_batch.chunks = chunks;
+    checksum_batch.checksums = checksums;
+    PR_PROFILE_BEGIN("pr_checksum_chunks");
+    pr_parallel_for(chunk_count, pr_chunk_checksum_batch_run, &checksum_batch);
+    PR_PROFILE_END("pr_checksum_chunks");
+    chunk_table_end = (uint64_t)PR_PACKAGE_HEADER_SIZE +
+        (uint64_t)chunk_count * PR_PACKAGE_CHUNK_ENTRY_SIZE;
+    file_size = pr_package_align(chunk_table_end);
+    for (i = 0u; i < chunk_count; ++i) {
+        offsets[i] = file_size;
+        file_size = pr_package_align(file_size + (uint64_t)chunks[i].size);
+    }
 
     if (
         fwrite("PRPK", 1u, 4u, file) != 4u ||
         !pr_write_u16_le(file, PR_PACKAGE_VERSION_MAJOR) ||
         !pr_write_u16_le(file, PR_PACKAGE_VERSION_MINOR) ||
-        !pr_write_u32_le(file, header_size) ||
+        !pr_write_u32_le(file, PR_PACKAGE_HEADER_SIZE) ||
         !pr_write_u32_le(file, (uint32_t)chunk_count) ||
-        !pr_write_u64_le(file, chunk_table_offset)
+        !pr_write_u64_le(file, PR_PACKAGE_HEADER_SIZE) ||
+        !pr_write_u32_le(file, PR_PACKAGE_CHUNK_ENTRY_SIZE) ||
+        !pr_write_u32_le(file, PR_PACKAGE_ALIGNMENT) ||
+        !pr_write_u64_le(file, file_size) ||
+        !pr_write_zeros(file, PR_PACKAGE_HEADER_SIZE - 40u)
     ) {
-        (void)fclose(file);
-        return PR_STATUS_IO_ERROR;
+        goto fail;
     }
 
     for (i = 0u; i < chunk_count; ++i) {
         if (
             fwrite(chunks[i].id, 1u, 4u, file) != 4u ||
-            !pr_write_u64_le(file, payload_offset) ||
-            !pr_write_u64_le(file, (uint64_t)chunks[i].size)
+            !pr_write_u32_le(file, PR_PACKAGE_CHUNK_FLAG_CHECKSUM) ||
+            !pr_write_u64_le(file, offsets[i]) ||
+            !pr_write_u64_le(file, (uint64_t)chunks[i].size) ||
+            !pr_write_u64_le(file, (uint64_t)chunks[i].size) ||
+            !pr_write_u32_le(file, PR_PACKAGE_CHUNK_CODEC_NONE) ||
+            !pr_write_u32_le(file, checksums[i])
         ) {
-            (void)fclose(file);
-            return PR_STATUS_IO_ERROR;
+            goto fail;
         }
-        payload_offset += (uint64_t)chunks[i].size;
     }
 
+    written = chunk_table_end;
     for (i = 0u; i < chunk_count; ++i) {
         if (
-            chunks[i].size > 0u &&
-            fwrite(chunks[i].bytes, 1u, chunks[i].size, file) != chunks[i].size
+            !pr_write_zeros(file, (size_t)(offsets[i] - written)) ||
+            (
+                chunks[i].size > 0u &&
+                fwrite(chunks[i].bytes, 1u, chunks[i].size, file) != chunks[i].size
+            )
         ) {
-            (void)fclose(file);
-            return PR_STATUS_IO_ERROR;
+            goto fail;
         }
+        written = offsets[i] + (uint64_t)chunks[i].size;
     }
+    if (!pr_write_zeros(file, (size_t)(file_size - written))) {
+        goto fail;
+    }
+    free(offsets);
+    free(checksums);
 
     if (fclose(file) != 0) {
         return PR_STATUS_IO_ERROR;
     }
     return PR_STATUS_OK;
+
+fail:
+    free(offsets);
+    free(checksums);
+    (void)fclose(file);
+    return PR_STATUS_IO_ERROR;
 }
 
 static void pr_write_json_escaped(FILE *file, const char *text)
@@ -2536,11 +4279,131 @@ static const char *pr_image_format_name(uint32_t format)
     }
 }
 
+static pr_build_page_stats_t *pr_build_page_stats_create(
+    const pr_pack_page_t *pages,
+    size_t page_count
+)
+{
+    pr_build_page_stats_t *stats;
+    size_t i;
+
+    stats = (pr_build_page_stats_t *)calloc((page_count == 0u) ? 1u : page_count, sizeof(stats[0]));
+    if (stats == NULL) {
+        return NULL;
+    }
+    for (i = 0u; i < page_count; ++i) {
+        uint64_t total;
+        uint32_t row_bytes;
+        uint32_t data_bytes;
+
+        total = (uint64_t)pages[i].final_w * (uint64_t)pages[i].final_h;
+        if (!pr_page_format_layout(
+                pages[i].format,
+                pages[i].final_w,
+                pages[i].final_h,
+                &row_bytes,
+                &data_bytes
+            )) {
+            data_bytes = 0u;
+        }
+        stats[i].width = pages[i].final_w;
+        stats[i].height = pages[i].final_h;
+        stats[i].frame_count = pages[i].frame_count;
+        stats[i].used_pixels = (unsigned long long)pages[i].used_pixels;
+        stats[i].wasted_pixels = (unsigned long long)(total - pages[i].used_pixels);
+        stats[i].occupancy = (total > 0u) ? (double)pages[i].used_pixels / (double)total : 0.0;
+        stats[i].format = pages[i].format;
+        stats[i].data_bytes = (unsigned long long)data_bytes;
+    }
+    return stats;
+}
+
+static void pr_write_debug_json_atlas(
+    FILE *file,
+    const pr_build_result_t *result,
+    int pretty_json
+)
+{
+    unsigned int i;
+
+    if (pretty_json != 0) {
+        (void)fputs("  \"atlas\": {\n", file);
+        (void)fprintf(file, "    \"pack_time_ms\": %.3f,\n", result->pack_time_ms);
+        (void)fprintf(file, "    \"used_pixels\": %llu,\n", result->atlas_used_pixels);
+        (void)fprintf(file, "    \"total_pixels\": %llu,\n", result->atlas_total_pixels);
+        (void)fprintf(
+            file,
+            "    \"wasted_pixels\": %llu,\n",
+            result->atlas_total_pixels - result->atlas_used_pixels
+        );
+        (void)fprintf(file, "    \"occupancy\": %.4f,\n", result->atlas_occupancy);
+        (void)fputs("    \"pages\": [\n", file);
+        for (i = 0u; i < result->atlas_page_count; ++i) {
+            const pr_build_page_stats_t *page;
+
+            page = &result->atlas_pages[i];
+            (void)fprintf(
+                file,
+                "      { \"index\": %u, \"width\": %u, \"height\": %u, \"frames\": %u, "
+                "\"used_pixels\": %llu, \"wasted_pixels\": %llu, \"occupancy\": %.4f, "
+                "\"format\": \"%s\", \"data_bytes\": %llu }%s\n",
+                i,
+                page->width,
+                page->height,
+                page->frame_count,
+                page->used_pixels,
+                page->wasted_pixels,
+                page->occupancy,
+                pr_page_format_name(page->format),
+                page->data_bytes,
+                (i + 1u < result->atlas_page_count) ? "," : ""
+            );
+        }
+        (void)fputs("    ]\n", file);
+        (void)fputs("  }\n", file);
+        return;
+    }
+
+    (void)fprintf(
+        file,
+        ",\"atlas\":{\"pack_time_ms\":%.3f,\"used_pixels\":%llu,\"total_pixels\":%llu,"
+        "\"wasted_pixels\":%llu,\"occupancy\":%.4f,\"pages\":[",
+        result->pack_time_ms,
+        result->atlas_used_pixels,
+        result->atlas_total_pixels,
+        result->atlas_total_pixels - result->atlas_used_pixels,
+        result->atlas_occupancy
+    );
+    for (i = 0u; i < result->atlas_page_count; ++i) {
+        const pr_build_page_stats_t *page;
+
+        page = &result->atlas_pages[i];
+        (void)fprintf(
+            file,
+            "%s{\"index\":%u,\"width\":%u,\"height\":%u,\"frames\":%u,"
+            "\"used_pixels\":%llu,\"wasted_pixels\":%llu,\"occupancy\":%.4f,"
+            "\"format\":\"%s\",\"data_bytes\":%llu}",
+            (i > 0u) ? "," : "",
+            i,
+            page->width,
+            page->height,
+            page->frame_count,
+            page->used_pixels,
+            page->wasted_pixels,
+            page->occupancy,
+            pr_page_format_name(page->format),
+            page->data_bytes
+        );
+    }
+    (void)fputs("]}", file);
+}
+
 static pr_status_t pr_write_debug_json(
     const char *debug_path,
     const pr_manifest_t *manifest,
     const pr_imported_image_t *images,
     const char *resolved_output_path,
+    const pr_build_result_t *result,
     int pretty_json,
     pr_diag_sink_fn diag_sink,
     void *diag_user_data
@@ -2553,7 +4416,8 @@ static pr_status_t pr_write_debug_json(
         debug_path == NULL ||
         debug_path[0] == '\0' ||
         manifest == NULL ||
-        resolved_output_path == NULL
+        resolved_output_path == NULL ||
+        result == NULL
     ) {
         return PR_STATUS_INVALID_ARGUMENT;
     }
@@ -2589,7 +4453,7 @@ static pr_status_t pr_write_debug_json(
         (void)fputs("{\n", file);
         (void)fprintf(file, "  \"schema_version\": %d,\n", manifest->schema_version);
         (void)fputs("  \"package_name\": \"", file);
-        pr_write_json_escaped(file, manifest->package_name);
+        pr_write_json_escaped(file, pr_manifest_string(manifest, manifest->package_name));
         (void)fputs("\",\n", file);
         (void)fputs("  \"output\": \"", file);
         pr_write_json_escaped(file, resolved_output_path);
@@ -2604,7 +4468,7 @@ static pr_status_t pr_write_debug_json(
         for (i = 0u; i < manifest->image_count; ++i) {
             (void)fputs("    {\n", file);
             (void)fputs("      \"id\": \"", file);
-            pr_write_json_escaped(file, manifest->images[i].id);
+            pr_write_json_escaped(file, pr_manifest_string(manifest, manifest->images[i].id));
             (void)fputs("\",\n", file);
             (void)fputs("      \"resolved_path\": \"", file);
             pr_write_json_escaped(file, images[i].resolved_path);
@@ -2617,13 +4481,14 @@ static pr_status_t pr_write_debug_json(
             (void)fputs("\"\n", file);
             (void)fputs((i + 1u < manifest->image_count) ? "    },\n" : "    }\n", file);
         }
-        (void)fputs("  ]\n", file);
+        (void)fputs("  ],\n", file);
+        pr_write_debug_json_atlas(file, result, 1);
         (void)fputs("}\n", file);
     } else {
         (void)fputs("{\"schema_version\":", file);
         (void)fprintf(file, "%d", manifest->schema_version);
         (void)fputs(",\"package_name\":\"", file);
-        pr_write_json_escaped(file, manifest->package_name);
+        pr_write_json_escaped(file, pr_manifest_string(manifest, manifest->package_name));
         (void)fputs("\",\"output\":\"", file);
         pr_write_json_escaped(file, resolved_output_path);
         (void)fputs("\",\"counts\":{\"images\":", file);
@@ -2635,7 +4500,7 @@ static pr_status_t pr_write_debug_json(
         (void)fputs("},\"images\":[", file);
         for (i = 0u; i < manifest->image_count; ++i) {
             (void)fputs("{\"id\":\"", file);
-            pr_write_json_escaped(file, manifest->images[i].id);
+            pr_write_json_escaped(file, pr_manifest_string(manifest, manifest->images[i].id));
             (void)fputs("\",\"resolved_path\":\"", file);
             pr_write_json_escaped(file, images[i].resolved_path);
             (void)fprintf(
@@ -2650,7 +4515,9 @@ static pr_status_t pr_write_debug_json(
                 (void)fputs(",", file);
             }
         }
-        (void)fputs("]}\n", file);
+        (void)fputs("]", file);
+        pr_write_debug_json_atlas(file, result, 0);
+        (void)fputs("}\n", file);
     }
 
     if (fclose(file) != 0) {
@@ -2659,6 +4526,59 @@ static pr_status_t pr_write_debug_json(
     return PR_STATUS_OK;
 }
 
+/* Records where every frame landed, for the next incremental build. */
+static pr_status_t pr_write_pack_lock(
+    const char *path,
+    const pr_manifest_t *manifest,
+    const pr_resolved_frame_t *frames,
+    size_t frame_count,
+    const pr_pack_page_t *pages,
+    size_t page_count
+)
+{
+    pr_pack_lock_t lock;
+    uint32_t padding;
+    uint32_t cell;
+    size_t i;
+    int ok;
+
+    memset(&lock, 0, sizeof(lock));
+    padding = (manifest->atlas.padding > 0) ? (uint32_t)manifest->atlas.padding : 0u;
+    cell = pr_pack_cell_size(manifest);
+    lock.max_page_width = (uint32_t)manifest->atlas.max_page_width;
+    lock.max_page_height = (uint32_t)manifest->atlas.max_page_height;
+    lock.padding = padding;
+    lock.cell = cell;
+    lock.page_count = page_count;
+    lock.frame_count = frame_count;
+    lock.pages = (pr_pack_lock_page_t *)calloc(page_count > 0u ? page_count : 1u, sizeof(lock.pages[0]));
+    lock.frames = (pr_pack_lock_frame_t *)calloc(frame_count > 0u ? frame_count : 1u, sizeof(lock.frames[0]));
+    if (lock.pages == NULL || lock.frames == NULL) {
+        free(lock.pages);
+        free(lock.frames);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    for (i = 0u; i < page_count; ++i) {
+        lock.pages[i].color_space = pages[i].color_space;
+        lock.pages[i].alpha_mode = pages[i].alpha_mode;
+    }
+    for (i = 0u; i < frame_count; ++i) {
+        lock.frames[i].sprite_id = pr_manifest_string(manifest, manifest->sprites[frames[i].sprite_index].id);
+        lock.frames[i].local_frame_index = frames[i].local_frame_index;
+        lock.frames[i].page = frames[i].atlas_page;
+        lock.frames[i].x = frames[i].atlas_x - padding;
+        lock.frames[i].y = frames[i].atlas_y - padding;
+        lock.frames[i].w = pr_pack_frame_extent(frames[i].source_w, padding, cell);
+        lock.frames[i].h = pr_pack_frame_extent(frames[i].source_h, padding, cell);
+    }
+
+    ok = pr_pack_lock_write(path, &lock);
+    free(lock.pages);
+    free(lock.frames);
+    return (ok != 0) ? PR_STATUS_OK : PR_STATUS_IO_ERROR;
+}
+
 pr_status_t pr_validate_manifest_file(
     const char *manifest_path,
     pr_diag_sink_fn diag_sink,
@@ -2673,6 +4593,7 @@ pr_status_t pr_validate_manifest_file(
     pr_manifest_init(&manifest);
     status = pr_manifest_load_and_validate(
         manifest_path,
+        0u,
         diag_sink,
         diag_user_data,
         &manifest,
@@ -2697,16 +4618,196 @@ pr_status_t pr_validate_manifest_file(
     return PR_STATUS_OK;
 }
 
+pr_status_t pr_validate_manifest_file_deep(
+    const char *manifest_path,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data
+)
+{
+    pr_manifest_t manifest;
+    pr_imported_image_t *images;
+    pr_intern_pool_t strings;
+    pr_index_maps_t maps;
+    pr_resolved_sprite_t *resolved_sprites;
+    size_t resolved_sprite_count;
+    pr_resolved_frame_t *resolved_frames;
+    size_t resolved_frame_count;
+    pr_resolved_animation_t *resolved_animations;
+    size_t resolved_animation_count;
+    pr_resolved_animation_key_t *resolved_animation_keys;
+    size_t resolved_animation_key_count;
+    pr_status_t status;
+    int error_count;
+    int warning_count;
+
+    pr_manifest_init(&manifest);
+    images = NULL;
+    pr_intern_pool_init(&strings);
+    memset(&maps, 0, sizeof(maps));
+    resolved_sprites = NULL;
+    resolved_sprite_count = 0u;
+    resolved_frames = NULL;
+    resolved_frame_count = 0u;
+    resolved_animations = NULL;
+    resolved_animation_count = 0u;
+    resolved_animation_keys = NULL;
+    resolved_animation_key_count = 0u;
+    PR_PROFILE_BEGIN("pr_validate_manifest_file_deep");
+
+    status = pr_manifest_load_and_validate(
+        manifest_path,
+        0u,
+        diag_sink,
+        diag_user_data,
+        &manifest,
+        &error_count,
+        &warning_count
+    );
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    PR_PROFILE_BEGIN("pr_import_manifest_image_headers");
+    status = pr_import_manifest_image_headers(
+        manifest_path,
+        &manifest,
+        diag_sink,
+        diag_user_data,
+        &images
+    );
+    PR_PROFILE_END("pr_import_manifest_image_headers");
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    if (!pr_allocate_index_maps(&manifest, &maps)) {
+        status = PR_STATUS_ALLOCATION_FAILED;
+        goto cleanup;
+    }
+    if (!pr_build_string_table_and_maps(
+            &manifest,
+            images,
+            &strings,
+            &maps,
+            diag_sink,
+            diag_user_data
+        )) {
+        status = PR_STATUS_INTERNAL_ERROR;
+        goto cleanup;
+    }
+
+    status = pr_resolve_sprite_frames(
+        &manifest,
+        images,
+        &maps,
+        manifest_path,
+        diag_sink,
+        diag_user_data,
+        &resolved_sprites,
+        &resolved_sprite_count,
+        &resolved_frames,
+        &resolved_frame_count
+    );
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    status = pr_resolve_animations(
+        &manifest,
+        &maps,
+        resolved_sprites,
+        resolved_sprite_count,
+        diag_sink,
+        diag_user_data,
+        &resolved_animations,
+        &resolved_animation_count,
+        &resolved_animation_keys,
+        &resolved_animation_key_count
+    );
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    pr_emit_diag(
+        diag_sink,
+        diag_user_data,
+        PR_DIAG_NOTE,
+        "Manifest and frame bounds validated successfully.",
+        manifest_path,
+        "manifest.valid",
+        NULL
+    );
+
+cleanup:
+    free(resolved_animation_keys);
+    free(resolved_animations);
+    free(resolved_frames);
+    free(resolved_sprites);
+    pr_free_index_maps(&maps);
+    pr_intern_pool_free(&strings);
+    pr_imported_images_free(images, manifest.image_count);
+    pr_manifest_free(&manifest);
+    PR_PROFILE_END("pr_validate_manifest_file_deep");
+    return status;
+}
+
+const char *pr_build_stage_name(pr_build_stage_t stage)
+{
+    switch (stage) {
+    case PR_BUILD_STAGE_LOAD:
+        return "load";
+    case PR_BUILD_STAGE_DECODE:
+        return "decode";
+    case PR_BUILD_STAGE_RESOLVE:
+        return "resolve";
+    case PR_BUILD_STAGE_PACK:
+        return "pack";
+    case PR_BUILD_STAGE_ENCODE:
+        return "encode";
+    case PR_BUILD_STAGE_WRITE:
+        return "write";
+    default:
+        return "unknown";
+    }
+}
+
+static void pr_build_timings_mark(
+    pr_build_timings_t *timings,
+    pr_build_stage_t stage,
+    double *stage_start
+)
+{
+    double now;
+
+    if (timings == NULL) {
+        return;
+    }
+    now = pr_timer_now_ms();
+    timings->stage_ms[stage] += now - *stage_start;
+    *stage_start = now;
+}
+
 pr_status_t pr_build_package(
     const pr_build_options_t *options,
     pr_diag_sink_fn diag_sink,
     void *diag_user_data,
     pr_build_result_t *out_result
 )
+{
+    return pr_build_package_timed(options, diag_sink, diag_user_data, out_result, NULL);
+}
+
+pr_status_t pr_build_package_timed(
+    const pr_build_options_t *options,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data,
+    pr_build_result_t *out_result,
+    pr_build_timings_t *out_timings
+)
 {
     pr_manifest_t manifest;
     pr_imported_image_t *images;
-    pr_string_table_t strings;
+    pr_intern_pool_t strings;
     pr_index_maps_t maps;
     pr_resolved_sprite_t *resolved_sprites;
     size_t resolved_sprite_count;
@@ -2726,6 +4827,20 @@ pr_status_t pr_build_package(
     int validation_warnings;
     int warning_count;
     int i;
+    double build_start;
+    double stage_start;
+    double pack_start;
+    int chunks_ok;
+    const char *format_name;
+    const char *encode_quality_name;
+    const char *compression_name;
+    pr_page_format_t page_format;
+    int auto_format;
+    pr_encode_quality_t encode_quality;
+    pr_page_compression_t compression;
+    char *lock_path;
+    pr_pack_lock_t lock;
+    int has_lock;
 
     if (
         options == NULL ||
@@ -2745,10 +4860,11 @@ pr_status_t pr_build_package(
     }
 
     memset(out_result, 0, sizeof(*out_result));
+    free(PR_BUILD_RESULT_STORAGE.page_stats);
     memset(&PR_BUILD_RESULT_STORAGE, 0, sizeof(PR_BUILD_RESULT_STORAGE));
     pr_manifest_init(&manifest);
     images = NULL;
-    pr_string_table_init(&strings);
+    pr_intern_pool_init(&strings);
     memset(&maps, 0, sizeof(maps));
     resolved_sprites = NULL;
     resolved_sprite_count = 0u;
@@ -2761,15 +4877,27 @@ pr_status_t pr_build_package(
     resolved_animation_keys = NULL;
     resolved_animation_key_count = 0u;
     memset(chunks, 0, sizeof(chunks));
+    lock_path = NULL;
+    memset(&lock, 0, sizeof(lock));
+    has_lock = 0;
+    if (out_timings != NULL) {
+        memset(out_timings, 0, sizeof(*out_timings));
+    }
+    build_start = pr_timer_now_ms();
+    stage_start = build_start;
+    PR_PROFILE_BEGIN("pr_build_package");
 
+    PR_PROFILE_BEGIN("pr_manifest_load_and_validate");
     status = pr_manifest_load_and_validate(
         options->manifest_path,
+        (options->no_manifest_cache != 0) ? 0u : PR_MANIFEST_LOAD_USE_CACHE,
         diag_sink,
         diag_user_data,
         &manifest,
         &validation_errors,
         &validation_warnings
     );
+    PR_PROFILE_END("pr_manifest_load_and_validate");
     if (status != PR_STATUS_OK) {
         goto cleanup;
     }
@@ -2779,7 +4907,7 @@ pr_status_t pr_build_package(
     output_path = (
         options->output_override != NULL &&
         options->output_override[0] != '\0'
-    ) ? options->output_override : manifest.output;
+    ) ? options->output_override : pr_manifest_string(&manifest, manifest.output);
     if (
         output_path == NULL ||
         output_path[0] == '\0' ||
@@ -2819,7 +4947,8 @@ pr_status_t pr_build_package(
         options->debug_output_override != NULL &&
         options->debug_output_override[0] != '\0'
     ) ? options->debug_output_override :
-        ((manifest.has_debug_output != 0) ? manifest.debug_output : NULL);
+        ((manifest.has_debug_output != 0) ?
+            pr_manifest_string(&manifest, manifest.debug_output) : NULL);
     if (
         debug_output_path != NULL &&
         debug_output_path[0] != '\0' &&
@@ -2842,6 +4971,63 @@ pr_status_t pr_build_package(
         goto cleanup;
     }
 
+    format_name = (
+        options->format_override != NULL &&
+        options->format_override[0] != '\0'
+    ) ? options->format_override : pr_manifest_string(&manifest, manifest.atlas.format);
+    auto_format = pr_page_format_is_auto(format_name);
+    page_format = PR_PAGE_FORMAT_RGBA8;
+    if (auto_format == 0 && !pr_page_format_from_name(format_name, &page_format)) {
+        pr_emit_diag(
+            diag_sink,
+            diag_user_data,
+            PR_DIAG_ERROR,
+            "Format must be auto, rgba8, rgb565, rgba4444, r8, ra8, indexed8, bc1, bc3, bc7, etc2_rgb or etc2_rgba.",
+            options->manifest_path,
+            "build.format_unknown",
+            NULL
+        );
+        status = PR_STATUS_VALIDATION_ERROR;
+        goto cleanup;
+    }
+    encode_quality_name = (
+        options->encode_quality_override != NULL &&
+        options->encode_quality_override[0] != '\0'
+    ) ? options->encode_quality_override :
+        pr_manifest_string(&manifest, manifest.atlas.encode_quality);
+    if (!pr_encode_quality_from_name(encode_quality_name, &encode_quality)) {
+        pr_emit_diag(
+            diag_sink,
+            diag_user_data,
+            PR_DIAG_ERROR,
+            "Encode quality must be fast, balanced or best.",
+            options->manifest_path,
+            "build.encode_quality_unknown",
+            NULL
+        );
+        status = PR_STATUS_VALIDATION_ERROR;
+        goto cleanup;
+    }
+    compression_name = (
+        options->compression_override != NULL &&
+        options->compression_override[0] != '\0'
+    ) ? options->compression_override : pr_manifest_string(&manifest, manifest.atlas.compression);
+    if (!pr_page_compression_from_name(compression_name, &compression)) {
+        pr_emit_diag(
+            diag_sink,
+            diag_user_data,
+            PR_DIAG_ERROR,
+            "Compression must be none or lz.",
+            options->manifest_path,
+            "build.compression_unknown",
+            NULL
+        );
+        status = PR_STATUS_VALIDATION_ERROR;
+        goto cleanup;
+    }
+
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_LOAD, &stage_start);
+    PR_PROFILE_BEGIN("pr_import_manifest_images");
     status = pr_import_manifest_images(
         options->manifest_path,
         &manifest,
@@ -2849,9 +5035,17 @@ pr_status_t pr_build_package(
         diag_user_data,
         &images
     );
+    PR_PROFILE_END("pr_import_manifest_images");
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+    PR_PROFILE_BEGIN("pr_premultiply_images");
+    status = pr_premultiply_imported_images(&manifest, images);
+    PR_PROFILE_END("pr_premultiply_images");
     if (status != PR_STATUS_OK) {
         goto cleanup;
     }
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_DECODE, &stage_start);
 
     if (options->strict_mode != 0 && warning_count > 0) {
         pr_emit_diag(
@@ -2884,6 +5078,7 @@ pr_status_t pr_build_package(
         goto cleanup;
     }
 
+    PR_PROFILE_BEGIN("pr_resolve_sprite_frames");
     status = pr_resolve_sprite_frames(
         &manifest,
         images,
@@ -2896,23 +5091,95 @@ pr_status_t pr_build_package(
         &resolved_frames,
         &resolved_frame_count
     );
+    PR_PROFILE_END("pr_resolve_sprite_frames");
     if (status != PR_STATUS_OK) {
         goto cleanup;
     }
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_RESOLVE, &stage_start);
+
+    if (manifest.atlas.incremental != 0) {
+        lock_path = pr_pack_lock_path(PR_BUILD_RESULT_STORAGE.package_path);
+        if (lock_path == NULL) {
+            status = PR_STATUS_ALLOCATION_FAILED;
+            goto cleanup;
+        }
+        has_lock = pr_pack_lock_read(lock_path, &lock);
+        if (
+            has_lock != 0 &&
+            (lock.max_page_width != (uint32_t)manifest.atlas.max_page_width ||
+                lock.max_page_height != (uint32_t)manifest.atlas.max_page_height ||
+                lock.padding != (uint32_t)manifest.atlas.padding ||
+                lock.cell != pr_pack_cell_size(&manifest))
+        ) {
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_NOTE,
+                "Atlas settings changed since the placement lock was written; packing from scratch.",
+                lock_path,
+                "build.atlas.lock_stale",
+                NULL
+            );
+            pr_pack_lock_free(&lock);
+            has_lock = 0;
+        }
+    }
 
+    pack_start = pr_timer_now_ms();
+    PR_PROFILE_BEGIN("pr_pack_resolved_frames");
     status = pr_pack_resolved_frames(
         &manifest,
         resolved_frames,
         resolved_frame_count,
+        (has_lock != 0) ? &lock : NULL,
         diag_sink,
         diag_user_data,
         &atlas_pages,
         &atlas_page_count
     );
+    PR_PROFILE_END("pr_pack_resolved_frames");
     if (status != PR_STATUS_OK) {
         goto cleanup;
     }
+    out_result->pack_time_ms = pr_timer_now_ms() - pack_start;
 
+    if (!pr_assign_page_formats(
+            images,
+            resolved_sprites,
+            resolved_frames,
+            resolved_frame_count,
+            atlas_pages,
+            atlas_page_count,
+            page_format,
+            auto_format,
+            pr_manifest_atlas_layout(&manifest) == PR_ATLAS_LAYOUT_ARRAY
+        )) {
+        status = PR_STATUS_ALLOCATION_FAILED;
+        goto cleanup;
+    }
+    PR_BUILD_RESULT_STORAGE.page_stats = pr_build_page_stats_create(
+        atlas_pages,
+        atlas_page_count
+    );
+    if (PR_BUILD_RESULT_STORAGE.page_stats == NULL) {
+        status = PR_STATUS_ALLOCATION_FAILED;
+        goto cleanup;
+    }
+    out_result->atlas_page_count = (unsigned int)atlas_page_count;
+    out_result->atlas_pages = PR_BUILD_RESULT_STORAGE.page_stats;
+    for (i = 0; i < (int)atlas_page_count; ++i) {
+        out_result->atlas_used_pixels += PR_BUILD_RESULT_STORAGE.page_stats[i].used_pixels;
+        out_result->atlas_total_pixels += (unsigned long long)atlas_pages[i].final_w *
+            (unsigned long long)atlas_pages[i].final_h;
+    }
+    out_result->atlas_occupancy = (out_result->atlas_total_pixels > 0u) ?
+        (double)out_result->atlas_used_pixels / (double)out_result->atlas_total_pixels : 0.0;
+    PR_PROFILE_COUNTER("packrat.atlas_pages", atlas_page_count);
+    PR_PROFILE_COUNTER("packrat.atlas_frames", resolved_frame_count);
+    PR_PROFILE_COUNTER("packrat.atlas_occupancy", out_result->atlas_occupancy);
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_PACK, &stage_start);
+
+    PR_PROFILE_BEGIN("pr_resolve_animations");
     status = pr_resolve_animations(
         &manifest,
         &maps,
@@ -2925,13 +5192,17 @@ pr_status_t pr_build_package(
         &resolved_animation_keys,
         &resolved_animation_key_count
     );
+    PR_PROFILE_END("pr_resolve_animations");
     if (status != PR_STATUS_OK) {
         goto cleanup;
     }
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_RESOLVE, &stage_start);
 
-    if (
-        !pr_build_chunk_strs(&strings, &chunks[0]) ||
-        !pr_build_chunk_txtr(
+    PR_PROFILE_BEGIN("pr_build_chunks");
+    chunks_ok = pr_build_chunk_strs(&strings, &chunks[0]);
+    if (chunks_ok != 0) {
+        PR_PROFILE_BEGIN("pr_build_chunk_txtr");
+        chunks_ok = pr_build_chunk_txtr(
             &manifest,
             atlas_pages,
             atlas_page_count,
@@ -2940,23 +5211,30 @@ pr_status_t pr_build_package(
             resolved_sprite_count,
             resolved_frames,
             resolved_frame_count,
+            encode_quality,
+            compression,
+            (uint32_t)manifest.atlas.tile_size,
             &chunks[1]
-        ) ||
-        !pr_build_chunk_sprt(
+        );
+        PR_PROFILE_END("pr_build_chunk_txtr");
+    }
+    chunks_ok = (
+        chunks_ok != 0 &&
+        pr_build_chunk_sprt(
             resolved_sprites,
             resolved_sprite_count,
             resolved_frames,
             resolved_frame_count,
             &chunks[2]
-        ) ||
-        !pr_build_chunk_anim(
+        ) &&
+        pr_build_chunk_anim(
             resolved_animations,
             resolved_animation_count,
             resolved_animation_keys,
             resolved_animation_key_count,
             &chunks[3]
-        ) ||
-        !pr_build_chunk_indx(
+        ) &&
+        pr_build_chunk_indx(
             &manifest,
             images,
             &maps,
@@ -2966,11 +5244,15 @@ pr_status_t pr_build_package(
             resolved_animation_count,
             &chunks[4]
         )
-    ) {
+    );
+    PR_PROFILE_END("pr_build_chunks");
+    if (chunks_ok == 0) {
         status = PR_STATUS_ALLOCATION_FAILED;
         goto cleanup;
     }
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_ENCODE, &stage_start);
 
+    PR_PROFILE_BEGIN("pr_write_package_with_chunks");
     status = pr_write_package_with_chunks(
         PR_BUILD_RESULT_STORAGE.package_path,
         chunks,
@@ -2978,6 +5260,7 @@ pr_status_t pr_build_package(
         diag_sink,
         diag_user_data
     );
+    PR_PROFILE_END("pr_write_package_with_chunks");
     if (status != PR_STATUS_OK) {
         pr_emit_diag(
             diag_sink,
@@ -2991,26 +5274,53 @@ pr_status_t pr_build_package(
         goto cleanup;
     }
 
+    if (lock_path != NULL) {
+        status = pr_write_pack_lock(
+            lock_path,
+            &manifest,
+            resolved_frames,
+            resolved_frame_count,
+            atlas_pages,
+            atlas_page_count
+        );
+        if (status != PR_STATUS_OK) {
+            pr_emit_diag(
+                diag_sink,
+                diag_user_data,
+                PR_DIAG_ERROR,
+                "Failed to write placement lock.",
+                lock_path,
+                "build.lock_write_failed",
+                NULL
+            );
+            goto cleanup;
+        }
+    }
+
     if (PR_BUILD_RESULT_STORAGE.debug_output_path[0] != '\0') {
+        PR_PROFILE_BEGIN("pr_write_debug_json");
         status = pr_write_debug_json(
             PR_BUILD_RESULT_STORAGE.debug_output_path,
             &manifest,
             images,
             PR_BUILD_RESULT_STORAGE.package_path,
+            out_result,
             (options->pretty_debug_json != 0 || manifest.pretty_debug_json != 0) ? 1 : 0,
             diag_sink,
             diag_user_data
         );
+        PR_PROFILE_END("pr_write_debug_json");
         if (status != PR_STATUS_OK) {
             goto cleanup;
         }
     }
 
+    pr_build_timings_mark(out_timings, PR_BUILD_STAGE_WRITE, &stage_start);
+
     out_result->package_path = PR_BUILD_RESULT_STORAGE.package_path;
     out_result->debug_output_path = (
         PR_BUILD_RESULT_STORAGE.debug_output_path[0] != '\0'
     ) ? PR_BUILD_RESULT_STORAGE.debug_output_path : NULL;
-    out_result->atlas_page_count = (unsigned int)atlas_page_count;
     out_result->sprite_count = (unsigned int)manifest.sprite_count;
     out_result->animation_count = (unsigned int)manifest.animation_count;
 
@@ -3036,8 +5346,14 @@ cleanup:
     free(resolved_frames);
     free(resolved_sprites);
     pr_free_index_maps(&maps);
-    pr_string_table_free(&strings);
+    pr_intern_pool_free(&strings);
     pr_imported_images_free(images, manifest.image_count);
     pr_manifest_free(&manifest);
+    pr_pack_lock_free(&lock);
+    free(lock_path);
+    if (out_timings != NULL) {
+        out_timings->total_ms = pr_timer_now_ms() - build_start;
+    }
+    PR_PROFILE_END("pr_build_package");
     return status;
 }
@@ -0,0 +1,35 @@
+#ifndef PACKRAT_BUILD_STAGES_H
+#define PACKRAT_BUILD_STAGES_H
+
+#include "packrat/build.h"
+
+typedef enum pr_build_stage {
+    PR_BUILD_STAGE_LOAD = 0,
+    PR_BUILD_STAGE_DECODE,
+    PR_BUILD_STAGE_RESOLVE,
+    PR_BUILD_STAGE_PACK,
+    PR_BUILD_STAGE_ENCODE,
+    PR_BUILD_STAGE_WRITE,
+    PR_BUILD_STAGE_COUNT
+} pr_build_stage_t;
+
+/* Wall-clock milliseconds spent in each stage of one build. Stages a failed
+ * build never reached stay at zero.
+ */
+typedef struct pr_build_timings {
+    double stage_ms[PR_BUILD_STAGE_COUNT];
+    double total_ms;
+} pr_build_timings_t;
+
+const char *pr_build_stage_name(pr_build_stage_t stage);
+
+/* pr_build_package that also fills `out_timings` when it is not NULL. */
+pr_status_t pr_build_package_timed(
+    const pr_build_options_t *options,
+    pr_diag_sink_fn diag_sink,
+    void *diag_user_data,
+    pr_build_result_t *out_result,
+    pr_build_timings_t *out_timings
+);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef PACKRAT_CHECKSUM_H
+#define PACKRAT_CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC-32C (Castagnoli, reflected polynomial 0x82F63B78) as stored in the
+ * package chunk table. Pass 0 as `crc` to start; feeding the result of one
+ * call into the next continues the same checksum. Uses the CPU's CRC32C
+ * instruction when there is one (SSE4.2, ARMv8 CRC) and a table otherwise;
+ * safe to call from several threads.
+ */
+uint32_t pr_crc32c(uint32_t crc, const void *bytes, size_t size);
+
+#endif
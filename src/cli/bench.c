@@ -0,0 +1,1098 @@
+#include "bench.h"
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <png.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "build_stages.h"
+#include "packrat/runtime.h"
+#include "timer.h"
+
+#define PR_BENCH_PATH_MAX 1024u
+#define PR_BENCH_ID_STRIDE 32u
+#define PR_BENCH_IMAGE_SIZE 64u
+#define PR_BENCH_GRID_CELL 16u
+#define PR_BENCH_ANIMATION_MAX_FRAMES 8u
+#define PR_BENCH_PNG_MAX_SIZE 256u
+
+typedef struct pr_bench_stat {
+    double min_ms;
+    double total_ms;
+    unsigned int samples;
+} pr_bench_stat_t;
+
+typedef struct pr_bench_results {
+    double generate_ms;
+    pr_bench_stat_t stages[PR_BUILD_STAGE_COUNT];
+    pr_bench_stat_t build_total;
+    pr_bench_stat_t open_file;
+    pr_bench_stat_t open_memory;
+    pr_bench_stat_t open_memory_verified;
+    pr_bench_stat_t find_sprite;
+    pr_bench_stat_t find_animation;
+    pr_bench_stat_t atlas_access;
+    size_t package_bytes;
+    size_t atlas_bytes;
+    unsigned int atlas_page_count;
+    unsigned long long atlas_checksum;
+    pr_package_stats_t package_stats;
+} pr_bench_results_t;
+
+void pr_bench_options_init(pr_bench_options_t *options)
+{
+    if (options == NULL) {
+        return;
+    }
+
+    memset(options, 0, sizeof(*options));
+    options->image_count = 256u;
+    options->sprite_count = (size_t)-1;
+    options->animation_count = (size_t)-1;
+    options->iterations = 5u;
+    options->work_dir = "packrat_bench_work";
+}
+
+static int pr_bench_parse_count(const char *text, size_t *out_value)
+{
+    char *end;
+    unsigned long long value;
+
+    if (text == NULL || text[0] == '\0' || text[0] == '-') {
+        return 0;
+    }
+    errno = 0;
+    value = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return 0;
+    }
+    *out_value = (size_t)value;
+    return 1;
+}
+
+int pr_bench_parse_args(
+    int argc,
+    char **argv,
+    int first_arg,
+    pr_bench_options_t *options
+)
+{
+    int i;
+
+    if (argv == NULL || options == NULL) {
+        return 0;
+    }
+
+    pr_bench_options_init(options);
+    for (i = first_arg; i < argc; ++i) {
+        size_t *count_target;
+        size_t iterations;
+
+        count_target = NULL;
+        if (strcmp(argv[i], "--images") == 0) {
+            count_target = &options->image_count;
+        } else if (strcmp(argv[i], "--sprites") == 0) {
+            count_target = &options->sprite_count;
+        } else if (strcmp(argv[i], "--animations") == 0) {
+            count_target = &options->animation_count;
+        }
+        if (count_target != NULL) {
+            if (i + 1 >= argc || !pr_bench_parse_count(argv[i + 1], count_target)) {
+                return 0;
+            }
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--iterations") == 0) {
+            if (
+                i + 1 >= argc ||
+                !pr_bench_parse_count(argv[i + 1], &iterations) ||
+                iterations == 0u ||
+                iterations > 100000u
+            ) {
+                return 0;
+            }
+            options->iterations = (unsigned int)iterations;
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--work-dir") == 0) {
+            if (i + 1 >= argc) {
+                return 0;
+            }
+            options->work_dir = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--json-output") == 0) {
+            if (i + 1 >= argc) {
+                return 0;
+            }
+            options->json_output = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--manifest-cache") == 0) {
+            options->use_manifest_cache = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--packing") == 0) {
+            options->packing_corpus = 1;
+            continue;
+        }
+        return 0;
+    }
+
+    if (options->image_count == 0u) {
+        return 0;
+    }
+    if (options->sprite_count == (size_t)-1) {
+        options->sprite_count = options->image_count;
+    }
+    if (options->animation_count == (size_t)-1) {
+        options->animation_count = options->sprite_count / 2u;
+    }
+    if (options->animation_count > 0u && options->sprite_count == 0u) {
+        return 0;
+    }
+    return 1;
+}
+
+void pr_bench_print_options(FILE *stream)
+{
+    if (stream == NULL) {
+        return;
+    }
+
+    fprintf(stream, "  --images <n>          (default 256)\n");
+    fprintf(stream, "  --sprites <n>         (default: images)\n");
+    fprintf(stream, "  --animations <n>      (default: sprites / 2)\n");
+    fprintf(stream, "  --iterations <n>      (default 5)\n");
+    fprintf(stream, "  --work-dir <path>     (default packrat_bench_work)\n");
+    fprintf(stream, "  --json-output <path>  (default stdout)\n");
+    fprintf(stream, "  --manifest-cache\n");
+    fprintf(stream, "  --packing             (packing-quality corpus instead)\n");
+}
+
+static void pr_bench_stat_add(pr_bench_stat_t *stat, double ms)
+{
+    if (stat->samples == 0u || ms < stat->min_ms) {
+        stat->min_ms = ms;
+    }
+    stat->total_ms += ms;
+    stat->samples += 1u;
+}
+
+static int pr_bench_make_directory(const char *path)
+{
+#ifdef _WIN32
+    if (_mkdir(path) == 0 || errno == EEXIST) {
+        return 1;
+    }
+#else
+    if (mkdir(path, 0755) == 0 || errno == EEXIST) {
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+static int pr_bench_format_path(
+    char *dst,
+    const char *work_dir,
+    const char *name
+)
+{
+    int written;
+
+    written = snprintf(dst, PR_BENCH_PATH_MAX, "%s/%s", work_dir, name);
+    return written > 0 && (size_t)written < PR_BENCH_PATH_MAX;
+}
+
+static int pr_bench_write_png(const char *path, uint32_t size, size_t seed)
+{
+    FILE *file;
+    png_structp png_ptr;
+    png_infop info_ptr;
+    unsigned char row[PR_BENCH_PNG_MAX_SIZE * 4u];
+    uint32_t x;
+    uint32_t y;
+
+    if (size == 0u || size > PR_BENCH_PNG_MAX_SIZE) {
+        return 0;
+    }
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (png_ptr == NULL) {
+        (void)fclose(file);
+        return 0;
+    }
+    info_ptr = png_create_info_struct(png_ptr);
+    if (info_ptr == NULL) {
+        png_destroy_write_struct(&png_ptr, NULL);
+        (void)fclose(file);
+        return 0;
+    }
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        (void)fclose(file);
+        return 0;
+    }
+
+    png_init_io(png_ptr, file);
+    png_set_IHDR(
+        png_ptr,
+        info_ptr,
+        size,
+        size,
+        8,
+        PNG_COLOR_TYPE_RGBA,
+        PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_DEFAULT,
+        PNG_FILTER_TYPE_DEFAULT
+    );
+    png_write_info(png_ptr, info_ptr);
+
+    /* Gradients plus a per-image tint, with a transparent corner so images
+     * are neither trivially compressible nor fully opaque.
+     */
+    for (y = 0u; y < size; ++y) {
+        for (x = 0u; x < size; ++x) {
+            unsigned char *pixel;
+
+            pixel = &row[x * 4u];
+            pixel[0] = (unsigned char)((x * 4u + (uint32_t)seed) & 0xFFu);
+            pixel[1] = (unsigned char)((y * 4u + (uint32_t)seed * 7u) & 0xFFu);
+            pixel[2] = (unsigned char)(((x ^ y) * 9u + (uint32_t)seed * 13u) & 0xFFu);
+            pixel[3] = (x + y < 12u) ? 0u : 0xFFu;
+        }
+        png_write_row(png_ptr, row);
+    }
+    png_write_end(png_ptr, NULL);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    return fclose(file) == 0;
+}
+
+static unsigned int pr_bench_sprite_frame_count(size_t sprite_index)
+{
+    switch (sprite_index % 3u) {
+    case 0u:
+        return 1u;
+    case 1u:
+        return (PR_BENCH_IMAGE_SIZE / PR_BENCH_GRID_CELL) *
+            (PR_BENCH_IMAGE_SIZE / PR_BENCH_GRID_CELL);
+    default:
+        return 2u;
+    }
+}
+
+/* Sprites cycle through the images and through single, grid and rects
+ * modes; animation i plays up to eight frames of sprite i % sprite_count.
+ */
+static int pr_bench_write_manifest(const char *path, const pr_bench_options_t *options)
+{
+    FILE *file;
+    size_t i;
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    fprintf(file, "schema_version = 1\n");
+    fprintf(file, "package_name = \"packrat_bench\"\n");
+    fprintf(file, "output = \"bench.prpk\"\n\n");
+    fprintf(file, "[atlas]\n");
+    fprintf(file, "max_page_width = 2048\n");
+    fprintf(file, "max_page_height = 2048\n");
+    fprintf(file, "padding = 1\n");
+    fprintf(file, "power_of_two = false\n\n");
+
+    for (i = 0u; i < options->image_count; ++i) {
+        fprintf(file, "[[images]]\nid = \"img_%zu\"\npath = \"images/img_%zu.png\"\n\n", i, i);
+    }
+
+    for (i = 0u; i < options->sprite_count; ++i) {
+        size_t image_index;
+
+        image_index = i % options->image_count;
+        fprintf(file, "[[sprites]]\nid = \"sprite_%zu\"\nsource = \"img_%zu\"\n", i, image_index);
+        switch (i % 3u) {
+        case 0u:
+            fprintf(file, "mode = \"single\"\nx = 8\ny = 8\nw = 48\nh = 48\n\n");
+            break;
+        case 1u:
+            fprintf(
+                file,
+                "mode = \"grid\"\ncell_w = %u\ncell_h = %u\n\n",
+                PR_BENCH_GRID_CELL,
+                PR_BENCH_GRID_CELL
+            );
+            break;
+        default:
+            fprintf(file, "mode = \"rects\"\n\n");
+            fprintf(file, "[[sprites.rects]]\nx = 0\ny = 0\nw = 32\nh = 16\n\n");
+            fprintf(file, "[[sprites.rects]]\nx = 16\ny = 32\nw = 24\nh = 24\n\n");
+            break;
+        }
+    }
+
+    for (i = 0u; i < options->animation_count; ++i) {
+        size_t sprite_index;
+        unsigned int frame_count;
+        unsigned int frame;
+
+        sprite_index = i % options->sprite_count;
+        frame_count = pr_bench_sprite_frame_count(sprite_index);
+        if (frame_count > PR_BENCH_ANIMATION_MAX_FRAMES) {
+            frame_count = PR_BENCH_ANIMATION_MAX_FRAMES;
+        }
+        fprintf(
+            file,
+            "[[animations]]\nid = \"anim_%zu\"\nsprite = \"sprite_%zu\"\nloop = \"loop\"\nframes = [",
+            i,
+            sprite_index
+        );
+        for (frame = 0u; frame < frame_count; ++frame) {
+            fprintf(file, "%s{ index = %u, ms = 100 }", (frame == 0u) ? "" : ", ", frame);
+        }
+        fprintf(file, "]\n\n");
+    }
+
+    if (ferror(file) != 0) {
+        (void)fclose(file);
+        return 0;
+    }
+    return fclose(file) == 0;
+}
+
+static int pr_bench_generate(
+    const pr_bench_options_t *options,
+    char *manifest_path
+)
+{
+    char path[PR_BENCH_PATH_MAX];
+    char name[64];
+    size_t i;
+
+    if (
+        !pr_bench_make_directory(options->work_dir) ||
+        !pr_bench_format_path(path, options->work_dir, "images") ||
+        !pr_bench_make_directory(path)
+    ) {
+        fprintf(stderr, "bench: failed to create %s\n", options->work_dir);
+        return 0;
+    }
+
+    for (i = 0u; i < options->image_count; ++i) {
+        (void)snprintf(name, sizeof(name), "images/img_%zu.png", i);
+        if (
+            !pr_bench_format_path(path, options->work_dir, name) ||
+            !pr_bench_write_png(path, PR_BENCH_IMAGE_SIZE, i)
+        ) {
+            fprintf(stderr, "bench: failed to write %s\n", path);
+            return 0;
+        }
+    }
+
+    if (
+        !pr_bench_format_path(manifest_path, options->work_dir, "packrat.toml") ||
+        !pr_bench_write_manifest(manifest_path, options)
+    ) {
+        fprintf(stderr, "bench: failed to write manifest\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void pr_bench_diag_sink(const pr_diagnostic_t *diag, void *user_data)
+{
+    (void)user_data;
+
+    if (diag == NULL || diag->severity != PR_DIAG_ERROR) {
+        return;
+    }
+    fprintf(
+        stderr,
+        "bench: %s [code=%s] [asset=%s]\n",
+        diag->message,
+        (diag->code != NULL) ? diag->code : "-",
+        (diag->asset_id != NULL) ? diag->asset_id : "-"
+    );
+}
+
+static unsigned char *pr_bench_read_file(const char *path, size_t *out_size)
+{
+    FILE *file;
+    unsigned char *bytes;
+    long size;
+
+    *out_size = 0u;
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0) {
+        (void)fclose(file);
+        return NULL;
+    }
+    bytes = (unsigned char *)malloc((size_t)size);
+    if (bytes == NULL || fread(bytes, 1u, (size_t)size, file) != (size_t)size) {
+        free(bytes);
+        (void)fclose(file);
+        return NULL;
+    }
+    (void)fclose(file);
+    *out_size = (size_t)size;
+    return bytes;
+}
+
+static char *pr_bench_make_ids(const char *prefix, size_t count)
+{
+    char *ids;
+    size_t i;
+
+    ids = (char *)malloc((count == 0u ? 1u : count) * PR_BENCH_ID_STRIDE);
+    if (ids == NULL) {
+        return NULL;
+    }
+    for (i = 0u; i < count; ++i) {
+        (void)snprintf(ids + i * PR_BENCH_ID_STRIDE, PR_BENCH_ID_STRIDE, "%s_%zu", prefix, i);
+    }
+    return ids;
+}
+
+static pr_status_t pr_bench_run_build(
+    const pr_bench_options_t *options,
+    const char *manifest_path,
+    const char *package_path,
+    pr_bench_results_t *results
+)
+{
+    pr_build_options_t build_options;
+    pr_build_result_t build_result;
+    pr_build_timings_t timings;
+    pr_status_t status;
+    unsigned int iteration;
+    int stage;
+
+    memset(&build_options, 0, sizeof(build_options));
+    build_options.manifest_path = manifest_path;
+    build_options.output_override = package_path;
+    build_options.no_manifest_cache = (options->use_manifest_cache != 0) ? 0 : 1;
+
+    for (iteration = 0u; iteration < options->iterations; ++iteration) {
+        status = pr_build_package_timed(
+            &build_options,
+            pr_bench_diag_sink,
+            NULL,
+            &build_result,
+            &timings
+        );
+        if (status != PR_STATUS_OK) {
+            return status;
+        }
+        for (stage = 0; stage < (int)PR_BUILD_STAGE_COUNT; ++stage) {
+            pr_bench_stat_add(&results->stages[stage], timings.stage_ms[stage]);
+        }
+        pr_bench_stat_add(&results->build_total, timings.total_ms);
+        results->atlas_page_count = build_result.atlas_page_count;
+    }
+    return PR_STATUS_OK;
+}
+
+static pr_status_t pr_bench_run_runtime(
+    const pr_bench_options_t *options,
+    const char *package_path,
+    pr_bench_results_t *results
+)
+{
+    unsigned char *bytes;
+    size_t size;
+    char *sprite_ids;
+    char *animation_ids;
+    pr_package_t *package;
+    pr_status_t status;
+    unsigned int iteration;
+    double start;
+    size_t i;
+
+    sprite_ids = NULL;
+    animation_ids = NULL;
+    package = NULL;
+
+    bytes = pr_bench_read_file(package_path, &size);
+    if (bytes == NULL) {
+        return PR_STATUS_IO_ERROR;
+    }
+    results->package_bytes = size;
+
+    for (iteration = 0u; iteration < options->iterations; ++iteration) {
+        start = pr_timer_now_ms();
+        status = pr_package_open_file(package_path, &package);
+        if (status != PR_STATUS_OK) {
+            goto cleanup;
+        }
+        pr_bench_stat_add(&results->open_file, pr_timer_now_ms() - start);
+        pr_package_close(package);
+        package = NULL;
+
+        start = pr_timer_now_ms();
+        status = pr_package_open_memory(bytes, size, &package);
+        if (status != PR_STATUS_OK) {
+            goto cleanup;
+        }
+        pr_bench_stat_add(&results->open_memory, pr_timer_now_ms() - start);
+        pr_package_close(package);
+        package = NULL;
+
+        start = pr_timer_now_ms();
+        status = pr_package_open_memory_ex(bytes, size, PR_PACKAGE_OPEN_VERIFY_CHECKSUMS, &package);
+        if (status != PR_STATUS_OK) {
+            goto cleanup;
+        }
+        pr_bench_stat_add(&results->open_memory_verified, pr_timer_now_ms() - start);
+        pr_package_close(package);
+        package = NULL;
+    }
+
+    status = pr_package_open_memory(bytes, size, &package);
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+    status = pr_package_get_stats(package, &results->package_stats);
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    sprite_ids = pr_bench_make_ids("sprite", options->sprite_count);
+    animation_ids = pr_bench_make_ids("anim", options->animation_count);
+    if (sprite_ids == NULL || animation_ids == NULL) {
+        status = PR_STATUS_ALLOCATION_FAILED;
+        goto cleanup;
+    }
+
+    for (iteration = 0u; iteration < options->iterations; ++iteration) {
+        unsigned int page;
+
+        start = pr_timer_now_ms();
+        for (i = 0u; i < options->sprite_count; ++i) {
+            if (pr_package_find_sprite(package, sprite_ids + i * PR_BENCH_ID_STRIDE) == NULL) {
+                status = PR_STATUS_VALIDATION_ERROR;
+                goto cleanup;
+            }
+        }
+        pr_bench_stat_add(&results->find_sprite, pr_timer_now_ms() - start);
+
+        start = pr_timer_now_ms();
+        for (i = 0u; i < options->animation_count; ++i) {
+            if (pr_package_find_animation(package, animation_ids + i * PR_BENCH_ID_STRIDE) == NULL) {
+                status = PR_STATUS_VALIDATION_ERROR;
+                goto cleanup;
+            }
+        }
+        pr_bench_stat_add(&results->find_animation, pr_timer_now_ms() - start);
+
+        /* Touch every atlas byte the way an upload to the GPU would. */
+        results->atlas_bytes = 0u;
+        start = pr_timer_now_ms();
+        for (page = 0u; page < pr_package_atlas_page_count(package); ++page) {
+            const unsigned char *data;
+            pr_atlas_page_info_t info;
+            size_t j;
+
+            data = (const unsigned char *)pr_package_atlas_page_data(package, page, &info);
+            if (data == NULL) {
+                status = PR_STATUS_VALIDATION_ERROR;
+                goto cleanup;
+            }
+            for (j = 0u; j < info.data_size; ++j) {
+                results->atlas_checksum += data[j];
+            }
+            results->atlas_bytes += info.data_size;
+        }
+        pr_bench_stat_add(&results->atlas_access, pr_timer_now_ms() - start);
+    }
+    status = PR_STATUS_OK;
+
+cleanup:
+    pr_package_close(package);
+    free(animation_ids);
+    free(sprite_ids);
+    free(bytes);
+    return status;
+}
+
+static void pr_bench_write_stat(
+    FILE *out,
+    const char *name,
+    const pr_bench_stat_t *stat,
+    size_t calls,
+    int last
+)
+{
+    double mean_ms;
+
+    mean_ms = (stat->samples > 0u) ? stat->total_ms / (double)stat->samples : 0.0;
+    fprintf(
+        out,
+        "    \"%s\": { \"min_ms\": %.4f, \"mean_ms\": %.4f, \"samples\": %u",
+        name,
+        stat->min_ms,
+        mean_ms,
+        stat->samples
+    );
+    if (calls > 0u) {
+        fprintf(out, ", \"calls\": %zu, \"min_ns_per_call\": %.2f", calls, stat->min_ms * 1000000.0 / (double)calls);
+    }
+    fprintf(out, " }%s\n", (last != 0) ? "" : ",");
+}
+
+static int pr_bench_write_json(
+    FILE *out,
+    const pr_bench_options_t *options,
+    const pr_bench_results_t *results
+)
+{
+    const pr_package_stats_t *stats;
+    unsigned int chunk;
+    int stage;
+
+    stats = &results->package_stats;
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"packrat\",\n");
+    fprintf(out, "  \"format_version\": 1,\n");
+    fprintf(out, "  \"config\": {\n");
+    fprintf(out, "    \"images\": %zu,\n", options->image_count);
+    fprintf(out, "    \"sprites\": %zu,\n", options->sprite_count);
+    fprintf(out, "    \"animations\": %zu,\n", options->animation_count);
+    fprintf(out, "    \"iterations\": %u,\n", options->iterations);
+    fprintf(out, "    \"manifest_cache\": %s\n", (options->use_manifest_cache != 0) ? "true" : "false");
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"generate_ms\": %.4f,\n", results->generate_ms);
+    fprintf(out, "  \"package_bytes\": %zu,\n", results->package_bytes);
+    fprintf(out, "  \"atlas_pages\": %u,\n", results->atlas_page_count);
+    fprintf(out, "  \"atlas_bytes\": %zu,\n", results->atlas_bytes);
+    fprintf(out, "  \"atlas_checksum\": %llu,\n", results->atlas_checksum);
+    fprintf(out, "  \"build\": {\n");
+    for (stage = 0; stage < (int)PR_BUILD_STAGE_COUNT; ++stage) {
+        pr_bench_write_stat(
+            out,
+            pr_build_stage_name((pr_build_stage_t)stage),
+            &results->stages[stage],
+            0u,
+            0
+        );
+    }
+    pr_bench_write_stat(out, "total", &results->build_total, 0u, 1);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"runtime\": {\n");
+    pr_bench_write_stat(out, "open_file", &results->open_file, 0u, 0);
+    pr_bench_write_stat(out, "open_memory", &results->open_memory, 0u, 0);
+    pr_bench_write_stat(out, "open_memory_verified", &results->open_memory_verified, 0u, 0);
+    pr_bench_write_stat(out, "find_sprite", &results->find_sprite, options->sprite_count, 0);
+    pr_bench_write_stat(out, "find_animation", &results->find_animation, options->animation_count, 0);
+    pr_bench_write_stat(out, "atlas_access", &results->atlas_access, 0u, 1);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"package\": {\n");
+    fprintf(out, "    \"file_bytes\": %llu,\n", stats->file_bytes);
+    fprintf(out, "    \"metadata_bytes\": %llu,\n", stats->metadata_bytes);
+    fprintf(out, "    \"pixel_bytes\": %llu,\n", stats->pixel_bytes);
+    fprintf(out, "    \"total_bytes\": %llu,\n", stats->total_bytes);
+    fprintf(out, "    \"chunks\": [");
+    for (chunk = 0u; chunk < stats->chunk_count; ++chunk) {
+        fprintf(
+            out,
+            "%s{ \"id\": \"%s\", \"bytes\": %llu, \"parse_ms\": %.4f }",
+            (chunk > 0u) ? ", " : "",
+            stats->chunks[chunk].id,
+            stats->chunks[chunk].bytes,
+            stats->chunks[chunk].parse_ms
+        );
+    }
+    fprintf(out, "]\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+    return ferror(out) == 0;
+}
+
+typedef struct pr_bench_corpus_frame {
+    uint32_t w;
+    uint32_t h;
+    uint32_t sprite;
+} pr_bench_corpus_frame_t;
+
+typedef struct pr_bench_pack_config {
+    uint32_t max_page_size;
+    uint32_t padding;
+    int power_of_two;
+} pr_bench_pack_config_t;
+
+static const char *const PR_BENCH_CORPUS_NAMES[] = {
+    "ui",
+    "characters",
+    "tiles",
+    "fx"
+};
+
+static const pr_bench_pack_config_t PR_BENCH_PACK_CONFIGS[] = {
+    { 1024u, 0u, 0 },
+    { 1024u, 2u, 0 },
+    { 1024u, 2u, 1 },
+    { 2048u, 0u, 0 },
+    { 2048u, 2u, 0 },
+    { 2048u, 2u, 1 }
+};
+
+static uint32_t pr_bench_random(uint32_t *state)
+{
+    uint32_t x;
+
+    x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint32_t pr_bench_random_range(uint32_t *state, uint32_t lo, uint32_t hi)
+{
+    return lo + pr_bench_random(state) % (hi - lo + 1u);
+}
+
+static int pr_bench_corpus_push(
+    pr_bench_corpus_frame_t *frames,
+    size_t capacity,
+    size_t *count,
+    uint32_t w,
+    uint32_t h,
+    uint32_t sprite
+)
+{
+    if (*count >= capacity) {
+        return 0;
+    }
+    frames[*count].w = (w > PR_BENCH_PNG_MAX_SIZE) ? PR_BENCH_PNG_MAX_SIZE : w;
+    frames[*count].h = (h > PR_BENCH_PNG_MAX_SIZE) ? PR_BENCH_PNG_MAX_SIZE : h;
+    frames[*count].sprite = sprite;
+    *count += 1u;
+    return 1;
+}
+
+/* Frame-size distributions modelled on typical content:
+ * - ui: one sprite per element; mostly square icons, some wide buttons and
+ *   large panels
+ * - characters: sheets of identically sized, taller-than-wide frames
+ * - tiles: uniform 32x32 tiles with a smaller 16x16 set
+ * - fx: sheets of large square frames
+ */
+static size_t pr_bench_corpus_frames(
+    size_t corpus,
+    pr_bench_corpus_frame_t *frames,
+    size_t capacity
+)
+{
+    static const uint32_t icon_sizes[] = { 16u, 24u, 32u, 48u, 64u };
+    static const uint32_t fx_sizes[] = { 64u, 96u, 128u, 192u, 256u };
+    uint32_t state;
+    size_t count;
+    uint32_t sprite;
+    uint32_t i;
+
+    state = 0x9E3779B9u + (uint32_t)corpus * 0x85EBCA6Bu;
+    count = 0u;
+
+    switch (corpus) {
+    case 0u:
+        for (sprite = 0u; sprite < 400u; ++sprite) {
+            uint32_t kind;
+            uint32_t w;
+            uint32_t h;
+
+            kind = pr_bench_random(&state) % 10u;
+            if (kind < 7u) {
+                w = icon_sizes[pr_bench_random(&state) % 5u];
+                h = w;
+            } else if (kind < 9u) {
+                w = pr_bench_random_range(&state, 64u, 192u);
+                h = pr_bench_random_range(&state, 24u, 48u);
+            } else {
+                w = pr_bench_random_range(&state, 128u, 256u);
+                h = pr_bench_random_range(&state, 64u, 192u);
+            }
+            (void)pr_bench_corpus_push(frames, capacity, &count, w, h, sprite);
+        }
+        break;
+    case 1u:
+        for (sprite = 0u; sprite < 24u; ++sprite) {
+            uint32_t w;
+            uint32_t h;
+
+            w = pr_bench_random_range(&state, 32u, 96u);
+            h = w + w * pr_bench_random_range(&state, 25u, 75u) / 100u;
+            for (i = 0u; i < 16u; ++i) {
+                (void)pr_bench_corpus_push(frames, capacity, &count, w, h, sprite);
+            }
+        }
+        break;
+    case 2u:
+        for (i = 0u; i < 1024u; ++i) {
+            uint32_t size;
+
+            size = (i < 768u) ? 32u : 16u;
+            (void)pr_bench_corpus_push(frames, capacity, &count, size, size, i / 64u);
+        }
+        break;
+    default:
+        for (sprite = 0u; sprite < 12u; ++sprite) {
+            uint32_t size;
+
+            size = fx_sizes[pr_bench_random(&state) % 5u];
+            for (i = 0u; i < 12u; ++i) {
+                (void)pr_bench_corpus_push(frames, capacity, &count, size, size, sprite);
+            }
+        }
+        break;
+    }
+    return count;
+}
+
+static int pr_bench_write_corpus_manifest(
+    const char *path,
+    const pr_bench_corpus_frame_t *frames,
+    size_t frame_count,
+    const pr_bench_pack_config_t *config
+)
+{
+    FILE *file;
+    size_t i;
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    fprintf(file, "schema_version = 1\n");
+    fprintf(file, "package_name = \"packrat_packing_bench\"\n");
+    fprintf(file, "output = \"packing.prpk\"\n\n");
+    fprintf(file, "[atlas]\n");
+    fprintf(file, "max_page_width = %u\n", config->max_page_size);
+    fprintf(file, "max_page_height = %u\n", config->max_page_size);
+    fprintf(file, "padding = %u\n", config->padding);
+    fprintf(file, "power_of_two = %s\n\n", (config->power_of_two != 0) ? "true" : "false");
+    fprintf(file, "[[images]]\nid = \"source\"\npath = \"source.png\"\n\n");
+
+    for (i = 0u; i < frame_count; ++i) {
+        if (i == 0u || frames[i].sprite != frames[i - 1u].sprite) {
+            fprintf(
+                file,
+                "[[sprites]]\nid = \"sprite_%u\"\nsource = \"source\"\nmode = \"rects\"\n\n",
+                frames[i].sprite
+            );
+        }
+        fprintf(file, "[[sprites.rects]]\nx = 0\ny = 0\nw = %u\nh = %u\n\n", frames[i].w, frames[i].h);
+    }
+
+    if (ferror(file) != 0) {
+        (void)fclose(file);
+        return 0;
+    }
+    return fclose(file) == 0;
+}
+
+static pr_status_t pr_bench_run_packing(const pr_bench_options_t *options)
+{
+    pr_bench_corpus_frame_t *frames;
+    char dir[PR_BENCH_PATH_MAX];
+    char path[PR_BENCH_PATH_MAX];
+    char package_path[PR_BENCH_PATH_MAX];
+    pr_status_t status;
+    FILE *out;
+    size_t corpus;
+    size_t config_index;
+    int first;
+
+    frames = (pr_bench_corpus_frame_t *)malloc(2048u * sizeof(frames[0]));
+    if (frames == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    out = NULL;
+
+    if (
+        !pr_bench_make_directory(options->work_dir) ||
+        !pr_bench_format_path(dir, options->work_dir, "packing") ||
+        !pr_bench_make_directory(dir) ||
+        !pr_bench_format_path(path, dir, "source.png") ||
+        !pr_bench_write_png(path, PR_BENCH_PNG_MAX_SIZE, 0u) ||
+        !pr_bench_format_path(package_path, dir, "packing.prpk")
+    ) {
+        fprintf(stderr, "bench: failed to prepare %s\n", options->work_dir);
+        status = PR_STATUS_IO_ERROR;
+        goto cleanup;
+    }
+
+    out = stdout;
+    if (options->json_output != NULL) {
+        out = fopen(options->json_output, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "bench: failed to open %s\n", options->json_output);
+            status = PR_STATUS_IO_ERROR;
+            goto cleanup;
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"packrat_packing\",\n");
+    fprintf(out, "  \"format_version\": 1,\n");
+    fprintf(out, "  \"iterations\": %u,\n", options->iterations);
+    fprintf(out, "  \"results\": [\n");
+
+    first = 1;
+    for (corpus = 0u; corpus < sizeof(PR_BENCH_CORPUS_NAMES) / sizeof(PR_BENCH_CORPUS_NAMES[0]); ++corpus) {
+        size_t frame_count;
+
+        frame_count = pr_bench_corpus_frames(corpus, frames, 2048u);
+        for (
+            config_index = 0u;
+            config_index < sizeof(PR_BENCH_PACK_CONFIGS) / sizeof(PR_BENCH_PACK_CONFIGS[0]);
+            ++config_index
+        ) {
+            const pr_bench_pack_config_t *config;
+            pr_build_options_t build_options;
+            pr_build_result_t result;
+            pr_bench_stat_t pack_time;
+            char name[64];
+            unsigned int iteration;
+            unsigned int page;
+
+            config = &PR_BENCH_PACK_CONFIGS[config_index];
+            (void)snprintf(name, sizeof(name), "%s_%zu.toml", PR_BENCH_CORPUS_NAMES[corpus], config_index);
+            if (
+                !pr_bench_format_path(path, dir, name) ||
+                !pr_bench_write_corpus_manifest(path, frames, frame_count, config)
+            ) {
+                status = PR_STATUS_IO_ERROR;
+                goto cleanup;
+            }
+
+            memset(&build_options, 0, sizeof(build_options));
+            build_options.manifest_path = path;
+            build_options.output_override = package_path;
+            build_options.no_manifest_cache = 1;
+            memset(&pack_time, 0, sizeof(pack_time));
+            for (iteration = 0u; iteration < options->iterations; ++iteration) {
+                status = pr_build_package(&build_options, pr_bench_diag_sink, NULL, &result);
+                if (status != PR_STATUS_OK) {
+                    fprintf(stderr, "bench: build failed for %s\n", name);
+                    goto cleanup;
+                }
+                pr_bench_stat_add(&pack_time, result.pack_time_ms);
+            }
+
+            fprintf(
+                out,
+                "%s    { \"corpus\": \"%s\", \"frames\": %zu, \"max_page_size\": %u, \"padding\": %u, "
+                "\"power_of_two\": %s, \"pages\": %u, \"used_pixels\": %llu, \"total_pixels\": %llu, "
+                "\"wasted_pixels\": %llu, \"occupancy\": %.4f, \"pack_min_ms\": %.4f, "
+                "\"pack_mean_ms\": %.4f, \"page_occupancy\": [",
+                (first != 0) ? "" : ",\n",
+                PR_BENCH_CORPUS_NAMES[corpus],
+                frame_count,
+                config->max_page_size,
+                config->padding,
+                (config->power_of_two != 0) ? "true" : "false",
+                result.atlas_page_count,
+                result.atlas_used_pixels,
+                result.atlas_total_pixels,
+                result.atlas_total_pixels - result.atlas_used_pixels,
+                result.atlas_occupancy,
+                pack_time.min_ms,
+                pack_time.total_ms / (double)pack_time.samples
+            );
+            for (page = 0u; page < result.atlas_page_count; ++page) {
+                fprintf(out, "%s%.4f", (page > 0u) ? ", " : "", result.atlas_pages[page].occupancy);
+            }
+            fprintf(out, "] }");
+            first = 0;
+        }
+    }
+
+    fprintf(out, "\n  ]\n");
+    fprintf(out, "}\n");
+    status = (ferror(out) == 0) ? PR_STATUS_OK : PR_STATUS_IO_ERROR;
+
+cleanup:
+    if (out != NULL && out != stdout && fclose(out) != 0) {
+        status = PR_STATUS_IO_ERROR;
+    }
+    free(frames);
+    return status;
+}
+
+pr_status_t pr_bench_run(const pr_bench_options_t *options)
+{
+    pr_bench_results_t results;
+    char manifest_path[PR_BENCH_PATH_MAX];
+    char package_path[PR_BENCH_PATH_MAX];
+    pr_status_t status;
+    FILE *out;
+    double start;
+    int ok;
+
+    if (options == NULL || options->work_dir == NULL || options->image_count == 0u) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    if (options->packing_corpus != 0) {
+        return pr_bench_run_packing(options);
+    }
+
+    memset(&results, 0, sizeof(results));
+    start = pr_timer_now_ms();
+    if (!pr_bench_generate(options, manifest_path)) {
+        return PR_STATUS_IO_ERROR;
+    }
+    results.generate_ms = pr_timer_now_ms() - start;
+
+    if (!pr_bench_format_path(package_path, options->work_dir, "bench.prpk")) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    status = pr_bench_run_build(options, manifest_path, package_path, &results);
+    if (status != PR_STATUS_OK) {
+        fprintf(stderr, "bench: build failed: %s\n", pr_status_string(status));
+        return status;
+    }
+    status = pr_bench_run_runtime(options, package_path, &results);
+    if (status != PR_STATUS_OK) {
+        fprintf(stderr, "bench: runtime pass failed: %s\n", pr_status_string(status));
+        return status;
+    }
+
+    out = stdout;
+    if (options->json_output != NULL) {
+        out = fopen(options->json_output, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "bench: failed to open %s\n", options->json_output);
+            return PR_STATUS_IO_ERROR;
+        }
+    }
+    ok = pr_bench_write_json(out, options, &results);
+    if (out != stdout && fclose(out) != 0) {
+        ok = 0;
+    }
+    return (ok != 0) ? PR_STATUS_OK : PR_STATUS_IO_ERROR;
+}
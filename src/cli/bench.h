@@ -0,0 +1,41 @@
+#ifndef PACKRAT_CLI_BENCH_H
+#define PACKRAT_CLI_BENCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "packrat/build.h"
+
+typedef struct pr_bench_options {
+    size_t image_count;
+    size_t sprite_count;
+    size_t animation_count;
+    unsigned int iterations;
+    const char *work_dir;
+    const char *json_output;
+    int use_manifest_cache;
+    int packing_corpus;
+} pr_bench_options_t;
+
+void pr_bench_options_init(pr_bench_options_t *options);
+
+/* Parses `argv[first_arg..argc)`. Returns 0 on unknown or malformed options. */
+int pr_bench_parse_args(
+    int argc,
+    char **argv,
+    int first_arg,
+    pr_bench_options_t *options
+);
+void pr_bench_print_options(FILE *stream);
+
+/* Generates a synthetic project under `work_dir`, builds it `iterations`
+ * times, then times package open, lookups and atlas access. Results are
+ * written as one JSON object to `json_output`, or stdout when it is NULL.
+ *
+ * With `packing_corpus` set it instead builds the UI, characters, tiles and
+ * FX frame-size corpora under every packer configuration and reports atlas
+ * occupancy, wasted area and packing time for each.
+ */
+pr_status_t pr_bench_run(const pr_bench_options_t *options);
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bench.h"
 #include "packrat/build.h"
 #include "packrat/runtime.h"
 
@@ -94,9 +95,12 @@ static int pr_cli_print_usage(FILE *stream)
     }
 
     fprintf(stream, "Usage:\n");
-    fprintf(stream, "  packrat validate <manifest>\n");
+    fprintf(stream, "  packrat validate <manifest> [--deep]\n");
     fprintf(stream, "  packrat build <manifest> [options]\n");
     fprintf(stream, "  packrat inspect <package> [options]\n");
+    fprintf(stream, "  packrat diff <old-package> <new-package> --out <patch.prpd>\n");
+    fprintf(stream, "  packrat patch <old-package> <patch.prpd> --out <new-package>\n");
+    fprintf(stream, "  packrat bench [options]\n");
     fprintf(stream, "\n");
     fprintf(stream, "Build options:\n");
     fprintf(stream, "  --output <path>\n");
@@ -104,10 +108,17 @@ static int pr_cli_print_usage(FILE *stream)
     fprintf(stream, "  --pretty-debug-json\n");
     fprintf(stream, "  --quiet\n");
     fprintf(stream, "  --strict\n");
+    fprintf(stream, "  --no-manifest-cache\n");
+    fprintf(stream, "  --format <auto|rgba8|rgb565|rgba4444|r8|ra8|indexed8|bc1|bc3|bc7|etc2_rgb|etc2_rgba>\n");
+    fprintf(stream, "  --encode-quality <fast|balanced|best>\n");
+    fprintf(stream, "  --compression <none|lz>\n");
     fprintf(stream, "\n");
     fprintf(stream, "Inspect options:\n");
     fprintf(stream, "  --json\n");
     fprintf(stream, "  --verbose\n");
+    fprintf(stream, "\n");
+    fprintf(stream, "Bench options:\n");
+    pr_bench_print_options(stream);
     return 1;
 }
 
@@ -115,13 +126,25 @@ static int pr_cli_run_validate(int argc, char **argv)
 {
     pr_status_t status;
     pr_cli_diag_context_t diag_context;
+    int deep;
 
-    if (argc != 3) {
+    if (argc < 3 || argc > 4) {
         return pr_cli_print_usage(stderr);
     }
+    deep = 0;
+    if (argc == 4) {
+        if (strcmp(argv[3], "--deep") != 0) {
+            return pr_cli_print_usage(stderr);
+        }
+        deep = 1;
+    }
 
     memset(&diag_context, 0, sizeof(diag_context));
-    status = pr_validate_manifest_file(argv[2], pr_cli_diag_printer, &diag_context);
+    if (deep != 0) {
+        status = pr_validate_manifest_file_deep(argv[2], pr_cli_diag_printer, &diag_context);
+    } else {
+        status = pr_validate_manifest_file(argv[2], pr_cli_diag_printer, &diag_context);
+    }
     if (status == PR_STATUS_OK) {
         fprintf(stdout, "Manifest is valid: %s\n", argv[2]);
     } else {
@@ -176,6 +199,34 @@ static int pr_cli_run_build(int argc, char **argv)
             options.strict_mode = 1;
             continue;
         }
+        if (strcmp(argv[i], "--no-manifest-cache") == 0) {
+            options.no_manifest_cache = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--format") == 0) {
+            if (i + 1 >= argc) {
+                return pr_cli_print_usage(stderr);
+            }
+            options.format_override = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--encode-quality") == 0) {
+            if (i + 1 >= argc) {
+                return pr_cli_print_usage(stderr);
+            }
+            options.encode_quality_override = argv[i + 1];
+            i += 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--compression") == 0) {
+            if (i + 1 >= argc) {
+                return pr_cli_print_usage(stderr);
+            }
+            options.compression_override = argv[i + 1];
+            i += 1;
+            continue;
+        }
 
         return pr_cli_print_usage(stderr);
     }
@@ -190,6 +241,54 @@ static int pr_cli_run_build(int argc, char **argv)
     return pr_cli_exit_code_for_status(status);
 }
 
+/* `packrat diff` and `packrat patch` share their argument shape: two inputs
+ * and `--out <path>`.
+ */
+static int pr_cli_run_patch_command(int argc, char **argv, int apply)
+{
+    pr_status_t status;
+    size_t output_size;
+
+    if (argc != 6 || strcmp(argv[4], "--out") != 0) {
+        return pr_cli_print_usage(stderr);
+    }
+
+    output_size = 0u;
+    if (apply != 0) {
+        status = pr_package_patch_files(argv[2], argv[3], argv[5], &output_size);
+    } else {
+        status = pr_package_diff_files(argv[2], argv[3], argv[5], &output_size);
+    }
+    if (status == PR_STATUS_OK) {
+        fprintf(
+            stdout,
+            "%s written: %s (%lu bytes)\n",
+            (apply != 0) ? "Package" : "Patch",
+            argv[5],
+            (unsigned long)output_size
+        );
+    } else {
+        fprintf(stderr, "%s failed: %s\n", (apply != 0) ? "Patch" : "Diff", pr_status_string(status));
+    }
+    return pr_cli_exit_code_for_status(status);
+}
+
+static int pr_cli_run_bench(int argc, char **argv)
+{
+    pr_bench_options_t options;
+    pr_status_t status;
+
+    if (!pr_bench_parse_args(argc, argv, 2, &options)) {
+        return pr_cli_print_usage(stderr);
+    }
+
+    status = pr_bench_run(&options);
+    if (status != PR_STATUS_OK) {
+        fprintf(stderr, "Bench failed: %s\n", pr_status_string(status));
+    }
+    return pr_cli_exit_code_for_status(status);
+}
+
 static const char *pr_cli_loop_mode_name(pr_loop_mode_t mode)
 {
     switch (mode) {
@@ -269,6 +368,7 @@ static void pr_cli_print_inspect_text(
 
     fprintf(stdout, "Package: %s\n", package_path);
     fprintf(stdout, "Atlas pages: %u\n", page_count);
+    fprintf(stdout, "Atlas layout: %s\n", pr_atlas_layout_name(pr_package_atlas_layout(package)));
     fprintf(stdout, "Sprites: %u\n", sprite_count);
     fprintf(stdout, "Animations: %u\n", animation_count);
 
@@ -278,23 +378,28 @@ static void pr_cli_print_inspect_text(
 
     fprintf(stdout, "\nAtlas:\n");
     for (i = 0u; i < page_count; ++i) {
-        unsigned int width;
-        unsigned int height;
-        unsigned int stride;
-        const unsigned char *pixels;
-
-        width = 0u;
-        height = 0u;
-        stride = 0u;
-        pixels = pr_package_atlas_page_pixels(package, i, &width, &height, &stride);
+        pr_atlas_page_info_t info;
+        const void *data;
+
+        memset(&info, 0, sizeof(info));
+        data = pr_package_atlas_page_data(package, i, &info);
         fprintf(
             stdout,
-            "  [%u] %ux%u stride=%u pixels=%s\n",
+            "  [%u] %ux%u format=%s color=%s alpha=%s palette=%u stride=%u levels=%u compression=%s "
+            "tile=%u stored=%zu pixels=%s\n",
             i,
-            width,
-            height,
-            stride,
-            (pixels != NULL) ? "yes" : "no"
+            info.width,
+            info.height,
+            pr_page_format_name(info.format),
+            pr_color_space_name(info.color_space),
+            pr_alpha_mode_name(info.alpha_mode),
+            info.palette_count,
+            info.row_bytes,
+            info.level_count,
+            pr_page_compression_name(info.compression),
+            info.tile_size,
+            info.stored_size,
+            (data != NULL || info.stored_size > 0u) ? "yes" : "no"
         );
     }
 
@@ -393,8 +498,9 @@ static void pr_cli_print_inspect_json(
     pr_cli_json_escaped(stdout, package_path);
     (void)fprintf(
         stdout,
-        "\",\"atlas_pages\":%u,\"sprite_count\":%u,\"animation_count\":%u",
+        "\",\"atlas_pages\":%u,\"atlas_layout\":\"%s\",\"sprite_count\":%u,\"animation_count\":%u",
         page_count,
+        pr_atlas_layout_name(pr_package_atlas_layout(package)),
         sprite_count,
         animation_count
     );
@@ -406,26 +512,33 @@ static void pr_cli_print_inspect_json(
 
     (void)fputs(",\"atlas\":[", stdout);
     for (i = 0u; i < page_count; ++i) {
-        unsigned int width;
-        unsigned int height;
-        unsigned int stride;
-        const unsigned char *pixels;
+        pr_atlas_page_info_t info;
+        const void *data;
 
         if (i > 0u) {
             (void)fputc(',', stdout);
         }
-        width = 0u;
-        height = 0u;
-        stride = 0u;
-        pixels = pr_package_atlas_page_pixels(package, i, &width, &height, &stride);
+        memset(&info, 0, sizeof(info));
+        data = pr_package_atlas_page_data(package, i, &info);
         (void)fprintf(
             stdout,
-            "{\"index\":%u,\"width\":%u,\"height\":%u,\"stride\":%u,\"has_pixels\":%s}",
+            "{\"index\":%u,\"width\":%u,\"height\":%u,\"format\":\"%s\",\"color_space\":\"%s\","
+            "\"alpha_mode\":\"%s\",\"palette_colors\":%u,\"stride\":%u,\"levels\":%u,\"data_bytes\":%zu,\"compression\":\"%s\",\"tile_size\":%u,\"stored_bytes\":%zu,"
+            "\"has_pixels\":%s}",
             i,
-            width,
-            height,
-            stride,
-            (pixels != NULL) ? "true" : "false"
+            info.width,
+            info.height,
+            pr_page_format_name(info.format),
+            pr_color_space_name(info.color_space),
+            pr_alpha_mode_name(info.alpha_mode),
+            info.palette_count,
+            info.row_bytes,
+            info.level_count,
+            info.data_size,
+            pr_page_compression_name(info.compression),
+            info.tile_size,
+            info.stored_size,
+            (data != NULL || info.stored_size > 0u) ? "true" : "false"
         );
     }
     (void)fputs("]", stdout);
@@ -560,7 +673,7 @@ static int pr_cli_run_inspect(int argc, char **argv)
         return pr_cli_print_usage(stderr);
     }
 
-    status = pr_package_open_file(argv[2], &package);
+    status = pr_package_open_file_ex(argv[2], PR_PACKAGE_OPEN_VERIFY_CHECKSUMS, &package);
     if (status != PR_STATUS_OK) {
         fprintf(stderr, "Inspect failed: %s\n", pr_status_string(status));
         return pr_cli_exit_code_for_status(status);
@@ -591,6 +704,15 @@ int main(int argc, char **argv)
     if (strcmp(argv[1], "inspect") == 0) {
         return pr_cli_run_inspect(argc, argv);
     }
+    if (strcmp(argv[1], "diff") == 0) {
+        return pr_cli_run_patch_command(argc, argv, 0);
+    }
+    if (strcmp(argv[1], "patch") == 0) {
+        return pr_cli_run_patch_command(argc, argv, 1);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return pr_cli_run_bench(argc, argv);
+    }
     if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
         return pr_cli_print_usage(stdout);
     }
@@ -0,0 +1,101 @@
+#include "color.h"
+
+/* Generated from the sRGB transfer function, rounded to nearest. */
+const uint16_t PR_COLOR_SRGB_TO_LINEAR[256] = {
+    0u, 20u, 40u, 60u, 80u, 99u, 119u, 139u,
+    159u, 179u, 199u, 219u, 241u, 264u, 288u, 313u,
+    340u, 367u, 396u, 427u, 458u, 491u, 526u, 562u,
+    599u, 637u, 677u, 718u, 761u, 805u, 851u, 898u,
+    947u, 997u, 1048u, 1101u, 1156u, 1212u, 1270u, 1330u,
+    1391u, 1453u, 1517u, 1583u, 1651u, 1720u, 1790u, 1863u,
+    1937u, 2013u, 2090u, 2170u, 2250u, 2333u, 2418u, 2504u,
+    2592u, 2681u, 2773u, 2866u, 2961u, 3058u, 3157u, 3258u,
+    3360u, 3464u, 3570u, 3678u, 3788u, 3900u, 4014u, 4129u,
+    4247u, 4366u, 4488u, 4611u, 4736u, 4864u, 4993u, 5124u,
+    5257u, 5392u, 5530u, 5669u, 5810u, 5953u, 6099u, 6246u,
+    6395u, 6547u, 6700u, 6856u, 7014u, 7174u, 7335u, 7500u,
+    7666u, 7834u, 8004u, 8177u, 8352u, 8528u, 8708u, 8889u,
+    9072u, 9258u, 9445u, 9635u, 9828u, 10022u, 10219u, 10417u,
+    10619u, 10822u, 11028u, 11235u, 11446u, 11658u, 11873u, 12090u,
+    12309u, 12530u, 12754u, 12980u, 13209u, 13440u, 13673u, 13909u,
+    14146u, 14387u, 14629u, 14874u, 15122u, 15371u, 15623u, 15878u,
+    16135u, 16394u, 16656u, 16920u, 17187u, 17456u, 17727u, 18001u,
+    18277u, 18556u, 18837u, 19121u, 19407u, 19696u, 19987u, 20281u,
+    20577u, 20876u, 21177u, 21481u, 21787u, 22096u, 22407u, 22721u,
+    23038u, 23357u, 23678u, 24002u, 24329u, 24658u, 24990u, 25325u,
+    25662u, 26001u, 26344u, 26688u, 27036u, 27386u, 27739u, 28094u,
+    28452u, 28813u, 29176u, 29542u, 29911u, 30282u, 30656u, 31033u,
+    31412u, 31794u, 32179u, 32567u, 32957u, 33350u, 33745u, 34143u,
+    34544u, 34948u, 35355u, 35764u, 36176u, 36591u, 37008u, 37429u,
+    37852u, 38278u, 38706u, 39138u, 39572u, 40009u, 40449u, 40891u,
+    41337u, 41785u, 42236u, 42690u, 43147u, 43606u, 44069u, 44534u,
+    45002u, 45473u, 45947u, 46423u, 46903u, 47385u, 47871u, 48359u,
+    48850u, 49344u, 49841u, 50341u, 50844u, 51349u, 51858u, 52369u,
+    52884u, 53401u, 53921u, 54445u, 54971u, 55500u, 56032u, 56567u,
+    57105u, 57646u, 58190u, 58737u, 59287u, 59840u, 60396u, 60955u,
+    61517u, 62082u, 62650u, 63221u, 63795u, 64372u, 64952u, 65535u
+};
+
+unsigned char pr_color_linear_to_srgb(uint32_t linear)
+{
+    uint32_t low;
+    uint32_t high;
+
+    low = 0u;
+    high = 255u;
+    while (low < high) {
+        uint32_t mid;
+
+        mid = (low + high + 1u) / 2u;
+        if (linear * 2u >= (uint32_t)PR_COLOR_SRGB_TO_LINEAR[mid - 1u] + PR_COLOR_SRGB_TO_LINEAR[mid]) {
+            low = mid;
+        } else {
+            high = mid - 1u;
+        }
+    }
+    return (unsigned char)low;
+}
+
+void pr_color_premultiply_table(pr_color_space_t color_space, unsigned char *table)
+{
+    uint32_t alpha;
+    uint32_t value;
+
+    for (alpha = 0u; alpha < 256u; ++alpha) {
+        unsigned char *row;
+
+        row = table + alpha * 256u;
+        for (value = 0u; value < 256u; ++value) {
+            if (color_space == PR_COLOR_SPACE_SRGB) {
+                row[value] = pr_color_linear_to_srgb(
+                    ((uint32_t)PR_COLOR_SRGB_TO_LINEAR[value] * alpha + 127u) / 255u
+                );
+            } else {
+                row[value] = (unsigned char)((value * alpha + 127u) / 255u);
+            }
+        }
+    }
+}
+
+void pr_color_premultiply_rgba(
+    unsigned char *pixels,
+    size_t pixel_count,
+    const unsigned char *table
+)
+{
+    size_t i;
+
+    for (i = 0u; i < pixel_count; ++i) {
+        unsigned char *texel;
+        const unsigned char *row;
+
+        texel = pixels + i * 4u;
+        if (texel[3] == 255u) {
+            continue;
+        }
+        row = table + (size_t)texel[3] * 256u;
+        texel[0] = row[texel[0]];
+        texel[1] = row[texel[1]];
+        texel[2] = row[texel[2]];
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef PACKRAT_COLOR_H
+#define PACKRAT_COLOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packrat/build.h"
+
+/* sRGB to linear light, scaled to 0..65535. */
+extern const uint16_t PR_COLOR_SRGB_TO_LINEAR[256];
+
+/* Nearest sRGB value for a linear one on the same scale, found by bisecting
+ * the midpoints of the decode table.
+ */
+unsigned char pr_color_linear_to_srgb(uint32_t linear);
+
+/* Fills a 256x256 lookup table where `table[alpha * 256 + value]` is `value`
+ * multiplied by `alpha`. sRGB values are multiplied in linear light.
+ */
+void pr_color_premultiply_table(pr_color_space_t color_space, unsigned char *table);
+
+/* Premultiplies the color of tightly packed RGBA8 texels in place. */
+void pr_color_premultiply_rgba(
+    unsigned char *pixels,
+    size_t pixel_count,
+    const unsigned char *table
+);
+
+#endif
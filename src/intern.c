@@ -0,0 +1,318 @@
+#include "intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PR_INTERN_MIN_SLOTS 64u
+
+static uint32_t pr_intern_hash(const char *value, size_t length)
+{
+    uint32_t hash;
+    size_t i;
+
+    hash = 2166136261u;
+    for (i = 0u; i < length; ++i) {
+        hash ^= (uint32_t)(unsigned char)value[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void pr_intern_pool_init(pr_intern_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+void pr_intern_pool_free(pr_intern_pool_t *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    free(pool->bytes);
+    free(pool->offsets);
+    free(pool->lengths);
+    free(pool->hashes);
+    free(pool->slots);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static int pr_intern_reserve_entries(pr_intern_pool_t *pool, size_t needed)
+{
+    size_t new_capacity;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t *hashes;
+
+    if (needed <= pool->capacity) {
+        return 1;
+    }
+    if (needed > (size_t)PR_INTERN_INVALID_HANDLE) {
+        return 0;
+    }
+
+    new_capacity = (pool->capacity == 0u) ? 16u : pool->capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2u;
+    }
+
+    offsets = (uint32_t *)realloc(pool->offsets, new_capacity * sizeof(offsets[0]));
+    if (offsets == NULL) {
+        return 0;
+    }
+    pool->offsets = offsets;
+    lengths = (uint32_t *)realloc(pool->lengths, new_capacity * sizeof(lengths[0]));
+    if (lengths == NULL) {
+        return 0;
+    }
+    pool->lengths = lengths;
+    hashes = (uint32_t *)realloc(pool->hashes, new_capacity * sizeof(hashes[0]));
+    if (hashes == NULL) {
+        return 0;
+    }
+    pool->hashes = hashes;
+    pool->capacity = new_capacity;
+    return 1;
+}
+
+static int pr_intern_reserve_bytes(pr_intern_pool_t *pool, size_t needed)
+{
+    size_t new_capacity;
+    char *grown;
+
+    if (needed <= pool->byte_capacity) {
+        return 1;
+    }
+    if (needed > (size_t)UINT32_MAX) {
+        return 0;
+    }
+
+    new_capacity = (pool->byte_capacity == 0u) ? 256u : pool->byte_capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2u;
+    }
+
+    grown = (char *)realloc(pool->bytes, new_capacity);
+    if (grown == NULL) {
+        return 0;
+    }
+    pool->bytes = grown;
+    pool->byte_capacity = new_capacity;
+    return 1;
+}
+
+static int pr_intern_rehash(pr_intern_pool_t *pool, size_t slot_count)
+{
+    uint32_t *slots;
+    size_t mask;
+    size_t i;
+
+    slots = (uint32_t *)calloc(slot_count, sizeof(slots[0]));
+    if (slots == NULL) {
+        return 0;
+    }
+
+    mask = slot_count - 1u;
+    for (i = 0u; i < pool->count; ++i) {
+        size_t slot;
+
+        slot = (size_t)pool->hashes[i] & mask;
+        while (slots[slot] != 0u) {
+            slot = (slot + 1u) & mask;
+        }
+        slots[slot] = (uint32_t)i + 1u;
+    }
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_count = slot_count;
+    return 1;
+}
+
+static int pr_intern_reserve_slots(pr_intern_pool_t *pool, size_t entry_count)
+{
+    size_t slot_count;
+
+    /* Keep the load factor at or below one half so probe chains stay short. */
+    slot_count = (pool->slot_count == 0u) ? PR_INTERN_MIN_SLOTS : pool->slot_count;
+    while (slot_count / 2u < entry_count) {
+        if (slot_count > ((size_t)-1) / 2u) {
+            return 0;
+        }
+        slot_count *= 2u;
+    }
+    if (slot_count == pool->slot_count) {
+        return 1;
+    }
+    return pr_intern_rehash(pool, slot_count);
+}
+
+int pr_intern_pool_reserve(
+    pr_intern_pool_t *pool,
+    size_t string_count,
+    size_t byte_count
+)
+{
+    if (pool == NULL) {
+        return 0;
+    }
+
+    return pr_intern_reserve_entries(pool, string_count) &&
+        pr_intern_reserve_bytes(pool, byte_count) &&
+        pr_intern_reserve_slots(pool, string_count);
+}
+
+static size_t pr_intern_probe(
+    const pr_intern_pool_t *pool,
+    const char *value,
+    size_t length,
+    uint32_t hash,
+    uint32_t *out_handle
+)
+{
+    size_t mask;
+    size_t slot;
+
+    mask = pool->slot_count - 1u;
+    slot = (size_t)hash & mask;
+    while (pool->slots[slot] != 0u) {
+        uint32_t handle;
+
+        handle = pool->slots[slot] - 1u;
+        if (
+            pool->hashes[handle] == hash &&
+            pool->lengths[handle] == (uint32_t)length &&
+            memcmp(pool->bytes + pool->offsets[handle], value, length) == 0
+        ) {
+            *out_handle = handle;
+            return slot;
+        }
+        slot = (slot + 1u) & mask;
+    }
+
+    *out_handle = PR_INTERN_INVALID_HANDLE;
+    return slot;
+}
+
+int pr_intern_pool_add_n(
+    pr_intern_pool_t *pool,
+    const char *value,
+    size_t length,
+    uint32_t *out_handle
+)
+{
+    uint32_t hash;
+    uint32_t handle;
+    size_t slot;
+
+    if (pool == NULL || (value == NULL && length > 0u) || out_handle == NULL) {
+        return 0;
+    }
+    if (length >= (size_t)UINT32_MAX) {
+        return 0;
+    }
+
+    if (!pr_intern_reserve_slots(pool, pool->count + 1u)) {
+        return 0;
+    }
+
+    hash = pr_intern_hash(value, length);
+    slot = pr_intern_probe(pool, value, length, hash, &handle);
+    if (handle != PR_INTERN_INVALID_HANDLE) {
+        *out_handle = handle;
+        return 1;
+    }
+
+    if (
+        pool->byte_count + length + 1u < pool->byte_count ||
+        !pr_intern_reserve_entries(pool, pool->count + 1u) ||
+        !pr_intern_reserve_bytes(pool, pool->byte_count + length + 1u)
+    ) {
+        return 0;
+    }
+
+    handle = (uint32_t)pool->count;
+    if (length > 0u) {
+        memcpy(pool->bytes + pool->byte_count, value, length);
+    }
+    pool->bytes[pool->byte_count + length] = '\0';
+    pool->offsets[handle] = (uint32_t)pool->byte_count;
+    pool->lengths[handle] = (uint32_t)length;
+    pool->hashes[handle] = hash;
+    pool->byte_count += length + 1u;
+    pool->count += 1u;
+    pool->slots[slot] = handle + 1u;
+
+    *out_handle = handle;
+    return 1;
+}
+
+int pr_intern_pool_add(
+    pr_intern_pool_t *pool,
+    const char *value,
+    uint32_t *out_handle
+)
+{
+    if (value == NULL) {
+        return 0;
+    }
+    return pr_intern_pool_add_n(pool, value, strlen(value), out_handle);
+}
+
+int pr_intern_pool_find_n(
+    const pr_intern_pool_t *pool,
+    const char *value,
+    size_t length,
+    uint32_t *out_handle
+)
+{
+    uint32_t handle;
+
+    if (pool == NULL || (value == NULL && length > 0u) || out_handle == NULL) {
+        return 0;
+    }
+
+    *out_handle = PR_INTERN_INVALID_HANDLE;
+    if (pool->count == 0u || length >= (size_t)UINT32_MAX) {
+        return 0;
+    }
+
+    (void)pr_intern_probe(pool, value, length, pr_intern_hash(value, length), &handle);
+    if (handle == PR_INTERN_INVALID_HANDLE) {
+        return 0;
+    }
+
+    *out_handle = handle;
+    return 1;
+}
+
+int pr_intern_pool_find(
+    const pr_intern_pool_t *pool,
+    const char *value,
+    uint32_t *out_handle
+)
+{
+    if (value == NULL) {
+        return 0;
+    }
+    return pr_intern_pool_find_n(pool, value, strlen(value), out_handle);
+}
+
+const char *pr_intern_pool_get(const pr_intern_pool_t *pool, uint32_t handle)
+{
+    if (pool == NULL || (size_t)handle >= pool->count) {
+        return NULL;
+    }
+    return pool->bytes + pool->offsets[handle];
+}
+
+size_t pr_intern_pool_length(const pr_intern_pool_t *pool, uint32_t handle)
+{
+    if (pool == NULL || (size_t)handle >= pool->count) {
+        return 0u;
+    }
+    return (size_t)pool->lengths[handle];
+}
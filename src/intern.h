@@ -0,0 +1,64 @@
+#ifndef PACKRAT_INTERN_H
+#define PACKRAT_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PR_INTERN_INVALID_HANDLE 0xFFFFFFFFu
+
+/* Deduplicating string pool. Strings are stored NUL-terminated, back to back,
+ * in one contiguous byte arena and addressed by dense 32-bit handles assigned
+ * in insertion order. Lookups go through an open-addressing hash table.
+ *
+ * Pointers returned by `pr_intern_pool_get` are invalidated by any later add.
+ */
+typedef struct pr_intern_pool {
+    char *bytes;
+    size_t byte_count;
+    size_t byte_capacity;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t *hashes;
+    size_t count;
+    size_t capacity;
+    uint32_t *slots;
+    size_t slot_count;
+} pr_intern_pool_t;
+
+void pr_intern_pool_init(pr_intern_pool_t *pool);
+void pr_intern_pool_free(pr_intern_pool_t *pool);
+
+int pr_intern_pool_reserve(
+    pr_intern_pool_t *pool,
+    size_t string_count,
+    size_t byte_count
+);
+
+int pr_intern_pool_add(
+    pr_intern_pool_t *pool,
+    const char *value,
+    uint32_t *out_handle
+);
+int pr_intern_pool_add_n(
+    pr_intern_pool_t *pool,
+    const char *value,
+    size_t length,
+    uint32_t *out_handle
+);
+
+int pr_intern_pool_find(
+    const pr_intern_pool_t *pool,
+    const char *value,
+    uint32_t *out_handle
+);
+int pr_intern_pool_find_n(
+    const pr_intern_pool_t *pool,
+    const char *value,
+    size_t length,
+    uint32_t *out_handle
+);
+
+const char *pr_intern_pool_get(const pr_intern_pool_t *pool, uint32_t handle);
+size_t pr_intern_pool_length(const pr_intern_pool_t *pool, uint32_t handle);
+
+#endif
@@ -0,0 +1,244 @@
+#include "lz.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define PR_LZ_MIN_MATCH 4u
+#define PR_LZ_MAX_OFFSET 0xFFFFu
+#define PR_LZ_HASH_BITS 14u
+#define PR_LZ_HASH_SIZE (1u << PR_LZ_HASH_BITS)
+
+static uint32_t pr_lz_read_u32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] |
+        ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) |
+        ((uint32_t)bytes[3] << 24);
+}
+
+static uint32_t pr_lz_hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32u - PR_LZ_HASH_BITS);
+}
+
+static int pr_lz_put_length(
+    unsigned char *dst,
+    size_t dst_capacity,
+    size_t *io_out,
+    size_t length
+)
+{
+    while (length >= 255u) {
+        if (*io_out >= dst_capacity) {
+            return 0;
+        }
+        dst[(*io_out)++] = 255u;
+        length -= 255u;
+    }
+    if (*io_out >= dst_capacity) {
+        return 0;
+    }
+    dst[(*io_out)++] = (unsigned char)length;
+    return 1;
+}
+
+/* `match_length` 0 writes the final, literal-only sequence. */
+static int pr_lz_put_sequence(
+    unsigned char *dst,
+    size_t dst_capacity,
+    size_t *io_out,
+    const unsigned char *literals,
+    size_t literal_count,
+    size_t offset,
+    size_t match_length
+)
+{
+    size_t match_code;
+    unsigned char token;
+
+    match_code = (match_length > 0u) ? match_length - PR_LZ_MIN_MATCH : 0u;
+    token = (unsigned char)(
+        ((literal_count >= 15u) ? 15u : literal_count) << 4 |
+        ((match_code >= 15u) ? 15u : match_code)
+    );
+    if (*io_out >= dst_capacity) {
+        return 0;
+    }
+    dst[(*io_out)++] = token;
+    if (literal_count >= 15u && !pr_lz_put_length(dst, dst_capacity, io_out, literal_count - 15u)) {
+        return 0;
+    }
+    if (literal_count > dst_capacity - *io_out) {
+        return 0;
+    }
+    memcpy(dst + *io_out, literals, literal_count);
+    *io_out += literal_count;
+    if (match_length == 0u) {
+        return 1;
+    }
+
+    if (dst_capacity - *io_out < 2u) {
+        return 0;
+    }
+    dst[(*io_out)++] = (unsigned char)(offset & 0xFFu);
+    dst[(*io_out)++] = (unsigned char)(offset >> 8);
+    if (match_code >= 15u && !pr_lz_put_length(dst, dst_capacity, io_out, match_code - 15u)) {
+        return 0;
+    }
+    return 1;
+}
+
+size_t pr_lz_compress(
+    const unsigned char *src,
+    size_t src_size,
+    unsigned char *dst,
+    size_t dst_capacity
+)
+{
+    uint32_t table[PR_LZ_HASH_SIZE];
+    size_t pos;
+    size_t anchor;
+    size_t out;
+
+    if ((src == NULL && src_size > 0u) || dst == NULL) {
+        return 0u;
+    }
+
+    memset(table, 0, sizeof(table));
+    pos = 0u;
+    anchor = 0u;
+    out = 0u;
+    while (src_size >= PR_LZ_MIN_MATCH && pos <= src_size - PR_LZ_MIN_MATCH) {
+        uint32_t sequence;
+        uint32_t hash;
+        size_t candidate;
+
+        sequence = pr_lz_read_u32(src + pos);
+        hash = pr_lz_hash(sequence);
+        candidate = (size_t)table[hash];
+        table[hash] = (uint32_t)pos;
+        if (
+            candidate < pos &&
+            pos - candidate <= PR_LZ_MAX_OFFSET &&
+            pr_lz_read_u32(src + candidate) == sequence
+        ) {
+            size_t length;
+
+            length = PR_LZ_MIN_MATCH;
+            while (pos + length < src_size && src[candidate + length] == src[pos + length]) {
+                ++length;
+            }
+            if (!pr_lz_put_sequence(
+                    dst,
+                    dst_capacity,
+                    &out,
+                    src + anchor,
+                    pos - anchor,
+                    pos - candidate,
+                    length
+                )) {
+                return 0u;
+            }
+            pos += length;
+            anchor = pos;
+        } else {
+            /* Step faster through data that keeps missing. */
+            pos += 1u + ((pos - anchor) >> 6);
+        }
+    }
+
+    if (!pr_lz_put_sequence(dst, dst_capacity, &out, src + anchor, src_size - anchor, 0u, 0u)) {
+        return 0u;
+    }
+    return out;
+}
+
+static int pr_lz_get_length(
+    const unsigned char *src,
+    size_t src_size,
+    size_t *io_in,
+    size_t *io_length
+)
+{
+    unsigned char byte;
+
+    do {
+        if (*io_in >= src_size) {
+            return 0;
+        }
+        byte = src[(*io_in)++];
+        *io_length += byte;
+    } while (byte == 255u);
+    return 1;
+}
+
+int pr_lz_decompress(
+    const unsigned char *src,
+    size_t src_size,
+    unsigned char *dst,
+    size_t dst_size
+)
+{
+    size_t in;
+    size_t out;
+
+    if ((src == NULL && src_size > 0u) || (dst == NULL && dst_size > 0u)) {
+        return 0;
+    }
+
+    in = 0u;
+    out = 0u;
+    while (in < src_size) {
+        unsigned char token;
+        size_t literal_count;
+        size_t match_length;
+        size_t offset;
+
+        token = src[in++];
+        literal_count = (size_t)(token >> 4);
+        if (literal_count == 15u && !pr_lz_get_length(src, src_size, &in, &literal_count)) {
+            return 0;
+        }
+        if (literal_count > src_size - in || literal_count > dst_size - out) {
+            return 0;
+        }
+        memcpy(dst + out, src + in, literal_count);
+        in += literal_count;
+        out += literal_count;
+        if (in == src_size) {
+            break;
+        }
+
+        if (src_size - in < 2u) {
+            return 0;
+        }
+        offset = (size_t)src[in] | ((size_t)src[in + 1u] << 8);
+        in += 2u;
+        match_length = (size_t)(token & 15u);
+        if (match_length == 15u && !pr_lz_get_length(src, src_size, &in, &match_length)) {
+            return 0;
+        }
+        match_length += PR_LZ_MIN_MATCH;
+        if (offset == 0u || offset > out || match_length > dst_size - out) {
+            return 0;
+        }
+        {
+            size_t start;
+
+            /* An overlapping match repeats a period of `offset` bytes, so each
+             * copy can take everything written since `start`, doubling in size.
+             */
+            start = out - offset;
+            while (match_length > 0u) {
+                size_t count;
+
+                count = out - start;
+                count = (count < match_length) ? count : match_length;
+                memcpy(dst + out, dst + start, count);
+                out += count;
+                match_length -= count;
+            }
+        }
+    }
+    return out == dst_size;
+}
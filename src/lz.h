@@ -0,0 +1,33 @@
+#ifndef PACKRAT_LZ_H
+#define PACKRAT_LZ_H
+
+#include <stddef.h>
+
+/* Byte-oriented LZ77 for atlas page blobs. A stream is a run of sequences,
+ * each a token byte (literal length in the high nibble, match length minus 4
+ * in the low nibble, 15 meaning "more length bytes follow"), the literals,
+ * then a 2-byte little-endian match offset and any extra match length bytes.
+ * The last sequence carries literals only.
+ */
+
+/* Returns the compressed size, or 0 when the output would not fit in
+ * `dst_capacity`.
+ */
+size_t pr_lz_compress(
+    const unsigned char *src,
+    size_t src_size,
+    unsigned char *dst,
+    size_t dst_capacity
+);
+
+/* Returns 1 when `src` decodes to exactly `dst_size` bytes, 0 for malformed
+ * or mis-sized input.
+ */
+int pr_lz_decompress(
+    const unsigned char *src,
+    size_t src_size,
+    unsigned char *dst,
+    size_t dst_size
+);
+
+#endif
@@ -4,6 +4,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "intern.h"
+#include "manifest_cache.h"
+#include "page_format.h"
+#include "parallel.h"
 
 typedef enum pr_manifest_section {
     PR_MANIFEST_SECTION_ROOT = 0,
@@ -19,8 +31,18 @@ typedef struct pr_manifest_diag_context {
     void *user_data;
     int error_count;
     int warning_count;
+    pr_manifest_cache_diags_t *capture;
 } pr_manifest_diag_context_t;
 
+/* Walks the manifest buffer one line at a time, terminating each line in
+ * place. Nothing is copied; spans handed to the parsers point into `text`.
+ */
+typedef struct pr_manifest_reader {
+    char *cursor;
+    char *end;
+    int line_number;
+} pr_manifest_reader_t;
+
 typedef struct pr_manifest_parse_state {
     pr_manifest_t *manifest;
     pr_manifest_diag_context_t *diag;
@@ -31,6 +53,7 @@ typedef struct pr_manifest_parse_state {
     size_t current_rect;
     size_t current_animation;
     int parse_error_count;
+    int is_include;
 } pr_manifest_parse_state_t;
 
 static void pr_manifest_emit_diag(
@@ -55,6 +78,18 @@ static void pr_manifest_emit_diag(
     } else if (severity == PR_DIAG_WARNING) {
         diag->warning_count += 1;
     }
+    if (diag->capture != NULL) {
+        pr_manifest_cache_diags_record(
+            diag->capture,
+            severity,
+            message,
+            file,
+            line,
+            column,
+            code,
+            asset_id
+        );
+    }
 
     if (diag->sink == NULL) {
         return;
@@ -103,23 +138,6 @@ static int pr_manifest_reserve_array(
     return 1;
 }
 
-static int pr_manifest_copy_string(char *dst, size_t dst_size, const char *src)
-{
-    size_t length;
-
-    if (dst == NULL || dst_size == 0u || src == NULL) {
-        return 0;
-    }
-
-    length = strlen(src);
-    if (length >= dst_size) {
-        return 0;
-    }
-
-    memcpy(dst, src, length + 1u);
-    return 1;
-}
-
 void pr_manifest_init(pr_manifest_t *manifest)
 {
     if (manifest == NULL) {
@@ -131,11 +149,15 @@ void pr_manifest_init(pr_manifest_t *manifest)
     manifest->atlas.max_page_height = 2048;
     manifest->atlas.padding = 1;
     manifest->atlas.power_of_two = 0;
-    (void)pr_manifest_copy_string(
-        manifest->atlas.sampling,
-        sizeof(manifest->atlas.sampling),
-        "pixel"
-    );
+    manifest->atlas.sampling = PR_MANIFEST_NO_STRING;
+    manifest->atlas.format = PR_MANIFEST_NO_STRING;
+    manifest->atlas.encode_quality = PR_MANIFEST_NO_STRING;
+    manifest->atlas.compression = PR_MANIFEST_NO_STRING;
+    manifest->atlas.layout = PR_MANIFEST_NO_STRING;
+    manifest->atlas.repack_threshold = 25;
+    manifest->package_name = PR_MANIFEST_NO_STRING;
+    manifest->output = PR_MANIFEST_NO_STRING;
+    manifest->debug_output = PR_MANIFEST_NO_STRING;
 }
 
 void pr_manifest_free(pr_manifest_t *manifest)
@@ -167,9 +189,38 @@ void pr_manifest_free(pr_manifest_t *manifest)
     free(manifest->images);
     free(manifest->sprites);
     free(manifest->animations);
+    free(manifest->includes);
+    free(manifest->sources);
+    pr_intern_pool_free(&manifest->strings);
     pr_manifest_init(manifest);
 }
 
+const char *pr_manifest_string(const pr_manifest_t *manifest, uint32_t handle)
+{
+    const char *value;
+
+    if (manifest == NULL) {
+        return "";
+    }
+    value = pr_intern_pool_get(&manifest->strings, handle);
+    return (value != NULL) ? value : "";
+}
+
+const char *pr_manifest_entry_path(
+    const pr_manifest_t *manifest,
+    uint32_t file,
+    const char *manifest_path
+)
+{
+    const char *value;
+
+    if (manifest == NULL || file == PR_MANIFEST_NO_STRING) {
+        return manifest_path;
+    }
+    value = pr_intern_pool_get(&manifest->strings, file);
+    return (value != NULL) ? value : manifest_path;
+}
+
 static char *pr_manifest_read_text_file(const char *path, size_t *out_size)
 {
     FILE *file;
@@ -221,52 +272,25 @@ static char *pr_manifest_read_text_file(const char *path, size_t *out_size)
     return buffer;
 }
 
-static int pr_manifest_split_lines(char *text, char ***out_lines, size_t *out_line_count)
+static char *pr_manifest_reader_next_line(pr_manifest_reader_t *reader)
 {
-    char **lines;
-    size_t line_capacity;
-    size_t line_count;
-    char *cursor;
+    char *line;
+    char *newline;
 
-    if (text == NULL || out_lines == NULL || out_line_count == NULL) {
-        return 0;
-    }
-
-    line_capacity = 16u;
-    line_count = 0u;
-    lines = (char **)calloc(line_capacity, sizeof(lines[0]));
-    if (lines == NULL) {
-        return 0;
+    if (reader == NULL || reader->cursor == NULL || reader->cursor > reader->end) {
+        return NULL;
     }
 
-    cursor = text;
-    while (1) {
-        char *newline;
-
-        if (line_count + 1u > line_capacity) {
-            char **grown;
-
-            line_capacity *= 2u;
-            grown = (char **)realloc(lines, line_capacity * sizeof(lines[0]));
-            if (grown == NULL) {
-                free(lines);
-                return 0;
-            }
-            lines = grown;
-        }
-
-        lines[line_count++] = cursor;
-        newline = strchr(cursor, '\n');
-        if (newline == NULL) {
-            break;
-        }
+    line = reader->cursor;
+    newline = (char *)memchr(line, '\n', (size_t)(reader->end - line));
+    if (newline == NULL) {
+        reader->cursor = NULL;
+    } else {
         *newline = '\0';
-        cursor = newline + 1;
+        reader->cursor = newline + 1;
     }
-
-    *out_lines = lines;
-    *out_line_count = line_count;
-    return 1;
+    reader->line_number += 1;
+    return line;
 }
 
 static void pr_manifest_strip_comment_inplace(char *line)
@@ -382,74 +406,78 @@ static int pr_manifest_split_key_value_inplace(
     return 0;
 }
 
-static int pr_manifest_parse_string_value(
-    const char *value,
-    char *out_value,
-    size_t out_value_size
-)
+/* Decodes a string value in place. Quoted values have their escapes resolved
+ * over the source text, so the result never outgrows the input.
+ */
+static int pr_manifest_parse_string_value(char *value, const char **out_value)
 {
-    const char *cursor;
+    char *cursor;
     size_t out_index;
+    int escape_next;
 
-    if (value == NULL || out_value == NULL || out_value_size == 0u) {
+    if (value == NULL || out_value == NULL) {
         return 0;
     }
 
-    out_value[0] = '\0';
-    cursor = value;
-
-    if (*cursor == '"') {
-        int escape_next;
-
-        cursor += 1;
-        out_index = 0u;
-        escape_next = 0;
-        while (*cursor != '\0') {
-            char ch;
+    *out_value = value;
+    if (*value != '"') {
+        return 1;
+    }
 
-            if (escape_next != 0) {
-                if (*cursor == 'n') {
-                    ch = '\n';
-                } else if (*cursor == 't') {
-                    ch = '\t';
-                } else {
-                    ch = *cursor;
-                }
-                escape_next = 0;
+    cursor = value + 1;
+    out_index = 0u;
+    escape_next = 0;
+    while (*cursor != '\0') {
+        char ch;
+
+        if (escape_next != 0) {
+            if (*cursor == 'n') {
+                ch = '\n';
+            } else if (*cursor == 't') {
+                ch = '\t';
             } else {
-                if (*cursor == '\\') {
-                    escape_next = 1;
-                    cursor += 1;
-                    continue;
-                }
-                if (*cursor == '"') {
-                    cursor += 1;
-                    break;
-                }
                 ch = *cursor;
             }
-
-            if (out_index + 1u >= out_value_size) {
-                return 0;
+            escape_next = 0;
+        } else {
+            if (*cursor == '\\') {
+                escape_next = 1;
+                cursor += 1;
+                continue;
             }
-            out_value[out_index++] = ch;
-            cursor += 1;
+            if (*cursor == '"') {
+                cursor += 1;
+                break;
+            }
+            ch = *cursor;
         }
 
-        cursor = pr_manifest_trim_inplace((char *)cursor);
-        if (*cursor != '\0') {
-            return 0;
-        }
-        out_value[out_index] = '\0';
-        return 1;
+        value[out_index++] = ch;
+        cursor += 1;
     }
 
-    if (!pr_manifest_copy_string(out_value, out_value_size, value)) {
+    cursor = pr_manifest_trim_inplace(cursor);
+    if (*cursor != '\0') {
         return 0;
     }
+    value[out_index] = '\0';
     return 1;
 }
 
+static int pr_manifest_parse_string_handle(
+    pr_manifest_t *manifest,
+    char *value,
+    uint32_t *out_handle
+)
+{
+    const char *parsed;
+
+    if (!pr_manifest_parse_string_value(value, &parsed)) {
+        return 0;
+    }
+    return pr_intern_pool_add(&manifest->strings, parsed, out_handle);
+}
+
 static int pr_manifest_parse_int_value(const char *value, int *out_value)
 {
     char *end;
@@ -547,188 +575,6 @@ static int pr_manifest_parse_section_header(
     return 0;
 }
 
-static int pr_manifest_bracket_depth_delta(const char *text)
-{
-    int depth;
-    int in_string;
-    int escape_next;
-    const char *cursor;
-
-    if (text == NULL) {
-        return 0;
-    }
-
-    depth = 0;
-    in_string = 0;
-    escape_next = 0;
-    for (cursor = text; *cursor != '\0'; ++cursor) {
-        if (in_string != 0) {
-            if (escape_next != 0) {
-                escape_next = 0;
-                continue;
-            }
-            if (*cursor == '\\') {
-                escape_next = 1;
-                continue;
-            }
-            if (*cursor == '"') {
-                in_string = 0;
-            }
-            continue;
-        }
-
-        if (*cursor == '"') {
-            in_string = 1;
-            continue;
-        }
-        if (*cursor == '[') {
-            depth += 1;
-        } else if (*cursor == ']') {
-            depth -= 1;
-        }
-    }
-
-    return depth;
-}
-
-static int pr_manifest_append_text(
-    char **buffer,
-    size_t *length,
-    size_t *capacity,
-    const char *text
-)
-{
-    size_t append_length;
-    size_t needed;
-    char *grown;
-
-    if (buffer == NULL || length == NULL || capacity == NULL || text == NULL) {
-        return 0;
-    }
-
-    append_length = strlen(text);
-    needed = *length + append_length + 1u;
-    if (needed > *capacity) {
-        size_t new_capacity;
-
-        new_capacity = (*capacity == 0u) ? 64u : *capacity;
-        while (new_capacity < needed) {
-            new_capacity *= 2u;
-        }
-
-        grown = (char *)realloc(*buffer, new_capacity);
-        if (grown == NULL) {
-            return 0;
-        }
-        *buffer = grown;
-        *capacity = new_capacity;
-    }
-
-    memcpy(*buffer + *length, text, append_length);
-    *length += append_length;
-    (*buffer)[*length] = '\0';
-    return 1;
-}
-
-static int pr_manifest_collect_array_value(
-    char **lines,
-    size_t line_count,
-    size_t *line_index,
-    char *initial_value,
-    char **out_value,
-    pr_manifest_diag_context_t *diag,
-    const char *manifest_path
-)
-{
-    char *combined;
-    size_t length;
-    size_t capacity;
-    int depth;
-
-    if (
-        lines == NULL ||
-        line_index == NULL ||
-        initial_value == NULL ||
-        out_value == NULL ||
-        diag == NULL
-    ) {
-        return 0;
-    }
-
-    *out_value = NULL;
-    combined = NULL;
-    length = 0u;
-    capacity = 0u;
-
-    if (initial_value[0] != '[') {
-        pr_manifest_emit_diag(
-            diag,
-            PR_DIAG_ERROR,
-            "Array value must start with '['.",
-            manifest_path,
-            (int)(*line_index + 1u),
-            1,
-            "manifest.array_missing_open",
-            NULL
-        );
-        return 0;
-    }
-
-    if (!pr_manifest_append_text(&combined, &length, &capacity, initial_value)) {
-        free(combined);
-        pr_manifest_emit_diag(
-            diag,
-            PR_DIAG_ERROR,
-            "Allocation failed while reading array value.",
-            manifest_path,
-            (int)(*line_index + 1u),
-            1,
-            "manifest.array_alloc_failed",
-            NULL
-        );
-        return 0;
-    }
-
-    depth = pr_manifest_bracket_depth_delta(initial_value);
-    while (depth > 0) {
-        char *line;
-
-        if (*line_index + 1u >= line_count) {
-            free(combined);
-            pr_manifest_emit_diag(
-                diag,
-                PR_DIAG_ERROR,
-                "Unterminated array value.",
-                manifest_path,
-                (int)(*line_index + 1u),
-                1,
-                "manifest.array_unterminated",
-                NULL
-            );
-            return 0;
-        }
-
-        *line_index += 1u;
-        line = lines[*line_index];
-        pr_manifest_strip_comment_inplace(line);
-        line = pr_manifest_trim_inplace(line);
-
-        if (!pr_manifest_append_text(&combined, &length, &capacity, "\n")) {
-            free(combined);
-            return 0;
-        }
-        if (!pr_manifest_append_text(&combined, &length, &capacity, line)) {
-            free(combined);
-            return 0;
-        }
-
-        depth += pr_manifest_bracket_depth_delta(line);
-    }
-
-    *out_value = combined;
-    return 1;
-}
-
 static pr_manifest_image_t *pr_manifest_push_image(pr_manifest_t *manifest)
 {
     pr_manifest_image_t *image;
@@ -748,7 +594,13 @@ static pr_manifest_image_t *pr_manifest_push_image(pr_manifest_t *manifest)
     image = &manifest->images[manifest->image_count++];
     memset(image, 0, sizeof(*image));
     image->premultiply_alpha = 0;
-    (void)pr_manifest_copy_string(image->color_space, sizeof(image->color_space), "srgb");
+    image->file = PR_MANIFEST_NO_STRING;
+    image->id = PR_MANIFEST_NO_STRING;
+    image->path = PR_MANIFEST_NO_STRING;
+    if (!pr_intern_pool_add(&manifest->strings, "srgb", &image->color_space)) {
+        manifest->image_count -= 1u;
+        return NULL;
+    }
     return image;
 }
 
@@ -770,6 +622,9 @@ static pr_manifest_sprite_t *pr_manifest_push_sprite(pr_manifest_t *manifest)
 
     sprite = &manifest->sprites[manifest->sprite_count++];
     memset(sprite, 0, sizeof(*sprite));
+    sprite->file = PR_MANIFEST_NO_STRING;
+    sprite->id = PR_MANIFEST_NO_STRING;
+    sprite->source = PR_MANIFEST_NO_STRING;
     sprite->mode = PR_MANIFEST_SPRITE_MODE_SINGLE;
     sprite->pivot_x = 0.5;
     sprite->pivot_y = 0.5;
@@ -794,6 +649,7 @@ static pr_manifest_sprite_rect_t *pr_manifest_push_sprite_rect(pr_manifest_sprit
 
     rect = &sprite->rects[sprite->rect_count++];
     memset(rect, 0, sizeof(*rect));
+    rect->label = PR_MANIFEST_NO_STRING;
     return rect;
 }
 
@@ -815,6 +671,9 @@ static pr_manifest_animation_t *pr_manifest_push_animation(pr_manifest_t *manife
 
     animation = &manifest->animations[manifest->animation_count++];
     memset(animation, 0, sizeof(*animation));
+    animation->file = PR_MANIFEST_NO_STRING;
+    animation->id = PR_MANIFEST_NO_STRING;
+    animation->sprite = PR_MANIFEST_NO_STRING;
     animation->loop_mode = PR_LOOP_LOOP;
     return animation;
 }
@@ -842,52 +701,144 @@ static pr_manifest_animation_frame_t *pr_manifest_push_animation_frame(
     return frame;
 }
 
-static int pr_manifest_parse_animation_frames_value(
-    const char *value,
-    pr_manifest_animation_t *animation,
-    pr_manifest_diag_context_t *diag,
-    const char *manifest_path,
-    int line_number
-)
+static int pr_manifest_bracket_depth_delta(const char *text)
 {
-    char *work;
-    char *cursor;
-    char *end;
-    int any_frame;
-
-    if (value == NULL || animation == NULL || diag == NULL) {
-        return 0;
-    }
+    int depth;
+    int in_string;
+    int escape_next;
+    const char *cursor;
 
-    work = (char *)malloc(strlen(value) + 1u);
-    if (work == NULL) {
-        pr_manifest_emit_diag(
-            diag,
-            PR_DIAG_ERROR,
-            "Allocation failed while parsing animation frames.",
-            manifest_path,
-            line_number,
-            1,
-            "manifest.frames_alloc_failed",
-            animation->id
-        );
+    if (text == NULL) {
         return 0;
     }
-    memcpy(work, value, strlen(value) + 1u);
-    cursor = pr_manifest_trim_inplace(work);
 
-    end = cursor + strlen(cursor);
-    if (end == cursor || cursor[0] != '[' || end[-1] != ']') {
-        free(work);
-        pr_manifest_emit_diag(
-            diag,
+    depth = 0;
+    in_string = 0;
+    escape_next = 0;
+    for (cursor = text; *cursor != '\0'; ++cursor) {
+        if (in_string != 0) {
+            if (escape_next != 0) {
+                escape_next = 0;
+                continue;
+            }
+            if (*cursor == '\\') {
+                escape_next = 1;
+                continue;
+            }
+            if (*cursor == '"') {
+                in_string = 0;
+            }
+            continue;
+        }
+
+        if (*cursor == '"') {
+            in_string = 1;
+            continue;
+        }
+        if (*cursor == '[') {
+            depth += 1;
+        } else if (*cursor == ']') {
+            depth -= 1;
+        }
+    }
+
+    return depth;
+}
+
+/* Pulls the remaining lines of a multi-line array from the reader and joins
+ * them onto value with '\n' separators. Each line sits later in the same
+ * buffer, so the joined text is compacted in place without a scratch copy.
+ */
+static int pr_manifest_collect_array_value(
+    pr_manifest_reader_t *reader,
+    char *value,
+    pr_manifest_diag_context_t *diag,
+    const char *manifest_path
+)
+{
+    char *end;
+    int depth;
+
+    if (reader == NULL || value == NULL || diag == NULL) {
+        return 0;
+    }
+
+    if (value[0] != '[') {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "Array value must start with '['.",
+            manifest_path,
+            reader->line_number,
+            1,
+            "manifest.array_missing_open",
+            NULL
+        );
+        return 0;
+    }
+
+    end = value + strlen(value);
+    depth = pr_manifest_bracket_depth_delta(value);
+    while (depth > 0) {
+        char *line;
+        size_t length;
+
+        line = pr_manifest_reader_next_line(reader);
+        if (line == NULL) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Unterminated array value.",
+                manifest_path,
+                reader->line_number,
+                1,
+                "manifest.array_unterminated",
+                NULL
+            );
+            return 0;
+        }
+        pr_manifest_strip_comment_inplace(line);
+        line = pr_manifest_trim_inplace(line);
+        depth += pr_manifest_bracket_depth_delta(line);
+
+        length = strlen(line);
+        *end = '\n';
+        memmove(end + 1, line, length + 1u);
+        end += length + 1u;
+    }
+
+    return 1;
+}
+
+static int pr_manifest_parse_animation_frames_value(
+    char *value,
+    pr_manifest_animation_t *animation,
+    const char *animation_id,
+    pr_manifest_diag_context_t *diag,
+    const char *manifest_path,
+    int line_number
+)
+{
+    char *cursor;
+    char *end;
+    int any_frame;
+
+    if (value == NULL || animation == NULL || diag == NULL) {
+        return 0;
+    }
+
+    cursor = pr_manifest_trim_inplace(value);
+    end = cursor + strlen(cursor);
+    if (end == cursor || cursor[0] != '[' || end[-1] != ']') {
+        pr_manifest_emit_diag(
+            diag,
             PR_DIAG_ERROR,
             "Animation frames must be an array of inline tables.",
             manifest_path,
             line_number,
             1,
             "manifest.frames_not_array",
-            animation->id
+            animation_id
         );
         return 0;
     }
@@ -898,12 +849,10 @@ static int pr_manifest_parse_animation_frames_value(
 
     any_frame = 0;
     while (1) {
-        char *object_start;
         char *object_end;
         int brace_depth;
         int in_string;
         int escape_next;
-        char *object_text;
         pr_manifest_animation_frame_t *frame;
         char *pair_cursor;
         int has_index;
@@ -917,7 +866,6 @@ static int pr_manifest_parse_animation_frames_value(
         }
 
         if (*cursor != '{') {
-            free(work);
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
@@ -926,12 +874,11 @@ static int pr_manifest_parse_animation_frames_value(
                 line_number,
                 1,
                 "manifest.frames_inline_table_expected",
-                animation->id
+                animation_id
             );
             return 0;
         }
 
-        object_start = cursor;
         object_end = cursor;
         brace_depth = 0;
         in_string = 0;
@@ -973,7 +920,6 @@ static int pr_manifest_parse_animation_frames_value(
         }
 
         if (brace_depth != 0) {
-            free(work);
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
@@ -982,48 +928,19 @@ static int pr_manifest_parse_animation_frames_value(
                 line_number,
                 1,
                 "manifest.frames_unterminated_table",
-                animation->id
-            );
-            return 0;
-        }
-
-        object_text = (char *)malloc((size_t)(object_end - object_start) + 1u);
-        if (object_text == NULL) {
-            free(work);
-            pr_manifest_emit_diag(
-                diag,
-                PR_DIAG_ERROR,
-                "Allocation failed while parsing frame object.",
-                manifest_path,
-                line_number,
-                1,
-                "manifest.frames_object_alloc_failed",
-                animation->id
+                animation_id
             );
             return 0;
         }
-        memcpy(object_text, object_start, (size_t)(object_end - object_start));
-        object_text[object_end - object_start] = '\0';
 
-        {
-            char *inner;
-            char *inner_end;
-
-            inner = pr_manifest_trim_inplace(object_text);
-            inner_end = inner + strlen(inner);
-            if (inner_end <= inner + 1u || inner[0] != '{' || inner_end[-1] != '}') {
-                free(object_text);
-                free(work);
-                return 0;
-            }
-            inner_end[-1] = '\0';
-            pair_cursor = inner + 1u;
-        }
+        /* The table is the span between its braces; terminating it at the
+         * closing brace leaves the next entry untouched at object_end.
+         */
+        object_end[-1] = '\0';
+        pair_cursor = cursor + 1;
 
         frame = pr_manifest_push_animation_frame(animation);
         if (frame == NULL) {
-            free(object_text);
-            free(work);
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
@@ -1032,7 +949,7 @@ static int pr_manifest_parse_animation_frames_value(
                 line_number,
                 1,
                 "manifest.frames_store_alloc_failed",
-                animation->id
+                animation_id
             );
             return 0;
         }
@@ -1041,13 +958,12 @@ static int pr_manifest_parse_animation_frames_value(
         has_ms = 0;
 
         while (*pair_cursor != '\0') {
-            char *pair_start;
             char *pair_end;
+            char *next_pair;
             int quote_depth;
             int quote_escape;
             char *key;
             char *pair_value;
-            char *pair_text;
 
             while (*pair_cursor != '\0' && (isspace((unsigned char)*pair_cursor) || *pair_cursor == ',')) {
                 pair_cursor += 1;
@@ -1056,7 +972,6 @@ static int pr_manifest_parse_animation_frames_value(
                 break;
             }
 
-            pair_start = pair_cursor;
             pair_end = pair_cursor;
             quote_depth = 0;
             quote_escape = 0;
@@ -1090,20 +1005,11 @@ static int pr_manifest_parse_animation_frames_value(
                 pair_end += 1;
             }
 
-            pair_text = (char *)malloc((size_t)(pair_end - pair_start) + 1u);
-            if (pair_text == NULL) {
-                free(object_text);
-                free(work);
-                return 0;
-            }
-            memcpy(pair_text, pair_start, (size_t)(pair_end - pair_start));
-            pair_text[pair_end - pair_start] = '\0';
-            key = pr_manifest_trim_inplace(pair_text);
+            next_pair = (*pair_end == ',') ? (pair_end + 1) : pair_end;
+            *pair_end = '\0';
+            key = pr_manifest_trim_inplace(pair_cursor);
 
             if (!pr_manifest_split_key_value_inplace(key, &key, &pair_value)) {
-                free(pair_text);
-                free(object_text);
-                free(work);
                 pr_manifest_emit_diag(
                     diag,
                     PR_DIAG_ERROR,
@@ -1112,7 +1018,7 @@ static int pr_manifest_parse_animation_frames_value(
                     line_number,
                     1,
                     "manifest.frames_invalid_pair",
-                    animation->id
+                    animation_id
                 );
                 return 0;
             }
@@ -1121,9 +1027,6 @@ static int pr_manifest_parse_animation_frames_value(
                 int parsed_index;
 
                 if (!pr_manifest_parse_int_value(pair_value, &parsed_index)) {
-                    free(pair_text);
-                    free(object_text);
-                    free(work);
                     pr_manifest_emit_diag(
                         diag,
                         PR_DIAG_ERROR,
@@ -1132,7 +1035,7 @@ static int pr_manifest_parse_animation_frames_value(
                         line_number,
                         1,
                         "manifest.frames_index_invalid",
-                        animation->id
+                        animation_id
                     );
                     return 0;
                 }
@@ -1143,9 +1046,6 @@ static int pr_manifest_parse_animation_frames_value(
                 int parsed_ms;
 
                 if (!pr_manifest_parse_int_value(pair_value, &parsed_ms)) {
-                    free(pair_text);
-                    free(object_text);
-                    free(work);
                     pr_manifest_emit_diag(
                         diag,
                         PR_DIAG_ERROR,
@@ -1154,7 +1054,7 @@ static int pr_manifest_parse_animation_frames_value(
                         line_number,
                         1,
                         "manifest.frames_ms_invalid",
-                        animation->id
+                        animation_id
                     );
                     return 0;
                 }
@@ -1178,17 +1078,14 @@ static int pr_manifest_parse_animation_frames_value(
                     line_number,
                     1,
                     "manifest.frames_unknown_field",
-                    animation->id
+                    animation_id
                 );
             }
 
-            free(pair_text);
-            pair_cursor = (*pair_end == ',') ? (pair_end + 1) : pair_end;
+            pair_cursor = next_pair;
         }
 
         if (has_index == 0 || has_ms == 0) {
-            free(object_text);
-            free(work);
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
@@ -1197,13 +1094,12 @@ static int pr_manifest_parse_animation_frames_value(
                 line_number,
                 1,
                 "manifest.frames_missing_fields",
-                animation->id
+                animation_id
             );
             return 0;
         }
 
         any_frame = 1;
-        free(object_text);
         cursor = object_end;
     }
 
@@ -1216,14 +1112,142 @@ static int pr_manifest_parse_animation_frames_value(
             line_number,
             1,
             "manifest.frames_empty",
-            animation->id
+            animation_id
         );
-        free(work);
         return 0;
     }
 
     animation->has_frames = 1;
-    free(work);
+    return 1;
+}
+
+static int pr_manifest_push_include(pr_manifest_t *manifest, uint32_t pattern)
+{
+    if (!pr_manifest_reserve_array(
+            (void **)&manifest->includes,
+            &manifest->include_capacity,
+            manifest->include_count + 1u,
+            sizeof(manifest->includes[0])
+        )) {
+        return 0;
+    }
+    manifest->includes[manifest->include_count++] = pattern;
+    return 1;
+}
+
+static int pr_manifest_parse_include_value(
+    char *value,
+    pr_manifest_t *manifest,
+    pr_manifest_diag_context_t *diag,
+    const char *manifest_path,
+    int line_number
+)
+{
+    char *cursor;
+    char *end;
+
+    if (value == NULL || manifest == NULL || diag == NULL) {
+        return 0;
+    }
+
+    cursor = pr_manifest_trim_inplace(value);
+    end = cursor + strlen(cursor);
+    if (
+        end == cursor ||
+        cursor[0] != '[' ||
+        end[-1] != ']' ||
+        pr_manifest_bracket_depth_delta(cursor) != 0
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "include must be an array of strings.",
+            manifest_path,
+            line_number,
+            1,
+            "manifest.include.invalid",
+            NULL
+        );
+        return 0;
+    }
+
+    cursor += 1;
+    end -= 1;
+    *end = '\0';
+
+    while (*cursor != '\0') {
+        char *element_end;
+        char *next_element;
+        char *element;
+        const char *pattern;
+        uint32_t handle;
+        int in_string;
+        int escape_next;
+
+        element_end = cursor;
+        in_string = 0;
+        escape_next = 0;
+        while (*element_end != '\0') {
+            if (in_string != 0) {
+                if (escape_next != 0) {
+                    escape_next = 0;
+                } else if (*element_end == '\\') {
+                    escape_next = 1;
+                } else if (*element_end == '"') {
+                    in_string = 0;
+                }
+            } else if (*element_end == '"') {
+                in_string = 1;
+            } else if (*element_end == ',') {
+                break;
+            }
+            element_end += 1;
+        }
+
+        next_element = (*element_end == ',') ? (element_end + 1) : element_end;
+        *element_end = '\0';
+        element = pr_manifest_trim_inplace(cursor);
+        cursor = next_element;
+        if (element[0] == '\0') {
+            continue;
+        }
+
+        if (
+            element[0] != '"' ||
+            !pr_manifest_parse_string_value(element, &pattern) ||
+            pattern[0] == '\0'
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "include entries must be non-empty strings.",
+                manifest_path,
+                line_number,
+                1,
+                "manifest.include.invalid",
+                NULL
+            );
+            return 0;
+        }
+        if (
+            !pr_intern_pool_add(&manifest->strings, pattern, &handle) ||
+            !pr_manifest_push_include(manifest, handle)
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Allocation failed while storing include pattern.",
+                manifest_path,
+                line_number,
+                1,
+                "manifest.include.alloc_failed",
+                NULL
+            );
+            return 0;
+        }
+    }
+
+    manifest->include_line = line_number;
     return 1;
 }
 
@@ -1235,16 +1259,60 @@ static void pr_manifest_mark_parse_error(pr_manifest_parse_state_t *state)
     state->parse_error_count += 1;
 }
 
+static void pr_manifest_emit_include_root_only(
+    pr_manifest_parse_state_t *state,
+    int line_number
+)
+{
+    pr_manifest_emit_diag(
+        state->diag,
+        PR_DIAG_ERROR,
+        "Included manifests may only declare [[images]], [[sprites]], and [[animations]].",
+        state->manifest_path,
+        line_number,
+        1,
+        "manifest.include.root_only",
+        NULL
+    );
+    pr_manifest_mark_parse_error(state);
+}
+
 static void pr_manifest_parse_root_assignment(
     pr_manifest_parse_state_t *state,
+    pr_manifest_reader_t *reader,
     const char *key,
-    const char *value,
+    char *value,
     int line_number
 )
 {
     pr_manifest_t *manifest;
 
     manifest = state->manifest;
+    if (state->is_include != 0) {
+        pr_manifest_emit_include_root_only(state, line_number);
+        return;
+    }
+    if (strcmp(key, "include") == 0) {
+        if (!pr_manifest_collect_array_value(
+                reader,
+                value,
+                state->diag,
+                state->manifest_path
+            )) {
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        if (!pr_manifest_parse_include_value(
+                value,
+                manifest,
+                state->diag,
+                state->manifest_path,
+                line_number
+            )) {
+            pr_manifest_mark_parse_error(state);
+        }
+        return;
+    }
     if (strcmp(key, "schema_version") == 0) {
         int parsed;
 
@@ -1267,9 +1335,9 @@ static void pr_manifest_parse_root_assignment(
         return;
     }
     if (strcmp(key, "package_name") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1283,18 +1351,14 @@ static void pr_manifest_parse_root_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(
-            manifest->package_name,
-            sizeof(manifest->package_name),
-            parsed
-        );
+        manifest->package_name = parsed;
         manifest->has_package_name = 1;
         return;
     }
     if (strcmp(key, "output") == 0) {
-        char parsed[PR_MANIFEST_PATH_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1308,18 +1372,14 @@ static void pr_manifest_parse_root_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(
-            manifest->output,
-            sizeof(manifest->output),
-            parsed
-        );
+        manifest->output = parsed;
         manifest->has_output = 1;
         return;
     }
     if (strcmp(key, "debug_output") == 0) {
-        char parsed[PR_MANIFEST_PATH_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1333,11 +1393,7 @@ static void pr_manifest_parse_root_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(
-            manifest->debug_output,
-            sizeof(manifest->debug_output),
-            parsed
-        );
+        manifest->debug_output = parsed;
         manifest->has_debug_output = 1;
         return;
     }
@@ -1384,7 +1440,7 @@ static void pr_manifest_parse_root_assignment(
 static void pr_manifest_parse_atlas_assignment(
     pr_manifest_parse_state_t *state,
     const char *key,
-    const char *value,
+    char *value,
     int line_number
 )
 {
@@ -1476,9 +1532,9 @@ static void pr_manifest_parse_atlas_assignment(
         return;
     }
     if (strcmp(key, "sampling") == 0) {
-        char parsed[PR_MANIFEST_SMALL_TEXT_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1492,22 +1548,253 @@ static void pr_manifest_parse_atlas_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(atlas->sampling, sizeof(atlas->sampling), parsed);
+        atlas->sampling = parsed;
         atlas->has_sampling = 1;
         return;
     }
+    if (strcmp(key, "format") == 0) {
+        uint32_t parsed;
 
-    {
-        char message[128];
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.format must be a string.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.format_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->format = parsed;
+        atlas->has_format = 1;
+        return;
+    }
+    if (strcmp(key, "encode_quality") == 0) {
+        uint32_t parsed;
 
-        (void)snprintf(message, sizeof(message), "Unknown atlas key: %s", key);
-        pr_manifest_emit_diag(
-            state->diag,
-            PR_DIAG_ERROR,
-            message,
-            state->manifest_path,
-            line_number,
-            1,
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.encode_quality must be a string.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.encode_quality_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->encode_quality = parsed;
+        atlas->has_encode_quality = 1;
+        return;
+    }
+    if (strcmp(key, "compression") == 0) {
+        uint32_t parsed;
+
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.compression must be a string.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.compression_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->compression = parsed;
+        atlas->has_compression = 1;
+        return;
+    }
+    if (strcmp(key, "tile_size") == 0) {
+        int parsed;
+
+        if (!pr_manifest_parse_int_value(value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.tile_size must be an integer.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.tile_size_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->tile_size = parsed;
+        atlas->has_tile_size = 1;
+        return;
+    }
+    if (strcmp(key, "mipmaps") == 0) {
+        int parsed_bool;
+
+        if (!pr_manifest_parse_bool_value(value, &parsed_bool)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.mipmaps must be true or false.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.mipmaps_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->mipmaps = parsed_bool;
+        atlas->has_mipmaps = 1;
+        return;
+    }
+    if (strcmp(key, "extrude") == 0) {
+        int parsed;
+
+        if (!pr_manifest_parse_int_value(value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.extrude must be an integer.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.extrude_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->extrude = parsed;
+        atlas->has_extrude = 1;
+        return;
+    }
+    if (strcmp(key, "bleed_alpha") == 0) {
+        int parsed_bool;
+
+        if (!pr_manifest_parse_bool_value(value, &parsed_bool)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.bleed_alpha must be true or false.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.bleed_alpha_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->bleed_alpha = parsed_bool;
+        atlas->has_bleed_alpha = 1;
+        return;
+    }
+    if (strcmp(key, "dither") == 0) {
+        int parsed_bool;
+
+        if (!pr_manifest_parse_bool_value(value, &parsed_bool)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.dither must be true or false.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.dither_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->dither = parsed_bool;
+        atlas->has_dither = 1;
+        return;
+    }
+    if (strcmp(key, "layout") == 0) {
+        uint32_t parsed;
+
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.layout must be a string.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.layout_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->layout = parsed;
+        atlas->has_layout = 1;
+        return;
+    }
+    if (strcmp(key, "incremental") == 0) {
+        int parsed_bool;
+
+        if (!pr_manifest_parse_bool_value(value, &parsed_bool)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.incremental must be true or false.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.incremental_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->incremental = parsed_bool;
+        atlas->has_incremental = 1;
+        return;
+    }
+    if (strcmp(key, "repack_threshold") == 0) {
+        int parsed;
+
+        if (!pr_manifest_parse_int_value(value, &parsed)) {
+            pr_manifest_emit_diag(
+                state->diag,
+                PR_DIAG_ERROR,
+                "atlas.repack_threshold must be an integer.",
+                state->manifest_path,
+                line_number,
+                1,
+                "manifest.atlas.repack_threshold_invalid",
+                NULL
+            );
+            pr_manifest_mark_parse_error(state);
+            return;
+        }
+        atlas->repack_threshold = parsed;
+        atlas->has_repack_threshold = 1;
+        return;
+    }
+
+    {
+        char message[128];
+
+        (void)snprintf(message, sizeof(message), "Unknown atlas key: %s", key);
+        pr_manifest_emit_diag(
+            state->diag,
+            PR_DIAG_ERROR,
+            message,
+            state->manifest_path,
+            line_number,
+            1,
             "manifest.atlas.unknown_key",
             NULL
         );
@@ -1518,7 +1805,7 @@ static void pr_manifest_parse_atlas_assignment(
 static void pr_manifest_parse_image_assignment(
     pr_manifest_parse_state_t *state,
     const char *key,
-    const char *value,
+    char *value,
     int line_number
 )
 {
@@ -1541,9 +1828,9 @@ static void pr_manifest_parse_image_assignment(
 
     image = &state->manifest->images[state->current_image];
     if (strcmp(key, "id") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1557,14 +1844,14 @@ static void pr_manifest_parse_image_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(image->id, sizeof(image->id), parsed);
+        image->id = parsed;
         image->has_id = 1;
         return;
     }
     if (strcmp(key, "path") == 0) {
-        char parsed[PR_MANIFEST_PATH_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1578,7 +1865,7 @@ static void pr_manifest_parse_image_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(image->path, sizeof(image->path), parsed);
+        image->path = parsed;
         image->has_path = 1;
         return;
     }
@@ -1604,9 +1891,9 @@ static void pr_manifest_parse_image_assignment(
         return;
     }
     if (strcmp(key, "color_space") == 0) {
-        char parsed[PR_MANIFEST_SMALL_TEXT_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1620,7 +1907,7 @@ static void pr_manifest_parse_image_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(image->color_space, sizeof(image->color_space), parsed);
+        image->color_space = parsed;
         image->has_color_space = 1;
         return;
     }
@@ -1646,7 +1933,7 @@ static void pr_manifest_parse_image_assignment(
 static void pr_manifest_parse_sprite_assignment(
     pr_manifest_parse_state_t *state,
     const char *key,
-    const char *value,
+    char *value,
     int line_number
 )
 {
@@ -1669,9 +1956,9 @@ static void pr_manifest_parse_sprite_assignment(
 
     sprite = &state->manifest->sprites[state->current_sprite];
     if (strcmp(key, "id") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1685,14 +1972,14 @@ static void pr_manifest_parse_sprite_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(sprite->id, sizeof(sprite->id), parsed);
+        sprite->id = parsed;
         sprite->has_id = 1;
         return;
     }
     if (strcmp(key, "source") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1706,14 +1993,14 @@ static void pr_manifest_parse_sprite_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(sprite->source, sizeof(sprite->source), parsed);
+        sprite->source = parsed;
         sprite->has_source = 1;
         return;
     }
     if (strcmp(key, "mode") == 0) {
-        char parsed[PR_MANIFEST_SMALL_TEXT_MAX];
+        const char *parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_value(value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1742,7 +2029,7 @@ static void pr_manifest_parse_sprite_assignment(
                 line_number,
                 1,
                 "manifest.sprites.mode_unknown",
-                sprite->id
+                pr_manifest_string(state->manifest, sprite->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
@@ -1762,7 +2049,7 @@ static void pr_manifest_parse_sprite_assignment(
                 line_number,
                 1,
                 "manifest.sprites.pivot_x_invalid",
-                sprite->id
+                pr_manifest_string(state->manifest, sprite->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
@@ -1783,7 +2070,7 @@ static void pr_manifest_parse_sprite_assignment(
                 line_number,
                 1,
                 "manifest.sprites.pivot_y_invalid",
-                sprite->id
+                pr_manifest_string(state->manifest, sprite->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
@@ -1805,7 +2092,7 @@ static void pr_manifest_parse_sprite_assignment(
                 line_number, \
                 1, \
                 field_code, \
-                sprite->id \
+                pr_manifest_string(state->manifest, sprite->id) \
             ); \
             pr_manifest_mark_parse_error(state); \
             return; \
@@ -1842,7 +2129,7 @@ static void pr_manifest_parse_sprite_assignment(
             line_number,
             1,
             "manifest.sprites.unknown_key",
-            sprite->id
+            pr_manifest_string(state->manifest, sprite->id)
         );
         pr_manifest_mark_parse_error(state);
     }
@@ -1851,7 +2138,7 @@ static void pr_manifest_parse_sprite_assignment(
 static void pr_manifest_parse_sprite_rect_assignment(
     pr_manifest_parse_state_t *state,
     const char *key,
-    const char *value,
+    char *value,
     int line_number
 )
 {
@@ -1895,7 +2182,7 @@ static void pr_manifest_parse_sprite_rect_assignment(
                 line_number, \
                 1, \
                 field_code, \
-                sprite->id \
+                pr_manifest_string(state->manifest, sprite->id) \
             ); \
             pr_manifest_mark_parse_error(state); \
             return; \
@@ -1913,9 +2200,9 @@ static void pr_manifest_parse_sprite_rect_assignment(
 #undef PR_PARSE_RECT_INT_FIELD
 
     if (strcmp(key, "label") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1924,12 +2211,12 @@ static void pr_manifest_parse_sprite_rect_assignment(
                 line_number,
                 1,
                 "manifest.sprites.rects.label_invalid",
-                sprite->id
+                pr_manifest_string(state->manifest, sprite->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(rect->label, sizeof(rect->label), parsed);
+        rect->label = parsed;
         rect->has_label = 1;
         return;
     }
@@ -1946,7 +2233,7 @@ static void pr_manifest_parse_sprite_rect_assignment(
             line_number,
             1,
             "manifest.sprites.rects.unknown_key",
-            sprite->id
+            pr_manifest_string(state->manifest, sprite->id)
         );
         pr_manifest_mark_parse_error(state);
     }
@@ -1954,9 +2241,7 @@ static void pr_manifest_parse_sprite_rect_assignment(
 
 static void pr_manifest_parse_animation_assignment(
     pr_manifest_parse_state_t *state,
-    char **lines,
-    size_t line_count,
-    size_t *line_index,
+    pr_manifest_reader_t *reader,
     const char *key,
     char *value,
     int line_number
@@ -1981,9 +2266,9 @@ static void pr_manifest_parse_animation_assignment(
 
     animation = &state->manifest->animations[state->current_animation];
     if (strcmp(key, "id") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -1997,14 +2282,14 @@ static void pr_manifest_parse_animation_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(animation->id, sizeof(animation->id), parsed);
+        animation->id = parsed;
         animation->has_id = 1;
         return;
     }
     if (strcmp(key, "sprite") == 0) {
-        char parsed[PR_MANIFEST_ID_MAX];
+        uint32_t parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_handle(state->manifest, value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -2018,14 +2303,14 @@ static void pr_manifest_parse_animation_assignment(
             pr_manifest_mark_parse_error(state);
             return;
         }
-        (void)pr_manifest_copy_string(animation->sprite, sizeof(animation->sprite), parsed);
+        animation->sprite = parsed;
         animation->has_sprite = 1;
         return;
     }
     if (strcmp(key, "loop") == 0) {
-        char parsed[PR_MANIFEST_SMALL_TEXT_MAX];
+        const char *parsed;
 
-        if (!pr_manifest_parse_string_value(value, parsed, sizeof(parsed))) {
+        if (!pr_manifest_parse_string_value(value, &parsed)) {
             pr_manifest_emit_diag(
                 state->diag,
                 PR_DIAG_ERROR,
@@ -2034,7 +2319,7 @@ static void pr_manifest_parse_animation_assignment(
                 line_number,
                 1,
                 "manifest.animations.loop_invalid",
-                animation->id
+                pr_manifest_string(state->manifest, animation->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
@@ -2055,7 +2340,7 @@ static void pr_manifest_parse_animation_assignment(
                 line_number,
                 1,
                 "manifest.animations.loop_unknown",
-                animation->id
+                pr_manifest_string(state->manifest, animation->id)
             );
             pr_manifest_mark_parse_error(state);
             return;
@@ -2064,37 +2349,27 @@ static void pr_manifest_parse_animation_assignment(
         return;
     }
     if (strcmp(key, "frames") == 0) {
-        char *array_text;
-
-        array_text = NULL;
         if (!pr_manifest_collect_array_value(
-                lines,
-                line_count,
-                line_index,
+                reader,
                 value,
-                &array_text,
                 state->diag,
                 state->manifest_path
             )) {
             pr_manifest_mark_parse_error(state);
-            free(array_text);
             return;
         }
 
         animation->frame_count = 0u;
         if (!pr_manifest_parse_animation_frames_value(
-                array_text,
+                value,
                 animation,
+                pr_manifest_string(state->manifest, animation->id),
                 state->diag,
                 state->manifest_path,
                 line_number
             )) {
             pr_manifest_mark_parse_error(state);
-            free(array_text);
-            return;
         }
-
-        free(array_text);
         return;
     }
 
@@ -2110,7 +2385,7 @@ static void pr_manifest_parse_animation_assignment(
             line_number,
             1,
             "manifest.animations.unknown_key",
-            animation->id
+            pr_manifest_string(state->manifest, animation->id)
         );
         pr_manifest_mark_parse_error(state);
     }
@@ -2120,32 +2395,45 @@ static int pr_manifest_parse_text(
     const char *manifest_path,
     char *text,
     pr_manifest_diag_context_t *diag,
-    pr_manifest_t *manifest
+    pr_manifest_t *manifest,
+    int is_include
 )
 {
     pr_manifest_parse_state_t state;
-    char **lines;
-    size_t line_count;
-    size_t i;
+    pr_manifest_reader_t reader;
+    char *line;
 
     if (manifest_path == NULL || text == NULL || diag == NULL || manifest == NULL) {
         return 0;
     }
 
-    if (!pr_manifest_split_lines(text, &lines, &line_count)) {
+    if (
+        is_include == 0 &&
+        (
+            !pr_intern_pool_add(&manifest->strings, "pixel", &manifest->atlas.sampling) ||
+            !pr_intern_pool_add(&manifest->strings, "rgba8", &manifest->atlas.format) ||
+            !pr_intern_pool_add(&manifest->strings, "balanced", &manifest->atlas.encode_quality) ||
+            !pr_intern_pool_add(&manifest->strings, "none", &manifest->atlas.compression) ||
+            !pr_intern_pool_add(&manifest->strings, "pages", &manifest->atlas.layout)
+        )
+    ) {
         pr_manifest_emit_diag(
             diag,
             PR_DIAG_ERROR,
-            "Failed to split manifest into lines.",
+            "Failed to allocate manifest string pool.",
             manifest_path,
             1,
             1,
-            "manifest.split_lines_failed",
+            "manifest.strings_alloc_failed",
             NULL
         );
         return 0;
     }
 
+    memset(&reader, 0, sizeof(reader));
+    reader.cursor = text;
+    reader.end = text + strlen(text);
+
     memset(&state, 0, sizeof(state));
     state.manifest = manifest;
     state.diag = diag;
@@ -2155,14 +2443,13 @@ static int pr_manifest_parse_text(
     state.current_sprite = (size_t)-1;
     state.current_rect = (size_t)-1;
     state.current_animation = (size_t)-1;
+    state.is_include = is_include;
 
-    for (i = 0u; i < line_count; ++i) {
-        char *line;
+    while ((line = pr_manifest_reader_next_line(&reader)) != NULL) {
         int line_number;
         pr_manifest_section_t parsed_section;
 
-        line = lines[i];
-        line_number = (int)(i + 1u);
+        line_number = reader.line_number;
         pr_manifest_strip_comment_inplace(line);
         line = pr_manifest_trim_inplace(line);
         if (line[0] == '\0') {
@@ -2187,7 +2474,9 @@ static int pr_manifest_parse_text(
 
             state.section = parsed_section;
             state.current_rect = (size_t)-1;
-            if (parsed_section == PR_MANIFEST_SECTION_IMAGE) {
+            if (parsed_section == PR_MANIFEST_SECTION_ATLAS && is_include != 0) {
+                pr_manifest_emit_include_root_only(&state, line_number);
+            } else if (parsed_section == PR_MANIFEST_SECTION_IMAGE) {
                 pr_manifest_image_t *image;
 
                 image = pr_manifest_push_image(state.manifest);
@@ -2256,7 +2545,7 @@ static int pr_manifest_parse_text(
                         line_number,
                         1,
                         "manifest.sprites.rects.alloc_failed",
-                        sprite->id
+                        pr_manifest_string(state.manifest, sprite->id)
                     );
                     pr_manifest_mark_parse_error(&state);
                     continue;
@@ -2311,7 +2600,7 @@ static int pr_manifest_parse_text(
 
             switch (state.section) {
             case PR_MANIFEST_SECTION_ROOT:
-                pr_manifest_parse_root_assignment(&state, key, value, line_number);
+                pr_manifest_parse_root_assignment(&state, &reader, key, value, line_number);
                 break;
             case PR_MANIFEST_SECTION_ATLAS:
                 pr_manifest_parse_atlas_assignment(&state, key, value, line_number);
@@ -2328,9 +2617,7 @@ static int pr_manifest_parse_text(
             case PR_MANIFEST_SECTION_ANIMATION:
                 pr_manifest_parse_animation_assignment(
                     &state,
-                    lines,
-                    line_count,
-                    &i,
+                    &reader,
                     key,
                     value,
                     line_number
@@ -2343,129 +2630,230 @@ static int pr_manifest_parse_text(
         }
     }
 
-    free(lines);
     return (state.parse_error_count == 0) ? 1 : 0;
 }
 
-static long pr_manifest_find_image_index(const pr_manifest_t *manifest, const char *id)
+/* Id lookup for one manifest section, keyed by manifest string handle.
+ * Entries sharing an id are chained in manifest order so duplicates can be
+ * reported without pairwise compares.
+ */
+typedef struct pr_manifest_id_index {
+    uint32_t *first_entry;
+    uint32_t *next_entry;
+    size_t handle_count;
+} pr_manifest_id_index_t;
+
+typedef struct pr_manifest_indexes {
+    pr_manifest_id_index_t images;
+    pr_manifest_id_index_t sprites;
+    pr_manifest_id_index_t animations;
+} pr_manifest_indexes_t;
+
+static void pr_manifest_id_index_free(pr_manifest_id_index_t *index)
 {
-    size_t i;
+    if (index == NULL) {
+        return;
+    }
 
-    if (manifest == NULL || id == NULL || id[0] == '\0') {
-        return -1;
+    free(index->first_entry);
+    free(index->next_entry);
+    memset(index, 0, sizeof(*index));
+}
+
+static int pr_manifest_id_index_begin(
+    pr_manifest_id_index_t *index,
+    size_t handle_count,
+    size_t entry_count
+)
+{
+    size_t first_count;
+    size_t next_count;
+
+    memset(index, 0, sizeof(*index));
+    if (entry_count >= (size_t)PR_MANIFEST_NO_STRING) {
+        return 0;
     }
 
-    for (i = 0u; i < manifest->image_count; ++i) {
-        if (manifest->images[i].has_id == 0) {
-            continue;
-        }
-        if (strcmp(manifest->images[i].id, id) == 0) {
-            return (long)i;
-        }
+    first_count = (handle_count == 0u) ? 1u : handle_count;
+    next_count = (entry_count == 0u) ? 1u : entry_count;
+    index->first_entry = (uint32_t *)malloc(first_count * sizeof(index->first_entry[0]));
+    index->next_entry = (uint32_t *)malloc(next_count * sizeof(index->next_entry[0]));
+    if (index->first_entry == NULL || index->next_entry == NULL) {
+        return 0;
+    }
+    memset(index->first_entry, 0xFF, first_count * sizeof(index->first_entry[0]));
+    memset(index->next_entry, 0xFF, next_count * sizeof(index->next_entry[0]));
+    index->handle_count = handle_count;
+    return 1;
+}
+
+static void pr_manifest_id_index_link(
+    pr_manifest_id_index_t *index,
+    uint32_t *last_entry,
+    size_t entry,
+    uint32_t handle
+)
+{
+    if ((size_t)handle >= index->handle_count) {
+        return;
+    }
+    if (index->first_entry[handle] == PR_MANIFEST_NO_STRING) {
+        index->first_entry[handle] = (uint32_t)entry;
+    } else {
+        index->next_entry[last_entry[handle]] = (uint32_t)entry;
+    }
+    last_entry[handle] = (uint32_t)entry;
+}
+
+static long pr_manifest_id_index_find(
+    const pr_manifest_id_index_t *index,
+    const pr_manifest_t *manifest,
+    uint32_t handle
+)
+{
+    if (
+        index == NULL ||
+        (size_t)handle >= index->handle_count ||
+        pr_manifest_string(manifest, handle)[0] == '\0' ||
+        index->first_entry[handle] == PR_MANIFEST_NO_STRING
+    ) {
+        return -1;
     }
+    return (long)index->first_entry[handle];
+}
 
-    return -1;
+static void pr_manifest_indexes_free(pr_manifest_indexes_t *indexes)
+{
+    pr_manifest_id_index_free(&indexes->images);
+    pr_manifest_id_index_free(&indexes->sprites);
+    pr_manifest_id_index_free(&indexes->animations);
 }
 
-static long pr_manifest_find_sprite_index(const pr_manifest_t *manifest, const char *id)
+static int pr_manifest_indexes_build(
+    const pr_manifest_t *manifest,
+    pr_manifest_indexes_t *indexes
+)
 {
+    uint32_t *last_entry;
+    size_t handle_count;
     size_t i;
 
-    if (manifest == NULL || id == NULL || id[0] == '\0') {
-        return -1;
+    handle_count = manifest->strings.count;
+    if (
+        !pr_manifest_id_index_begin(&indexes->images, handle_count, manifest->image_count) ||
+        !pr_manifest_id_index_begin(&indexes->sprites, handle_count, manifest->sprite_count) ||
+        !pr_manifest_id_index_begin(
+            &indexes->animations,
+            handle_count,
+            manifest->animation_count
+        )
+    ) {
+        return 0;
+    }
+
+    last_entry = (uint32_t *)malloc(
+        ((handle_count == 0u) ? 1u : handle_count) * sizeof(last_entry[0])
+    );
+    if (last_entry == NULL) {
+        return 0;
     }
 
+    for (i = 0u; i < manifest->image_count; ++i) {
+        if (manifest->images[i].has_id != 0) {
+            pr_manifest_id_index_link(&indexes->images, last_entry, i, manifest->images[i].id);
+        }
+    }
     for (i = 0u; i < manifest->sprite_count; ++i) {
-        if (manifest->sprites[i].has_id == 0) {
-            continue;
+        if (manifest->sprites[i].has_id != 0) {
+            pr_manifest_id_index_link(&indexes->sprites, last_entry, i, manifest->sprites[i].id);
         }
-        if (strcmp(manifest->sprites[i].id, id) == 0) {
-            return (long)i;
+    }
+    for (i = 0u; i < manifest->animation_count; ++i) {
+        if (manifest->animations[i].has_id != 0) {
+            pr_manifest_id_index_link(
+                &indexes->animations,
+                last_entry,
+                i,
+                manifest->animations[i].id
+            );
         }
     }
 
-    return -1;
+    free(last_entry);
+    return 1;
 }
 
 static void pr_manifest_validate_duplicates(
     const pr_manifest_t *manifest,
+    const pr_manifest_indexes_t *indexes,
     pr_manifest_diag_context_t *diag,
     const char *manifest_path
 )
 {
     size_t i;
-    size_t j;
+    uint32_t j;
 
-    if (manifest == NULL || diag == NULL) {
+    if (manifest == NULL || indexes == NULL || diag == NULL) {
         return;
     }
 
+    /* Every earlier entry reports each later entry sharing its id, matching
+     * the order of a pairwise i < j scan.
+     */
     for (i = 0u; i < manifest->image_count; ++i) {
-        if (manifest->images[i].has_id == 0) {
-            continue;
-        }
-        for (j = i + 1u; j < manifest->image_count; ++j) {
-            if (manifest->images[j].has_id == 0) {
-                continue;
-            }
-            if (strcmp(manifest->images[i].id, manifest->images[j].id) == 0) {
-                pr_manifest_emit_diag(
-                    diag,
-                    PR_DIAG_ERROR,
-                    "Duplicate image id.",
-                    manifest_path,
-                    manifest->images[j].line,
-                    1,
-                    "manifest.images.duplicate_id",
-                    manifest->images[j].id
-                );
-            }
+        for (
+            j = indexes->images.next_entry[i];
+            j != PR_INTERN_INVALID_HANDLE;
+            j = indexes->images.next_entry[j]
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Duplicate image id.",
+                pr_manifest_entry_path(manifest, manifest->images[j].file, manifest_path),
+                manifest->images[j].line,
+                1,
+                "manifest.images.duplicate_id",
+                pr_manifest_string(manifest, manifest->images[j].id)
+            );
         }
     }
 
     for (i = 0u; i < manifest->sprite_count; ++i) {
-        if (manifest->sprites[i].has_id == 0) {
-            continue;
-        }
-        for (j = i + 1u; j < manifest->sprite_count; ++j) {
-            if (manifest->sprites[j].has_id == 0) {
-                continue;
-            }
-            if (strcmp(manifest->sprites[i].id, manifest->sprites[j].id) == 0) {
-                pr_manifest_emit_diag(
-                    diag,
-                    PR_DIAG_ERROR,
-                    "Duplicate sprite id.",
-                    manifest_path,
-                    manifest->sprites[j].line,
-                    1,
-                    "manifest.sprites.duplicate_id",
-                    manifest->sprites[j].id
-                );
-            }
+        for (
+            j = indexes->sprites.next_entry[i];
+            j != PR_INTERN_INVALID_HANDLE;
+            j = indexes->sprites.next_entry[j]
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Duplicate sprite id.",
+                pr_manifest_entry_path(manifest, manifest->sprites[j].file, manifest_path),
+                manifest->sprites[j].line,
+                1,
+                "manifest.sprites.duplicate_id",
+                pr_manifest_string(manifest, manifest->sprites[j].id)
+            );
         }
     }
 
     for (i = 0u; i < manifest->animation_count; ++i) {
-        if (manifest->animations[i].has_id == 0) {
-            continue;
-        }
-        for (j = i + 1u; j < manifest->animation_count; ++j) {
-            if (manifest->animations[j].has_id == 0) {
-                continue;
-            }
-            if (strcmp(manifest->animations[i].id, manifest->animations[j].id) == 0) {
-                pr_manifest_emit_diag(
-                    diag,
-                    PR_DIAG_ERROR,
-                    "Duplicate animation id.",
-                    manifest_path,
-                    manifest->animations[j].line,
-                    1,
-                    "manifest.animations.duplicate_id",
-                    manifest->animations[j].id
-                );
-            }
+        for (
+            j = indexes->animations.next_entry[i];
+            j != PR_INTERN_INVALID_HANDLE;
+            j = indexes->animations.next_entry[j]
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Duplicate animation id.",
+                pr_manifest_entry_path(manifest, manifest->animations[j].file, manifest_path),
+                manifest->animations[j].line,
+                1,
+                "manifest.animations.duplicate_id",
+                pr_manifest_string(manifest, manifest->animations[j].id)
+            );
         }
     }
 }
@@ -2512,11 +2900,33 @@ static void pr_manifest_validate_semantics(
 )
 {
     size_t i;
+    pr_manifest_indexes_t indexes;
+    const char *entry_path;
+    pr_page_format_t page_format;
+    pr_encode_quality_t encode_quality;
+    pr_page_compression_t compression;
+    pr_atlas_layout_t layout;
 
     if (manifest == NULL || diag == NULL || manifest_path == NULL) {
         return;
     }
 
+    memset(&indexes, 0, sizeof(indexes));
+    if (!pr_manifest_indexes_build(manifest, &indexes)) {
+        pr_manifest_indexes_free(&indexes);
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "Failed to allocate manifest id indexes.",
+            manifest_path,
+            1,
+            1,
+            "manifest.index_alloc_failed",
+            NULL
+        );
+        return;
+    }
+
     if (manifest->has_schema_version == 0) {
         pr_manifest_emit_diag(
             diag,
@@ -2541,7 +2951,7 @@ static void pr_manifest_validate_semantics(
         );
     }
 
-    if (manifest->has_package_name == 0 || manifest->package_name[0] == '\0') {
+    if (manifest->has_package_name == 0 || pr_manifest_string(manifest, manifest->package_name)[0] == '\0') {
         pr_manifest_emit_diag(
             diag,
             PR_DIAG_ERROR,
@@ -2553,7 +2963,7 @@ static void pr_manifest_validate_semantics(
             NULL
         );
     }
-    if (manifest->has_output == 0 || manifest->output[0] == '\0') {
+    if (manifest->has_output == 0 || pr_manifest_string(manifest, manifest->output)[0] == '\0') {
         pr_manifest_emit_diag(
             diag,
             PR_DIAG_ERROR,
@@ -2603,8 +3013,54 @@ static void pr_manifest_validate_semantics(
         );
     }
     if (
-        strcmp(manifest->atlas.sampling, "pixel") != 0 &&
-        strcmp(manifest->atlas.sampling, "linear") != 0
+        manifest->atlas.extrude < 0 ||
+        (manifest->atlas.padding >= 0 && manifest->atlas.extrude > manifest->atlas.padding)
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.extrude must be between 0 and atlas.padding.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.extrude_range",
+            NULL
+        );
+    }
+    if (manifest->atlas.repack_threshold < 0 || manifest->atlas.repack_threshold > 1000) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.repack_threshold must be between 0 and 1000.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.repack_threshold_range",
+            NULL
+        );
+    }
+    if (
+        manifest->atlas.tile_size != 0 &&
+        (
+            manifest->atlas.tile_size < PR_PAGE_TILE_SIZE_MIN ||
+            manifest->atlas.tile_size > PR_PAGE_TILE_SIZE_MAX ||
+            manifest->atlas.tile_size % 4 != 0
+        )
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.tile_size must be 0 or a multiple of 4 from 16 to 4096.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.tile_size_range",
+            NULL
+        );
+    }
+    if (
+        strcmp(pr_manifest_string(manifest, manifest->atlas.sampling), "pixel") != 0 &&
+        strcmp(pr_manifest_string(manifest, manifest->atlas.sampling), "linear") != 0
     ) {
         pr_manifest_emit_diag(
             diag,
@@ -2616,49 +3072,151 @@ static void pr_manifest_validate_semantics(
             "manifest.atlas.sampling_unknown",
             NULL
         );
+    } else if (
+        manifest->atlas.mipmaps != 0 &&
+        strcmp(pr_manifest_string(manifest, manifest->atlas.sampling), "linear") != 0
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.mipmaps requires atlas.sampling = \"linear\".",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.mipmaps_sampling",
+            NULL
+        );
+    }
+    if (
+        !pr_page_format_is_auto(pr_manifest_string(manifest, manifest->atlas.format)) &&
+        !pr_page_format_from_name(pr_manifest_string(manifest, manifest->atlas.format), &page_format)
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.format must be auto, rgba8, rgb565, rgba4444, r8, ra8, indexed8, bc1, bc3, bc7, etc2_rgb or etc2_rgba.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.format_unknown",
+            NULL
+        );
+    }
+    if (
+        !pr_encode_quality_from_name(
+            pr_manifest_string(manifest, manifest->atlas.encode_quality),
+            &encode_quality
+        )
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.encode_quality must be fast, balanced or best.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.encode_quality_unknown",
+            NULL
+        );
+    }
+    if (
+        !pr_page_compression_from_name(
+            pr_manifest_string(manifest, manifest->atlas.compression),
+            &compression
+        )
+    ) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.compression must be none or lz.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.compression_unknown",
+            NULL
+        );
+    }
+    layout = PR_ATLAS_LAYOUT_PAGES;
+    if (!pr_atlas_layout_from_name(pr_manifest_string(manifest, manifest->atlas.layout), &layout)) {
+        pr_manifest_emit_diag(
+            diag,
+            PR_DIAG_ERROR,
+            "atlas.layout must be pages or array.",
+            manifest_path,
+            1,
+            1,
+            "manifest.atlas.layout_unknown",
+            NULL
+        );
     }
 
     for (i = 0u; i < manifest->image_count; ++i) {
         const pr_manifest_image_t *image;
 
         image = &manifest->images[i];
-        if (image->has_id == 0 || image->id[0] == '\0') {
+        entry_path = pr_manifest_entry_path(manifest, image->file, manifest_path);
+        if (image->has_id == 0 || pr_manifest_string(manifest, image->id)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "images entry is missing id.",
-                manifest_path,
+                entry_path,
                 image->line,
                 1,
                 "manifest.images.missing_id",
                 NULL
             );
         }
-        if (image->has_path == 0 || image->path[0] == '\0') {
+        if (image->has_path == 0 || pr_manifest_string(manifest, image->path)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "images entry is missing path.",
-                manifest_path,
+                entry_path,
                 image->line,
                 1,
                 "manifest.images.missing_path",
-                image->id
+                pr_manifest_string(manifest, image->id)
             );
         }
         if (
-            strcmp(image->color_space, "srgb") != 0 &&
-            strcmp(image->color_space, "linear") != 0
+            strcmp(pr_manifest_string(manifest, image->color_space), "srgb") != 0 &&
+            strcmp(pr_manifest_string(manifest, image->color_space), "linear") != 0
         ) {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "images.color_space must be srgb or linear.",
-                manifest_path,
+                entry_path,
                 image->line,
                 1,
                 "manifest.images.color_space_unknown",
-                image->id
+                pr_manifest_string(manifest, image->id)
+            );
+        }
+        /* Array layers share one texture format, so they cannot mix color
+         * spaces or alpha modes.
+         */
+        if (
+            layout == PR_ATLAS_LAYOUT_ARRAY &&
+            i > 0u &&
+            (
+                strcmp(
+                    pr_manifest_string(manifest, image->color_space),
+                    pr_manifest_string(manifest, manifest->images[0].color_space)
+                ) != 0 ||
+                image->premultiply_alpha != manifest->images[0].premultiply_alpha
+            )
+        ) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "atlas.layout = \"array\" requires every image to share color_space and premultiply_alpha.",
+                entry_path,
+                image->line,
+                1,
+                "manifest.images.array_mixed",
+                pr_manifest_string(manifest, image->id)
             );
         }
     }
@@ -2667,39 +3225,40 @@ static void pr_manifest_validate_semantics(
         const pr_manifest_sprite_t *sprite;
 
         sprite = &manifest->sprites[i];
-        if (sprite->has_id == 0 || sprite->id[0] == '\0') {
+        entry_path = pr_manifest_entry_path(manifest, sprite->file, manifest_path);
+        if (sprite->has_id == 0 || pr_manifest_string(manifest, sprite->id)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "sprites entry is missing id.",
-                manifest_path,
+                entry_path,
                 sprite->line,
                 1,
                 "manifest.sprites.missing_id",
                 NULL
             );
         }
-        if (sprite->has_source == 0 || sprite->source[0] == '\0') {
+        if (sprite->has_source == 0 || pr_manifest_string(manifest, sprite->source)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "sprites entry is missing source.",
-                manifest_path,
+                entry_path,
                 sprite->line,
                 1,
                 "manifest.sprites.missing_source",
-                sprite->id
+                pr_manifest_string(manifest, sprite->id)
             );
-        } else if (pr_manifest_find_image_index(manifest, sprite->source) < 0) {
+        } else if (pr_manifest_id_index_find(&indexes.images, manifest, sprite->source) < 0) {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "sprites.source references unknown image id.",
-                manifest_path,
+                entry_path,
                 sprite->line,
                 1,
                 "manifest.sprites.source_unknown",
-                sprite->id
+                pr_manifest_string(manifest, sprite->id)
             );
         }
 
@@ -2708,11 +3267,11 @@ static void pr_manifest_validate_semantics(
                 diag,
                 PR_DIAG_ERROR,
                 "sprites.pivot_x must be between 0 and 1.",
-                manifest_path,
+                entry_path,
                 sprite->line,
                 1,
                 "manifest.sprites.pivot_x_range",
-                sprite->id
+                pr_manifest_string(manifest, sprite->id)
             );
         }
         if (sprite->pivot_y < 0.0 || sprite->pivot_y > 1.0) {
@@ -2720,11 +3279,11 @@ static void pr_manifest_validate_semantics(
                 diag,
                 PR_DIAG_ERROR,
                 "sprites.pivot_y must be between 0 and 1.",
-                manifest_path,
+                entry_path,
                 sprite->line,
                 1,
                 "manifest.sprites.pivot_y_range",
-                sprite->id
+                pr_manifest_string(manifest, sprite->id)
             );
         }
 
@@ -2734,11 +3293,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "grid sprites require cell_w > 0.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.grid.cell_w",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
             if (sprite->has_cell_h == 0 || sprite->cell_h <= 0) {
@@ -2746,11 +3305,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "grid sprites require cell_h > 0.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.grid.cell_h",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
             if (sprite->has_frame_start != 0 && sprite->frame_start < 0) {
@@ -2758,11 +3317,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "grid sprites frame_start must be >= 0.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.grid.frame_start",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
             if (sprite->has_frame_count != 0 && sprite->frame_count <= 0) {
@@ -2770,11 +3329,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "grid sprites frame_count must be > 0 when provided.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.grid.frame_count",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
         } else if (sprite->mode == PR_MANIFEST_SPRITE_MODE_RECTS) {
@@ -2785,11 +3344,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "rects sprites require at least one [[sprites.rects]] entry.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.rects.empty",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
 
@@ -2802,11 +3361,11 @@ static void pr_manifest_validate_semantics(
                         diag,
                         PR_DIAG_ERROR,
                         "sprites.rects entries require x, y, w, h.",
-                        manifest_path,
+                        entry_path,
                         rect->line,
                         1,
                         "manifest.sprites.rects.missing_fields",
-                        sprite->id
+                        pr_manifest_string(manifest, sprite->id)
                     );
                     continue;
                 }
@@ -2815,11 +3374,11 @@ static void pr_manifest_validate_semantics(
                         diag,
                         PR_DIAG_ERROR,
                         "sprites.rects values must satisfy x>=0, y>=0, w>0, h>0.",
-                        manifest_path,
+                        entry_path,
                         rect->line,
                         1,
                         "manifest.sprites.rects.range",
-                        sprite->id
+                        pr_manifest_string(manifest, sprite->id)
                     );
                 }
             }
@@ -2829,11 +3388,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "single sprite w must be > 0 when provided.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.single.w_range",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
             if (sprite->has_h != 0 && sprite->h <= 0) {
@@ -2841,11 +3400,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "single sprite h must be > 0 when provided.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.single.h_range",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
             if ((sprite->has_x != 0 && sprite->x < 0) || (sprite->has_y != 0 && sprite->y < 0)) {
@@ -2853,11 +3412,11 @@ static void pr_manifest_validate_semantics(
                     diag,
                     PR_DIAG_ERROR,
                     "single sprite x/y must be >= 0 when provided.",
-                    manifest_path,
+                    entry_path,
                     sprite->line,
                     1,
                     "manifest.sprites.single.xy_range",
-                    sprite->id
+                    pr_manifest_string(manifest, sprite->id)
                 );
             }
         }
@@ -2868,43 +3427,44 @@ static void pr_manifest_validate_semantics(
         long sprite_index;
 
         animation = &manifest->animations[i];
-        if (animation->has_id == 0 || animation->id[0] == '\0') {
+        entry_path = pr_manifest_entry_path(manifest, animation->file, manifest_path);
+        if (animation->has_id == 0 || pr_manifest_string(manifest, animation->id)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "animations entry is missing id.",
-                manifest_path,
+                entry_path,
                 animation->line,
                 1,
                 "manifest.animations.missing_id",
                 NULL
             );
         }
-        if (animation->has_sprite == 0 || animation->sprite[0] == '\0') {
+        if (animation->has_sprite == 0 || pr_manifest_string(manifest, animation->sprite)[0] == '\0') {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "animations entry is missing sprite reference.",
-                manifest_path,
+                entry_path,
                 animation->line,
                 1,
                 "manifest.animations.missing_sprite",
-                animation->id
+                pr_manifest_string(manifest, animation->id)
             );
             continue;
         }
 
-        sprite_index = pr_manifest_find_sprite_index(manifest, animation->sprite);
+        sprite_index = pr_manifest_id_index_find(&indexes.sprites, manifest, animation->sprite);
         if (sprite_index < 0) {
             pr_manifest_emit_diag(
                 diag,
                 PR_DIAG_ERROR,
                 "animations.sprite references unknown sprite id.",
-                manifest_path,
+                entry_path,
                 animation->line,
                 1,
                 "manifest.animations.sprite_unknown",
-                animation->id
+                pr_manifest_string(manifest, animation->id)
             );
         }
 
@@ -2913,11 +3473,11 @@ static void pr_manifest_validate_semantics(
                 diag,
                 PR_DIAG_ERROR,
                 "animations.frames is required and cannot be empty.",
-                manifest_path,
+                entry_path,
                 animation->line,
                 1,
                 "manifest.animations.frames_missing",
-                animation->id
+                pr_manifest_string(manifest, animation->id)
             );
             continue;
         }
@@ -2948,11 +3508,11 @@ static void pr_manifest_validate_semantics(
                         diag,
                         PR_DIAG_ERROR,
                         "animation frame index must be >= 0.",
-                        manifest_path,
+                        entry_path,
                         frame->line,
                         1,
                         "manifest.animations.frame_index_range",
-                        animation->id
+                        pr_manifest_string(manifest, animation->id)
                     );
                 }
                 if (frame->has_ms == 0 || frame->ms <= 0) {
@@ -2960,11 +3520,11 @@ static void pr_manifest_validate_semantics(
                         diag,
                         PR_DIAG_ERROR,
                         "animation frame ms must be > 0.",
-                        manifest_path,
+                        entry_path,
                         frame->line,
                         1,
                         "manifest.animations.frame_ms_range",
-                        animation->id
+                        pr_manifest_string(manifest, animation->id)
                     );
                 }
 
@@ -2975,11 +3535,11 @@ static void pr_manifest_validate_semantics(
                                 diag,
                                 PR_DIAG_ERROR,
                                 "animation frame index exceeds sprite frame count.",
-                                manifest_path,
+                                entry_path,
                                 frame->line,
                                 1,
                                 "manifest.animations.frame_index_oob",
-                                animation->id
+                                pr_manifest_string(manifest, animation->id)
                             );
                         }
                     } else if (warned_unknown_bound == 0) {
@@ -2987,11 +3547,11 @@ static void pr_manifest_validate_semantics(
                             diag,
                             PR_DIAG_WARNING,
                             "Cannot fully validate animation frame bounds for sprite without exact frame_count.",
-                            manifest_path,
+                            entry_path,
                             animation->line,
                             1,
                             "manifest.animations.frame_index_unbounded",
-                            animation->id
+                            pr_manifest_string(manifest, animation->id)
                         );
                         warned_unknown_bound = 1;
                     }
@@ -3000,11 +3560,774 @@ static void pr_manifest_validate_semantics(
         }
     }
 
-    pr_manifest_validate_duplicates(manifest, diag, manifest_path);
+    pr_manifest_validate_duplicates(manifest, &indexes, diag, manifest_path);
+    pr_manifest_indexes_free(&indexes);
+}
+
+static int pr_manifest_is_path_separator(char ch)
+{
+    return (ch == '/' || ch == '\\') ? 1 : 0;
+}
+
+static int pr_manifest_is_absolute_path(const char *path)
+{
+    if (path == NULL || path[0] == '\0') {
+        return 0;
+    }
+    if (pr_manifest_is_path_separator(path[0])) {
+        return 1;
+    }
+    return (
+        ((path[0] >= 'A' && path[0] <= 'Z') || (path[0] >= 'a' && path[0] <= 'z')) &&
+        path[1] == ':'
+    ) ? 1 : 0;
+}
+
+/* Length of the directory part of `path`, excluding the final separator;
+ * 0 when `path` has no directory part.
+ */
+static size_t pr_manifest_directory_length(const char *path)
+{
+    size_t length;
+    size_t i;
+
+    length = 0u;
+    for (i = 0u; path[i] != '\0'; ++i) {
+        if (pr_manifest_is_path_separator(path[i])) {
+            length = (i == 0u) ? 1u : i;
+        }
+    }
+    return length;
+}
+
+static char *pr_manifest_join_path(
+    const char *base,
+    size_t base_length,
+    const char *tail,
+    size_t tail_length
+)
+{
+    int need_separator;
+    char *joined;
+
+    need_separator = (
+        base_length > 0u &&
+        tail_length > 0u &&
+        !pr_manifest_is_path_separator(base[base_length - 1u])
+    ) ? 1 : 0;
+
+    joined = (char *)malloc(base_length + (size_t)need_separator + tail_length + 1u);
+    if (joined == NULL) {
+        return NULL;
+    }
+    if (base_length > 0u) {
+        memcpy(joined, base, base_length);
+    }
+    if (need_separator != 0) {
+        joined[base_length] = '/';
+    }
+    if (tail_length > 0u) {
+        memcpy(joined + base_length + (size_t)need_separator, tail, tail_length);
+    }
+    joined[base_length + (size_t)need_separator + tail_length] = '\0';
+    return joined;
+}
+
+static int pr_manifest_is_regular_file(const char *path)
+{
+    struct stat info;
+
+    if (stat(path, &info) != 0) {
+        return 0;
+    }
+    return ((info.st_mode & S_IFMT) == S_IFREG) ? 1 : 0;
+}
+
+static int pr_manifest_has_wildcard(const char *text, size_t length)
+{
+    size_t i;
+
+    for (i = 0u; i < length; ++i) {
+        if (text[i] == '*' || text[i] == '?') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* `*` matches any run of characters and `?` any single character. */
+static int pr_manifest_wildcard_match(const char *pattern, const char *name)
+{
+    const char *star_pattern;
+    const char *star_name;
+
+    star_pattern = NULL;
+    star_name = NULL;
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star_pattern = ++pattern;
+            star_name = name;
+            continue;
+        }
+        if (*pattern == '?' || *pattern == *name) {
+            pattern += 1;
+            name += 1;
+            continue;
+        }
+        if (star_pattern == NULL) {
+            return 0;
+        }
+        pattern = star_pattern;
+        name = ++star_name;
+    }
+    while (*pattern == '*') {
+        pattern += 1;
+    }
+    return (*pattern == '\0') ? 1 : 0;
+}
+
+typedef struct pr_manifest_path_list {
+    char **items;
+    size_t count;
+    size_t capacity;
+} pr_manifest_path_list_t;
+
+static void pr_manifest_path_list_free(pr_manifest_path_list_t *list)
+{
+    size_t i;
+
+    for (i = 0u; i < list->count; ++i) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+/* Takes ownership of `path`, including on failure. */
+static int pr_manifest_path_list_push(pr_manifest_path_list_t *list, char *path)
+{
+    if (path == NULL) {
+        return 0;
+    }
+    if (!pr_manifest_reserve_array(
+            (void **)&list->items,
+            &list->capacity,
+            list->count + 1u,
+            sizeof(list->items[0])
+        )) {
+        free(path);
+        return 0;
+    }
+    list->items[list->count++] = path;
+    return 1;
+}
+
+static int pr_manifest_path_list_contains(const pr_manifest_path_list_t *list, const char *path)
+{
+    size_t i;
+
+    for (i = 0u; i < list->count; ++i) {
+        if (strcmp(list->items[i], path) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int pr_manifest_compare_paths(const void *lhs, const void *rhs)
+{
+    return strcmp(*(const char *const *)lhs, *(const char *const *)rhs);
+}
+
+/* Appends every regular file in `directory` whose name matches
+ * `name_pattern`. Hidden files only match patterns that start with '.'.
+ */
+static int pr_manifest_list_directory_matches(
+    const char *directory,
+    size_t directory_length,
+    const char *name_pattern,
+    pr_manifest_path_list_t *out_matches
+)
+{
+    char *directory_path;
+    int ok;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find;
+    char *search_path;
+#else
+    DIR *handle;
+    struct dirent *entry;
+#endif
+
+    directory_path = (directory_length > 0u)
+        ? pr_manifest_join_path(directory, directory_length, "", 0u)
+        : pr_manifest_join_path(".", 1u, "", 0u);
+    if (directory_path == NULL) {
+        return 0;
+    }
+
+    ok = 1;
+#ifdef _WIN32
+    search_path = pr_manifest_join_path(directory_path, strlen(directory_path), "*", 1u);
+    free(directory_path);
+    if (search_path == NULL) {
+        return 0;
+    }
+    find = FindFirstFileA(search_path, &entry);
+    free(search_path);
+    if (find == INVALID_HANDLE_VALUE) {
+        return 1;
+    }
+    do {
+        const char *name;
+
+        name = entry.cFileName;
+        if (
+            (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0u ||
+            (name[0] == '.' && name_pattern[0] != '.') ||
+            !pr_manifest_wildcard_match(name_pattern, name)
+        ) {
+            continue;
+        }
+        if (!pr_manifest_path_list_push(
+                out_matches,
+                pr_manifest_join_path(directory, directory_length, name, strlen(name))
+            )) {
+            ok = 0;
+            break;
+        }
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    handle = opendir(directory_path);
+    free(directory_path);
+    if (handle == NULL) {
+        return 1;
+    }
+    while ((entry = readdir(handle)) != NULL) {
+        const char *name;
+        char *path;
+
+        name = entry->d_name;
+        if (
+            (name[0] == '.' && name_pattern[0] != '.') ||
+            !pr_manifest_wildcard_match(name_pattern, name)
+        ) {
+            continue;
+        }
+        path = pr_manifest_join_path(directory, directory_length, name, strlen(name));
+        if (path != NULL && !pr_manifest_is_regular_file(path)) {
+            free(path);
+            continue;
+        }
+        if (!pr_manifest_path_list_push(out_matches, path)) {
+            ok = 0;
+            break;
+        }
+    }
+    (void)closedir(handle);
+#endif
+    return ok;
+}
+
+/* Resolves the root manifest's include patterns, relative to its directory,
+ * into an ordered, de-duplicated file list: patterns in declaration order,
+ * wildcard matches sorted by path. Reports through `diag`, which may be NULL
+ * for a silent check.
+ */
+static int pr_manifest_expand_includes(
+    const pr_manifest_t *manifest,
+    const char *manifest_path,
+    pr_manifest_diag_context_t *diag,
+    pr_manifest_path_list_t *out_paths
+)
+{
+    size_t root_length;
+    size_t i;
+    int ok;
+
+    root_length = pr_manifest_directory_length(manifest_path);
+    ok = 1;
+    for (i = 0u; i < manifest->include_count; ++i) {
+        pr_manifest_path_list_t matches;
+        const char *pattern;
+        const char *base;
+        size_t base_length;
+        size_t directory_length;
+        const char *name_pattern;
+        char *directory;
+        size_t m;
+
+        pattern = pr_manifest_string(manifest, manifest->includes[i]);
+        if (pr_manifest_is_absolute_path(pattern)) {
+            base = "";
+            base_length = 0u;
+        } else {
+            base = manifest_path;
+            base_length = root_length;
+        }
+
+        directory_length = pr_manifest_directory_length(pattern);
+        name_pattern = pattern + directory_length;
+        while (pr_manifest_is_path_separator(*name_pattern)) {
+            name_pattern += 1;
+        }
+
+        if (pr_manifest_has_wildcard(pattern, directory_length)) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "include wildcards are only supported in the file name.",
+                manifest_path,
+                manifest->include_line,
+                1,
+                "manifest.include.pattern_unsupported",
+                pattern
+            );
+            ok = 0;
+            continue;
+        }
+
+        if (!pr_manifest_has_wildcard(name_pattern, strlen(name_pattern))) {
+            char *path;
+
+            path = pr_manifest_join_path(base, base_length, pattern, strlen(pattern));
+            if (path == NULL) {
+                return 0;
+            }
+            if (!pr_manifest_is_regular_file(path)) {
+                free(path);
+                pr_manifest_emit_diag(
+                    diag,
+                    PR_DIAG_ERROR,
+                    "Included manifest file not found.",
+                    manifest_path,
+                    manifest->include_line,
+                    1,
+                    "manifest.include.not_found",
+                    pattern
+                );
+                ok = 0;
+                continue;
+            }
+            if (
+                strcmp(path, manifest_path) == 0 ||
+                pr_manifest_path_list_contains(out_paths, path)
+            ) {
+                free(path);
+                continue;
+            }
+            if (!pr_manifest_path_list_push(out_paths, path)) {
+                return 0;
+            }
+            continue;
+        }
+
+        directory = pr_manifest_join_path(base, base_length, pattern, directory_length);
+        if (directory == NULL) {
+            return 0;
+        }
+        memset(&matches, 0, sizeof(matches));
+        if (!pr_manifest_list_directory_matches(
+                directory,
+                strlen(directory),
+                name_pattern,
+                &matches
+            )) {
+            free(directory);
+            pr_manifest_path_list_free(&matches);
+            return 0;
+        }
+        free(directory);
+
+        if (matches.count == 0u) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_WARNING,
+                "include pattern matched no files.",
+                manifest_path,
+                manifest->include_line,
+                1,
+                "manifest.include.no_matches",
+                pattern
+            );
+        }
+        qsort(matches.items, matches.count, sizeof(matches.items[0]), pr_manifest_compare_paths);
+        for (m = 0u; m < matches.count; ++m) {
+            if (
+                strcmp(matches.items[m], manifest_path) == 0 ||
+                pr_manifest_path_list_contains(out_paths, matches.items[m])
+            ) {
+                continue;
+            }
+            if (!pr_manifest_path_list_push(out_paths, matches.items[m])) {
+                matches.items[m] = NULL;
+                pr_manifest_path_list_free(&matches);
+                return 0;
+            }
+            matches.items[m] = NULL;
+        }
+        pr_manifest_path_list_free(&matches);
+    }
+    return ok;
+}
+
+typedef struct pr_manifest_include_job {
+    const char *path;
+    pr_manifest_t manifest;
+    pr_manifest_cache_diags_t diags;
+    uint64_t size;
+    uint64_t hash;
+    int read_failed;
+    int parsed;
+    int hash_only;
+} pr_manifest_include_job_t;
+
+static void pr_manifest_include_job_run(void *user_data, size_t index)
+{
+    pr_manifest_include_job_t *job;
+    pr_manifest_diag_context_t diag;
+    char *text;
+    size_t text_size;
+
+    job = &((pr_manifest_include_job_t *)user_data)[index];
+    text = pr_manifest_read_text_file(job->path, &text_size);
+    if (text == NULL) {
+        job->read_failed = 1;
+        return;
+    }
+    job->size = (uint64_t)text_size;
+    job->hash = pr_manifest_cache_hash(text, text_size);
+    if (job->hash_only != 0) {
+        free(text);
+        return;
+    }
+
+    /* Workers never touch the caller's sink; diagnostics are captured and
+     * replayed in include order once every file has been parsed.
+     */
+    memset(&diag, 0, sizeof(diag));
+    diag.capture = &job->diags;
+    job->parsed = pr_manifest_parse_text(job->path, text, &diag, &job->manifest, 1);
+    free(text);
+}
+
+static uint32_t pr_manifest_remap_handle(const uint32_t *remap, uint32_t handle)
+{
+    return (handle == PR_MANIFEST_NO_STRING) ? PR_MANIFEST_NO_STRING : remap[handle];
+}
+
+/* Appends the entries of `included` to `manifest`, re-interning its strings.
+ * Rect and frame arrays are moved, not copied.
+ */
+static int pr_manifest_merge_include(
+    pr_manifest_t *manifest,
+    pr_manifest_include_job_t *job
+)
+{
+    pr_manifest_t *included;
+    pr_manifest_source_t *source;
+    uint32_t *remap;
+    uint32_t file;
+    size_t i;
+
+    included = &job->manifest;
+    remap = NULL;
+    if (included->strings.count > 0u) {
+        remap = (uint32_t *)malloc(included->strings.count * sizeof(remap[0]));
+        if (remap == NULL) {
+            return 0;
+        }
+    }
+    for (i = 0u; i < included->strings.count; ++i) {
+        if (!pr_intern_pool_add_n(
+                &manifest->strings,
+                pr_intern_pool_get(&included->strings, (uint32_t)i),
+                pr_intern_pool_length(&included->strings, (uint32_t)i),
+                &remap[i]
+            )) {
+            free(remap);
+            return 0;
+        }
+    }
+
+    if (
+        !pr_intern_pool_add(&manifest->strings, job->path, &file) ||
+        !pr_manifest_reserve_array(
+            (void **)&manifest->images,
+            &manifest->image_capacity,
+            manifest->image_count + included->image_count,
+            sizeof(manifest->images[0])
+        ) ||
+        !pr_manifest_reserve_array(
+            (void **)&manifest->sprites,
+            &manifest->sprite_capacity,
+            manifest->sprite_count + included->sprite_count,
+            sizeof(manifest->sprites[0])
+        ) ||
+        !pr_manifest_reserve_array(
+            (void **)&manifest->animations,
+            &manifest->animation_capacity,
+            manifest->animation_count + included->animation_count,
+            sizeof(manifest->animations[0])
+        ) ||
+        !pr_manifest_reserve_array(
+            (void **)&manifest->sources,
+            &manifest->source_capacity,
+            manifest->source_count + 1u,
+            sizeof(manifest->sources[0])
+        )
+    ) {
+        free(remap);
+        return 0;
+    }
+
+    for (i = 0u; i < included->image_count; ++i) {
+        pr_manifest_image_t *image;
+
+        image = &manifest->images[manifest->image_count++];
+        *image = included->images[i];
+        image->file = file;
+        image->id = pr_manifest_remap_handle(remap, image->id);
+        image->path = pr_manifest_remap_handle(remap, image->path);
+        image->color_space = pr_manifest_remap_handle(remap, image->color_space);
+    }
+
+    for (i = 0u; i < included->sprite_count; ++i) {
+        pr_manifest_sprite_t *sprite;
+        size_t r;
+
+        sprite = &manifest->sprites[manifest->sprite_count++];
+        *sprite = included->sprites[i];
+        sprite->file = file;
+        sprite->id = pr_manifest_remap_handle(remap, sprite->id);
+        sprite->source = pr_manifest_remap_handle(remap, sprite->source);
+        for (r = 0u; r < sprite->rect_count; ++r) {
+            sprite->rects[r].label = pr_manifest_remap_handle(remap, sprite->rects[r].label);
+        }
+        included->sprites[i].rects = NULL;
+        included->sprites[i].rect_count = 0u;
+        included->sprites[i].rect_capacity = 0u;
+    }
+
+    for (i = 0u; i < included->animation_count; ++i) {
+        pr_manifest_animation_t *animation;
+
+        animation = &manifest->animations[manifest->animation_count++];
+        *animation = included->animations[i];
+        animation->file = file;
+        animation->id = pr_manifest_remap_handle(remap, animation->id);
+        animation->sprite = pr_manifest_remap_handle(remap, animation->sprite);
+        included->animations[i].frames = NULL;
+        included->animations[i].frame_count = 0u;
+        included->animations[i].frame_capacity = 0u;
+    }
+
+    source = &manifest->sources[manifest->source_count++];
+    source->path = file;
+    source->size = job->size;
+    source->hash = job->hash;
+
+    free(remap);
+    return 1;
+}
+
+static void pr_manifest_replay_cached_diags(
+    pr_manifest_diag_context_t *diag,
+    const pr_manifest_cache_diags_t *cached,
+    const char *manifest_path
+)
+{
+    size_t i;
+
+    for (i = 0u; i < cached->count; ++i) {
+        const pr_manifest_cache_diag_t *item;
+        const char *file;
+
+        item = &cached->items[i];
+        file = pr_intern_pool_get(&cached->strings, item->file);
+        pr_manifest_emit_diag(
+            diag,
+            item->severity,
+            pr_intern_pool_get(&cached->strings, item->message),
+            (file != NULL) ? file : manifest_path,
+            item->line,
+            item->column,
+            pr_intern_pool_get(&cached->strings, item->code),
+            pr_intern_pool_get(&cached->strings, item->asset_id)
+        );
+    }
+}
+
+static pr_manifest_include_job_t *pr_manifest_include_jobs_create(
+    const pr_manifest_path_list_t *paths,
+    int hash_only
+)
+{
+    pr_manifest_include_job_t *jobs;
+    size_t i;
+
+    jobs = (pr_manifest_include_job_t *)calloc(paths->count, sizeof(jobs[0]));
+    if (jobs == NULL) {
+        return NULL;
+    }
+    for (i = 0u; i < paths->count; ++i) {
+        jobs[i].path = paths->items[i];
+        jobs[i].hash_only = hash_only;
+        pr_manifest_init(&jobs[i].manifest);
+        pr_manifest_cache_diags_init(&jobs[i].diags);
+    }
+    return jobs;
+}
+
+static void pr_manifest_include_jobs_free(pr_manifest_include_job_t *jobs, size_t count)
+{
+    size_t i;
+
+    if (jobs == NULL) {
+        return;
+    }
+    for (i = 0u; i < count; ++i) {
+        pr_manifest_free(&jobs[i].manifest);
+        pr_manifest_cache_diags_free(&jobs[i].diags);
+    }
+    free(jobs);
+}
+
+/* Parses every included manifest in parallel, then merges them into
+ * `manifest` after its own entries, in include order.
+ */
+static int pr_manifest_parse_includes(
+    const char *manifest_path,
+    pr_manifest_diag_context_t *diag,
+    pr_manifest_t *manifest
+)
+{
+    pr_manifest_path_list_t paths;
+    pr_manifest_include_job_t *jobs;
+    size_t i;
+    int ok;
+
+    if (manifest->include_count == 0u) {
+        return 1;
+    }
+
+    memset(&paths, 0, sizeof(paths));
+    ok = pr_manifest_expand_includes(manifest, manifest_path, diag, &paths);
+    if (ok == 0 || paths.count == 0u) {
+        pr_manifest_path_list_free(&paths);
+        return ok;
+    }
+
+    jobs = pr_manifest_include_jobs_create(&paths, 0);
+    if (jobs == NULL) {
+        pr_manifest_path_list_free(&paths);
+        return 0;
+    }
+    pr_parallel_for(paths.count, pr_manifest_include_job_run, jobs);
+
+    for (i = 0u; i < paths.count; ++i) {
+        pr_manifest_include_job_t *job;
+
+        job = &jobs[i];
+        if (job->read_failed != 0) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Failed to read included manifest file.",
+                job->path,
+                1,
+                1,
+                "manifest.include.read_failed",
+                NULL
+            );
+            ok = 0;
+            continue;
+        }
+
+        pr_manifest_replay_cached_diags(diag, &job->diags, job->path);
+        if (job->diags.failed != 0 || job->parsed == 0) {
+            ok = 0;
+            continue;
+        }
+        if (ok != 0 && !pr_manifest_merge_include(manifest, job)) {
+            pr_manifest_emit_diag(
+                diag,
+                PR_DIAG_ERROR,
+                "Allocation failed while merging included manifest.",
+                job->path,
+                1,
+                1,
+                "manifest.include.alloc_failed",
+                NULL
+            );
+            ok = 0;
+        }
+    }
+
+    pr_manifest_include_jobs_free(jobs, paths.count);
+    pr_manifest_path_list_free(&paths);
+    return ok;
+}
+
+/* A cached manifest is only current if its includes still expand to the same
+ * files and none of them changed.
+ */
+static int pr_manifest_sources_current(const pr_manifest_t *manifest, const char *manifest_path)
+{
+    pr_manifest_path_list_t paths;
+    pr_manifest_include_job_t *jobs;
+    size_t i;
+    int current;
+
+    memset(&paths, 0, sizeof(paths));
+    if (!pr_manifest_expand_includes(manifest, manifest_path, NULL, &paths)) {
+        pr_manifest_path_list_free(&paths);
+        return 0;
+    }
+    if (paths.count != manifest->source_count) {
+        pr_manifest_path_list_free(&paths);
+        return 0;
+    }
+    for (i = 0u; i < paths.count; ++i) {
+        if (strcmp(paths.items[i], pr_manifest_string(manifest, manifest->sources[i].path)) != 0) {
+            pr_manifest_path_list_free(&paths);
+            return 0;
+        }
+    }
+    if (paths.count == 0u) {
+        pr_manifest_path_list_free(&paths);
+        return 1;
+    }
+
+    jobs = pr_manifest_include_jobs_create(&paths, 1);
+    if (jobs == NULL) {
+        pr_manifest_path_list_free(&paths);
+        return 0;
+    }
+    pr_parallel_for(paths.count, pr_manifest_include_job_run, jobs);
+
+    current = 1;
+    for (i = 0u; i < paths.count; ++i) {
+        if (
+            jobs[i].read_failed != 0 ||
+            jobs[i].size != manifest->sources[i].size ||
+            jobs[i].hash != manifest->sources[i].hash
+        ) {
+            current = 0;
+            break;
+        }
+    }
+
+    pr_manifest_include_jobs_free(jobs, paths.count);
+    pr_manifest_path_list_free(&paths);
+    return current;
 }
 
 pr_status_t pr_manifest_load_and_validate(
     const char *manifest_path,
+    unsigned int flags,
     pr_diag_sink_fn diag_sink,
     void *diag_user_data,
     pr_manifest_t *out_manifest,
@@ -3013,9 +4336,12 @@ pr_status_t pr_manifest_load_and_validate(
 )
 {
     pr_manifest_diag_context_t diag;
+    pr_manifest_cache_diags_t cached_diags;
     pr_manifest_t manifest;
     char *text;
     size_t text_size;
+    char *cache_path;
+    uint64_t source_hash;
     pr_status_t status;
 
     if (out_error_count != NULL) {
@@ -3063,8 +4389,52 @@ pr_status_t pr_manifest_load_and_validate(
         return PR_STATUS_VALIDATION_ERROR;
     }
 
-    if (!pr_manifest_parse_text(manifest_path, text, &diag, &manifest)) {
+    /* The compiled cache is keyed on the exact source bytes, so it has to be
+     * hashed before parsing terminates lines in place.
+     */
+    pr_manifest_cache_diags_init(&cached_diags);
+    cache_path = NULL;
+    source_hash = 0u;
+    if ((flags & PR_MANIFEST_LOAD_USE_CACHE) != 0u) {
+        source_hash = pr_manifest_cache_hash(text, text_size);
+        cache_path = pr_manifest_cache_path(manifest_path);
+        if (
+            cache_path != NULL &&
+            pr_manifest_cache_load(
+                cache_path,
+                (uint64_t)text_size,
+                source_hash,
+                &manifest,
+                &cached_diags
+            ) &&
+            pr_manifest_sources_current(&manifest, manifest_path)
+        ) {
+            free(text);
+            free(cache_path);
+            pr_manifest_replay_cached_diags(&diag, &cached_diags, manifest_path);
+            pr_manifest_cache_diags_free(&cached_diags);
+            *out_manifest = manifest;
+            if (out_warning_count != NULL) {
+                *out_warning_count = diag.warning_count;
+            }
+            return PR_STATUS_OK;
+        }
+        pr_manifest_free(&manifest);
+        pr_manifest_cache_diags_free(&cached_diags);
+        pr_manifest_cache_diags_init(&cached_diags);
+        if (cache_path != NULL) {
+            cached_diags.root_path = manifest_path;
+            diag.capture = &cached_diags;
+        }
+    }
+
+    if (
+        !pr_manifest_parse_text(manifest_path, text, &diag, &manifest, 0) ||
+        !pr_manifest_parse_includes(manifest_path, &diag, &manifest)
+    ) {
         free(text);
+        free(cache_path);
+        pr_manifest_cache_diags_free(&cached_diags);
         if (out_error_count != NULL) {
             *out_error_count = diag.error_count;
         }
@@ -3081,9 +4451,21 @@ pr_status_t pr_manifest_load_and_validate(
         status = PR_STATUS_VALIDATION_ERROR;
         pr_manifest_free(&manifest);
     } else {
+        /* Best effort: an unwritable cache only costs the next load a parse. */
+        if (cache_path != NULL) {
+            (void)pr_manifest_cache_write(
+                cache_path,
+                (uint64_t)text_size,
+                source_hash,
+                &manifest,
+                &cached_diags
+            );
+        }
         *out_manifest = manifest;
         status = PR_STATUS_OK;
     }
+    free(cache_path);
+    pr_manifest_cache_diags_free(&cached_diags);
 
     if (out_error_count != NULL) {
         *out_error_count = diag.error_count;
@@ -3094,4 +4476,3 @@ pr_status_t pr_manifest_load_and_validate(
 
     return status;
 }
-
@@ -2,13 +2,19 @@
 #define PACKRAT_MANIFEST_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "packrat/build.h"
 #include "packrat/runtime.h"
 
-#define PR_MANIFEST_ID_MAX 128u
-#define PR_MANIFEST_PATH_MAX 1024u
-#define PR_MANIFEST_SMALL_TEXT_MAX 32u
+#include "intern.h"
+
+#define PR_MANIFEST_NO_STRING PR_INTERN_INVALID_HANDLE
+
+/* Load through "<manifest_path>.prmc": reuse it when it was compiled from the
+ * same manifest bytes, otherwise parse, validate, and rewrite it.
+ */
+#define PR_MANIFEST_LOAD_USE_CACHE 1u
 
 typedef enum pr_manifest_sprite_mode {
     PR_MANIFEST_SPRITE_MODE_SINGLE = 0,
@@ -16,51 +22,51 @@ typedef enum pr_manifest_sprite_mode {
     PR_MANIFEST_SPRITE_MODE_RECTS
 } pr_manifest_sprite_mode_t;
 
+/* String fields are handles into `pr_manifest_t.strings`; resolve them with
+ * `pr_manifest_string`. Unset handles are PR_MANIFEST_NO_STRING.
+ *
+ * `file` names the included manifest an entry came from; entries declared in
+ * the root manifest keep PR_MANIFEST_NO_STRING. Rects and frames share the
+ * file of their parent entry.
+ */
 typedef struct pr_manifest_sprite_rect {
     int x;
     int y;
     int w;
     int h;
-    int has_x;
-    int has_y;
-    int has_w;
-    int has_h;
-    char label[PR_MANIFEST_ID_MAX];
-    int has_label;
+    uint32_t label;
     int line;
+    unsigned int has_x : 1;
+    unsigned int has_y : 1;
+    unsigned int has_w : 1;
+    unsigned int has_h : 1;
+    unsigned int has_label : 1;
 } pr_manifest_sprite_rect_t;
 
 typedef struct pr_manifest_image {
-    char id[PR_MANIFEST_ID_MAX];
-    char path[PR_MANIFEST_PATH_MAX];
-    int has_id;
-    int has_path;
-    int premultiply_alpha;
-    int has_premultiply_alpha;
-    char color_space[PR_MANIFEST_SMALL_TEXT_MAX];
-    int has_color_space;
+    uint32_t file;
+    uint32_t id;
+    uint32_t path;
+    uint32_t color_space;
     int line;
+    unsigned int has_id : 1;
+    unsigned int has_path : 1;
+    unsigned int premultiply_alpha : 1;
+    unsigned int has_premultiply_alpha : 1;
+    unsigned int has_color_space : 1;
 } pr_manifest_image_t;
 
 typedef struct pr_manifest_sprite {
-    char id[PR_MANIFEST_ID_MAX];
-    char source[PR_MANIFEST_ID_MAX];
-    int has_id;
-    int has_source;
+    uint32_t file;
+    uint32_t id;
+    uint32_t source;
     pr_manifest_sprite_mode_t mode;
-    int has_mode;
     double pivot_x;
     double pivot_y;
-    int has_pivot_x;
-    int has_pivot_y;
     int x;
     int y;
     int w;
     int h;
-    int has_x;
-    int has_y;
-    int has_w;
-    int has_h;
     int cell_w;
     int cell_h;
     int frame_start;
@@ -69,40 +75,50 @@ typedef struct pr_manifest_sprite {
     int margin_y;
     int spacing_x;
     int spacing_y;
-    int has_cell_w;
-    int has_cell_h;
-    int has_frame_start;
-    int has_frame_count;
-    int has_margin_x;
-    int has_margin_y;
-    int has_spacing_x;
-    int has_spacing_y;
     pr_manifest_sprite_rect_t *rects;
     size_t rect_count;
     size_t rect_capacity;
     int line;
+    unsigned int has_id : 1;
+    unsigned int has_source : 1;
+    unsigned int has_mode : 1;
+    unsigned int has_pivot_x : 1;
+    unsigned int has_pivot_y : 1;
+    unsigned int has_x : 1;
+    unsigned int has_y : 1;
+    unsigned int has_w : 1;
+    unsigned int has_h : 1;
+    unsigned int has_cell_w : 1;
+    unsigned int has_cell_h : 1;
+    unsigned int has_frame_start : 1;
+    unsigned int has_frame_count : 1;
+    unsigned int has_margin_x : 1;
+    unsigned int has_margin_y : 1;
+    unsigned int has_spacing_x : 1;
+    unsigned int has_spacing_y : 1;
 } pr_manifest_sprite_t;
 
 typedef struct pr_manifest_animation_frame {
     int index;
     int ms;
-    int has_index;
-    int has_ms;
     int line;
+    unsigned int has_index : 1;
+    unsigned int has_ms : 1;
 } pr_manifest_animation_frame_t;
 
 typedef struct pr_manifest_animation {
-    char id[PR_MANIFEST_ID_MAX];
-    char sprite[PR_MANIFEST_ID_MAX];
-    int has_id;
-    int has_sprite;
+    uint32_t file;
+    uint32_t id;
+    uint32_t sprite;
     pr_loop_mode_t loop_mode;
-    int has_loop_mode;
     pr_manifest_animation_frame_t *frames;
     size_t frame_count;
     size_t frame_capacity;
-    int has_frames;
     int line;
+    unsigned int has_id : 1;
+    unsigned int has_sprite : 1;
+    unsigned int has_loop_mode : 1;
+    unsigned int has_frames : 1;
 } pr_manifest_animation_t;
 
 typedef struct pr_manifest_atlas {
@@ -110,25 +126,57 @@ typedef struct pr_manifest_atlas {
     int max_page_height;
     int padding;
     int power_of_two;
-    char sampling[PR_MANIFEST_SMALL_TEXT_MAX];
-    int has_max_page_width;
-    int has_max_page_height;
-    int has_padding;
-    int has_power_of_two;
-    int has_sampling;
+    uint32_t sampling;
+    uint32_t format;
+    uint32_t encode_quality;
+    uint32_t compression;
+    int tile_size;
+    int mipmaps;
+    int extrude;
+    int bleed_alpha;
+    int dither;
+    uint32_t layout;
+    int incremental;
+    int repack_threshold;
+    unsigned int has_max_page_width : 1;
+    unsigned int has_max_page_height : 1;
+    unsigned int has_padding : 1;
+    unsigned int has_power_of_two : 1;
+    unsigned int has_sampling : 1;
+    unsigned int has_format : 1;
+    unsigned int has_encode_quality : 1;
+    unsigned int has_compression : 1;
+    unsigned int has_tile_size : 1;
+    unsigned int has_mipmaps : 1;
+    unsigned int has_extrude : 1;
+    unsigned int has_bleed_alpha : 1;
+    unsigned int has_dither : 1;
+    unsigned int has_layout : 1;
+    unsigned int has_incremental : 1;
+    unsigned int has_repack_threshold : 1;
 } pr_manifest_atlas_t;
 
+/* An included manifest file, recorded so cached loads can tell when it
+ * changed. `path` is relative to the working directory, like the root path.
+ */
+typedef struct pr_manifest_source {
+    uint32_t path;
+    uint64_t size;
+    uint64_t hash;
+} pr_manifest_source_t;
+
 typedef struct pr_manifest {
+    pr_intern_pool_t strings;
     int schema_version;
-    int has_schema_version;
-    char package_name[PR_MANIFEST_ID_MAX];
-    int has_package_name;
-    char output[PR_MANIFEST_PATH_MAX];
-    int has_output;
-    char debug_output[PR_MANIFEST_PATH_MAX];
-    int has_debug_output;
+    uint32_t package_name;
+    uint32_t output;
+    uint32_t debug_output;
     int pretty_debug_json;
-    int has_pretty_debug_json;
+    unsigned int has_schema_version : 1;
+    unsigned int has_package_name : 1;
+    unsigned int has_output : 1;
+    unsigned int has_debug_output : 1;
+    unsigned int has_pretty_debug_json : 1;
     pr_manifest_atlas_t atlas;
     pr_manifest_image_t *images;
     size_t image_count;
@@ -139,13 +187,35 @@ typedef struct pr_manifest {
     pr_manifest_animation_t *animations;
     size_t animation_count;
     size_t animation_capacity;
+    uint32_t *includes;
+    size_t include_count;
+    size_t include_capacity;
+    int include_line;
+    pr_manifest_source_t *sources;
+    size_t source_count;
+    size_t source_capacity;
 } pr_manifest_t;
 
 void pr_manifest_init(pr_manifest_t *manifest);
 void pr_manifest_free(pr_manifest_t *manifest);
 
+/* Returns "" for PR_MANIFEST_NO_STRING so unset fields compare and print
+ * like empty strings.
+ */
+const char *pr_manifest_string(const pr_manifest_t *manifest, uint32_t handle);
+
+/* Path of the manifest file that declared an entry: the included file named
+ * by `file`, or `manifest_path` for the root manifest.
+ */
+const char *pr_manifest_entry_path(
+    const pr_manifest_t *manifest,
+    uint32_t file,
+    const char *manifest_path
+);
+
 pr_status_t pr_manifest_load_and_validate(
     const char *manifest_path,
+    unsigned int flags,
     pr_diag_sink_fn diag_sink,
     void *diag_user_data,
     pr_manifest_t *out_manifest,
@@ -0,0 +1,1318 @@
+#include "manifest_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compiled manifest layout (all integers little-endian):
+ *
+ *   header   64 bytes: "PRMC", u16 major, u16 minor, u32 header_size,
+ *            u32 section_count, u64 source_size, u64 source_hash,
+ *            u64 section_table_offset, u64 file_size, 16 reserved bytes
+ *   sections 24 bytes each: u32 tag, u32 record_count, u64 offset, u64 size
+ *
+ * Section payloads start on 8-byte boundaries and hold fixed-size records, so
+ * the file can be mapped and walked in place. Strings are stored once in the
+ * STRS table (u32 offsets followed by the NUL-separated blob, in handle order)
+ * and records refer to them by handle, exactly like `pr_manifest_t`.
+ *
+ * `source_hash` only covers the root manifest. Included files are listed in
+ * SRCS with their own size and hash, alongside the include patterns in INCL,
+ * so the loader can re-expand and re-check them.
+ */
+#define PR_MANIFEST_CACHE_VERSION_MAJOR 11u
+#define PR_MANIFEST_CACHE_VERSION_MINOR 0u
+#define PR_MANIFEST_CACHE_HEADER_SIZE 64u
+#define PR_MANIFEST_CACHE_SECTION_SIZE 24u
+#define PR_MANIFEST_CACHE_SECTION_COUNT 11u
+
+#define PR_MANIFEST_CACHE_ROOT_SIZE 96u
+#define PR_MANIFEST_CACHE_IMAGE_SIZE 24u
+#define PR_MANIFEST_CACHE_SPRITE_SIZE 96u
+#define PR_MANIFEST_CACHE_RECT_SIZE 28u
+#define PR_MANIFEST_CACHE_ANIMATION_SIZE 32u
+#define PR_MANIFEST_CACHE_FRAME_SIZE 16u
+#define PR_MANIFEST_CACHE_INCLUDE_SIZE 4u
+#define PR_MANIFEST_CACHE_SOURCE_SIZE 24u
+#define PR_MANIFEST_CACHE_DIAG_SIZE 28u
+
+#define PR_MANIFEST_CACHE_FOURCC(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+enum {
+    PR_MANIFEST_CACHE_SECTION_ROOT = 0,
+    PR_MANIFEST_CACHE_SECTION_STRS,
+    PR_MANIFEST_CACHE_SECTION_IMGS,
+    PR_MANIFEST_CACHE_SECTION_SPRT,
+    PR_MANIFEST_CACHE_SECTION_RECT,
+    PR_MANIFEST_CACHE_SECTION_ANIM,
+    PR_MANIFEST_CACHE_SECTION_FRMS,
+    PR_MANIFEST_CACHE_SECTION_INCL,
+    PR_MANIFEST_CACHE_SECTION_SRCS,
+    PR_MANIFEST_CACHE_SECTION_DSTR,
+    PR_MANIFEST_CACHE_SECTION_DIAG
+};
+
+static const uint32_t PR_MANIFEST_CACHE_SECTION_TAGS[PR_MANIFEST_CACHE_SECTION_COUNT] = {
+    PR_MANIFEST_CACHE_FOURCC('R', 'O', 'O', 'T'),
+    PR_MANIFEST_CACHE_FOURCC('S', 'T', 'R', 'S'),
+    PR_MANIFEST_CACHE_FOURCC('I', 'M', 'G', 'S'),
+    PR_MANIFEST_CACHE_FOURCC('S', 'P', 'R', 'T'),
+    PR_MANIFEST_CACHE_FOURCC('R', 'E', 'C', 'T'),
+    PR_MANIFEST_CACHE_FOURCC('A', 'N', 'I', 'M'),
+    PR_MANIFEST_CACHE_FOURCC('F', 'R', 'M', 'S'),
+    PR_MANIFEST_CACHE_FOURCC('I', 'N', 'C', 'L'),
+    PR_MANIFEST_CACHE_FOURCC('S', 'R', 'C', 'S'),
+    PR_MANIFEST_CACHE_FOURCC('D', 'S', 'T', 'R'),
+    PR_MANIFEST_CACHE_FOURCC('D', 'I', 'A', 'G')
+};
+
+typedef struct pr_manifest_cache_section {
+    uint32_t count;
+    uint64_t offset;
+    uint64_t size;
+} pr_manifest_cache_section_t;
+
+typedef struct pr_manifest_cache_writer {
+    uint8_t *bytes;
+    size_t cursor;
+} pr_manifest_cache_writer_t;
+
+void pr_manifest_cache_diags_init(pr_manifest_cache_diags_t *diags)
+{
+    if (diags == NULL) {
+        return;
+    }
+    memset(diags, 0, sizeof(*diags));
+    pr_intern_pool_init(&diags->strings);
+}
+
+void pr_manifest_cache_diags_free(pr_manifest_cache_diags_t *diags)
+{
+    if (diags == NULL) {
+        return;
+    }
+    pr_intern_pool_free(&diags->strings);
+    free(diags->items);
+    memset(diags, 0, sizeof(*diags));
+}
+
+static int pr_manifest_cache_intern_optional(
+    pr_intern_pool_t *pool,
+    const char *value,
+    uint32_t *out_handle
+)
+{
+    if (value == NULL) {
+        *out_handle = PR_INTERN_INVALID_HANDLE;
+        return 1;
+    }
+    return pr_intern_pool_add(pool, value, out_handle);
+}
+
+void pr_manifest_cache_diags_record(
+    pr_manifest_cache_diags_t *diags,
+    pr_diag_severity_t severity,
+    const char *message,
+    const char *file,
+    int line,
+    int column,
+    const char *code,
+    const char *asset_id
+)
+{
+    pr_manifest_cache_diag_t *item;
+
+    if (diags == NULL || diags->failed != 0) {
+        return;
+    }
+
+    if (diags->count == diags->capacity) {
+        size_t new_capacity;
+        pr_manifest_cache_diag_t *grown;
+
+        new_capacity = (diags->capacity == 0u) ? 8u : diags->capacity * 2u;
+        grown = (pr_manifest_cache_diag_t *)realloc(
+            diags->items,
+            new_capacity * sizeof(diags->items[0])
+        );
+        if (grown == NULL) {
+            diags->failed = 1;
+            return;
+        }
+        diags->items = grown;
+        diags->capacity = new_capacity;
+    }
+
+    item = &diags->items[diags->count];
+    item->severity = severity;
+    item->line = line;
+    item->column = column;
+    if (file != NULL && diags->root_path != NULL && strcmp(file, diags->root_path) == 0) {
+        file = NULL;
+    }
+    if (
+        !pr_manifest_cache_intern_optional(&diags->strings, file, &item->file) ||
+        !pr_manifest_cache_intern_optional(&diags->strings, message, &item->message) ||
+        !pr_manifest_cache_intern_optional(&diags->strings, code, &item->code) ||
+        !pr_manifest_cache_intern_optional(&diags->strings, asset_id, &item->asset_id)
+    ) {
+        diags->failed = 1;
+        return;
+    }
+    diags->count += 1u;
+}
+
+char *pr_manifest_cache_path(const char *manifest_path)
+{
+    static const char suffix[] = ".prmc";
+    size_t length;
+    char *path;
+
+    if (manifest_path == NULL) {
+        return NULL;
+    }
+
+    length = strlen(manifest_path);
+    path = (char *)malloc(length + sizeof(suffix));
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, manifest_path, length);
+    memcpy(path + length, suffix, sizeof(suffix));
+    return path;
+}
+
+uint64_t pr_manifest_cache_hash(const void *bytes, size_t size)
+{
+    const unsigned char *cursor;
+    uint64_t hash;
+    size_t i;
+
+    cursor = (const unsigned char *)bytes;
+    hash = 14695981039346656037ull;
+    for (i = 0u; i < size; ++i) {
+        hash ^= (uint64_t)cursor[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static size_t pr_manifest_cache_align8(size_t value)
+{
+    return (value + 7u) & ~(size_t)7u;
+}
+
+static uint32_t pr_manifest_cache_get_u32(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] |
+        ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) |
+        ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t pr_manifest_cache_get_u64(const uint8_t *bytes)
+{
+    return (uint64_t)pr_manifest_cache_get_u32(bytes) |
+        ((uint64_t)pr_manifest_cache_get_u32(bytes + 4) << 32);
+}
+
+static int pr_manifest_cache_get_int(const uint8_t *bytes)
+{
+    uint32_t value;
+
+    value = pr_manifest_cache_get_u32(bytes);
+    if (value <= 0x7FFFFFFFu) {
+        return (int)value;
+    }
+    return -(int)(~value) - 1;
+}
+
+static double pr_manifest_cache_get_f64(const uint8_t *bytes)
+{
+    uint64_t bits;
+    double value;
+
+    bits = pr_manifest_cache_get_u64(bytes);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void pr_manifest_cache_put_u32(pr_manifest_cache_writer_t *writer, uint32_t value)
+{
+    uint8_t *bytes;
+
+    bytes = writer->bytes + writer->cursor;
+    bytes[0] = (uint8_t)(value & 0xFFu);
+    bytes[1] = (uint8_t)((value >> 8) & 0xFFu);
+    bytes[2] = (uint8_t)((value >> 16) & 0xFFu);
+    bytes[3] = (uint8_t)((value >> 24) & 0xFFu);
+    writer->cursor += 4u;
+}
+
+static void pr_manifest_cache_put_u64(pr_manifest_cache_writer_t *writer, uint64_t value)
+{
+    pr_manifest_cache_put_u32(writer, (uint32_t)(value & 0xFFFFFFFFu));
+    pr_manifest_cache_put_u32(writer, (uint32_t)(value >> 32));
+}
+
+static void pr_manifest_cache_put_int(pr_manifest_cache_writer_t *writer, int value)
+{
+    pr_manifest_cache_put_u32(writer, (uint32_t)value);
+}
+
+static void pr_manifest_cache_put_f64(pr_manifest_cache_writer_t *writer, double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    pr_manifest_cache_put_u64(writer, bits);
+}
+
+static void pr_manifest_cache_put_bytes(
+    pr_manifest_cache_writer_t *writer,
+    const void *bytes,
+    size_t size
+)
+{
+    if (size > 0u) {
+        memcpy(writer->bytes + writer->cursor, bytes, size);
+    }
+    writer->cursor += size;
+}
+
+static void pr_manifest_cache_put_pool(
+    pr_manifest_cache_writer_t *writer,
+    const pr_intern_pool_t *pool
+)
+{
+    size_t i;
+
+    for (i = 0u; i < pool->count; ++i) {
+        pr_manifest_cache_put_u32(writer, pool->offsets[i]);
+    }
+    pr_manifest_cache_put_bytes(writer, pool->bytes, pool->byte_count);
+}
+
+static int pr_manifest_cache_get_pool(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *section,
+    pr_intern_pool_t *pool
+)
+{
+    const char *blob;
+    size_t blob_size;
+    size_t i;
+
+    if ((uint64_t)section->count * 4u > section->size) {
+        return 0;
+    }
+    blob = (const char *)(bytes + section->offset + (size_t)section->count * 4u);
+    blob_size = (size_t)section->size - (size_t)section->count * 4u;
+
+    if (!pr_intern_pool_reserve(pool, section->count, blob_size)) {
+        return 0;
+    }
+    for (i = 0u; i < section->count; ++i) {
+        const char *terminator;
+        uint32_t offset;
+        uint32_t handle;
+
+        offset = pr_manifest_cache_get_u32(bytes + section->offset + i * 4u);
+        if ((size_t)offset >= blob_size) {
+            return 0;
+        }
+        terminator = (const char *)memchr(blob + offset, '\0', blob_size - offset);
+        if (
+            terminator == NULL ||
+            !pr_intern_pool_add_n(pool, blob + offset, (size_t)(terminator - (blob + offset)), &handle) ||
+            handle != (uint32_t)i
+        ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int pr_manifest_cache_valid_handle(uint32_t handle, size_t string_count)
+{
+    return handle == PR_INTERN_INVALID_HANDLE || (size_t)handle < string_count;
+}
+
+static uint32_t pr_manifest_cache_image_flags(const pr_manifest_image_t *image)
+{
+    return (uint32_t)image->has_id |
+        ((uint32_t)image->has_path << 1) |
+        ((uint32_t)image->premultiply_alpha << 2) |
+        ((uint32_t)image->has_premultiply_alpha << 3) |
+        ((uint32_t)image->has_color_space << 4);
+}
+
+static uint32_t pr_manifest_cache_sprite_flags(const pr_manifest_sprite_t *sprite)
+{
+    return (uint32_t)sprite->has_id |
+        ((uint32_t)sprite->has_source << 1) |
+        ((uint32_t)sprite->has_mode << 2) |
+        ((uint32_t)sprite->has_pivot_x << 3) |
+        ((uint32_t)sprite->has_pivot_y << 4) |
+        ((uint32_t)sprite->has_x << 5) |
+        ((uint32_t)sprite->has_y << 6) |
+        ((uint32_t)sprite->has_w << 7) |
+        ((uint32_t)sprite->has_h << 8) |
+        ((uint32_t)sprite->has_cell_w << 9) |
+        ((uint32_t)sprite->has_cell_h << 10) |
+        ((uint32_t)sprite->has_frame_start << 11) |
+        ((uint32_t)sprite->has_frame_count << 12) |
+        ((uint32_t)sprite->has_margin_x << 13) |
+        ((uint32_t)sprite->has_margin_y << 14) |
+        ((uint32_t)sprite->has_spacing_x << 15) |
+        ((uint32_t)sprite->has_spacing_y << 16);
+}
+
+static uint32_t pr_manifest_cache_rect_flags(const pr_manifest_sprite_rect_t *rect)
+{
+    return (uint32_t)rect->has_x |
+        ((uint32_t)rect->has_y << 1) |
+        ((uint32_t)rect->has_w << 2) |
+        ((uint32_t)rect->has_h << 3) |
+        ((uint32_t)rect->has_label << 4);
+}
+
+static uint32_t pr_manifest_cache_animation_flags(const pr_manifest_animation_t *animation)
+{
+    return (uint32_t)animation->has_id |
+        ((uint32_t)animation->has_sprite << 1) |
+        ((uint32_t)animation->has_loop_mode << 2) |
+        ((uint32_t)animation->has_frames << 3);
+}
+
+static uint32_t pr_manifest_cache_frame_flags(const pr_manifest_animation_frame_t *frame)
+{
+    return (uint32_t)frame->has_index | ((uint32_t)frame->has_ms << 1);
+}
+
+static uint32_t pr_manifest_cache_root_flags(const pr_manifest_t *manifest)
+{
+    return (uint32_t)manifest->has_schema_version |
+        ((uint32_t)manifest->has_package_name << 1) |
+        ((uint32_t)manifest->has_output << 2) |
+        ((uint32_t)manifest->has_debug_output << 3) |
+        ((uint32_t)manifest->has_pretty_debug_json << 4);
+}
+
+static uint32_t pr_manifest_cache_atlas_flags(const pr_manifest_atlas_t *atlas)
+{
+    return (uint32_t)atlas->has_max_page_width |
+        ((uint32_t)atlas->has_max_page_height << 1) |
+        ((uint32_t)atlas->has_padding << 2) |
+        ((uint32_t)atlas->has_power_of_two << 3) |
+        ((uint32_t)atlas->has_sampling << 4) |
+        ((uint32_t)atlas->has_format << 5) |
+        ((uint32_t)atlas->has_encode_quality << 6) |
+        ((uint32_t)atlas->has_compression << 7) |
+        ((uint32_t)atlas->has_tile_size << 8) |
+        ((uint32_t)atlas->has_mipmaps << 9) |
+        ((uint32_t)atlas->has_extrude << 10) |
+        ((uint32_t)atlas->has_bleed_alpha << 11) |
+        ((uint32_t)atlas->has_dither << 12) |
+        ((uint32_t)atlas->has_layout << 13) |
+        ((uint32_t)atlas->has_incremental << 14) |
+        ((uint32_t)atlas->has_repack_threshold << 15);
+}
+
+#define PR_MANIFEST_CACHE_BIT(flags, bit) ((unsigned int)(((flags) >> (bit)) & 1u))
+
+int pr_manifest_cache_write(
+    const char *cache_path,
+    uint64_t source_size,
+    uint64_t source_hash,
+    const pr_manifest_t *manifest,
+    const pr_manifest_cache_diags_t *diags
+)
+{
+    pr_manifest_cache_section_t sections[PR_MANIFEST_CACHE_SECTION_COUNT];
+    pr_manifest_cache_writer_t writer;
+    size_t rect_total;
+    size_t frame_total;
+    size_t rect_first;
+    size_t frame_first;
+    size_t offset;
+    size_t i;
+    FILE *file;
+    int ok;
+
+    if (cache_path == NULL || manifest == NULL || diags == NULL || diags->failed != 0) {
+        return 0;
+    }
+
+    rect_total = 0u;
+    for (i = 0u; i < manifest->sprite_count; ++i) {
+        rect_total += manifest->sprites[i].rect_count;
+    }
+    frame_total = 0u;
+    for (i = 0u; i < manifest->animation_count; ++i) {
+        frame_total += manifest->animations[i].frame_count;
+    }
+    if (
+        manifest->strings.count > (size_t)UINT32_MAX ||
+        manifest->image_count > (size_t)UINT32_MAX ||
+        manifest->sprite_count > (size_t)UINT32_MAX ||
+        manifest->animation_count > (size_t)UINT32_MAX ||
+        manifest->include_count > (size_t)UINT32_MAX ||
+        manifest->source_count > (size_t)UINT32_MAX ||
+        rect_total > (size_t)UINT32_MAX ||
+        frame_total > (size_t)UINT32_MAX
+    ) {
+        return 0;
+    }
+
+    sections[PR_MANIFEST_CACHE_SECTION_ROOT].count = 1u;
+    sections[PR_MANIFEST_CACHE_SECTION_ROOT].size = PR_MANIFEST_CACHE_ROOT_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_STRS].count = (uint32_t)manifest->strings.count;
+    sections[PR_MANIFEST_CACHE_SECTION_STRS].size =
+        (uint64_t)manifest->strings.count * 4u + manifest->strings.byte_count;
+    sections[PR_MANIFEST_CACHE_SECTION_IMGS].count = (uint32_t)manifest->image_count;
+    sections[PR_MANIFEST_CACHE_SECTION_IMGS].size =
+        (uint64_t)manifest->image_count * PR_MANIFEST_CACHE_IMAGE_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_SPRT].count = (uint32_t)manifest->sprite_count;
+    sections[PR_MANIFEST_CACHE_SECTION_SPRT].size =
+        (uint64_t)manifest->sprite_count * PR_MANIFEST_CACHE_SPRITE_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_RECT].count = (uint32_t)rect_total;
+    sections[PR_MANIFEST_CACHE_SECTION_RECT].size =
+        (uint64_t)rect_total * PR_MANIFEST_CACHE_RECT_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_ANIM].count = (uint32_t)manifest->animation_count;
+    sections[PR_MANIFEST_CACHE_SECTION_ANIM].size =
+        (uint64_t)manifest->animation_count * PR_MANIFEST_CACHE_ANIMATION_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_FRMS].count = (uint32_t)frame_total;
+    sections[PR_MANIFEST_CACHE_SECTION_FRMS].size =
+        (uint64_t)frame_total * PR_MANIFEST_CACHE_FRAME_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_INCL].count = (uint32_t)manifest->include_count;
+    sections[PR_MANIFEST_CACHE_SECTION_INCL].size =
+        (uint64_t)manifest->include_count * PR_MANIFEST_CACHE_INCLUDE_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_SRCS].count = (uint32_t)manifest->source_count;
+    sections[PR_MANIFEST_CACHE_SECTION_SRCS].size =
+        (uint64_t)manifest->source_count * PR_MANIFEST_CACHE_SOURCE_SIZE;
+    sections[PR_MANIFEST_CACHE_SECTION_DSTR].count = (uint32_t)diags->strings.count;
+    sections[PR_MANIFEST_CACHE_SECTION_DSTR].size =
+        (uint64_t)diags->strings.count * 4u + diags->strings.byte_count;
+    sections[PR_MANIFEST_CACHE_SECTION_DIAG].count = (uint32_t)diags->count;
+    sections[PR_MANIFEST_CACHE_SECTION_DIAG].size =
+        (uint64_t)diags->count * PR_MANIFEST_CACHE_DIAG_SIZE;
+
+    offset = PR_MANIFEST_CACHE_HEADER_SIZE +
+        PR_MANIFEST_CACHE_SECTION_COUNT * PR_MANIFEST_CACHE_SECTION_SIZE;
+    for (i = 0u; i < PR_MANIFEST_CACHE_SECTION_COUNT; ++i) {
+        offset = pr_manifest_cache_align8(offset);
+        sections[i].offset = offset;
+        offset += (size_t)sections[i].size;
+    }
+
+    writer.bytes = (uint8_t *)calloc(offset, 1u);
+    writer.cursor = 0u;
+    if (writer.bytes == NULL) {
+        return 0;
+    }
+
+    pr_manifest_cache_put_bytes(&writer, "PRMC", 4u);
+    pr_manifest_cache_put_u32(
+        &writer,
+        PR_MANIFEST_CACHE_VERSION_MAJOR | (PR_MANIFEST_CACHE_VERSION_MINOR << 16)
+    );
+    pr_manifest_cache_put_u32(&writer, PR_MANIFEST_CACHE_HEADER_SIZE);
+    pr_manifest_cache_put_u32(&writer, PR_MANIFEST_CACHE_SECTION_COUNT);
+    pr_manifest_cache_put_u64(&writer, source_size);
+    pr_manifest_cache_put_u64(&writer, source_hash);
+    pr_manifest_cache_put_u64(&writer, PR_MANIFEST_CACHE_HEADER_SIZE);
+    pr_manifest_cache_put_u64(&writer, (uint64_t)offset);
+
+    writer.cursor = PR_MANIFEST_CACHE_HEADER_SIZE;
+    for (i = 0u; i < PR_MANIFEST_CACHE_SECTION_COUNT; ++i) {
+        pr_manifest_cache_put_u32(&writer, PR_MANIFEST_CACHE_SECTION_TAGS[i]);
+        pr_manifest_cache_put_u32(&writer, sections[i].count);
+        pr_manifest_cache_put_u64(&writer, sections[i].offset);
+        pr_manifest_cache_put_u64(&writer, sections[i].size);
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_ROOT].offset;
+    pr_manifest_cache_put_int(&writer, manifest->schema_version);
+    pr_manifest_cache_put_u32(&writer, manifest->package_name);
+    pr_manifest_cache_put_u32(&writer, manifest->output);
+    pr_manifest_cache_put_u32(&writer, manifest->debug_output);
+    pr_manifest_cache_put_int(&writer, manifest->pretty_debug_json);
+    pr_manifest_cache_put_u32(&writer, pr_manifest_cache_root_flags(manifest));
+    pr_manifest_cache_put_int(&writer, manifest->atlas.max_page_width);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.max_page_height);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.padding);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.power_of_two);
+    pr_manifest_cache_put_u32(&writer, manifest->atlas.sampling);
+    pr_manifest_cache_put_u32(&writer, pr_manifest_cache_atlas_flags(&manifest->atlas));
+    pr_manifest_cache_put_int(&writer, manifest->include_line);
+    pr_manifest_cache_put_u32(&writer, manifest->atlas.format);
+    pr_manifest_cache_put_u32(&writer, manifest->atlas.encode_quality);
+    pr_manifest_cache_put_u32(&writer, manifest->atlas.compression);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.tile_size);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.mipmaps);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.extrude);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.bleed_alpha);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.dither);
+    pr_manifest_cache_put_u32(&writer, manifest->atlas.layout);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.incremental);
+    pr_manifest_cache_put_int(&writer, manifest->atlas.repack_threshold);
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_STRS].offset;
+    pr_manifest_cache_put_pool(&writer, &manifest->strings);
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_IMGS].offset;
+    for (i = 0u; i < manifest->image_count; ++i) {
+        const pr_manifest_image_t *image;
+
+        image = &manifest->images[i];
+        pr_manifest_cache_put_u32(&writer, image->file);
+        pr_manifest_cache_put_u32(&writer, image->id);
+        pr_manifest_cache_put_u32(&writer, image->path);
+        pr_manifest_cache_put_u32(&writer, image->color_space);
+        pr_manifest_cache_put_int(&writer, image->line);
+        pr_manifest_cache_put_u32(&writer, pr_manifest_cache_image_flags(image));
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_SPRT].offset;
+    rect_first = 0u;
+    for (i = 0u; i < manifest->sprite_count; ++i) {
+        const pr_manifest_sprite_t *sprite;
+
+        sprite = &manifest->sprites[i];
+        pr_manifest_cache_put_f64(&writer, sprite->pivot_x);
+        pr_manifest_cache_put_f64(&writer, sprite->pivot_y);
+        pr_manifest_cache_put_u32(&writer, sprite->id);
+        pr_manifest_cache_put_u32(&writer, sprite->source);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)sprite->mode);
+        pr_manifest_cache_put_int(&writer, sprite->x);
+        pr_manifest_cache_put_int(&writer, sprite->y);
+        pr_manifest_cache_put_int(&writer, sprite->w);
+        pr_manifest_cache_put_int(&writer, sprite->h);
+        pr_manifest_cache_put_int(&writer, sprite->cell_w);
+        pr_manifest_cache_put_int(&writer, sprite->cell_h);
+        pr_manifest_cache_put_int(&writer, sprite->frame_start);
+        pr_manifest_cache_put_int(&writer, sprite->frame_count);
+        pr_manifest_cache_put_int(&writer, sprite->margin_x);
+        pr_manifest_cache_put_int(&writer, sprite->margin_y);
+        pr_manifest_cache_put_int(&writer, sprite->spacing_x);
+        pr_manifest_cache_put_int(&writer, sprite->spacing_y);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)rect_first);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)sprite->rect_count);
+        pr_manifest_cache_put_int(&writer, sprite->line);
+        pr_manifest_cache_put_u32(&writer, pr_manifest_cache_sprite_flags(sprite));
+        pr_manifest_cache_put_u32(&writer, sprite->file);
+        rect_first += sprite->rect_count;
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_RECT].offset;
+    for (i = 0u; i < manifest->sprite_count; ++i) {
+        size_t r;
+
+        for (r = 0u; r < manifest->sprites[i].rect_count; ++r) {
+            const pr_manifest_sprite_rect_t *rect;
+
+            rect = &manifest->sprites[i].rects[r];
+            pr_manifest_cache_put_int(&writer, rect->x);
+            pr_manifest_cache_put_int(&writer, rect->y);
+            pr_manifest_cache_put_int(&writer, rect->w);
+            pr_manifest_cache_put_int(&writer, rect->h);
+            pr_manifest_cache_put_u32(&writer, rect->label);
+            pr_manifest_cache_put_int(&writer, rect->line);
+            pr_manifest_cache_put_u32(&writer, pr_manifest_cache_rect_flags(rect));
+        }
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_ANIM].offset;
+    frame_first = 0u;
+    for (i = 0u; i < manifest->animation_count; ++i) {
+        const pr_manifest_animation_t *animation;
+
+        animation = &manifest->animations[i];
+        pr_manifest_cache_put_u32(&writer, animation->file);
+        pr_manifest_cache_put_u32(&writer, animation->id);
+        pr_manifest_cache_put_u32(&writer, animation->sprite);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)animation->loop_mode);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)frame_first);
+        pr_manifest_cache_put_u32(&writer, (uint32_t)animation->frame_count);
+        pr_manifest_cache_put_int(&writer, animation->line);
+        pr_manifest_cache_put_u32(&writer, pr_manifest_cache_animation_flags(animation));
+        frame_first += animation->frame_count;
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_FRMS].offset;
+    for (i = 0u; i < manifest->animation_count; ++i) {
+        size_t f;
+
+        for (f = 0u; f < manifest->animations[i].frame_count; ++f) {
+            const pr_manifest_animation_frame_t *frame;
+
+            frame = &manifest->animations[i].frames[f];
+            pr_manifest_cache_put_int(&writer, frame->index);
+            pr_manifest_cache_put_int(&writer, frame->ms);
+            pr_manifest_cache_put_int(&writer, frame->line);
+            pr_manifest_cache_put_u32(&writer, pr_manifest_cache_frame_flags(frame));
+        }
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_INCL].offset;
+    for (i = 0u; i < manifest->include_count; ++i) {
+        pr_manifest_cache_put_u32(&writer, manifest->includes[i]);
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_SRCS].offset;
+    for (i = 0u; i < manifest->source_count; ++i) {
+        pr_manifest_cache_put_u32(&writer, manifest->sources[i].path);
+        pr_manifest_cache_put_u32(&writer, 0u);
+        pr_manifest_cache_put_u64(&writer, manifest->sources[i].size);
+        pr_manifest_cache_put_u64(&writer, manifest->sources[i].hash);
+    }
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_DSTR].offset;
+    pr_manifest_cache_put_pool(&writer, &diags->strings);
+
+    writer.cursor = (size_t)sections[PR_MANIFEST_CACHE_SECTION_DIAG].offset;
+    for (i = 0u; i < diags->count; ++i) {
+        const pr_manifest_cache_diag_t *item;
+
+        item = &diags->items[i];
+        pr_manifest_cache_put_u32(&writer, (uint32_t)item->severity);
+        pr_manifest_cache_put_u32(&writer, item->file);
+        pr_manifest_cache_put_int(&writer, item->line);
+        pr_manifest_cache_put_int(&writer, item->column);
+        pr_manifest_cache_put_u32(&writer, item->message);
+        pr_manifest_cache_put_u32(&writer, item->code);
+        pr_manifest_cache_put_u32(&writer, item->asset_id);
+    }
+
+    file = fopen(cache_path, "wb");
+    if (file == NULL) {
+        free(writer.bytes);
+        return 0;
+    }
+    ok = fwrite(writer.bytes, 1u, offset, file) == offset;
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        (void)remove(cache_path);
+    }
+    free(writer.bytes);
+    return ok;
+}
+
+static uint8_t *pr_manifest_cache_read_file(const char *path, size_t *out_size)
+{
+    FILE *file;
+    long file_size;
+    uint8_t *bytes;
+
+    *out_size = 0u;
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    file_size = ftell(file);
+    if (file_size < (long)PR_MANIFEST_CACHE_HEADER_SIZE || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    bytes = (uint8_t *)malloc((size_t)file_size);
+    if (bytes == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    if (fread(bytes, 1u, (size_t)file_size, file) != (size_t)file_size) {
+        free(bytes);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    *out_size = (size_t)file_size;
+    return bytes;
+}
+
+static int pr_manifest_cache_read_sections(
+    const uint8_t *bytes,
+    size_t size,
+    uint64_t source_size,
+    uint64_t source_hash,
+    pr_manifest_cache_section_t *sections
+)
+{
+    static const uint32_t record_sizes[PR_MANIFEST_CACHE_SECTION_COUNT] = {
+        PR_MANIFEST_CACHE_ROOT_SIZE,
+        0u,
+        PR_MANIFEST_CACHE_IMAGE_SIZE,
+        PR_MANIFEST_CACHE_SPRITE_SIZE,
+        PR_MANIFEST_CACHE_RECT_SIZE,
+        PR_MANIFEST_CACHE_ANIMATION_SIZE,
+        PR_MANIFEST_CACHE_FRAME_SIZE,
+        PR_MANIFEST_CACHE_INCLUDE_SIZE,
+        PR_MANIFEST_CACHE_SOURCE_SIZE,
+        0u,
+        PR_MANIFEST_CACHE_DIAG_SIZE
+    };
+    uint64_t table_offset;
+    size_t i;
+
+    if (
+        memcmp(bytes, "PRMC", 4u) != 0 ||
+        pr_manifest_cache_get_u32(bytes + 4) !=
+            (PR_MANIFEST_CACHE_VERSION_MAJOR | (PR_MANIFEST_CACHE_VERSION_MINOR << 16)) ||
+        pr_manifest_cache_get_u32(bytes + 8) != PR_MANIFEST_CACHE_HEADER_SIZE ||
+        pr_manifest_cache_get_u32(bytes + 12) != PR_MANIFEST_CACHE_SECTION_COUNT ||
+        pr_manifest_cache_get_u64(bytes + 16) != source_size ||
+        pr_manifest_cache_get_u64(bytes + 24) != source_hash ||
+        pr_manifest_cache_get_u64(bytes + 40) != (uint64_t)size
+    ) {
+        return 0;
+    }
+
+    table_offset = pr_manifest_cache_get_u64(bytes + 32);
+    if (
+        table_offset > (uint64_t)size ||
+        (uint64_t)size - table_offset <
+            (uint64_t)PR_MANIFEST_CACHE_SECTION_COUNT * PR_MANIFEST_CACHE_SECTION_SIZE
+    ) {
+        return 0;
+    }
+
+    for (i = 0u; i < PR_MANIFEST_CACHE_SECTION_COUNT; ++i) {
+        const uint8_t *entry;
+
+        entry = bytes + (size_t)table_offset + i * PR_MANIFEST_CACHE_SECTION_SIZE;
+        if (pr_manifest_cache_get_u32(entry) != PR_MANIFEST_CACHE_SECTION_TAGS[i]) {
+            return 0;
+        }
+        sections[i].count = pr_manifest_cache_get_u32(entry + 4);
+        sections[i].offset = pr_manifest_cache_get_u64(entry + 8);
+        sections[i].size = pr_manifest_cache_get_u64(entry + 16);
+        if (
+            sections[i].offset > (uint64_t)size ||
+            sections[i].size > (uint64_t)size - sections[i].offset ||
+            (sections[i].offset & 7u) != 0u
+        ) {
+            return 0;
+        }
+        if (
+            record_sizes[i] != 0u &&
+            sections[i].size != (uint64_t)sections[i].count * record_sizes[i]
+        ) {
+            return 0;
+        }
+    }
+
+    return sections[PR_MANIFEST_CACHE_SECTION_ROOT].count == 1u;
+}
+
+static int pr_manifest_cache_load_includes(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *include_section,
+    const pr_manifest_cache_section_t *source_section,
+    pr_manifest_t *manifest
+)
+{
+    size_t i;
+
+    if (include_section->count > 0u) {
+        manifest->includes = (uint32_t *)calloc(
+            include_section->count,
+            sizeof(manifest->includes[0])
+        );
+        if (manifest->includes == NULL) {
+            return 0;
+        }
+        manifest->include_capacity = include_section->count;
+    }
+    for (i = 0u; i < include_section->count; ++i) {
+        uint32_t pattern;
+
+        pattern = pr_manifest_cache_get_u32(
+            bytes + include_section->offset + i * PR_MANIFEST_CACHE_INCLUDE_SIZE
+        );
+        if ((size_t)pattern >= manifest->strings.count) {
+            return 0;
+        }
+        manifest->includes[manifest->include_count++] = pattern;
+    }
+
+    if (source_section->count > 0u) {
+        manifest->sources = (pr_manifest_source_t *)calloc(
+            source_section->count,
+            sizeof(manifest->sources[0])
+        );
+        if (manifest->sources == NULL) {
+            return 0;
+        }
+        manifest->source_capacity = source_section->count;
+    }
+    for (i = 0u; i < source_section->count; ++i) {
+        const uint8_t *record;
+        pr_manifest_source_t *source;
+
+        record = bytes + source_section->offset + i * PR_MANIFEST_CACHE_SOURCE_SIZE;
+        source = &manifest->sources[manifest->source_count++];
+        source->path = pr_manifest_cache_get_u32(record);
+        source->size = pr_manifest_cache_get_u64(record + 8);
+        source->hash = pr_manifest_cache_get_u64(record + 16);
+        if ((size_t)source->path >= manifest->strings.count) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int pr_manifest_cache_load_images(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *section,
+    pr_manifest_t *manifest
+)
+{
+    size_t i;
+
+    if (section->count == 0u) {
+        return 1;
+    }
+    manifest->images = (pr_manifest_image_t *)calloc(section->count, sizeof(manifest->images[0]));
+    if (manifest->images == NULL) {
+        return 0;
+    }
+    manifest->image_capacity = section->count;
+
+    for (i = 0u; i < section->count; ++i) {
+        const uint8_t *record;
+        pr_manifest_image_t *image;
+        uint32_t flags;
+
+        record = bytes + section->offset + i * PR_MANIFEST_CACHE_IMAGE_SIZE;
+        image = &manifest->images[i];
+        image->file = pr_manifest_cache_get_u32(record);
+        image->id = pr_manifest_cache_get_u32(record + 4);
+        image->path = pr_manifest_cache_get_u32(record + 8);
+        image->color_space = pr_manifest_cache_get_u32(record + 12);
+        image->line = pr_manifest_cache_get_int(record + 16);
+        flags = pr_manifest_cache_get_u32(record + 20);
+        image->has_id = PR_MANIFEST_CACHE_BIT(flags, 0);
+        image->has_path = PR_MANIFEST_CACHE_BIT(flags, 1);
+        image->premultiply_alpha = PR_MANIFEST_CACHE_BIT(flags, 2);
+        image->has_premultiply_alpha = PR_MANIFEST_CACHE_BIT(flags, 3);
+        image->has_color_space = PR_MANIFEST_CACHE_BIT(flags, 4);
+        manifest->image_count += 1u;
+
+        if (
+            !pr_manifest_cache_valid_handle(image->file, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(image->id, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(image->path, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(image->color_space, manifest->strings.count)
+        ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int pr_manifest_cache_load_sprites(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *section,
+    const pr_manifest_cache_section_t *rect_section,
+    pr_manifest_t *manifest
+)
+{
+    size_t i;
+
+    if (section->count == 0u) {
+        return 1;
+    }
+    manifest->sprites = (pr_manifest_sprite_t *)calloc(section->count, sizeof(manifest->sprites[0]));
+    if (manifest->sprites == NULL) {
+        return 0;
+    }
+    manifest->sprite_capacity = section->count;
+
+    for (i = 0u; i < section->count; ++i) {
+        const uint8_t *record;
+        pr_manifest_sprite_t *sprite;
+        uint32_t mode;
+        uint32_t rect_first;
+        uint32_t rect_count;
+        uint32_t flags;
+        size_t r;
+
+        record = bytes + section->offset + i * PR_MANIFEST_CACHE_SPRITE_SIZE;
+        sprite = &manifest->sprites[i];
+        manifest->sprite_count += 1u;
+
+        sprite->pivot_x = pr_manifest_cache_get_f64(record);
+        sprite->pivot_y = pr_manifest_cache_get_f64(record + 8);
+        sprite->id = pr_manifest_cache_get_u32(record + 16);
+        sprite->source = pr_manifest_cache_get_u32(record + 20);
+        mode = pr_manifest_cache_get_u32(record + 24);
+        sprite->x = pr_manifest_cache_get_int(record + 28);
+        sprite->y = pr_manifest_cache_get_int(record + 32);
+        sprite->w = pr_manifest_cache_get_int(record + 36);
+        sprite->h = pr_manifest_cache_get_int(record + 40);
+        sprite->cell_w = pr_manifest_cache_get_int(record + 44);
+        sprite->cell_h = pr_manifest_cache_get_int(record + 48);
+        sprite->frame_start = pr_manifest_cache_get_int(record + 52);
+        sprite->frame_count = pr_manifest_cache_get_int(record + 56);
+        sprite->margin_x = pr_manifest_cache_get_int(record + 60);
+        sprite->margin_y = pr_manifest_cache_get_int(record + 64);
+        sprite->spacing_x = pr_manifest_cache_get_int(record + 68);
+        sprite->spacing_y = pr_manifest_cache_get_int(record + 72);
+        rect_first = pr_manifest_cache_get_u32(record + 76);
+        rect_count = pr_manifest_cache_get_u32(record + 80);
+        sprite->line = pr_manifest_cache_get_int(record + 84);
+        flags = pr_manifest_cache_get_u32(record + 88);
+        sprite->file = pr_manifest_cache_get_u32(record + 92);
+
+        if (
+            mode > (uint32_t)PR_MANIFEST_SPRITE_MODE_RECTS ||
+            !pr_manifest_cache_valid_handle(sprite->file, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(sprite->id, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(sprite->source, manifest->strings.count) ||
+            rect_first > rect_section->count ||
+            rect_count > rect_section->count - rect_first
+        ) {
+            return 0;
+        }
+        sprite->mode = (pr_manifest_sprite_mode_t)mode;
+        sprite->has_id = PR_MANIFEST_CACHE_BIT(flags, 0);
+        sprite->has_source = PR_MANIFEST_CACHE_BIT(flags, 1);
+        sprite->has_mode = PR_MANIFEST_CACHE_BIT(flags, 2);
+        sprite->has_pivot_x = PR_MANIFEST_CACHE_BIT(flags, 3);
+        sprite->has_pivot_y = PR_MANIFEST_CACHE_BIT(flags, 4);
+        sprite->has_x = PR_MANIFEST_CACHE_BIT(flags, 5);
+        sprite->has_y = PR_MANIFEST_CACHE_BIT(flags, 6);
+        sprite->has_w = PR_MANIFEST_CACHE_BIT(flags, 7);
+        sprite->has_h = PR_MANIFEST_CACHE_BIT(flags, 8);
+        sprite->has_cell_w = PR_MANIFEST_CACHE_BIT(flags, 9);
+        sprite->has_cell_h = PR_MANIFEST_CACHE_BIT(flags, 10);
+        sprite->has_frame_start = PR_MANIFEST_CACHE_BIT(flags, 11);
+        sprite->has_frame_count = PR_MANIFEST_CACHE_BIT(flags, 12);
+        sprite->has_margin_x = PR_MANIFEST_CACHE_BIT(flags, 13);
+        sprite->has_margin_y = PR_MANIFEST_CACHE_BIT(flags, 14);
+        sprite->has_spacing_x = PR_MANIFEST_CACHE_BIT(flags, 15);
+        sprite->has_spacing_y = PR_MANIFEST_CACHE_BIT(flags, 16);
+
+        if (rect_count == 0u) {
+            continue;
+        }
+        sprite->rects = (pr_manifest_sprite_rect_t *)calloc(rect_count, sizeof(sprite->rects[0]));
+        if (sprite->rects == NULL) {
+            return 0;
+        }
+        sprite->rect_capacity = rect_count;
+        sprite->rect_count = rect_count;
+
+        for (r = 0u; r < rect_count; ++r) {
+            const uint8_t *rect_record;
+            pr_manifest_sprite_rect_t *rect;
+            uint32_t rect_flags;
+
+            rect_record = bytes + rect_section->offset +
+                ((size_t)rect_first + r) * PR_MANIFEST_CACHE_RECT_SIZE;
+            rect = &sprite->rects[r];
+            rect->x = pr_manifest_cache_get_int(rect_record);
+            rect->y = pr_manifest_cache_get_int(rect_record + 4);
+            rect->w = pr_manifest_cache_get_int(rect_record + 8);
+            rect->h = pr_manifest_cache_get_int(rect_record + 12);
+            rect->label = pr_manifest_cache_get_u32(rect_record + 16);
+            rect->line = pr_manifest_cache_get_int(rect_record + 20);
+            rect_flags = pr_manifest_cache_get_u32(rect_record + 24);
+            rect->has_x = PR_MANIFEST_CACHE_BIT(rect_flags, 0);
+            rect->has_y = PR_MANIFEST_CACHE_BIT(rect_flags, 1);
+            rect->has_w = PR_MANIFEST_CACHE_BIT(rect_flags, 2);
+            rect->has_h = PR_MANIFEST_CACHE_BIT(rect_flags, 3);
+            rect->has_label = PR_MANIFEST_CACHE_BIT(rect_flags, 4);
+            if (!pr_manifest_cache_valid_handle(rect->label, manifest->strings.count)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int pr_manifest_cache_load_animations(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *section,
+    const pr_manifest_cache_section_t *frame_section,
+    pr_manifest_t *manifest
+)
+{
+    size_t i;
+
+    if (section->count == 0u) {
+        return 1;
+    }
+    manifest->animations = (pr_manifest_animation_t *)calloc(
+        section->count,
+        sizeof(manifest->animations[0])
+    );
+    if (manifest->animations == NULL) {
+        return 0;
+    }
+    manifest->animation_capacity = section->count;
+
+    for (i = 0u; i < section->count; ++i) {
+        const uint8_t *record;
+        pr_manifest_animation_t *animation;
+        uint32_t loop_mode;
+        uint32_t frame_first;
+        uint32_t frame_count;
+        uint32_t flags;
+        size_t f;
+
+        record = bytes + section->offset + i * PR_MANIFEST_CACHE_ANIMATION_SIZE;
+        animation = &manifest->animations[i];
+        manifest->animation_count += 1u;
+
+        animation->file = pr_manifest_cache_get_u32(record);
+        animation->id = pr_manifest_cache_get_u32(record + 4);
+        animation->sprite = pr_manifest_cache_get_u32(record + 8);
+        loop_mode = pr_manifest_cache_get_u32(record + 12);
+        frame_first = pr_manifest_cache_get_u32(record + 16);
+        frame_count = pr_manifest_cache_get_u32(record + 20);
+        animation->line = pr_manifest_cache_get_int(record + 24);
+        flags = pr_manifest_cache_get_u32(record + 28);
+
+        if (
+            loop_mode > (uint32_t)PR_LOOP_PING_PONG ||
+            !pr_manifest_cache_valid_handle(animation->file, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(animation->id, manifest->strings.count) ||
+            !pr_manifest_cache_valid_handle(animation->sprite, manifest->strings.count) ||
+            frame_first > frame_section->count ||
+            frame_count > frame_section->count - frame_first
+        ) {
+            return 0;
+        }
+        animation->loop_mode = (pr_loop_mode_t)loop_mode;
+        animation->has_id = PR_MANIFEST_CACHE_BIT(flags, 0);
+        animation->has_sprite = PR_MANIFEST_CACHE_BIT(flags, 1);
+        animation->has_loop_mode = PR_MANIFEST_CACHE_BIT(flags, 2);
+        animation->has_frames = PR_MANIFEST_CACHE_BIT(flags, 3);
+
+        if (frame_count == 0u) {
+            continue;
+        }
+        animation->frames = (pr_manifest_animation_frame_t *)calloc(
+            frame_count,
+            sizeof(animation->frames[0])
+        );
+        if (animation->frames == NULL) {
+            return 0;
+        }
+        animation->frame_capacity = frame_count;
+        animation->frame_count = frame_count;
+
+        for (f = 0u; f < frame_count; ++f) {
+            const uint8_t *frame_record;
+            pr_manifest_animation_frame_t *frame;
+            uint32_t frame_flags;
+
+            frame_record = bytes + frame_section->offset +
+                ((size_t)frame_first + f) * PR_MANIFEST_CACHE_FRAME_SIZE;
+            frame = &animation->frames[f];
+            frame->index = pr_manifest_cache_get_int(frame_record);
+            frame->ms = pr_manifest_cache_get_int(frame_record + 4);
+            frame->line = pr_manifest_cache_get_int(frame_record + 8);
+            frame_flags = pr_manifest_cache_get_u32(frame_record + 12);
+            frame->has_index = PR_MANIFEST_CACHE_BIT(frame_flags, 0);
+            frame->has_ms = PR_MANIFEST_CACHE_BIT(frame_flags, 1);
+        }
+    }
+    return 1;
+}
+
+static int pr_manifest_cache_load_diags(
+    const uint8_t *bytes,
+    const pr_manifest_cache_section_t *string_section,
+    const pr_manifest_cache_section_t *section,
+    pr_manifest_cache_diags_t *diags
+)
+{
+    size_t i;
+
+    if (!pr_manifest_cache_get_pool(bytes, string_section, &diags->strings)) {
+        return 0;
+    }
+    if (section->count == 0u) {
+        return 1;
+    }
+    diags->items = (pr_manifest_cache_diag_t *)calloc(section->count, sizeof(diags->items[0]));
+    if (diags->items == NULL) {
+        return 0;
+    }
+    diags->capacity = section->count;
+
+    for (i = 0u; i < section->count; ++i) {
+        const uint8_t *record;
+        pr_manifest_cache_diag_t *item;
+        uint32_t severity;
+
+        record = bytes + section->offset + i * PR_MANIFEST_CACHE_DIAG_SIZE;
+        item = &diags->items[i];
+        severity = pr_manifest_cache_get_u32(record);
+        item->file = pr_manifest_cache_get_u32(record + 4);
+        item->line = pr_manifest_cache_get_int(record + 8);
+        item->column = pr_manifest_cache_get_int(record + 12);
+        item->message = pr_manifest_cache_get_u32(record + 16);
+        item->code = pr_manifest_cache_get_u32(record + 20);
+        item->asset_id = pr_manifest_cache_get_u32(record + 24);
+        if (
+            severity > (uint32_t)PR_DIAG_NOTE ||
+            !pr_manifest_cache_valid_handle(item->file, diags->strings.count) ||
+            (size_t)item->message >= diags->strings.count ||
+            !pr_manifest_cache_valid_handle(item->code, diags->strings.count) ||
+            !pr_manifest_cache_valid_handle(item->asset_id, diags->strings.count)
+        ) {
+            return 0;
+        }
+        item->severity = (pr_diag_severity_t)severity;
+        diags->count += 1u;
+    }
+    return 1;
+}
+
+int pr_manifest_cache_load(
+    const char *cache_path,
+    uint64_t source_size,
+    uint64_t source_hash,
+    pr_manifest_t *out_manifest,
+    pr_manifest_cache_diags_t *out_diags
+)
+{
+    pr_manifest_cache_section_t sections[PR_MANIFEST_CACHE_SECTION_COUNT];
+    pr_manifest_t manifest;
+    uint8_t *bytes;
+    const uint8_t *root;
+    uint32_t root_flags;
+    uint32_t atlas_flags;
+    size_t size;
+
+    if (cache_path == NULL || out_manifest == NULL || out_diags == NULL) {
+        return 0;
+    }
+
+    bytes = pr_manifest_cache_read_file(cache_path, &size);
+    if (bytes == NULL) {
+        return 0;
+    }
+    pr_manifest_init(&manifest);
+    if (!pr_manifest_cache_read_sections(bytes, size, source_size, source_hash, sections)) {
+        goto fail;
+    }
+
+    if (
+        !pr_manifest_cache_get_pool(bytes, &sections[PR_MANIFEST_CACHE_SECTION_STRS], &manifest.strings)
+    ) {
+        goto fail;
+    }
+
+    root = bytes + sections[PR_MANIFEST_CACHE_SECTION_ROOT].offset;
+    manifest.schema_version = pr_manifest_cache_get_int(root);
+    manifest.package_name = pr_manifest_cache_get_u32(root + 4);
+    manifest.output = pr_manifest_cache_get_u32(root + 8);
+    manifest.debug_output = pr_manifest_cache_get_u32(root + 12);
+    manifest.pretty_debug_json = pr_manifest_cache_get_int(root + 16);
+    root_flags = pr_manifest_cache_get_u32(root + 20);
+    manifest.atlas.max_page_width = pr_manifest_cache_get_int(root + 24);
+    manifest.atlas.max_page_height = pr_manifest_cache_get_int(root + 28);
+    manifest.atlas.padding = pr_manifest_cache_get_int(root + 32);
+    manifest.atlas.power_of_two = pr_manifest_cache_get_int(root + 36);
+    manifest.atlas.sampling = pr_manifest_cache_get_u32(root + 40);
+    atlas_flags = pr_manifest_cache_get_u32(root + 44);
+    manifest.include_line = pr_manifest_cache_get_int(root + 48);
+    manifest.atlas.format = pr_manifest_cache_get_u32(root + 52);
+    manifest.atlas.encode_quality = pr_manifest_cache_get_u32(root + 56);
+    manifest.atlas.compression = pr_manifest_cache_get_u32(root + 60);
+    manifest.atlas.tile_size = pr_manifest_cache_get_int(root + 64);
+    manifest.atlas.mipmaps = pr_manifest_cache_get_int(root + 68);
+    manifest.atlas.extrude = pr_manifest_cache_get_int(root + 72);
+    manifest.atlas.bleed_alpha = pr_manifest_cache_get_int(root + 76);
+    manifest.atlas.dither = pr_manifest_cache_get_int(root + 80);
+    manifest.atlas.layout = pr_manifest_cache_get_u32(root + 84);
+    manifest.atlas.incremental = pr_manifest_cache_get_int(root + 88);
+    manifest.atlas.repack_threshold = pr_manifest_cache_get_int(root + 92);
+    manifest.has_schema_version = PR_MANIFEST_CACHE_BIT(root_flags, 0);
+    manifest.has_package_name = PR_MANIFEST_CACHE_BIT(root_flags, 1);
+    manifest.has_output = PR_MANIFEST_CACHE_BIT(root_flags, 2);
+    manifest.has_debug_output = PR_MANIFEST_CACHE_BIT(root_flags, 3);
+    manifest.has_pretty_debug_json = PR_MANIFEST_CACHE_BIT(root_flags, 4);
+    manifest.atlas.has_max_page_width = PR_MANIFEST_CACHE_BIT(atlas_flags, 0);
+    manifest.atlas.has_max_page_height = PR_MANIFEST_CACHE_BIT(atlas_flags, 1);
+    manifest.atlas.has_padding = PR_MANIFEST_CACHE_BIT(atlas_flags, 2);
+    manifest.atlas.has_power_of_two = PR_MANIFEST_CACHE_BIT(atlas_flags, 3);
+    manifest.atlas.has_sampling = PR_MANIFEST_CACHE_BIT(atlas_flags, 4);
+    manifest.atlas.has_format = PR_MANIFEST_CACHE_BIT(atlas_flags, 5);
+    manifest.atlas.has_encode_quality = PR_MANIFEST_CACHE_BIT(atlas_flags, 6);
+    manifest.atlas.has_compression = PR_MANIFEST_CACHE_BIT(atlas_flags, 7);
+    manifest.atlas.has_tile_size = PR_MANIFEST_CACHE_BIT(atlas_flags, 8);
+    manifest.atlas.has_mipmaps = PR_MANIFEST_CACHE_BIT(atlas_flags, 9);
+    manifest.atlas.has_extrude = PR_MANIFEST_CACHE_BIT(atlas_flags, 10);
+    manifest.atlas.has_bleed_alpha = PR_MANIFEST_CACHE_BIT(atlas_flags, 11);
+    manifest.atlas.has_dither = PR_MANIFEST_CACHE_BIT(atlas_flags, 12);
+    manifest.atlas.has_layout = PR_MANIFEST_CACHE_BIT(atlas_flags, 13);
+    manifest.atlas.has_incremental = PR_MANIFEST_CACHE_BIT(atlas_flags, 14);
+    manifest.atlas.has_repack_threshold = PR_MANIFEST_CACHE_BIT(atlas_flags, 15);
+    if (
+        !pr_manifest_cache_valid_handle(manifest.package_name, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.output, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.debug_output, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.atlas.sampling, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.atlas.format, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.atlas.encode_quality, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.atlas.compression, manifest.strings.count) ||
+        !pr_manifest_cache_valid_handle(manifest.atlas.layout, manifest.strings.count)
+    ) {
+        goto fail;
+    }
+
+    if (
+        !pr_manifest_cache_load_includes(
+            bytes,
+            &sections[PR_MANIFEST_CACHE_SECTION_INCL],
+            &sections[PR_MANIFEST_CACHE_SECTION_SRCS],
+            &manifest
+        ) ||
+        !pr_manifest_cache_load_images(bytes, &sections[PR_MANIFEST_CACHE_SECTION_IMGS], &manifest) ||
+        !pr_manifest_cache_load_sprites(
+            bytes,
+            &sections[PR_MANIFEST_CACHE_SECTION_SPRT],
+            &sections[PR_MANIFEST_CACHE_SECTION_RECT],
+            &manifest
+        ) ||
+        !pr_manifest_cache_load_animations(
+            bytes,
+            &sections[PR_MANIFEST_CACHE_SECTION_ANIM],
+            &sections[PR_MANIFEST_CACHE_SECTION_FRMS],
+            &manifest
+        ) ||
+        !pr_manifest_cache_load_diags(
+            bytes,
+            &sections[PR_MANIFEST_CACHE_SECTION_DSTR],
+            &sections[PR_MANIFEST_CACHE_SECTION_DIAG],
+            out_diags
+        )
+    ) {
+        goto fail;
+    }
+
+    free(bytes);
+    *out_manifest = manifest;
+    return 1;
+
+fail:
+    free(bytes);
+    pr_manifest_free(&manifest);
+    pr_manifest_cache_diags_free(out_diags);
+    pr_manifest_cache_diags_init(out_diags);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef PACKRAT_MANIFEST_CACHE_H
+#define PACKRAT_MANIFEST_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "intern.h"
+#include "manifest.h"
+
+/* Non-error diagnostics produced while parsing and validating a manifest.
+ * They are stored in the compiled cache so a cache hit reports the same
+ * warnings as a fresh parse.
+ */
+typedef struct pr_manifest_cache_diag {
+    pr_diag_severity_t severity;
+    uint32_t file;
+    int line;
+    int column;
+    uint32_t message;
+    uint32_t code;
+    uint32_t asset_id;
+} pr_manifest_cache_diag_t;
+
+/* Diagnostics reported against `root_path` are stored without a file and
+ * replayed against whatever path the manifest is loaded through next time.
+ */
+typedef struct pr_manifest_cache_diags {
+    const char *root_path;
+    pr_intern_pool_t strings;
+    pr_manifest_cache_diag_t *items;
+    size_t count;
+    size_t capacity;
+    int failed;
+} pr_manifest_cache_diags_t;
+
+void pr_manifest_cache_diags_init(pr_manifest_cache_diags_t *diags);
+void pr_manifest_cache_diags_free(pr_manifest_cache_diags_t *diags);
+void pr_manifest_cache_diags_record(
+    pr_manifest_cache_diags_t *diags,
+    pr_diag_severity_t severity,
+    const char *message,
+    const char *file,
+    int line,
+    int column,
+    const char *code,
+    const char *asset_id
+);
+
+/* Returns a heap-allocated "<manifest_path>.prmc". */
+char *pr_manifest_cache_path(const char *manifest_path);
+uint64_t pr_manifest_cache_hash(const void *bytes, size_t size);
+
+/* Returns 1 and fills `out_manifest`/`out_diags` only when the cache exists,
+ * is well formed, and was compiled from a source with the same size and hash.
+ */
+int pr_manifest_cache_load(
+    const char *cache_path,
+    uint64_t source_size,
+    uint64_t source_hash,
+    pr_manifest_t *out_manifest,
+    pr_manifest_cache_diags_t *out_diags
+);
+
+int pr_manifest_cache_write(
+    const char *cache_path,
+    uint64_t source_size,
+    uint64_t source_hash,
+    const pr_manifest_t *manifest,
+    const pr_manifest_cache_diags_t *diags
+);
+
+#endif
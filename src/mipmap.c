@@ -0,0 +1,107 @@
+#include "mipmap.h"
+
+#include <stddef.h>
+
+#include "color.h"
+
+uint32_t pr_mipmap_level_count(uint32_t width, uint32_t height)
+{
+    uint32_t size;
+    uint32_t count;
+
+    size = (width > height) ? width : height;
+    count = 1u;
+    while (size > 1u) {
+        size >>= 1u;
+        count += 1u;
+    }
+    return count;
+}
+
+void pr_mipmap_level_size(
+    uint32_t width,
+    uint32_t height,
+    uint32_t level,
+    uint32_t *out_width,
+    uint32_t *out_height
+)
+{
+    width = (level < 32u) ? (width >> level) : 0u;
+    height = (level < 32u) ? (height >> level) : 0u;
+    *out_width = (width > 0u) ? width : 1u;
+    *out_height = (height > 0u) ? height : 1u;
+}
+
+static uint32_t pr_mipmap_decode(unsigned char value, pr_color_space_t color_space)
+{
+    return (color_space == PR_COLOR_SPACE_SRGB) ?
+        (uint32_t)PR_COLOR_SRGB_TO_LINEAR[value] : (uint32_t)value * 257u;
+}
+
+static unsigned char pr_mipmap_encode(uint32_t linear, pr_color_space_t color_space)
+{
+    return (color_space == PR_COLOR_SPACE_SRGB) ?
+        pr_color_linear_to_srgb(linear) : (unsigned char)((linear + 128u) / 257u);
+}
+
+void pr_mipmap_downsample(
+    const unsigned char *src,
+    uint32_t src_width,
+    uint32_t src_height,
+    pr_color_space_t color_space,
+    pr_alpha_mode_t alpha_mode,
+    unsigned char *dst
+)
+{
+    uint32_t dst_width;
+    uint32_t dst_height;
+    uint32_t x;
+    uint32_t y;
+
+    pr_mipmap_level_size(src_width, src_height, 1u, &dst_width, &dst_height);
+    for (y = 0u; y < dst_height; ++y) {
+        const unsigned char *rows[2];
+
+        rows[0] = src + (size_t)(y * 2u) * src_width * 4u;
+        rows[1] = src + (size_t)((y * 2u + 1u < src_height) ? y * 2u + 1u : y * 2u) * src_width * 4u;
+        for (x = 0u; x < dst_width; ++x) {
+            const unsigned char *texels[4];
+            uint32_t columns[2];
+            uint32_t alpha_sum;
+            uint32_t channel;
+            uint32_t k;
+            unsigned char *out;
+
+            columns[0] = x * 2u * 4u;
+            columns[1] = ((x * 2u + 1u < src_width) ? x * 2u + 1u : x * 2u) * 4u;
+            texels[0] = rows[0] + columns[0];
+            texels[1] = rows[0] + columns[1];
+            texels[2] = rows[1] + columns[0];
+            texels[3] = rows[1] + columns[1];
+            alpha_sum = 0u;
+            for (k = 0u; k < 4u; ++k) {
+                alpha_sum += texels[k][3];
+            }
+
+            out = dst + ((size_t)y * dst_width + x) * 4u;
+            for (channel = 0u; channel < 3u; ++channel) {
+                uint32_t sum;
+
+                sum = 0u;
+                /* Premultiplied color is already weighted by alpha. */
+                if (alpha_sum > 0u && alpha_mode == PR_ALPHA_MODE_STRAIGHT) {
+                    for (k = 0u; k < 4u; ++k) {
+                        sum += pr_mipmap_decode(texels[k][channel], color_space) * texels[k][3];
+                    }
+                    out[channel] = pr_mipmap_encode((sum + alpha_sum / 2u) / alpha_sum, color_space);
+                } else {
+                    for (k = 0u; k < 4u; ++k) {
+                        sum += pr_mipmap_decode(texels[k][channel], color_space);
+                    }
+                    out[channel] = pr_mipmap_encode((sum + 2u) / 4u, color_space);
+                }
+            }
+            out[3] = (unsigned char)((alpha_sum + 2u) / 4u);
+        }
+    }
+}
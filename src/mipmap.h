@@ -0,0 +1,45 @@
+#ifndef PACKRAT_MIPMAP_H
+#define PACKRAT_MIPMAP_H
+
+#include <stdint.h>
+
+#include "packrat/build.h"
+
+/* Frame cells on mipmapped pages are aligned to this many pixels, so the
+ * first log2(PR_MIPMAP_ALIGN) + 1 levels never mix two frames in one texel.
+ */
+#define PR_MIPMAP_ALIGN 16u
+
+/* Longest possible chain, for a page 2^31 or more texels across. */
+#define PR_MIPMAP_MAX_LEVELS 32u
+
+/* Levels in a full chain down to 1x1, counting the page itself. */
+uint32_t pr_mipmap_level_count(uint32_t width, uint32_t height);
+
+/* Size of `level`: each level halves the one above, rounding down, to at
+ * least 1x1.
+ */
+void pr_mipmap_level_size(
+    uint32_t width,
+    uint32_t height,
+    uint32_t level,
+    uint32_t *out_width,
+    uint32_t *out_height
+);
+
+/* Writes the next level of a tightly packed RGBA8 image to `dst`. Each texel
+ * averages a 2x2 box in linear light (sRGB color is decoded first). Straight
+ * color is weighted by alpha so clear texels do not darken edges;
+ * premultiplied color is averaged as is. Odd trailing rows/columns are
+ * dropped.
+ */
+void pr_mipmap_downsample(
+    const unsigned char *src,
+    uint32_t src_width,
+    uint32_t src_height,
+    pr_color_space_t color_space,
+    pr_alpha_mode_t alpha_mode,
+    unsigned char *dst
+);
+
+#endif
@@ -0,0 +1,339 @@
+#include "pack_lock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PR_PACK_LOCK_VERSION_MAJOR 1u
+#define PR_PACK_LOCK_VERSION_MINOR 0u
+#define PR_PACK_LOCK_HEADER_SIZE 32u
+#define PR_PACK_LOCK_PAGE_SIZE 8u
+#define PR_PACK_LOCK_FRAME_SIZE 28u
+
+static void pr_pack_lock_put_u32(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value & 0xFFu);
+    bytes[1] = (unsigned char)((value >> 8) & 0xFFu);
+    bytes[2] = (unsigned char)((value >> 16) & 0xFFu);
+    bytes[3] = (unsigned char)((value >> 24) & 0xFFu);
+}
+
+static uint32_t pr_pack_lock_get_u32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] |
+        ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) |
+        ((uint32_t)bytes[3] << 24);
+}
+
+static int pr_pack_lock_compare_key(
+    const char *lhs_id,
+    uint32_t lhs_index,
+    const char *rhs_id,
+    uint32_t rhs_index
+)
+{
+    int order;
+
+    order = strcmp(lhs_id, rhs_id);
+    if (order != 0) {
+        return order;
+    }
+    if (lhs_index != rhs_index) {
+        return (lhs_index < rhs_index) ? -1 : 1;
+    }
+    return 0;
+}
+
+static int pr_pack_lock_frame_compare(const void *lhs, const void *rhs)
+{
+    const pr_pack_lock_frame_t *a;
+    const pr_pack_lock_frame_t *b;
+
+    a = (const pr_pack_lock_frame_t *)lhs;
+    b = (const pr_pack_lock_frame_t *)rhs;
+    return pr_pack_lock_compare_key(a->sprite_id, a->local_frame_index, b->sprite_id, b->local_frame_index);
+}
+
+char *pr_pack_lock_path(const char *package_path)
+{
+    static const char suffix[] = ".prlk";
+    size_t length;
+    char *path;
+
+    if (package_path == NULL) {
+        return NULL;
+    }
+
+    length = strlen(package_path);
+    path = (char *)malloc(length + sizeof(suffix));
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, package_path, length);
+    memcpy(path + length, suffix, sizeof(suffix));
+    return path;
+}
+
+static unsigned char *pr_pack_lock_read_file(const char *path, size_t *out_size)
+{
+    FILE *file;
+    long file_size;
+    unsigned char *bytes;
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    file_size = ftell(file);
+    if (file_size < (long)PR_PACK_LOCK_HEADER_SIZE || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    bytes = (unsigned char *)malloc((size_t)file_size);
+    if (bytes == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    if (fread(bytes, 1u, (size_t)file_size, file) != (size_t)file_size) {
+        free(bytes);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *out_size = (size_t)file_size;
+    return bytes;
+}
+
+int pr_pack_lock_read(const char *path, pr_pack_lock_t *out_lock)
+{
+    unsigned char *bytes;
+    size_t size;
+    size_t page_count;
+    size_t frame_count;
+    size_t ids_offset;
+    size_t ids_size;
+    size_t i;
+    pr_pack_lock_t lock;
+
+    if (path == NULL || out_lock == NULL) {
+        return 0;
+    }
+    memset(out_lock, 0, sizeof(*out_lock));
+    bytes = pr_pack_lock_read_file(path, &size);
+    if (bytes == NULL) {
+        return 0;
+    }
+
+    memset(&lock, 0, sizeof(lock));
+    page_count = (size_t)pr_pack_lock_get_u32(bytes + 24);
+    frame_count = (size_t)pr_pack_lock_get_u32(bytes + 28);
+    if (
+        memcmp(bytes, "PRLK", 4u) != 0 ||
+        pr_pack_lock_get_u32(bytes + 4) !=
+            (PR_PACK_LOCK_VERSION_MAJOR | (PR_PACK_LOCK_VERSION_MINOR << 16)) ||
+        page_count > (size - PR_PACK_LOCK_HEADER_SIZE) / PR_PACK_LOCK_PAGE_SIZE ||
+        frame_count > (size - PR_PACK_LOCK_HEADER_SIZE - page_count * PR_PACK_LOCK_PAGE_SIZE) /
+            PR_PACK_LOCK_FRAME_SIZE
+    ) {
+        free(bytes);
+        return 0;
+    }
+    lock.max_page_width = pr_pack_lock_get_u32(bytes + 8);
+    lock.max_page_height = pr_pack_lock_get_u32(bytes + 12);
+    lock.padding = pr_pack_lock_get_u32(bytes + 16);
+    lock.cell = pr_pack_lock_get_u32(bytes + 20);
+    ids_offset = PR_PACK_LOCK_HEADER_SIZE + page_count * PR_PACK_LOCK_PAGE_SIZE +
+        frame_count * PR_PACK_LOCK_FRAME_SIZE;
+    ids_size = size - ids_offset;
+
+    lock.pages = (pr_pack_lock_page_t *)calloc(page_count > 0u ? page_count : 1u, sizeof(lock.pages[0]));
+    lock.frames = (pr_pack_lock_frame_t *)calloc(frame_count > 0u ? frame_count : 1u, sizeof(lock.frames[0]));
+    lock.ids = (char *)malloc(ids_size > 0u ? ids_size : 1u);
+    if (lock.pages == NULL || lock.frames == NULL || lock.ids == NULL) {
+        goto fail;
+    }
+    memcpy(lock.ids, bytes + ids_offset, ids_size);
+    lock.page_count = page_count;
+    lock.frame_count = frame_count;
+
+    for (i = 0u; i < page_count; ++i) {
+        const unsigned char *record;
+        uint32_t color_space;
+        uint32_t alpha_mode;
+
+        record = bytes + PR_PACK_LOCK_HEADER_SIZE + i * PR_PACK_LOCK_PAGE_SIZE;
+        color_space = pr_pack_lock_get_u32(record);
+        alpha_mode = pr_pack_lock_get_u32(record + 4);
+        if (color_space > (uint32_t)PR_COLOR_SPACE_LINEAR || alpha_mode > (uint32_t)PR_ALPHA_MODE_PREMULTIPLIED) {
+            goto fail;
+        }
+        lock.pages[i].color_space = (pr_color_space_t)color_space;
+        lock.pages[i].alpha_mode = (pr_alpha_mode_t)alpha_mode;
+    }
+    for (i = 0u; i < frame_count; ++i) {
+        const unsigned char *record;
+        uint32_t id_offset;
+
+        record = bytes + PR_PACK_LOCK_HEADER_SIZE + page_count * PR_PACK_LOCK_PAGE_SIZE +
+            i * PR_PACK_LOCK_FRAME_SIZE;
+        id_offset = pr_pack_lock_get_u32(record);
+        if ((size_t)id_offset >= ids_size || memchr(lock.ids + id_offset, '\0', ids_size - id_offset) == NULL) {
+            goto fail;
+        }
+        lock.frames[i].sprite_id = lock.ids + id_offset;
+        lock.frames[i].local_frame_index = pr_pack_lock_get_u32(record + 4);
+        lock.frames[i].page = pr_pack_lock_get_u32(record + 8);
+        lock.frames[i].x = pr_pack_lock_get_u32(record + 12);
+        lock.frames[i].y = pr_pack_lock_get_u32(record + 16);
+        lock.frames[i].w = pr_pack_lock_get_u32(record + 20);
+        lock.frames[i].h = pr_pack_lock_get_u32(record + 24);
+        if (lock.frames[i].page >= page_count) {
+            goto fail;
+        }
+    }
+    free(bytes);
+
+    qsort(lock.frames, frame_count, sizeof(lock.frames[0]), pr_pack_lock_frame_compare);
+    *out_lock = lock;
+    return 1;
+
+fail:
+    free(bytes);
+    pr_pack_lock_free(&lock);
+    return 0;
+}
+
+int pr_pack_lock_write(const char *path, const pr_pack_lock_t *lock)
+{
+    FILE *file;
+    unsigned char *bytes;
+    unsigned char *cursor;
+    size_t ids_size;
+    size_t size;
+    size_t i;
+    uint32_t id_offset;
+    int ok;
+
+    if (path == NULL || lock == NULL) {
+        return 0;
+    }
+
+    ids_size = 0u;
+    for (i = 0u; i < lock->frame_count; ++i) {
+        ids_size += strlen(lock->frames[i].sprite_id) + 1u;
+    }
+    size = PR_PACK_LOCK_HEADER_SIZE + lock->page_count * PR_PACK_LOCK_PAGE_SIZE +
+        lock->frame_count * PR_PACK_LOCK_FRAME_SIZE + ids_size;
+    if (ids_size > 0xFFFFFFFFu) {
+        return 0;
+    }
+    bytes = (unsigned char *)malloc(size);
+    if (bytes == NULL) {
+        return 0;
+    }
+
+    memcpy(bytes, "PRLK", 4u);
+    pr_pack_lock_put_u32(bytes + 4, PR_PACK_LOCK_VERSION_MAJOR | (PR_PACK_LOCK_VERSION_MINOR << 16));
+    pr_pack_lock_put_u32(bytes + 8, lock->max_page_width);
+    pr_pack_lock_put_u32(bytes + 12, lock->max_page_height);
+    pr_pack_lock_put_u32(bytes + 16, lock->padding);
+    pr_pack_lock_put_u32(bytes + 20, lock->cell);
+    pr_pack_lock_put_u32(bytes + 24, (uint32_t)lock->page_count);
+    pr_pack_lock_put_u32(bytes + 28, (uint32_t)lock->frame_count);
+    cursor = bytes + PR_PACK_LOCK_HEADER_SIZE;
+    for (i = 0u; i < lock->page_count; ++i) {
+        pr_pack_lock_put_u32(cursor, (uint32_t)lock->pages[i].color_space);
+        pr_pack_lock_put_u32(cursor + 4, (uint32_t)lock->pages[i].alpha_mode);
+        cursor += PR_PACK_LOCK_PAGE_SIZE;
+    }
+
+    /* Sprite ids are repeated per frame; locks are small enough not to
+     * bother sharing them.
+     */
+    id_offset = 0u;
+    for (i = 0u; i < lock->frame_count; ++i) {
+        const pr_pack_lock_frame_t *frame;
+        size_t id_length;
+
+        frame = &lock->frames[i];
+        id_length = strlen(frame->sprite_id) + 1u;
+        pr_pack_lock_put_u32(cursor, id_offset);
+        pr_pack_lock_put_u32(cursor + 4, frame->local_frame_index);
+        pr_pack_lock_put_u32(cursor + 8, frame->page);
+        pr_pack_lock_put_u32(cursor + 12, frame->x);
+        pr_pack_lock_put_u32(cursor + 16, frame->y);
+        pr_pack_lock_put_u32(cursor + 20, frame->w);
+        pr_pack_lock_put_u32(cursor + 24, frame->h);
+        memcpy(bytes + size - ids_size + id_offset, frame->sprite_id, id_length);
+        id_offset += (uint32_t)id_length;
+        cursor += PR_PACK_LOCK_FRAME_SIZE;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        free(bytes);
+        return 0;
+    }
+    ok = fwrite(bytes, 1u, size, file) == size;
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        (void)remove(path);
+    }
+    free(bytes);
+    return ok;
+}
+
+const pr_pack_lock_frame_t *pr_pack_lock_find(
+    const pr_pack_lock_t *lock,
+    const char *sprite_id,
+    uint32_t local_frame_index
+)
+{
+    size_t low;
+    size_t high;
+
+    if (lock == NULL || sprite_id == NULL) {
+        return NULL;
+    }
+    low = 0u;
+    high = lock->frame_count;
+    while (low < high) {
+        size_t mid;
+        int order;
+
+        mid = low + (high - low) / 2u;
+        order = pr_pack_lock_compare_key(
+            sprite_id,
+            local_frame_index,
+            lock->frames[mid].sprite_id,
+            lock->frames[mid].local_frame_index
+        );
+        if (order == 0) {
+            return &lock->frames[mid];
+        }
+        if (order < 0) {
+            high = mid;
+        } else {
+            low = mid + 1u;
+        }
+    }
+    return NULL;
+}
+
+void pr_pack_lock_free(pr_pack_lock_t *lock)
+{
+    if (lock == NULL) {
+        return;
+    }
+    free(lock->pages);
+    free(lock->frames);
+    free(lock->ids);
+    memset(lock, 0, sizeof(*lock));
+}
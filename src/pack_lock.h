@@ -0,0 +1,75 @@
+#ifndef PACKRAT_PACK_LOCK_H
+#define PACKRAT_PACK_LOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packrat/build.h"
+
+/* Placement lock written next to a package built with `atlas.incremental`,
+ * recording where every frame went so the next build can keep it there.
+ * Layout (all integers little-endian):
+ *
+ *   header  32 bytes: "PRLK", u16 major, u16 minor, u32 max_page_width,
+ *           u32 max_page_height, u32 padding, u32 cell, u32 page_count,
+ *           u32 frame_count
+ *   pages   8 bytes each: u32 color_space, u32 alpha_mode
+ *   frames  28 bytes each: u32 id_offset, u32 local_frame_index, u32 page,
+ *           u32 x, u32 y, u32 w, u32 h
+ *   ids     NUL-terminated sprite ids; `id_offset` points into this blob
+ *
+ * Frame rectangles include padding (and mip cell rounding), as the packer
+ * places them. `cell` is the mip cell size, 1 without mipmaps.
+ */
+
+typedef struct pr_pack_lock_page {
+    pr_color_space_t color_space;
+    pr_alpha_mode_t alpha_mode;
+} pr_pack_lock_page_t;
+
+typedef struct pr_pack_lock_frame {
+    const char *sprite_id;
+    uint32_t local_frame_index;
+    uint32_t page;
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+    uint32_t h;
+} pr_pack_lock_frame_t;
+
+/* `ids` owns the sprite id strings of a lock that was read; locks assembled
+ * for writing leave it NULL and point `sprite_id` at their own strings.
+ */
+typedef struct pr_pack_lock {
+    uint32_t max_page_width;
+    uint32_t max_page_height;
+    uint32_t padding;
+    uint32_t cell;
+    pr_pack_lock_page_t *pages;
+    size_t page_count;
+    pr_pack_lock_frame_t *frames;
+    size_t frame_count;
+    char *ids;
+} pr_pack_lock_t;
+
+/* Returns a heap-allocated "<package_path>.prlk". */
+char *pr_pack_lock_path(const char *package_path);
+
+/* Returns 1 and fills `out_lock` when the file exists and is well formed;
+ * frames are then sorted for pr_pack_lock_find.
+ */
+int pr_pack_lock_read(const char *path, pr_pack_lock_t *out_lock);
+
+int pr_pack_lock_write(const char *path, const pr_pack_lock_t *lock);
+
+/* Frame `local_frame_index` of sprite `sprite_id`, or NULL. */
+const pr_pack_lock_frame_t *pr_pack_lock_find(
+    const pr_pack_lock_t *lock,
+    const char *sprite_id,
+    uint32_t local_frame_index
+);
+
+/* Frees a lock filled by pr_pack_lock_read. */
+void pr_pack_lock_free(pr_pack_lock_t *lock);
+
+#endif
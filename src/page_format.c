@@ -0,0 +1,304 @@
+#include "page_format.h"
+
+#include <string.h>
+
+typedef struct pr_page_format_info {
+    const char *name;
+    uint32_t pixel_bytes;
+    uint32_t block_bytes;
+} pr_page_format_info_t;
+
+/* Indexed by pr_page_format_t. */
+static const pr_page_format_info_t PR_PAGE_FORMATS[] = {
+    { "rgba8", 4u, 0u },
+    { "bc1", 0u, 8u },
+    { "bc3", 0u, 16u },
+    { "bc7", 0u, 16u },
+    { "etc2_rgb", 0u, 8u },
+    { "etc2_rgba", 0u, 16u },
+    { "rgb565", 2u, 0u },
+    { "rgba4444", 2u, 0u },
+    { "r8", 1u, 0u },
+    { "ra8", 2u, 0u },
+    { "indexed8", 1u, 0u }
+};
+
+/* Indexed by pr_encode_quality_t. */
+static const char *const PR_ENCODE_QUALITY_NAMES[] = {
+    "fast",
+    "balanced",
+    "best"
+};
+
+/* Indexed by pr_page_compression_t. */
+static const char *const PR_PAGE_COMPRESSION_NAMES[] = {
+    "none",
+    "lz"
+};
+
+/* Indexed by pr_color_space_t. */
+static const char *const PR_COLOR_SPACE_NAMES[] = {
+    "srgb",
+    "linear"
+};
+
+/* Indexed by pr_alpha_mode_t. */
+static const char *const PR_ALPHA_MODE_NAMES[] = {
+    "straight",
+    "premultiplied"
+};
+
+/* Indexed by pr_atlas_layout_t. */
+static const char *const PR_ATLAS_LAYOUT_NAMES[] = {
+    "pages",
+    "array"
+};
+
+#define PR_PAGE_FORMAT_COUNT (sizeof(PR_PAGE_FORMATS) / sizeof(PR_PAGE_FORMATS[0]))
+#define PR_PAGE_COMPRESSION_COUNT (sizeof(PR_PAGE_COMPRESSION_NAMES) / sizeof(PR_PAGE_COMPRESSION_NAMES[0]))
+#define PR_COLOR_SPACE_COUNT (sizeof(PR_COLOR_SPACE_NAMES) / sizeof(PR_COLOR_SPACE_NAMES[0]))
+#define PR_ALPHA_MODE_COUNT (sizeof(PR_ALPHA_MODE_NAMES) / sizeof(PR_ALPHA_MODE_NAMES[0]))
+#define PR_ATLAS_LAYOUT_COUNT (sizeof(PR_ATLAS_LAYOUT_NAMES) / sizeof(PR_ATLAS_LAYOUT_NAMES[0]))
+
+const char *pr_page_format_name(pr_page_format_t format)
+{
+    if ((size_t)format >= PR_PAGE_FORMAT_COUNT) {
+        return "unknown";
+    }
+    return PR_PAGE_FORMATS[format].name;
+}
+
+int pr_page_format_from_name(const char *name, pr_page_format_t *out_format)
+{
+    size_t i;
+
+    if (name == NULL || out_format == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < PR_PAGE_FORMAT_COUNT; ++i) {
+        if (strcmp(name, PR_PAGE_FORMATS[i].name) == 0) {
+            *out_format = (pr_page_format_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int pr_page_format_is_auto(const char *name)
+{
+    return name != NULL && strcmp(name, "auto") == 0;
+}
+
+int pr_encode_quality_from_name(const char *name, pr_encode_quality_t *out_quality)
+{
+    size_t i;
+
+    if (name == NULL || out_quality == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < sizeof(PR_ENCODE_QUALITY_NAMES) / sizeof(PR_ENCODE_QUALITY_NAMES[0]); ++i) {
+        if (strcmp(name, PR_ENCODE_QUALITY_NAMES[i]) == 0) {
+            *out_quality = (pr_encode_quality_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *pr_page_compression_name(pr_page_compression_t compression)
+{
+    if ((size_t)compression >= PR_PAGE_COMPRESSION_COUNT) {
+        return "unknown";
+    }
+    return PR_PAGE_COMPRESSION_NAMES[compression];
+}
+
+int pr_page_compression_from_name(const char *name, pr_page_compression_t *out_compression)
+{
+    size_t i;
+
+    if (name == NULL || out_compression == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < PR_PAGE_COMPRESSION_COUNT; ++i) {
+        if (strcmp(name, PR_PAGE_COMPRESSION_NAMES[i]) == 0) {
+            *out_compression = (pr_page_compression_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t pr_page_format_pixel_bytes(pr_page_format_t format)
+{
+    if ((size_t)format >= PR_PAGE_FORMAT_COUNT) {
+        return 0u;
+    }
+    return PR_PAGE_FORMATS[format].pixel_bytes;
+}
+
+uint32_t pr_page_format_block_bytes(pr_page_format_t format)
+{
+    if ((size_t)format >= PR_PAGE_FORMAT_COUNT) {
+        return 0u;
+    }
+    return PR_PAGE_FORMATS[format].block_bytes;
+}
+
+int pr_page_format_layout(
+    pr_page_format_t format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t *out_row_bytes,
+    uint32_t *out_data_bytes
+)
+{
+    const pr_page_format_info_t *info;
+    uint64_t row_bytes;
+    uint64_t rows;
+
+    if ((size_t)format >= PR_PAGE_FORMAT_COUNT || out_row_bytes == NULL || out_data_bytes == NULL) {
+        return 0;
+    }
+
+    info = &PR_PAGE_FORMATS[format];
+    if (info->block_bytes > 0u) {
+        row_bytes = (((uint64_t)width + 3u) / 4u) * info->block_bytes;
+        rows = ((uint64_t)height + 3u) / 4u;
+    } else {
+        row_bytes = (uint64_t)width * info->pixel_bytes;
+        rows = height;
+    }
+    if (row_bytes > UINT32_MAX || row_bytes * rows > UINT32_MAX) {
+        return 0;
+    }
+
+    *out_row_bytes = (uint32_t)row_bytes;
+    *out_data_bytes = (uint32_t)(row_bytes * rows);
+    return 1;
+}
+
+int pr_page_tile_grid(
+    uint32_t width,
+    uint32_t height,
+    uint32_t tile_size,
+    uint32_t *out_tiles_x,
+    uint32_t *out_tiles_y
+)
+{
+    if (tile_size == 0u || tile_size % 4u != 0u || out_tiles_x == NULL || out_tiles_y == NULL) {
+        return 0;
+    }
+    *out_tiles_x = (uint32_t)(((uint64_t)width + tile_size - 1u) / tile_size);
+    *out_tiles_y = (uint32_t)(((uint64_t)height + tile_size - 1u) / tile_size);
+    return 1;
+}
+
+int pr_page_tile_at(
+    pr_page_format_t format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t tile_size,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    pr_page_tile_t *out_tile
+)
+{
+    const pr_page_format_info_t *info;
+    uint32_t units_x;
+    uint32_t units_y;
+    uint32_t unit_bytes;
+    uint32_t tile_units;
+    uint32_t first_x;
+    uint32_t first_y;
+
+    if (
+        (size_t)format >= PR_PAGE_FORMAT_COUNT ||
+        tile_size == 0u ||
+        tile_size % 4u != 0u ||
+        out_tile == NULL
+    ) {
+        return 0;
+    }
+
+    /* Work in data units: pixels, or 4x4 blocks. */
+    info = &PR_PAGE_FORMATS[format];
+    if (info->block_bytes > 0u) {
+        units_x = (width + 3u) / 4u;
+        units_y = (height + 3u) / 4u;
+        unit_bytes = info->block_bytes;
+        tile_units = tile_size / 4u;
+    } else {
+        units_x = width;
+        units_y = height;
+        unit_bytes = info->pixel_bytes;
+        tile_units = tile_size;
+    }
+
+    first_x = tile_x * tile_units;
+    first_y = tile_y * tile_units;
+    if (first_x >= units_x || first_y >= units_y) {
+        return 0;
+    }
+    out_tile->row = first_y;
+    out_tile->rows = ((units_y - first_y) < tile_units) ? (units_y - first_y) : tile_units;
+    out_tile->offset = first_x * unit_bytes;
+    out_tile->row_bytes = (((units_x - first_x) < tile_units) ? (units_x - first_x) : tile_units) * unit_bytes;
+    return 1;
+}
+
+const char *pr_color_space_name(pr_color_space_t color_space)
+{
+    if ((size_t)color_space >= PR_COLOR_SPACE_COUNT) {
+        return "unknown";
+    }
+    return PR_COLOR_SPACE_NAMES[color_space];
+}
+
+int pr_color_space_from_name(const char *name, pr_color_space_t *out_color_space)
+{
+    size_t i;
+
+    if (name == NULL || out_color_space == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < PR_COLOR_SPACE_COUNT; ++i) {
+        if (strcmp(name, PR_COLOR_SPACE_NAMES[i]) == 0) {
+            *out_color_space = (pr_color_space_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *pr_alpha_mode_name(pr_alpha_mode_t alpha_mode)
+{
+    if ((size_t)alpha_mode >= PR_ALPHA_MODE_COUNT) {
+        return "unknown";
+    }
+    return PR_ALPHA_MODE_NAMES[alpha_mode];
+}
+
+const char *pr_atlas_layout_name(pr_atlas_layout_t layout)
+{
+    if ((size_t)layout >= PR_ATLAS_LAYOUT_COUNT) {
+        return "unknown";
+    }
+    return PR_ATLAS_LAYOUT_NAMES[layout];
+}
+
+int pr_atlas_layout_from_name(const char *name, pr_atlas_layout_t *out_layout)
+{
+    size_t i;
+
+    if (name == NULL || out_layout == NULL) {
+        return 0;
+    }
+    for (i = 0u; i < PR_ATLAS_LAYOUT_COUNT; ++i) {
+        if (strcmp(name, PR_ATLAS_LAYOUT_NAMES[i]) == 0) {
+            *out_layout = (pr_atlas_layout_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
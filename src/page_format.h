@@ -0,0 +1,97 @@
+#ifndef PACKRAT_PAGE_FORMAT_H
+#define PACKRAT_PAGE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "packrat/build.h"
+
+/* Bounds of `atlas.tile_size`; tiles are also a multiple of 4 so they hold
+ * whole 4x4 blocks.
+ */
+#define PR_PAGE_TILE_SIZE_MIN 16
+#define PR_PAGE_TILE_SIZE_MAX 4096
+
+/* Block encoder effort. Higher presets search more endpoint candidates. */
+typedef enum pr_encode_quality {
+    PR_ENCODE_QUALITY_FAST = 0,
+    PR_ENCODE_QUALITY_BALANCED,
+    PR_ENCODE_QUALITY_BEST
+} pr_encode_quality_t;
+
+/* Maps a manifest `atlas.format` string to its format. Returns 0 for unknown
+ * names.
+ */
+int pr_page_format_from_name(const char *name, pr_page_format_t *out_format);
+
+/* `atlas.format = "auto"` picks r8, ra8 or rgba8 per page, whichever holds
+ * the page's frames without loss.
+ */
+int pr_page_format_is_auto(const char *name);
+
+/* Maps `atlas.encode_quality` ("fast", "balanced", "best"). */
+int pr_encode_quality_from_name(const char *name, pr_encode_quality_t *out_quality);
+
+/* Maps `atlas.compression` ("none", "lz"). */
+int pr_page_compression_from_name(const char *name, pr_page_compression_t *out_compression);
+
+/* Maps `atlas.layout` ("pages", "array"). */
+int pr_atlas_layout_from_name(const char *name, pr_atlas_layout_t *out_layout);
+
+/* Maps an image's `color_space` ("srgb", "linear"). */
+int pr_color_space_from_name(const char *name, pr_color_space_t *out_color_space);
+
+/* Bytes per pixel, or 0 for block formats. */
+uint32_t pr_page_format_pixel_bytes(pr_page_format_t format);
+
+/* Bytes per 4x4 block, or 0 for formats stored one pixel at a time. */
+uint32_t pr_page_format_block_bytes(pr_page_format_t format);
+
+/* Size of one page's data: `row_bytes` covers a row of pixels, or a row of
+ * 4x4 blocks for block formats (partial blocks at the edges are padded).
+ * Returns 0 when the size does not fit in 32 bits.
+ */
+int pr_page_format_layout(
+    pr_page_format_t format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t *out_row_bytes,
+    uint32_t *out_data_bytes
+);
+
+/* Part of a page's data covered by one tile: `rows` data rows starting at
+ * `row`, each `row_bytes` long and starting `offset` bytes into the page row.
+ * Data rows are pixel rows, or rows of 4x4 blocks for block formats.
+ */
+typedef struct pr_page_tile {
+    uint32_t row;
+    uint32_t rows;
+    uint32_t offset;
+    uint32_t row_bytes;
+} pr_page_tile_t;
+
+/* Number of `tile_size` tiles across and down a page. Returns 0 when
+ * `tile_size` is not a positive multiple of 4.
+ */
+int pr_page_tile_grid(
+    uint32_t width,
+    uint32_t height,
+    uint32_t tile_size,
+    uint32_t *out_tiles_x,
+    uint32_t *out_tiles_y
+);
+
+/* Data covered by tile (`tile_x`, `tile_y`); edge tiles are cut to the page.
+ * Tiles are stored in row-major tile order.
+ */
+int pr_page_tile_at(
+    pr_page_format_t format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t tile_size,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    pr_page_tile_t *out_tile
+);
+
+#endif
@@ -0,0 +1,395 @@
+#include "palette.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Distinct colors of the input, keyed by their packed RGBA bytes, with the
+ * number of texels using each and, once the palette is built, their index.
+ */
+typedef struct pr_palette_table {
+    uint32_t *keys;
+    uint32_t *counts;
+    unsigned char *indices;
+    uint32_t bits;
+    size_t count;
+} pr_palette_table_t;
+
+typedef struct pr_palette_color {
+    uint32_t key;
+    uint32_t count;
+    unsigned char rgba[4];
+} pr_palette_color_t;
+
+/* A run of `colors` that becomes one palette entry; `channel` is the one
+ * with the widest spread of values.
+ */
+typedef struct pr_palette_box {
+    size_t first;
+    size_t count;
+    uint32_t channel;
+    uint32_t range;
+} pr_palette_box_t;
+
+static uint32_t pr_palette_key(const unsigned char *rgba)
+{
+    return (uint32_t)rgba[0] |
+        ((uint32_t)rgba[1] << 8) |
+        ((uint32_t)rgba[2] << 16) |
+        ((uint32_t)rgba[3] << 24);
+}
+
+/* Slot holding `key`, or the empty slot where it belongs. Empty slots have a
+ * zero count.
+ */
+static size_t pr_palette_table_slot(const pr_palette_table_t *table, uint32_t key)
+{
+    size_t mask;
+    size_t slot;
+
+    mask = ((size_t)1u << table->bits) - 1u;
+    slot = (size_t)((key * 2654435761u) >> (32u - table->bits));
+    while (table->counts[slot] != 0u && table->keys[slot] != key) {
+        slot = (slot + 1u) & mask;
+    }
+    return slot;
+}
+
+static int pr_palette_table_init(pr_palette_table_t *table, uint32_t bits)
+{
+    size_t capacity;
+
+    capacity = (size_t)1u << bits;
+    table->keys = (uint32_t *)malloc(capacity * sizeof(table->keys[0]));
+    table->counts = (uint32_t *)calloc(capacity, sizeof(table->counts[0]));
+    table->indices = (unsigned char *)malloc(capacity);
+    table->bits = bits;
+    table->count = 0u;
+    if (table->keys == NULL || table->counts == NULL || table->indices == NULL) {
+        free(table->keys);
+        free(table->counts);
+        free(table->indices);
+        return 0;
+    }
+    return 1;
+}
+
+static void pr_palette_table_free(pr_palette_table_t *table)
+{
+    free(table->keys);
+    free(table->counts);
+    free(table->indices);
+}
+
+/* Counts one texel of `key`, doubling the table at half load. */
+static int pr_palette_table_add(pr_palette_table_t *table, uint32_t key)
+{
+    size_t slot;
+
+    slot = pr_palette_table_slot(table, key);
+    if (table->counts[slot] != 0u) {
+        table->counts[slot] += 1u;
+        return 1;
+    }
+    if ((table->count + 1u) * 2u > ((size_t)1u << table->bits)) {
+        pr_palette_table_t grown;
+        size_t old_capacity;
+        size_t i;
+
+        if (table->bits >= 31u || !pr_palette_table_init(&grown, table->bits + 1u)) {
+            return 0;
+        }
+        old_capacity = (size_t)1u << table->bits;
+        for (i = 0u; i < old_capacity; ++i) {
+            size_t moved;
+
+            if (table->counts[i] == 0u) {
+                continue;
+            }
+            moved = pr_palette_table_slot(&grown, table->keys[i]);
+            grown.keys[moved] = table->keys[i];
+            grown.counts[moved] = table->counts[i];
+        }
+        grown.count = table->count;
+        pr_palette_table_free(table);
+        *table = grown;
+        slot = pr_palette_table_slot(table, key);
+    }
+    table->keys[slot] = key;
+    table->counts[slot] = 1u;
+    table->count += 1u;
+    return 1;
+}
+
+static int pr_palette_compare_key(const void *lhs, const void *rhs)
+{
+    const pr_palette_color_t *a;
+    const pr_palette_color_t *b;
+
+    a = (const pr_palette_color_t *)lhs;
+    b = (const pr_palette_color_t *)rhs;
+    if (a->key != b->key) {
+        return (a->key < b->key) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Orders by one channel, then by key so the order is total. */
+static int pr_palette_compare_channel(const void *lhs, const void *rhs, uint32_t channel)
+{
+    const pr_palette_color_t *a;
+    const pr_palette_color_t *b;
+
+    a = (const pr_palette_color_t *)lhs;
+    b = (const pr_palette_color_t *)rhs;
+    if (a->rgba[channel] != b->rgba[channel]) {
+        return (a->rgba[channel] < b->rgba[channel]) ? -1 : 1;
+    }
+    return pr_palette_compare_key(lhs, rhs);
+}
+
+static int pr_palette_compare_r(const void *lhs, const void *rhs)
+{
+    return pr_palette_compare_channel(lhs, rhs, 0u);
+}
+
+static int pr_palette_compare_g(const void *lhs, const void *rhs)
+{
+    return pr_palette_compare_channel(lhs, rhs, 1u);
+}
+
+static int pr_palette_compare_b(const void *lhs, const void *rhs)
+{
+    return pr_palette_compare_channel(lhs, rhs, 2u);
+}
+
+static int pr_palette_compare_a(const void *lhs, const void *rhs)
+{
+    return pr_palette_compare_channel(lhs, rhs, 3u);
+}
+
+/* Indexed by channel. */
+static int (*const PR_PALETTE_COMPARE[4])(const void *, const void *) = {
+    pr_palette_compare_r,
+    pr_palette_compare_g,
+    pr_palette_compare_b,
+    pr_palette_compare_a
+};
+
+static void pr_palette_box_measure(const pr_palette_color_t *colors, pr_palette_box_t *box)
+{
+    unsigned char low[4];
+    unsigned char high[4];
+    uint32_t channel;
+    size_t i;
+
+    memcpy(low, colors[box->first].rgba, 4u);
+    memcpy(high, colors[box->first].rgba, 4u);
+    for (i = box->first + 1u; i < box->first + box->count; ++i) {
+        for (channel = 0u; channel < 4u; ++channel) {
+            if (colors[i].rgba[channel] < low[channel]) {
+                low[channel] = colors[i].rgba[channel];
+            }
+            if (colors[i].rgba[channel] > high[channel]) {
+                high[channel] = colors[i].rgba[channel];
+            }
+        }
+    }
+    box->channel = 0u;
+    box->range = 0u;
+    for (channel = 0u; channel < 4u; ++channel) {
+        if ((uint32_t)(high[channel] - low[channel]) > box->range) {
+            box->channel = channel;
+            box->range = (uint32_t)(high[channel] - low[channel]);
+        }
+    }
+}
+
+/* Splits boxes until there are 256 or every box is a single color. The box
+ * with the widest channel is split next, at the texel-weighted median of
+ * that channel.
+ */
+static void pr_palette_median_cut(
+    pr_palette_color_t *colors,
+    size_t color_count,
+    pr_palette_t *out_palette
+)
+{
+    pr_palette_box_t boxes[PR_PALETTE_MAX_COLORS];
+    size_t box_count;
+    size_t i;
+
+    boxes[0].first = 0u;
+    boxes[0].count = color_count;
+    pr_palette_box_measure(colors, &boxes[0]);
+    box_count = 1u;
+    while (box_count < PR_PALETTE_MAX_COLORS) {
+        pr_palette_box_t *box;
+        uint64_t total;
+        uint64_t running;
+        size_t split;
+
+        box = NULL;
+        for (i = 0u; i < box_count; ++i) {
+            if (boxes[i].count > 1u && (box == NULL || boxes[i].range > box->range)) {
+                box = &boxes[i];
+            }
+        }
+        if (box == NULL) {
+            break;
+        }
+
+        qsort(colors + box->first, box->count, sizeof(colors[0]), PR_PALETTE_COMPARE[box->channel]);
+        total = 0u;
+        for (i = box->first; i < box->first + box->count; ++i) {
+            total += colors[i].count;
+        }
+        running = 0u;
+        split = 1u;
+        for (i = box->first; i < box->first + box->count - 1u; ++i) {
+            running += colors[i].count;
+            split = i - box->first + 1u;
+            if (running * 2u >= total) {
+                break;
+            }
+        }
+
+        boxes[box_count].first = box->first + split;
+        boxes[box_count].count = box->count - split;
+        box->count = split;
+        pr_palette_box_measure(colors, box);
+        pr_palette_box_measure(colors, &boxes[box_count]);
+        box_count += 1u;
+    }
+
+    out_palette->count = (uint32_t)box_count;
+    for (i = 0u; i < box_count; ++i) {
+        uint64_t sums[4];
+        uint64_t total;
+        uint32_t channel;
+        size_t k;
+
+        memset(sums, 0, sizeof(sums));
+        total = 0u;
+        for (k = boxes[i].first; k < boxes[i].first + boxes[i].count; ++k) {
+            for (channel = 0u; channel < 4u; ++channel) {
+                sums[channel] += (uint64_t)colors[k].rgba[channel] * colors[k].count;
+            }
+            total += colors[k].count;
+        }
+        for (channel = 0u; channel < 4u; ++channel) {
+            out_palette->colors[i * 4u + channel] = (unsigned char)((sums[channel] + total / 2u) / total);
+        }
+    }
+}
+
+static unsigned char pr_palette_nearest(const pr_palette_t *palette, const unsigned char *rgba)
+{
+    uint32_t best;
+    uint32_t best_distance;
+    uint32_t i;
+
+    best = 0u;
+    best_distance = UINT32_MAX;
+    for (i = 0u; i < palette->count; ++i) {
+        uint32_t distance;
+        uint32_t channel;
+
+        distance = 0u;
+        for (channel = 0u; channel < 4u; ++channel) {
+            int delta;
+
+            delta = (int)rgba[channel] - (int)palette->colors[i * 4u + channel];
+            distance += (uint32_t)(delta * delta);
+        }
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return (unsigned char)best;
+}
+
+int pr_palette_quantize(
+    const unsigned char *const *images,
+    const size_t *pixel_counts,
+    size_t image_count,
+    pr_palette_t *out_palette,
+    unsigned char **out_indices
+)
+{
+    pr_palette_table_t table;
+    pr_palette_color_t *colors;
+    size_t capacity;
+    size_t color_count;
+    size_t i;
+    size_t k;
+
+    if (!pr_palette_table_init(&table, 10u)) {
+        return 0;
+    }
+    for (k = 0u; k < image_count; ++k) {
+        out_indices[k] = NULL;
+        for (i = 0u; i < pixel_counts[k]; ++i) {
+            if (!pr_palette_table_add(&table, pr_palette_key(images[k] + i * 4u))) {
+                pr_palette_table_free(&table);
+                return 0;
+            }
+        }
+    }
+
+    capacity = (size_t)1u << table.bits;
+    colors = (pr_palette_color_t *)malloc((table.count > 0u ? table.count : 1u) * sizeof(colors[0]));
+    if (colors == NULL) {
+        pr_palette_table_free(&table);
+        return 0;
+    }
+    color_count = 0u;
+    for (i = 0u; i < capacity; ++i) {
+        if (table.counts[i] == 0u) {
+            continue;
+        }
+        colors[color_count].key = table.keys[i];
+        colors[color_count].count = table.counts[i];
+        colors[color_count].rgba[0] = (unsigned char)(table.keys[i] & 0xFFu);
+        colors[color_count].rgba[1] = (unsigned char)((table.keys[i] >> 8) & 0xFFu);
+        colors[color_count].rgba[2] = (unsigned char)((table.keys[i] >> 16) & 0xFFu);
+        colors[color_count].rgba[3] = (unsigned char)(table.keys[i] >> 24);
+        color_count += 1u;
+    }
+
+    memset(out_palette, 0, sizeof(*out_palette));
+    if (color_count <= PR_PALETTE_MAX_COLORS) {
+        qsort(colors, color_count, sizeof(colors[0]), pr_palette_compare_key);
+        out_palette->count = (uint32_t)color_count;
+        for (i = 0u; i < color_count; ++i) {
+            memcpy(out_palette->colors + i * 4u, colors[i].rgba, 4u);
+            table.indices[pr_palette_table_slot(&table, colors[i].key)] = (unsigned char)i;
+        }
+    } else {
+        pr_palette_median_cut(colors, color_count, out_palette);
+        for (i = 0u; i < color_count; ++i) {
+            table.indices[pr_palette_table_slot(&table, colors[i].key)] =
+                pr_palette_nearest(out_palette, colors[i].rgba);
+        }
+    }
+    free(colors);
+
+    for (k = 0u; k < image_count; ++k) {
+        out_indices[k] = (unsigned char *)malloc(pixel_counts[k] > 0u ? pixel_counts[k] : 1u);
+        if (out_indices[k] == NULL) {
+            while (k > 0u) {
+                free(out_indices[--k]);
+                out_indices[k] = NULL;
+            }
+            pr_palette_table_free(&table);
+            return 0;
+        }
+        for (i = 0u; i < pixel_counts[k]; ++i) {
+            out_indices[k][i] = table.indices[
+                pr_palette_table_slot(&table, pr_palette_key(images[k] + i * 4u))
+            ];
+        }
+    }
+    pr_palette_table_free(&table);
+    return 1;
+}
@@ -0,0 +1,32 @@
+#ifndef PACKRAT_PALETTE_H
+#define PACKRAT_PALETTE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PR_PALETTE_MAX_COLORS 256u
+
+/* Up to 256 RGBA8 colors; `colors` holds `count * 4` bytes. */
+typedef struct pr_palette {
+    uint32_t count;
+    unsigned char colors[PR_PALETTE_MAX_COLORS * 4u];
+} pr_palette_t;
+
+/* Builds one palette for `image_count` tightly packed RGBA8 images, e.g. a
+ * page and its mip levels, and maps every texel to it. When the images use
+ * at most 256 distinct colors the palette is exactly those colors, sorted;
+ * otherwise it comes from a median cut weighted by texel count, and each
+ * texel maps to the nearest palette color.
+ *
+ * `out_indices[k]` receives a malloc'ed buffer of `pixel_counts[k]` bytes.
+ * Returns 0 on allocation failure, with nothing left allocated.
+ */
+int pr_palette_quantize(
+    const unsigned char *const *images,
+    const size_t *pixel_counts,
+    size_t image_count,
+    pr_palette_t *out_palette,
+    unsigned char **out_indices
+);
+
+#endif
@@ -0,0 +1,169 @@
+#include "parallel.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define PR_PARALLEL_MAX_WORKERS 64u
+
+typedef struct pr_parallel_job {
+    pr_parallel_fn fn;
+    void *user_data;
+    size_t count;
+    size_t next;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} pr_parallel_job_t;
+
+unsigned int pr_parallel_worker_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    if (info.dwNumberOfProcessors < 1u) {
+        return 1u;
+    }
+    return (unsigned int)info.dwNumberOfProcessors;
+#else
+    long count;
+
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1) {
+        return 1u;
+    }
+    return (unsigned int)count;
+#endif
+}
+
+static int pr_parallel_take(pr_parallel_job_t *job, size_t *out_index)
+{
+    int taken;
+
+#ifdef _WIN32
+    EnterCriticalSection(&job->lock);
+#else
+    pthread_mutex_lock(&job->lock);
+#endif
+    taken = (job->next < job->count) ? 1 : 0;
+    if (taken != 0) {
+        *out_index = job->next;
+        job->next += 1u;
+    }
+#ifdef _WIN32
+    LeaveCriticalSection(&job->lock);
+#else
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return taken;
+}
+
+static void pr_parallel_drain(pr_parallel_job_t *job)
+{
+    size_t index;
+
+    while (pr_parallel_take(job, &index)) {
+        job->fn(job->user_data, index);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI pr_parallel_thread_main(LPVOID user_data)
+{
+    pr_parallel_drain((pr_parallel_job_t *)user_data);
+    return 0;
+}
+#else
+static void *pr_parallel_thread_main(void *user_data)
+{
+    pr_parallel_drain((pr_parallel_job_t *)user_data);
+    return NULL;
+}
+#endif
+
+void pr_parallel_for(size_t count, pr_parallel_fn fn, void *user_data)
+{
+    pr_parallel_job_t job;
+#ifdef _WIN32
+    HANDLE threads[PR_PARALLEL_MAX_WORKERS];
+#else
+    pthread_t threads[PR_PARALLEL_MAX_WORKERS];
+#endif
+    size_t worker_count;
+    size_t started;
+    size_t i;
+
+    if (fn == NULL || count == 0u) {
+        return;
+    }
+
+    worker_count = (size_t)pr_parallel_worker_count();
+    if (worker_count > PR_PARALLEL_MAX_WORKERS) {
+        worker_count = PR_PARALLEL_MAX_WORKERS;
+    }
+    if (worker_count > count) {
+        worker_count = count;
+    }
+    if (worker_count <= 1u) {
+        for (i = 0u; i < count; ++i) {
+            fn(user_data, i);
+        }
+        return;
+    }
+
+    job.fn = fn;
+    job.user_data = user_data;
+    job.count = count;
+    job.next = 0u;
+#ifdef _WIN32
+    InitializeCriticalSection(&job.lock);
+#else
+    if (pthread_mutex_init(&job.lock, NULL) != 0) {
+        for (i = 0u; i < count; ++i) {
+            fn(user_data, i);
+        }
+        return;
+    }
+#endif
+
+    /* The calling thread is one of the workers. */
+    started = 0u;
+    for (i = 1u; i < worker_count; ++i) {
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0u, pr_parallel_thread_main, &job, 0u, NULL);
+        if (threads[started] == NULL) {
+            break;
+        }
+#else
+        if (pthread_create(&threads[started], NULL, pr_parallel_thread_main, &job) != 0) {
+            break;
+        }
+#endif
+        started += 1u;
+    }
+
+    pr_parallel_drain(&job);
+
+    for (i = 0u; i < started; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        (void)pthread_join(threads[i], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&job.lock);
+#else
+    (void)pthread_mutex_destroy(&job.lock);
+#endif
+}
@@ -0,0 +1,19 @@
+#ifndef PACKRAT_PARALLEL_H
+#define PACKRAT_PARALLEL_H
+
+#include <stddef.h>
+
+typedef void (*pr_parallel_fn)(void *user_data, size_t index);
+
+/* Number of hardware threads, at least 1. */
+unsigned int pr_parallel_worker_count(void);
+
+/* Calls `fn(user_data, i)` once for every i in [0, count) across up to
+ * `pr_parallel_worker_count()` threads, including the calling one, and
+ * returns when all calls have finished. Indices are handed out in order but
+ * may complete in any order. Falls back to running on the calling thread when
+ * threads cannot be created.
+ */
+void pr_parallel_for(size_t count, pr_parallel_fn fn, void *user_data);
+
+#endif
@@ -0,0 +1,605 @@
+#include "patch.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "profiler.h"
+
+/* Patch layout (all integers little-endian):
+ *
+ *   header  48 bytes: "PRPD", u16 major, u16 minor, u64 old_size,
+ *           u64 old_hash, u64 new_size, u64 new_hash, u32 op_count,
+ *           u32 reserved
+ *   ops     20 bytes each: u32 kind, u64 offset, u64 size; a copy op takes
+ *           `size` bytes at `offset` in the old package, a data op takes
+ *           them at `offset` in the literal bytes
+ *   literal bytes
+ *
+ * Ops write the new package front to back. Hashes are 64-bit FNV-1a over
+ * the whole package.
+ */
+#define PR_PATCH_VERSION_MAJOR 1u
+#define PR_PATCH_VERSION_MINOR 0u
+#define PR_PATCH_HEADER_SIZE 48u
+#define PR_PATCH_OP_SIZE 20u
+
+#define PR_PATCH_OP_COPY 0u
+#define PR_PATCH_OP_DATA 1u
+
+#define PR_PATCH_PART_NONE SIZE_MAX
+
+typedef struct pr_patch_op {
+    uint32_t kind;
+    uint64_t offset;
+    uint64_t size;
+} pr_patch_op_t;
+
+/* One side of a diff: the package, its part offsets and a hash per part. */
+typedef struct pr_patch_parts {
+    pr_package_t *package;
+    const unsigned char *bytes;
+    size_t size;
+    size_t *offsets;
+    size_t offset_count;
+    uint64_t *hashes;
+} pr_patch_parts_t;
+
+static uint64_t pr_patch_hash(const unsigned char *bytes, size_t size)
+{
+    uint64_t hash;
+    size_t i;
+
+    hash = 14695981039346656037ull;
+    for (i = 0u; i < size; ++i) {
+        hash ^= (uint64_t)bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void pr_patch_put_u32(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value & 0xFFu);
+    bytes[1] = (unsigned char)((value >> 8) & 0xFFu);
+    bytes[2] = (unsigned char)((value >> 16) & 0xFFu);
+    bytes[3] = (unsigned char)((value >> 24) & 0xFFu);
+}
+
+static void pr_patch_put_u64(unsigned char *bytes, uint64_t value)
+{
+    pr_patch_put_u32(bytes, (uint32_t)(value & 0xFFFFFFFFu));
+    pr_patch_put_u32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t pr_patch_get_u32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] |
+        ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) |
+        ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t pr_patch_get_u64(const unsigned char *bytes)
+{
+    return (uint64_t)pr_patch_get_u32(bytes) | ((uint64_t)pr_patch_get_u32(bytes + 4) << 32);
+}
+
+static void pr_patch_hash_batch_run(void *user_data, size_t index)
+{
+    pr_patch_parts_t *parts;
+
+    parts = (pr_patch_parts_t *)user_data;
+    parts->hashes[index] = pr_patch_hash(
+        parts->bytes + parts->offsets[index],
+        parts->offsets[index + 1u] - parts->offsets[index]
+    );
+}
+
+static void pr_patch_parts_free(pr_patch_parts_t *parts)
+{
+    pr_package_close(parts->package);
+    free(parts->offsets);
+    free(parts->hashes);
+    memset(parts, 0, sizeof(*parts));
+}
+
+static pr_status_t pr_patch_parts_init(pr_patch_parts_t *parts, const void *data, size_t size)
+{
+    pr_status_t status;
+
+    memset(parts, 0, sizeof(*parts));
+    parts->bytes = (const unsigned char *)data;
+    parts->size = size;
+    status = pr_package_open_memory(data, size, &parts->package);
+    if (status == PR_STATUS_OK) {
+        status = pr_package_part_offsets(parts->package, &parts->offsets, &parts->offset_count);
+    }
+    if (status != PR_STATUS_OK) {
+        pr_patch_parts_free(parts);
+        return status;
+    }
+
+    parts->hashes = (uint64_t *)malloc(parts->offset_count * sizeof(parts->hashes[0]));
+    if (parts->hashes == NULL) {
+        pr_patch_parts_free(parts);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    pr_parallel_for(parts->offset_count - 1u, pr_patch_hash_batch_run, parts);
+    return PR_STATUS_OK;
+}
+
+static size_t pr_patch_part_size(const pr_patch_parts_t *parts, size_t index)
+{
+    return parts->offsets[index + 1u] - parts->offsets[index];
+}
+
+static int pr_patch_parts_equal(
+    const pr_patch_parts_t *lhs,
+    size_t lhs_index,
+    const pr_patch_parts_t *rhs,
+    size_t rhs_index
+)
+{
+    size_t size;
+
+    size = pr_patch_part_size(lhs, lhs_index);
+    return size == pr_patch_part_size(rhs, rhs_index) &&
+        lhs->hashes[lhs_index] == rhs->hashes[rhs_index] &&
+        memcmp(lhs->bytes + lhs->offsets[lhs_index], rhs->bytes + rhs->offsets[rhs_index], size) == 0;
+}
+
+static int pr_patch_push_op(
+    pr_patch_op_t **ops,
+    size_t *count,
+    size_t *capacity,
+    uint32_t kind,
+    uint64_t offset,
+    uint64_t size
+)
+{
+    pr_patch_op_t *last;
+
+    last = (*count > 0u) ? &(*ops)[*count - 1u] : NULL;
+    if (last != NULL && last->kind == kind && last->offset + last->size == offset) {
+        last->size += size;
+        return 1;
+    }
+    if (*count == *capacity) {
+        size_t grown_capacity;
+        pr_patch_op_t *grown;
+
+        grown_capacity = (*capacity > 0u) ? *capacity * 2u : 64u;
+        grown = (pr_patch_op_t *)realloc(*ops, grown_capacity * sizeof(grown[0]));
+        if (grown == NULL) {
+            return 0;
+        }
+        *ops = grown;
+        *capacity = grown_capacity;
+    }
+    (*ops)[*count].kind = kind;
+    (*ops)[*count].offset = offset;
+    (*ops)[*count].size = size;
+    *count += 1u;
+    return 1;
+}
+
+pr_status_t pr_package_diff(
+    const void *old_data,
+    size_t old_size,
+    const void *new_data,
+    size_t new_size,
+    void **out_patch,
+    size_t *out_patch_size
+)
+{
+    pr_patch_parts_t old_parts;
+    pr_patch_parts_t new_parts;
+    size_t *table;
+    size_t table_mask;
+    pr_patch_op_t *ops;
+    size_t op_count;
+    size_t op_capacity;
+    uint64_t literal_size;
+    size_t next_old;
+    size_t i;
+    unsigned char *patch;
+    unsigned char *cursor;
+    size_t patch_size;
+    pr_status_t status;
+
+    if (
+        old_data == NULL ||
+        new_data == NULL ||
+        out_patch == NULL ||
+        out_patch_size == NULL
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    *out_patch = NULL;
+    *out_patch_size = 0u;
+
+    PR_PROFILE_BEGIN("pr_package_diff");
+    table = NULL;
+    ops = NULL;
+    op_count = 0u;
+    op_capacity = 0u;
+    memset(&new_parts, 0, sizeof(new_parts));
+    status = pr_patch_parts_init(&old_parts, old_data, old_size);
+    if (status != PR_STATUS_OK) {
+        PR_PROFILE_END("pr_package_diff");
+        return status;
+    }
+    status = pr_patch_parts_init(&new_parts, new_data, new_size);
+    if (status != PR_STATUS_OK) {
+        goto cleanup;
+    }
+
+    /* Open-addressing table of old parts by hash; equal parts keep the
+     * first one.
+     */
+    status = PR_STATUS_ALLOCATION_FAILED;
+    table_mask = 1u;
+    while (table_mask < old_parts.offset_count * 2u) {
+        table_mask <<= 1u;
+    }
+    table = (size_t *)malloc(table_mask * sizeof(table[0]));
+    if (table == NULL) {
+        goto cleanup;
+    }
+    table_mask -= 1u;
+    for (i = 0u; i <= table_mask; ++i) {
+        table[i] = PR_PATCH_PART_NONE;
+    }
+    for (i = 0u; i + 1u < old_parts.offset_count; ++i) {
+        size_t slot;
+
+        slot = (size_t)old_parts.hashes[i] & table_mask;
+        while (table[slot] != PR_PATCH_PART_NONE && !pr_patch_parts_equal(&old_parts, table[slot], &old_parts, i)) {
+            slot = (slot + 1u) & table_mask;
+        }
+        if (table[slot] == PR_PATCH_PART_NONE) {
+            table[slot] = i;
+        }
+    }
+
+    /* Each new part is copied from an equal old one when there is one,
+     * preferring the part right after the last copy so runs merge.
+     */
+    literal_size = 0u;
+    next_old = PR_PATCH_PART_NONE;
+    for (i = 0u; i + 1u < new_parts.offset_count; ++i) {
+        size_t match;
+        size_t size;
+
+        size = pr_patch_part_size(&new_parts, i);
+        match = PR_PATCH_PART_NONE;
+        if (
+            next_old != PR_PATCH_PART_NONE &&
+            next_old + 1u < old_parts.offset_count &&
+            pr_patch_parts_equal(&old_parts, next_old, &new_parts, i)
+        ) {
+            match = next_old;
+        } else {
+            size_t slot;
+
+            slot = (size_t)new_parts.hashes[i] & table_mask;
+            while (table[slot] != PR_PATCH_PART_NONE) {
+                if (pr_patch_parts_equal(&old_parts, table[slot], &new_parts, i)) {
+                    match = table[slot];
+                    break;
+                }
+                slot = (slot + 1u) & table_mask;
+            }
+        }
+
+        if (match != PR_PATCH_PART_NONE) {
+            if (!pr_patch_push_op(&ops, &op_count, &op_capacity, PR_PATCH_OP_COPY, old_parts.offsets[match], size)) {
+                goto cleanup;
+            }
+            next_old = match + 1u;
+        } else {
+            if (!pr_patch_push_op(&ops, &op_count, &op_capacity, PR_PATCH_OP_DATA, literal_size, size)) {
+                goto cleanup;
+            }
+            literal_size += size;
+            next_old = PR_PATCH_PART_NONE;
+        }
+    }
+
+    patch_size = PR_PATCH_HEADER_SIZE + op_count * PR_PATCH_OP_SIZE + (size_t)literal_size;
+    patch = (unsigned char *)malloc(patch_size);
+    if (patch == NULL) {
+        goto cleanup;
+    }
+    memcpy(patch, "PRPD", 4u);
+    pr_patch_put_u32(patch + 4, PR_PATCH_VERSION_MAJOR | (PR_PATCH_VERSION_MINOR << 16));
+    pr_patch_put_u64(patch + 8, (uint64_t)old_size);
+    pr_patch_put_u64(patch + 16, pr_patch_hash(old_parts.bytes, old_size));
+    pr_patch_put_u64(patch + 24, (uint64_t)new_size);
+    pr_patch_put_u64(patch + 32, pr_patch_hash(new_parts.bytes, new_size));
+    pr_patch_put_u32(patch + 40, (uint32_t)op_count);
+    pr_patch_put_u32(patch + 44, 0u);
+    cursor = patch + PR_PATCH_HEADER_SIZE;
+    for (i = 0u; i < op_count; ++i) {
+        pr_patch_put_u32(cursor, ops[i].kind);
+        pr_patch_put_u64(cursor + 4, ops[i].offset);
+        pr_patch_put_u64(cursor + 12, ops[i].size);
+        cursor += PR_PATCH_OP_SIZE;
+    }
+    {
+        uint64_t new_offset;
+
+        new_offset = 0u;
+        for (i = 0u; i < op_count; ++i) {
+            if (ops[i].kind == PR_PATCH_OP_DATA) {
+                memcpy(cursor + ops[i].offset, new_parts.bytes + new_offset, (size_t)ops[i].size);
+            }
+            new_offset += ops[i].size;
+        }
+    }
+
+    *out_patch = patch;
+    *out_patch_size = patch_size;
+    status = PR_STATUS_OK;
+
+cleanup:
+    free(ops);
+    free(table);
+    pr_patch_parts_free(&new_parts);
+    pr_patch_parts_free(&old_parts);
+    PR_PROFILE_END("pr_package_diff");
+    return status;
+}
+
+typedef struct pr_patch_apply_batch {
+    const pr_patch_op_t *ops;
+    const uint64_t *dst_offsets;
+    const unsigned char *old_bytes;
+    const unsigned char *literals;
+    unsigned char *dst;
+} pr_patch_apply_batch_t;
+
+static void pr_patch_apply_batch_run(void *user_data, size_t index)
+{
+    pr_patch_apply_batch_t *batch;
+    const pr_patch_op_t *op;
+    const unsigned char *src;
+
+    batch = (pr_patch_apply_batch_t *)user_data;
+    op = &batch->ops[index];
+    src = (op->kind == PR_PATCH_OP_COPY) ? batch->old_bytes : batch->literals;
+    memcpy(batch->dst + batch->dst_offsets[index], src + op->offset, (size_t)op->size);
+}
+
+pr_status_t pr_package_patch(
+    const void *old_data,
+    size_t old_size,
+    const void *patch_data,
+    size_t patch_size,
+    void **out_data,
+    size_t *out_size
+)
+{
+    const unsigned char *patch;
+    pr_patch_apply_batch_t batch;
+    pr_patch_op_t *ops;
+    uint64_t *dst_offsets;
+    uint64_t new_size64;
+    uint64_t new_hash;
+    uint64_t literal_size;
+    uint64_t total;
+    size_t op_count;
+    size_t new_size;
+    size_t i;
+    unsigned char *dst;
+
+    if (
+        old_data == NULL ||
+        patch_data == NULL ||
+        out_data == NULL ||
+        out_size == NULL
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    *out_data = NULL;
+    *out_size = 0u;
+
+    patch = (const unsigned char *)patch_data;
+    if (
+        patch_size < PR_PATCH_HEADER_SIZE ||
+        memcmp(patch, "PRPD", 4u) != 0 ||
+        pr_patch_get_u32(patch + 4) != (PR_PATCH_VERSION_MAJOR | (PR_PATCH_VERSION_MINOR << 16))
+    ) {
+        return PR_STATUS_PARSE_ERROR;
+    }
+    op_count = (size_t)pr_patch_get_u32(patch + 40);
+    new_size64 = pr_patch_get_u64(patch + 24);
+    new_hash = pr_patch_get_u64(patch + 32);
+    if (
+        op_count > (patch_size - PR_PATCH_HEADER_SIZE) / PR_PATCH_OP_SIZE ||
+        new_size64 == 0u ||
+        new_size64 > (uint64_t)SIZE_MAX
+    ) {
+        return PR_STATUS_PARSE_ERROR;
+    }
+    if (
+        pr_patch_get_u64(patch + 8) != (uint64_t)old_size ||
+        pr_patch_get_u64(patch + 16) != pr_patch_hash((const unsigned char *)old_data, old_size)
+    ) {
+        return PR_STATUS_VALIDATION_ERROR;
+    }
+    new_size = (size_t)new_size64;
+    literal_size = (uint64_t)(patch_size - PR_PATCH_HEADER_SIZE - op_count * PR_PATCH_OP_SIZE);
+
+    ops = (pr_patch_op_t *)malloc((op_count > 0u ? op_count : 1u) * sizeof(ops[0]));
+    dst_offsets = (uint64_t *)malloc((op_count > 0u ? op_count : 1u) * sizeof(dst_offsets[0]));
+    if (ops == NULL || dst_offsets == NULL) {
+        free(ops);
+        free(dst_offsets);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    total = 0u;
+    for (i = 0u; i < op_count; ++i) {
+        const unsigned char *record;
+        uint64_t limit;
+
+        record = patch + PR_PATCH_HEADER_SIZE + i * PR_PATCH_OP_SIZE;
+        ops[i].kind = pr_patch_get_u32(record);
+        ops[i].offset = pr_patch_get_u64(record + 4);
+        ops[i].size = pr_patch_get_u64(record + 12);
+        limit = (ops[i].kind == PR_PATCH_OP_COPY) ? (uint64_t)old_size : literal_size;
+        if (
+            (ops[i].kind != PR_PATCH_OP_COPY && ops[i].kind != PR_PATCH_OP_DATA) ||
+            ops[i].offset > limit ||
+            ops[i].size > limit - ops[i].offset ||
+            ops[i].size > new_size64 - total
+        ) {
+            free(ops);
+            free(dst_offsets);
+            return PR_STATUS_PARSE_ERROR;
+        }
+        dst_offsets[i] = total;
+        total += ops[i].size;
+    }
+    if (total != new_size64) {
+        free(ops);
+        free(dst_offsets);
+        return PR_STATUS_PARSE_ERROR;
+    }
+
+    dst = (unsigned char *)malloc(new_size);
+    if (dst == NULL) {
+        free(ops);
+        free(dst_offsets);
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+    batch.ops = ops;
+    batch.dst_offsets = dst_offsets;
+    batch.old_bytes = (const unsigned char *)old_data;
+    batch.literals = patch + PR_PATCH_HEADER_SIZE + op_count * PR_PATCH_OP_SIZE;
+    batch.dst = dst;
+    PR_PROFILE_BEGIN("pr_package_patch");
+    pr_parallel_for(op_count, pr_patch_apply_batch_run, &batch);
+    PR_PROFILE_END("pr_package_patch");
+    free(ops);
+    free(dst_offsets);
+
+    if (pr_patch_hash(dst, new_size) != new_hash) {
+        free(dst);
+        return PR_STATUS_VALIDATION_ERROR;
+    }
+    *out_data = dst;
+    *out_size = new_size;
+    return PR_STATUS_OK;
+}
+
+void pr_package_patch_free(void *data)
+{
+    free(data);
+}
+
+static unsigned char *pr_patch_read_file(const char *path, size_t *out_size)
+{
+    FILE *file;
+    long size;
+    unsigned char *bytes;
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    if (fseek(file, 0L, SEEK_END) != 0 || (size = ftell(file)) <= 0L || fseek(file, 0L, SEEK_SET) != 0) {
+        (void)fclose(file);
+        return NULL;
+    }
+    bytes = (unsigned char *)malloc((size_t)size);
+    if (bytes == NULL || fread(bytes, 1u, (size_t)size, file) != (size_t)size) {
+        free(bytes);
+        (void)fclose(file);
+        return NULL;
+    }
+    (void)fclose(file);
+    *out_size = (size_t)size;
+    return bytes;
+}
+
+static pr_status_t pr_patch_write_file(const char *path, const void *bytes, size_t size)
+{
+    FILE *file;
+    int ok;
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return PR_STATUS_IO_ERROR;
+    }
+    ok = fwrite(bytes, 1u, size, file) == size;
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    return (ok != 0) ? PR_STATUS_OK : PR_STATUS_IO_ERROR;
+}
+
+/* Reads two inputs, runs `fn` and writes its output to `out_path`. */
+static pr_status_t pr_patch_run_files(
+    const char *first_path,
+    const char *second_path,
+    const char *out_path,
+    pr_status_t (*fn)(const void *, size_t, const void *, size_t, void **, size_t *),
+    size_t *out_size
+)
+{
+    unsigned char *first;
+    unsigned char *second;
+    size_t first_size;
+    size_t second_size;
+    void *output;
+    size_t output_size;
+    pr_status_t status;
+
+    if (first_path == NULL || second_path == NULL || out_path == NULL) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    first = pr_patch_read_file(first_path, &first_size);
+    second = pr_patch_read_file(second_path, &second_size);
+    if (first == NULL || second == NULL) {
+        free(first);
+        free(second);
+        return PR_STATUS_IO_ERROR;
+    }
+
+    status = fn(first, first_size, second, second_size, &output, &output_size);
+    free(first);
+    free(second);
+    if (status != PR_STATUS_OK) {
+        return status;
+    }
+    status = pr_patch_write_file(out_path, output, output_size);
+    pr_package_patch_free(output);
+    if (status == PR_STATUS_OK && out_size != NULL) {
+        *out_size = output_size;
+    }
+    return status;
+}
+
+pr_status_t pr_package_diff_files(
+    const char *old_path,
+    const char *new_path,
+    const char *patch_path,
+    size_t *out_patch_size
+)
+{
+    return pr_patch_run_files(old_path, new_path, patch_path, pr_package_diff, out_patch_size);
+}
+
+pr_status_t pr_package_patch_files(
+    const char *old_path,
+    const char *patch_path,
+    const char *out_path,
+    size_t *out_size
+)
+{
+    return pr_patch_run_files(old_path, patch_path, out_path, pr_package_patch, out_size);
+}
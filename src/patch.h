@@ -0,0 +1,26 @@
+#ifndef PACKRAT_PATCH_H
+#define PACKRAT_PATCH_H
+
+#include <stddef.h>
+
+#include "packrat/runtime.h"
+
+/* Uncompressed, untiled page levels are split into bands of whole rows of
+ * about this many bytes, so a change in one frame leaves the other bands
+ * reusable.
+ */
+#define PR_PATCH_BAND_BYTES 4096u
+
+/* Sorted, distinct offsets that cut `package` into the parts a patch reuses
+ * one by one: the header and chunk table, every chunk, and within TXTR each
+ * page level's stored data, split further at every tile of tiled levels and
+ * every band of uncompressed ones. Includes 0 and the package size.
+ * Implemented in runtime.c next to the chunk parsers.
+ */
+pr_status_t pr_package_part_offsets(
+    const pr_package_t *package,
+    size_t **out_offsets,
+    size_t *out_count
+);
+
+#endif
@@ -0,0 +1,148 @@
+#include "pixel_encode.h"
+
+#include "parallel.h"
+#include "profiler.h"
+
+typedef struct pr_pixel_encode_job {
+    pr_page_format_t format;
+    int dither;
+    const unsigned char *rgba;
+    uint32_t width;
+    uint32_t stride;
+    uint32_t row_bytes;
+    unsigned char *out;
+} pr_pixel_encode_job_t;
+
+/* 4x4 Bayer matrix; thresholds are (value + 0.5) / 16 of one step. */
+static const unsigned char PR_PIXEL_BAYER4[4][4] = {
+    { 0u, 8u, 2u, 10u },
+    { 12u, 4u, 14u, 6u },
+    { 3u, 11u, 1u, 9u },
+    { 15u, 7u, 13u, 5u }
+};
+
+/* Scales `value` to 0..`max`, adding `bias` (0..509, 255 rounds to nearest)
+ * before flooring.
+ */
+static uint32_t pr_pixel_quantize(uint32_t value, uint32_t max, uint32_t bias)
+{
+    uint32_t scaled;
+
+    scaled = (value * max * 2u + bias) / 510u;
+    return (scaled > max) ? max : scaled;
+}
+
+static void pr_pixel_encode_row(void *user_data, size_t y)
+{
+    const pr_pixel_encode_job_t *job;
+    const unsigned char *src;
+    unsigned char *dst;
+    uint32_t x;
+
+    job = (const pr_pixel_encode_job_t *)user_data;
+    src = job->rgba + y * (size_t)job->stride;
+    dst = job->out + y * (size_t)job->row_bytes;
+    for (x = 0u; x < job->width; ++x) {
+        const unsigned char *texel;
+        uint32_t bias;
+        uint32_t word;
+
+        texel = src + (size_t)x * 4u;
+        bias = (job->dither != 0) ?
+            (uint32_t)PR_PIXEL_BAYER4[y & 3u][x & 3u] * 32u + 15u : 255u;
+        switch (job->format) {
+        case PR_PAGE_FORMAT_RGB565:
+            word = (pr_pixel_quantize(texel[0], 31u, bias) << 11) |
+                (pr_pixel_quantize(texel[1], 63u, bias) << 5) |
+                pr_pixel_quantize(texel[2], 31u, bias);
+            dst[x * 2u] = (unsigned char)(word & 0xFFu);
+            dst[x * 2u + 1u] = (unsigned char)(word >> 8);
+            break;
+        case PR_PAGE_FORMAT_RGBA4444:
+            word = (pr_pixel_quantize(texel[0], 15u, bias) << 12) |
+                (pr_pixel_quantize(texel[1], 15u, bias) << 8) |
+                (pr_pixel_quantize(texel[2], 15u, bias) << 4) |
+                pr_pixel_quantize(texel[3], 15u, bias);
+            dst[x * 2u] = (unsigned char)(word & 0xFFu);
+            dst[x * 2u + 1u] = (unsigned char)(word >> 8);
+            break;
+        case PR_PAGE_FORMAT_R8:
+            dst[x] = texel[0];
+            break;
+        case PR_PAGE_FORMAT_RA8:
+            dst[x * 2u] = texel[0];
+            dst[x * 2u + 1u] = texel[3];
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int pr_pixel_encode_page(
+    pr_page_format_t format,
+    int dither,
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t stride,
+    unsigned char *out
+)
+{
+    pr_pixel_encode_job_t job;
+
+    if (rgba == NULL || out == NULL || width == 0u || height == 0u) {
+        return 0;
+    }
+    if (
+        format != PR_PAGE_FORMAT_RGB565 &&
+        format != PR_PAGE_FORMAT_RGBA4444 &&
+        format != PR_PAGE_FORMAT_R8 &&
+        format != PR_PAGE_FORMAT_RA8
+    ) {
+        return 0;
+    }
+
+    job.format = format;
+    job.dither = dither;
+    job.rgba = rgba;
+    job.width = width;
+    job.stride = stride;
+    job.row_bytes = width * pr_page_format_pixel_bytes(format);
+    job.out = out;
+
+    PR_PROFILE_BEGIN("pr_pixel_encode_page");
+    pr_parallel_for((size_t)height, pr_pixel_encode_row, &job);
+    PR_PROFILE_END("pr_pixel_encode_page");
+    return 1;
+}
+
+void pr_pixel_classify(
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    size_t stride,
+    int *io_gray,
+    int *io_opaque
+)
+{
+    uint32_t x;
+    uint32_t y;
+
+    for (y = 0u; y < height && (*io_gray != 0 || *io_opaque != 0); ++y) {
+        const unsigned char *row;
+
+        row = rgba + (size_t)y * stride;
+        for (x = 0u; x < width; ++x) {
+            const unsigned char *texel;
+
+            texel = row + (size_t)x * 4u;
+            if (texel[3] != 255u) {
+                *io_opaque = 0;
+            }
+            if (texel[3] != 0u && (texel[0] != texel[1] || texel[1] != texel[2])) {
+                *io_gray = 0;
+            }
+        }
+    }
+}
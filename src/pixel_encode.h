@@ -0,0 +1,39 @@
+#ifndef PACKRAT_PIXEL_ENCODE_H
+#define PACKRAT_PIXEL_ENCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "page_format.h"
+
+/* Converts an RGBA8 page to a reduced pixel `format` (RGB565, RGBA4444, R8
+ * or RA8). `out` must hold the `pr_page_format_layout` data size. Channels
+ * are rounded to the nearest step, or, with `dither`, the 16-bit formats add
+ * a 4x4 ordered dither keyed to the pixel position first. Rows are converted
+ * in parallel, and the output does not depend on the thread count.
+ *
+ * Returns 0 for RGBA8 and block formats.
+ */
+int pr_pixel_encode_page(
+    pr_page_format_t format,
+    int dither,
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    uint32_t stride,
+    unsigned char *out
+);
+
+/* Clears `*io_gray` when a texel that is not fully transparent has unequal
+ * color channels, and `*io_opaque` when a texel is not fully opaque.
+ */
+void pr_pixel_classify(
+    const unsigned char *rgba,
+    uint32_t width,
+    uint32_t height,
+    size_t stride,
+    int *io_gray,
+    int *io_opaque
+);
+
+#endif
@@ -0,0 +1,14 @@
+#include "profiler.h"
+
+#include <string.h>
+
+pr_profiler_hooks_t PR_PROFILER_HOOKS;
+
+void pr_profiler_set_hooks(const pr_profiler_hooks_t *hooks)
+{
+    if (hooks == NULL) {
+        memset(&PR_PROFILER_HOOKS, 0, sizeof(PR_PROFILER_HOOKS));
+        return;
+    }
+    PR_PROFILER_HOOKS = *hooks;
+}
@@ -0,0 +1,29 @@
+#ifndef PACKRAT_PROFILER_INTERNAL_H
+#define PACKRAT_PROFILER_INTERNAL_H
+
+#include "packrat/profiler.h"
+
+extern pr_profiler_hooks_t PR_PROFILER_HOOKS;
+
+#define PR_PROFILE_BEGIN(name) \
+    do { \
+        if (PR_PROFILER_HOOKS.zone_begin != NULL) { \
+            PR_PROFILER_HOOKS.zone_begin((name), PR_PROFILER_HOOKS.user_data); \
+        } \
+    } while (0)
+
+#define PR_PROFILE_END(name) \
+    do { \
+        if (PR_PROFILER_HOOKS.zone_end != NULL) { \
+            PR_PROFILER_HOOKS.zone_end((name), PR_PROFILER_HOOKS.user_data); \
+        } \
+    } while (0)
+
+#define PR_PROFILE_COUNTER(name, value) \
+    do { \
+        if (PR_PROFILER_HOOKS.counter != NULL) { \
+            PR_PROFILER_HOOKS.counter((name), (double)(value), PR_PROFILER_HOOKS.user_data); \
+        } \
+    } while (0)
+
+#endif
@@ -6,19 +6,45 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "checksum.h"
+#include "lz.h"
+#include "mipmap.h"
+#include "page_format.h"
+#include "parallel.h"
+#include "patch.h"
+#include "profiler.h"
+#include "timer.h"
+
 #define PR_CHUNK_ID_STRS "STRS"
 #define PR_CHUNK_ID_TXTR "TXTR"
 #define PR_CHUNK_ID_SPRT "SPRT"
 #define PR_CHUNK_ID_ANIM "ANIM"
 
+/* v2 extends the header with the chunk entry size, alignment and file size,
+ * and each chunk entry with flags, a codec, the uncompressed size and a
+ * checksum.
+ */
+#define PR_PACKAGE_VERSION_MAX 2u
 #define PR_PACKAGE_HEADER_SIZE_V1 24u
+#define PR_PACKAGE_HEADER_SIZE_V2 64u
 #define PR_CHUNK_TABLE_ENTRY_SIZE 20u
+#define PR_CHUNK_TABLE_ENTRY_SIZE_V2 40u
+#define PR_CHUNK_FLAG_CHECKSUM 1u
+#define PR_CHUNK_CODEC_NONE 0u
+
+/* v8 appends the atlas layout to the header. */
+#define PR_TXTR_HEADER_SIZE 28u
+#define PR_TXTR_HEADER_SIZE_V8 32u
+#define PR_TXTR_VERSION_MAX 9u
+#define PR_TXTR_DATA_ALIGNMENT 64u
 
 typedef struct pr_chunk_entry {
     char id[4];
     size_t offset;
     size_t size;
     const unsigned char *payload;
+    uint32_t flags;
+    uint32_t checksum;
 } pr_chunk_entry_t;
 
 typedef struct pr_sprite_meta {
@@ -33,12 +59,47 @@ typedef struct pr_animation_meta {
     uint32_t key_count;
 } pr_animation_meta_t;
 
+#ifdef PACKRAT_RUNTIME_COUNTERS
+typedef struct pr_package_counters {
+    unsigned long long sprite_lookups;
+    unsigned long long sprite_misses;
+    unsigned long long animation_lookups;
+    unsigned long long animation_misses;
+    unsigned long long atlas_page_accesses;
+} pr_package_counters_t;
+
+/* Lookups take a const package; the counters are the one mutable part. */
+#define PR_PACKAGE_COUNT(package, field) \
+    (((pr_package_counters_t *)&(package)->counters)->field += 1u)
+#else
+#define PR_PACKAGE_COUNT(package, field) ((void)0)
+#endif
+
+/* `data` points into the package bytes for uncompressed pages, at `decoded`
+ * once a compressed page has been decompressed, and is NULL before that.
+ * `palette` points into the package bytes too; only indexed8 pages have one,
+ * shared by their mip levels.
+ */
 typedef struct pr_atlas_page_view {
     uint32_t width;
     uint32_t height;
-    uint32_t stride;
-    const unsigned char *pixels;
-    uint32_t pixel_bytes;
+    pr_page_format_t format;
+    uint32_t row_bytes;
+    const unsigned char *data;
+    uint32_t data_bytes;
+    pr_page_compression_t compression;
+    const unsigned char *stored;
+    uint32_t stored_bytes;
+    uint32_t tile_size;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    unsigned char *decoded;
+    uint32_t level_count;
+    uint32_t first_mip;
+    pr_color_space_t color_space;
+    pr_alpha_mode_t alpha_mode;
+    const unsigned char *palette;
+    uint32_t palette_count;
 } pr_atlas_page_view_t;
 
 struct pr_package {
@@ -51,6 +112,12 @@ struct pr_package {
 
     unsigned int atlas_page_count;
     pr_atlas_page_view_t *atlas_pages;
+    /* Mip levels after the first, page by page; a page's level 1 is
+     * `atlas_mips[first_mip]`.
+     */
+    pr_atlas_page_view_t *atlas_mips;
+    unsigned int atlas_mip_count;
+    pr_atlas_layout_t atlas_layout;
     int has_txtr_chunk;
 
     pr_sprite_t *sprites;
@@ -64,6 +131,14 @@ struct pr_package {
 
     pr_anim_frame_t *animation_frames;
     unsigned int animation_frame_count;
+
+    double read_ms;
+    double parse_ms;
+    unsigned int chunk_stats_count;
+    pr_package_chunk_stats_t chunk_stats[PR_PACKAGE_STATS_MAX_CHUNKS];
+#ifdef PACKRAT_RUNTIME_COUNTERS
+    pr_package_counters_t counters;
+#endif
 };
 
 static int pr_can_read(size_t total_size, size_t offset, size_t byte_count)
@@ -173,7 +248,9 @@ static pr_status_t pr_parse_chunk_table(
     uint16_t version_minor;
     uint32_t header_size;
     uint32_t chunk_count;
+    uint32_t entry_size;
     uint64_t chunk_table_offset64;
+    uint64_t file_size64;
     size_t chunk_table_offset;
     size_t chunk_table_size;
     pr_chunk_entry_t *chunks;
@@ -207,19 +284,36 @@ static pr_status_t pr_parse_chunk_table(
     }
     (void)version_minor;
 
-    if (version_major == 0u || header_size < PR_PACKAGE_HEADER_SIZE_V1) {
+    if (
+        version_major == 0u ||
+        version_major > PR_PACKAGE_VERSION_MAX ||
+        header_size < PR_PACKAGE_HEADER_SIZE_V1
+    ) {
         return PR_STATUS_PARSE_ERROR;
     }
+    entry_size = PR_CHUNK_TABLE_ENTRY_SIZE;
+    if (version_major >= 2u) {
+        /* The alignment at offset 28 only matters to writers. */
+        if (
+            header_size < PR_PACKAGE_HEADER_SIZE_V2 ||
+            !pr_read_u32_le(bytes, size, 24u, &entry_size) ||
+            !pr_read_u64_le(bytes, size, 32u, &file_size64) ||
+            entry_size < PR_CHUNK_TABLE_ENTRY_SIZE_V2 ||
+            file_size64 != (uint64_t)size
+        ) {
+            return PR_STATUS_PARSE_ERROR;
+        }
+    }
     if (!pr_u64_to_size(chunk_table_offset64, &chunk_table_offset)) {
         return PR_STATUS_PARSE_ERROR;
     }
     if (chunk_count == 0u) {
         return PR_STATUS_PARSE_ERROR;
     }
-    if ((size_t)chunk_count > SIZE_MAX / PR_CHUNK_TABLE_ENTRY_SIZE) {
+    if ((size_t)chunk_count > SIZE_MAX / entry_size) {
         return PR_STATUS_PARSE_ERROR;
     }
-    chunk_table_size = (size_t)chunk_count * PR_CHUNK_TABLE_ENTRY_SIZE;
+    chunk_table_size = (size_t)chunk_count * entry_size;
     if (!pr_can_read(size, chunk_table_offset, chunk_table_size)) {
         return PR_STATUS_PARSE_ERROR;
     }
@@ -231,14 +325,39 @@ static pr_status_t pr_parse_chunk_table(
 
     for (i = 0u; i < chunk_count; ++i) {
         size_t cursor;
+        size_t field;
         uint64_t payload_offset64;
         uint64_t payload_size64;
+        uint64_t uncompressed_size64;
+        uint32_t codec;
 
-        cursor = chunk_table_offset + (size_t)i * PR_CHUNK_TABLE_ENTRY_SIZE;
+        cursor = chunk_table_offset + (size_t)i * entry_size;
         memcpy(chunks[i].id, bytes + cursor, 4u);
+        field = cursor + 4u;
+        if (version_major >= 2u) {
+            if (!pr_read_u32_le(bytes, size, field, &chunks[i].flags)) {
+                free(chunks);
+                return PR_STATUS_PARSE_ERROR;
+            }
+            field += 4u;
+        }
         if (
-            !pr_read_u64_le(bytes, size, cursor + 4u, &payload_offset64) ||
-            !pr_read_u64_le(bytes, size, cursor + 12u, &payload_size64)
+            !pr_read_u64_le(bytes, size, field, &payload_offset64) ||
+            !pr_read_u64_le(bytes, size, field + 8u, &payload_size64)
+        ) {
+            free(chunks);
+            return PR_STATUS_PARSE_ERROR;
+        }
+        /* No codec is defined yet, so a chunk is always stored as is. */
+        if (
+            version_major >= 2u &&
+            (
+                !pr_read_u64_le(bytes, size, field + 16u, &uncompressed_size64) ||
+                !pr_read_u32_le(bytes, size, field + 24u, &codec) ||
+                !pr_read_u32_le(bytes, size, field + 28u, &chunks[i].checksum) ||
+                codec != PR_CHUNK_CODEC_NONE ||
+                uncompressed_size64 != payload_size64
+            )
         ) {
             free(chunks);
             return PR_STATUS_PARSE_ERROR;
@@ -262,8 +381,61 @@ static pr_status_t pr_parse_chunk_table(
     return PR_STATUS_OK;
 }
 
+typedef struct pr_chunk_verify_batch {
+    const pr_chunk_entry_t *chunks;
+    unsigned char *mismatched;
+} pr_chunk_verify_batch_t;
+
+static void pr_chunk_verify_batch_run(void *user_data, size_t index)
+{
+    pr_chunk_verify_batch_t *batch;
+    const pr_chunk_entry_t *chunk;
+
+    batch = (pr_chunk_verify_batch_t *)user_data;
+    chunk = &batch->chunks[index];
+    if ((chunk->flags & PR_CHUNK_FLAG_CHECKSUM) == 0u) {
+        return;
+    }
+    batch->mismatched[index] = (
+        pr_crc32c(0u, chunk->payload, chunk->size) != chunk->checksum
+    ) ? 1u : 0u;
+}
+
+/* Checks every chunk that carries a checksum, one chunk per task; v1
+ * packages have none.
+ */
+static pr_status_t pr_verify_chunk_checksums(
+    const pr_chunk_entry_t *chunks,
+    uint32_t chunk_count
+)
+{
+    pr_chunk_verify_batch_t batch;
+    unsigned char *mismatched;
+    uint32_t i;
+
+    mismatched = (unsigned char *)calloc((size_t)chunk_count, sizeof(mismatched[0]));
+    if (mismatched == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    batch.chunks = chunks;
+    batch.mismatched = mismatched;
+    pr_parallel_for((size_t)chunk_count, pr_chunk_verify_batch_run, &batch);
+
+    for (i = 0u; i < chunk_count; ++i) {
+        if (mismatched[i] != 0u) {
+            free(mismatched);
+            return PR_STATUS_PARSE_ERROR;
+        }
+    }
+    free(mismatched);
+    return PR_STATUS_OK;
+}
+
 static void pr_package_clear_parsed_data(pr_package_t *package)
 {
+    unsigned int i;
+
     if (package == NULL) {
         return;
     }
@@ -272,8 +444,17 @@ static void pr_package_clear_parsed_data(pr_package_t *package)
     package->strings = NULL;
     package->string_count = 0u;
 
+    for (i = 0u; package->atlas_pages != NULL && i < package->atlas_page_count; ++i) {
+        free(package->atlas_pages[i].decoded);
+    }
     free(package->atlas_pages);
     package->atlas_pages = NULL;
+    for (i = 0u; package->atlas_mips != NULL && i < package->atlas_mip_count; ++i) {
+        free(package->atlas_mips[i].decoded);
+    }
+    free(package->atlas_mips);
+    package->atlas_mips = NULL;
+    package->atlas_mip_count = 0u;
     package->has_txtr_chunk = 0;
 
     free(package->sprites);
@@ -371,6 +552,131 @@ static pr_status_t pr_parse_chunk_strs(
     return PR_STATUS_OK;
 }
 
+/* Checks a tiled page's offset table: offsets start at 0, never decrease,
+ * end at the stored tile data size, and no tile is stored larger than it is
+ * raw. Fills in the tile grid.
+ */
+static int pr_atlas_page_tiles_valid(pr_atlas_page_view_t *page)
+{
+    size_t tile_count;
+    size_t table_bytes;
+    uint32_t previous;
+    uint32_t tile_x;
+    uint32_t tile_y;
+    size_t k;
+
+    if (
+        page->data_bytes == 0u ||
+        !pr_page_tile_grid(page->width, page->height, page->tile_size, &page->tiles_x, &page->tiles_y)
+    ) {
+        return 0;
+    }
+    tile_count = (size_t)page->tiles_x * page->tiles_y;
+    table_bytes = (tile_count + 1u) * 4u;
+    if (table_bytes > page->stored_bytes) {
+        return 0;
+    }
+
+    k = 0u;
+    if (!pr_read_u32_le(page->stored, page->stored_bytes, 0u, &previous) || previous != 0u) {
+        return 0;
+    }
+    for (tile_y = 0u; tile_y < page->tiles_y; ++tile_y) {
+        for (tile_x = 0u; tile_x < page->tiles_x; ++tile_x) {
+            pr_page_tile_t tile;
+            uint32_t next;
+
+            k += 1u;
+            if (
+                !pr_read_u32_le(page->stored, page->stored_bytes, k * 4u, &next) ||
+                next < previous ||
+                !pr_page_tile_at(page->format, page->width, page->height, page->tile_size, tile_x, tile_y, &tile) ||
+                (uint64_t)(next - previous) > (uint64_t)tile.rows * tile.row_bytes
+            ) {
+                return 0;
+            }
+            previous = next;
+        }
+    }
+    return (size_t)previous == page->stored_bytes - table_bytes;
+}
+
+/* Reads the part of a page record that describes one level's data:
+ * compression, tile size, data size and stored size (as far as `version`
+ * has them), then the stored bytes. `level` has its size and format set.
+ */
+static int pr_parse_txtr_level(
+    const pr_chunk_entry_t *chunk,
+    uint32_t version,
+    size_t *io_cursor,
+    pr_atlas_page_view_t *level
+)
+{
+    uint32_t compression;
+    uint32_t tile_size;
+    uint32_t pixel_blob_size;
+    uint32_t stored_size;
+    uint32_t expected_bytes;
+    size_t cursor;
+    int fields_ok;
+
+    cursor = *io_cursor;
+    compression = (uint32_t)PR_PAGE_COMPRESSION_NONE;
+    tile_size = 0u;
+    fields_ok = 1;
+    if (version >= 3u) {
+        fields_ok = pr_read_u32_le(chunk->payload, chunk->size, cursor, &compression);
+        cursor += 4u;
+    }
+    if (fields_ok && version >= 4u) {
+        fields_ok = pr_read_u32_le(chunk->payload, chunk->size, cursor, &tile_size);
+        cursor += 4u;
+    }
+    fields_ok = fields_ok && pr_read_u32_le(chunk->payload, chunk->size, cursor, &pixel_blob_size);
+    cursor += 4u;
+    stored_size = pixel_blob_size;
+    if (fields_ok && version >= 3u) {
+        fields_ok = pr_read_u32_le(chunk->payload, chunk->size, cursor, &stored_size);
+        cursor += 4u;
+    }
+    if (fields_ok && version >= 9u) {
+        cursor = ((cursor + PR_TXTR_DATA_ALIGNMENT - 1u) / PR_TXTR_DATA_ALIGNMENT) *
+            PR_TXTR_DATA_ALIGNMENT;
+    }
+    if (!fields_ok || !pr_can_read(chunk->size, cursor, (size_t)stored_size)) {
+        return 0;
+    }
+
+    if (
+        !pr_page_format_layout(level->format, level->width, level->height, &level->row_bytes, &expected_bytes) ||
+        (pixel_blob_size != 0u && pixel_blob_size != expected_bytes) ||
+        compression > (uint32_t)PR_PAGE_COMPRESSION_LZ ||
+        (compression == (uint32_t)PR_PAGE_COMPRESSION_NONE && stored_size != pixel_blob_size) ||
+        (
+            tile_size != 0u &&
+            (
+                compression == (uint32_t)PR_PAGE_COMPRESSION_NONE ||
+                tile_size < PR_PAGE_TILE_SIZE_MIN ||
+                tile_size > PR_PAGE_TILE_SIZE_MAX
+            )
+        )
+    ) {
+        return 0;
+    }
+
+    level->data_bytes = pixel_blob_size;
+    level->compression = (pr_page_compression_t)compression;
+    level->stored = (stored_size > 0u) ? (chunk->payload + cursor) : NULL;
+    level->stored_bytes = stored_size;
+    level->data = (compression == (uint32_t)PR_PAGE_COMPRESSION_NONE) ? level->stored : NULL;
+    level->tile_size = tile_size;
+    if (tile_size != 0u && !pr_atlas_page_tiles_valid(level)) {
+        return 0;
+    }
+    *io_cursor = cursor + (size_t)stored_size;
+    return 1;
+}
+
 static pr_status_t pr_parse_chunk_txtr(
     pr_package_t *package,
     const pr_chunk_entry_t *chunk
@@ -378,10 +684,16 @@ static pr_status_t pr_parse_chunk_txtr(
 {
     uint32_t version;
     uint32_t page_count;
+    uint32_t layout;
+    size_t header_size;
     pr_atlas_page_view_t *pages;
+    pr_atlas_page_view_t *mips;
+    size_t mip_count;
+    size_t mip_capacity;
     unsigned char *seen_pages;
     size_t cursor;
     uint32_t i;
+    pr_status_t status;
 
     if (package == NULL || chunk == NULL) {
         return PR_STATUS_INVALID_ARGUMENT;
@@ -393,11 +705,29 @@ static pr_status_t pr_parse_chunk_txtr(
     ) {
         return PR_STATUS_PARSE_ERROR;
     }
-    if (version != 1u) {
+    if (version < 1u || version > PR_TXTR_VERSION_MAX) {
+        return PR_STATUS_PARSE_ERROR;
+    }
+    header_size = (version >= 8u) ? PR_TXTR_HEADER_SIZE_V8 : PR_TXTR_HEADER_SIZE;
+    /* Every page record takes at least 16 bytes. */
+    if (chunk->size < header_size || page_count > (chunk->size - header_size) / 16u) {
+        return PR_STATUS_PARSE_ERROR;
+    }
+    layout = (uint32_t)PR_ATLAS_LAYOUT_PAGES;
+    if (
+        version >= 8u &&
+        (
+            !pr_read_u32_le(chunk->payload, chunk->size, PR_TXTR_HEADER_SIZE, &layout) ||
+            layout > (uint32_t)PR_ATLAS_LAYOUT_ARRAY
+        )
+    ) {
         return PR_STATUS_PARSE_ERROR;
     }
 
     pages = NULL;
+    mips = NULL;
+    mip_count = 0u;
+    mip_capacity = 0u;
     seen_pages = NULL;
     if (page_count > 0u) {
         pages = (pr_atlas_page_view_t *)calloc((size_t)page_count, sizeof(pages[0]));
@@ -409,90 +739,168 @@ static pr_status_t pr_parse_chunk_txtr(
         }
     }
 
-    cursor = 28u;
+    status = PR_STATUS_PARSE_ERROR;
+    cursor = header_size;
     if (!pr_can_read(chunk->size, 0u, cursor)) {
-        free(pages);
-        free(seen_pages);
-        return PR_STATUS_PARSE_ERROR;
+        goto fail;
     }
 
     for (i = 0u; i < page_count; ++i) {
         uint32_t page_index;
         uint32_t width;
         uint32_t height;
-        uint32_t pixel_blob_size;
-        uint64_t expected_bytes64;
-        uint32_t stride;
-
-        if (
-            !pr_read_u32_le(chunk->payload, chunk->size, cursor + 0u, &page_index) ||
-            !pr_read_u32_le(chunk->payload, chunk->size, cursor + 4u, &width) ||
-            !pr_read_u32_le(chunk->payload, chunk->size, cursor + 8u, &height) ||
-            !pr_read_u32_le(chunk->payload, chunk->size, cursor + 12u, &pixel_blob_size)
-        ) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+        uint32_t format;
+        uint32_t level_count;
+        uint32_t color_space;
+        uint32_t alpha_mode;
+        uint32_t palette_count;
+        uint32_t level;
+        pr_atlas_page_view_t page;
+        int fields_ok;
+
+        /* Each version appends fields to the page record: v2 the format
+         * (v1 pages are RGBA8), v3 the compression and stored size, v4 the
+         * tile size, v5 the mip level count, each level after the first
+         * repeating the fields from the compression on, v6 the color space
+         * and alpha mode (older pages are straight sRGB), v7 the palette.
+         * v9 pads the chunk before each level's data to a 64-byte offset.
+         */
+        format = (uint32_t)PR_PAGE_FORMAT_RGBA8;
+        level_count = 1u;
+        color_space = (uint32_t)PR_COLOR_SPACE_SRGB;
+        alpha_mode = (uint32_t)PR_ALPHA_MODE_STRAIGHT;
+        palette_count = 0u;
+        fields_ok = (
+            pr_read_u32_le(chunk->payload, chunk->size, cursor + 0u, &page_index) &&
+            pr_read_u32_le(chunk->payload, chunk->size, cursor + 4u, &width) &&
+            pr_read_u32_le(chunk->payload, chunk->size, cursor + 8u, &height)
+        );
+        cursor += 12u;
+        if (fields_ok && version >= 2u) {
+            fields_ok = pr_read_u32_le(chunk->payload, chunk->size, cursor, &format);
+            cursor += 4u;
         }
-
-        cursor += 16u;
-        if (!pr_can_read(chunk->size, cursor, (size_t)pixel_blob_size)) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+        if (fields_ok && version >= 5u) {
+            fields_ok = pr_read_u32_le(chunk->payload, chunk->size, cursor, &level_count);
+            cursor += 4u;
+        }
+        if (fields_ok && version >= 6u) {
+            fields_ok = (
+                pr_read_u32_le(chunk->payload, chunk->size, cursor + 0u, &color_space) &&
+                pr_read_u32_le(chunk->payload, chunk->size, cursor + 4u, &alpha_mode)
+            );
+            cursor += 8u;
+        }
+        if (fields_ok && version >= 7u) {
+            fields_ok = (
+                pr_read_u32_le(chunk->payload, chunk->size, cursor, &palette_count) &&
+                palette_count <= 256u &&
+                pr_can_read(chunk->size, cursor + 4u, (size_t)palette_count * 4u)
+            );
+            cursor += 4u;
         }
-
         if (
+            !fields_ok ||
             page_index >= page_count ||
             seen_pages[page_index] != 0u ||
             width == 0u ||
-            height == 0u
+            height == 0u ||
+            level_count == 0u ||
+            level_count > pr_mipmap_level_count(width, height) ||
+            color_space > (uint32_t)PR_COLOR_SPACE_LINEAR ||
+            alpha_mode > (uint32_t)PR_ALPHA_MODE_PREMULTIPLIED ||
+            (format == (uint32_t)PR_PAGE_FORMAT_INDEXED8) != (palette_count > 0u)
         ) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+            goto fail;
         }
 
-        expected_bytes64 = (uint64_t)width * (uint64_t)height * 4u;
-        if (expected_bytes64 > (uint64_t)UINT32_MAX) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+        memset(&page, 0, sizeof(page));
+        page.width = width;
+        page.height = height;
+        page.format = (pr_page_format_t)format;
+        page.level_count = level_count;
+        page.first_mip = (uint32_t)mip_count;
+        page.color_space = (pr_color_space_t)color_space;
+        page.alpha_mode = (pr_alpha_mode_t)alpha_mode;
+        page.palette = (palette_count > 0u) ? chunk->payload + cursor : NULL;
+        page.palette_count = palette_count;
+        cursor += (size_t)palette_count * 4u;
+        if (!pr_parse_txtr_level(chunk, version, &cursor, &page)) {
+            goto fail;
         }
-        stride = width * 4u;
-        if (pixel_blob_size != 0u && pixel_blob_size != (uint32_t)expected_bytes64) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+
+        if (mip_count + (level_count - 1u) > mip_capacity) {
+            pr_atlas_page_view_t *grown;
+            size_t capacity;
+
+            capacity = (mip_capacity > 0u) ? mip_capacity * 2u : 16u;
+            while (capacity < mip_count + (level_count - 1u)) {
+                capacity *= 2u;
+            }
+            grown = (pr_atlas_page_view_t *)realloc(mips, capacity * sizeof(mips[0]));
+            if (grown == NULL) {
+                status = PR_STATUS_ALLOCATION_FAILED;
+                goto fail;
+            }
+            mips = grown;
+            mip_capacity = capacity;
+        }
+        for (level = 1u; level < level_count; ++level) {
+            pr_atlas_page_view_t *mip;
+
+            mip = &mips[mip_count];
+            memset(mip, 0, sizeof(*mip));
+            pr_mipmap_level_size(width, height, level, &mip->width, &mip->height);
+            mip->format = page.format;
+            mip->level_count = 1u;
+            if (!pr_parse_txtr_level(chunk, version, &cursor, mip)) {
+                goto fail;
+            }
+            mip_count += 1u;
         }
 
-        pages[page_index].width = width;
-        pages[page_index].height = height;
-        pages[page_index].stride = stride;
-        pages[page_index].pixel_bytes = pixel_blob_size;
-        pages[page_index].pixels = (pixel_blob_size > 0u) ? (chunk->payload + cursor) : NULL;
+        pages[page_index] = page;
         seen_pages[page_index] = 1u;
-        cursor += (size_t)pixel_blob_size;
     }
 
     if (cursor != chunk->size) {
-        free(pages);
-        free(seen_pages);
-        return PR_STATUS_PARSE_ERROR;
+        goto fail;
     }
     for (i = 0u; i < page_count; ++i) {
         if (seen_pages[i] == 0u) {
-            free(pages);
-            free(seen_pages);
-            return PR_STATUS_PARSE_ERROR;
+            goto fail;
+        }
+    }
+    /* Array layers must be interchangeable, so their mip levels match too. */
+    if (layout == (uint32_t)PR_ATLAS_LAYOUT_ARRAY) {
+        for (i = 1u; i < page_count; ++i) {
+            if (
+                pages[i].width != pages[0].width ||
+                pages[i].height != pages[0].height ||
+                pages[i].format != pages[0].format ||
+                pages[i].level_count != pages[0].level_count ||
+                pages[i].color_space != pages[0].color_space ||
+                pages[i].alpha_mode != pages[0].alpha_mode
+            ) {
+                goto fail;
+            }
         }
     }
 
     free(seen_pages);
     package->atlas_pages = pages;
     package->atlas_page_count = page_count;
+    package->atlas_mips = mips;
+    package->atlas_mip_count = (unsigned int)mip_count;
+    package->atlas_layout = (pr_atlas_layout_t)layout;
     package->has_txtr_chunk = 1;
     return PR_STATUS_OK;
+
+fail:
+    free(pages);
+    free(mips);
+    free(seen_pages);
+    return status;
 }
 
 static pr_status_t pr_parse_chunk_sprt(
@@ -895,7 +1303,32 @@ static pr_status_t pr_parse_chunk_anim(
     return PR_STATUS_OK;
 }
 
-static pr_status_t pr_parse_loaded_package(pr_package_t *package)
+typedef pr_status_t (*pr_chunk_parse_fn)(pr_package_t *package, const pr_chunk_entry_t *chunk);
+
+static pr_status_t pr_package_timed_chunk_parse(
+    pr_package_t *package,
+    const pr_chunk_entry_t *chunks,
+    const pr_chunk_entry_t *chunk,
+    const char *zone_name,
+    pr_chunk_parse_fn parse
+)
+{
+    pr_status_t status;
+    size_t index;
+    double start;
+
+    start = pr_timer_now_ms();
+    PR_PROFILE_BEGIN(zone_name);
+    status = parse(package, chunk);
+    PR_PROFILE_END(zone_name);
+    index = (size_t)(chunk - chunks);
+    if (index < package->chunk_stats_count) {
+        package->chunk_stats[index].parse_ms = pr_timer_now_ms() - start;
+    }
+    return status;
+}
+
+static pr_status_t pr_parse_loaded_package(pr_package_t *package, unsigned int flags)
 {
     pr_chunk_entry_t *chunks;
     uint32_t chunk_count;
@@ -904,17 +1337,44 @@ static pr_status_t pr_parse_loaded_package(pr_package_t *package)
     const pr_chunk_entry_t *sprt_chunk;
     const pr_chunk_entry_t *anim_chunk;
     pr_status_t status;
+    double parse_start;
+    uint32_t i;
 
     if (package == NULL || package->bytes == NULL || package->size == 0u) {
         return PR_STATUS_INVALID_ARGUMENT;
     }
 
+    parse_start = pr_timer_now_ms();
     chunks = NULL;
     chunk_count = 0u;
+    PR_PROFILE_BEGIN("pr_parse_chunk_table");
     status = pr_parse_chunk_table(package->bytes, package->size, &chunks, &chunk_count);
+    PR_PROFILE_END("pr_parse_chunk_table");
     if (status != PR_STATUS_OK) {
         return status;
     }
+    /* Checksums are opt-in: a plain open still validates every record. */
+    if ((flags & PR_PACKAGE_OPEN_VERIFY_CHECKSUMS) != 0u) {
+        PR_PROFILE_BEGIN("pr_verify_chunk_checksums");
+        status = pr_verify_chunk_checksums(chunks, chunk_count);
+        PR_PROFILE_END("pr_verify_chunk_checksums");
+        if (status != PR_STATUS_OK) {
+            free(chunks);
+            return status;
+        }
+    }
+
+    package->chunk_stats_count = 0u;
+    for (i = 0u; i < chunk_count && i < PR_PACKAGE_STATS_MAX_CHUNKS; ++i) {
+        pr_package_chunk_stats_t *stats;
+
+        stats = &package->chunk_stats[i];
+        memcpy(stats->id, chunks[i].id, 4u);
+        stats->id[4] = '\0';
+        stats->bytes = (unsigned long long)chunks[i].size;
+        stats->parse_ms = 0.0;
+        package->chunk_stats_count += 1u;
+    }
 
     strs_chunk = pr_find_chunk(chunks, chunk_count, PR_CHUNK_ID_STRS);
     txtr_chunk = pr_find_chunk(chunks, chunk_count, PR_CHUNK_ID_TXTR);
@@ -926,7 +1386,13 @@ static pr_status_t pr_parse_loaded_package(pr_package_t *package)
         return PR_STATUS_PARSE_ERROR;
     }
 
-    status = pr_parse_chunk_strs(package, strs_chunk);
+    status = pr_package_timed_chunk_parse(
+        package,
+        chunks,
+        strs_chunk,
+        "pr_parse_chunk_strs",
+        pr_parse_chunk_strs
+    );
     if (status != PR_STATUS_OK) {
         free(chunks);
         pr_package_clear_parsed_data(package);
@@ -934,7 +1400,13 @@ static pr_status_t pr_parse_loaded_package(pr_package_t *package)
     }
 
     if (txtr_chunk != NULL) {
-        status = pr_parse_chunk_txtr(package, txtr_chunk);
+        status = pr_package_timed_chunk_parse(
+            package,
+            chunks,
+            txtr_chunk,
+            "pr_parse_chunk_txtr",
+            pr_parse_chunk_txtr
+        );
         if (status != PR_STATUS_OK) {
             free(chunks);
             pr_package_clear_parsed_data(package);
@@ -942,14 +1414,26 @@ static pr_status_t pr_parse_loaded_package(pr_package_t *package)
         }
     }
 
-    status = pr_parse_chunk_sprt(package, sprt_chunk);
+    status = pr_package_timed_chunk_parse(
+        package,
+        chunks,
+        sprt_chunk,
+        "pr_parse_chunk_sprt",
+        pr_parse_chunk_sprt
+    );
     if (status != PR_STATUS_OK) {
         free(chunks);
         pr_package_clear_parsed_data(package);
         return status;
     }
 
-    status = pr_parse_chunk_anim(package, anim_chunk);
+    status = pr_package_timed_chunk_parse(
+        package,
+        chunks,
+        anim_chunk,
+        "pr_parse_chunk_anim",
+        pr_parse_chunk_anim
+    );
     if (status != PR_STATUS_OK) {
         free(chunks);
         pr_package_clear_parsed_data(package);
@@ -957,6 +1441,7 @@ static pr_status_t pr_parse_loaded_package(pr_package_t *package)
     }
 
     free(chunks);
+    package->parse_ms = pr_timer_now_ms() - parse_start;
     return PR_STATUS_OK;
 }
 
@@ -1010,22 +1495,32 @@ static unsigned char *pr_read_binary_file(const char *path, size_t *out_size)
     return buffer;
 }
 
-pr_status_t pr_package_open_file(const char *path, pr_package_t **out_package)
+pr_status_t pr_package_open_file_ex(
+    const char *path,
+    unsigned int flags,
+    pr_package_t **out_package
+)
 {
     pr_package_t *package;
     size_t size;
     unsigned char *bytes;
     pr_status_t status;
+    double read_start;
+    double read_ms;
 
     if (path == NULL || out_package == NULL) {
         return PR_STATUS_INVALID_ARGUMENT;
     }
 
     *out_package = NULL;
+    read_start = pr_timer_now_ms();
+    PR_PROFILE_BEGIN("pr_read_binary_file");
     bytes = pr_read_binary_file(path, &size);
+    PR_PROFILE_END("pr_read_binary_file");
     if (bytes == NULL) {
         return PR_STATUS_IO_ERROR;
     }
+    read_ms = pr_timer_now_ms() - read_start;
 
     package = (pr_package_t *)calloc(1u, sizeof(*package));
     if (package == NULL) {
@@ -1036,26 +1531,37 @@ pr_status_t pr_package_open_file(const char *path, pr_package_t **out_package)
     package->owned_bytes = bytes;
     package->bytes = bytes;
     package->size = size;
+    package->read_ms = read_ms;
 
-    status = pr_parse_loaded_package(package);
+    PR_PROFILE_BEGIN("pr_parse_loaded_package");
+    status = pr_parse_loaded_package(package, flags);
+    PR_PROFILE_END("pr_parse_loaded_package");
     if (status != PR_STATUS_OK) {
         pr_package_close(package);
         return status;
     }
 
+    PR_PROFILE_COUNTER("packrat.package_bytes", (double)package->size);
     *out_package = package;
     return PR_STATUS_OK;
 }
 
-pr_status_t pr_package_open_memory(
+pr_status_t pr_package_open_file(const char *path, pr_package_t **out_package)
+{
+    return pr_package_open_file_ex(path, 0u, out_package);
+}
+
+pr_status_t pr_package_open_memory_ex(
     const void *data,
     size_t size,
+    unsigned int flags,
     pr_package_t **out_package
 )
 {
     pr_package_t *package;
     unsigned char *copy;
     pr_status_t status;
+    double read_start;
 
     if (data == NULL || size == 0u || out_package == NULL) {
         return PR_STATUS_INVALID_ARGUMENT;
@@ -1067,6 +1573,7 @@ pr_status_t pr_package_open_memory(
         return PR_STATUS_ALLOCATION_FAILED;
     }
 
+    read_start = pr_timer_now_ms();
     copy = (unsigned char *)malloc(size);
     if (copy == NULL) {
         free(package);
@@ -1077,17 +1584,30 @@ pr_status_t pr_package_open_memory(
     package->owned_bytes = copy;
     package->bytes = copy;
     package->size = size;
+    package->read_ms = pr_timer_now_ms() - read_start;
 
-    status = pr_parse_loaded_package(package);
+    PR_PROFILE_BEGIN("pr_parse_loaded_package");
+    status = pr_parse_loaded_package(package, flags);
+    PR_PROFILE_END("pr_parse_loaded_package");
     if (status != PR_STATUS_OK) {
         pr_package_close(package);
         return status;
     }
 
+    PR_PROFILE_COUNTER("packrat.package_bytes", (double)package->size);
     *out_package = package;
     return PR_STATUS_OK;
 }
 
+pr_status_t pr_package_open_memory(
+    const void *data,
+    size_t size,
+    pr_package_t **out_package
+)
+{
+    return pr_package_open_memory_ex(data, size, 0u, out_package);
+}
+
 void pr_package_close(pr_package_t *package)
 {
     if (package == NULL) {
@@ -1115,11 +1635,13 @@ const pr_sprite_t *pr_package_find_sprite(
         return NULL;
     }
 
+    PR_PACKAGE_COUNT(package, sprite_lookups);
     for (i = 0u; i < package->sprite_count; ++i) {
         if (package->sprites[i].id != NULL && strcmp(package->sprites[i].id, sprite_id) == 0) {
             return &package->sprites[i];
         }
     }
+    PR_PACKAGE_COUNT(package, sprite_misses);
     return NULL;
 }
 
@@ -1134,6 +1656,7 @@ const pr_animation_t *pr_package_find_animation(
         return NULL;
     }
 
+    PR_PACKAGE_COUNT(package, animation_lookups);
     for (i = 0u; i < package->animation_count; ++i) {
         if (
             package->animations[i].id != NULL &&
@@ -1142,6 +1665,7 @@ const pr_animation_t *pr_package_find_animation(
             return &package->animations[i];
         }
     }
+    PR_PACKAGE_COUNT(package, animation_misses);
     return NULL;
 }
 
@@ -1206,6 +1730,14 @@ unsigned int pr_package_atlas_page_count(const pr_package_t *package)
     return package->atlas_page_count;
 }
 
+pr_atlas_layout_t pr_package_atlas_layout(const pr_package_t *package)
+{
+    if (package == NULL) {
+        return PR_ATLAS_LAYOUT_PAGES;
+    }
+    return package->atlas_layout;
+}
+
 const unsigned char *pr_package_atlas_page_pixels(
     const pr_package_t *package,
     unsigned int index,
@@ -1225,6 +1757,12 @@ const unsigned char *pr_package_atlas_page_pixels(
     }
 
     page = &package->atlas_pages[index];
+    if (page->format != PR_PAGE_FORMAT_RGBA8) {
+        return NULL;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_atlas_page_pixels");
+    PR_PACKAGE_COUNT(package, atlas_page_accesses);
     if (out_width != NULL) {
         *out_width = page->width;
     }
@@ -1232,9 +1770,545 @@ const unsigned char *pr_package_atlas_page_pixels(
         *out_height = page->height;
     }
     if (out_stride != NULL) {
-        *out_stride = page->stride;
+        *out_stride = page->row_bytes;
+    }
+    PR_PROFILE_END("pr_package_atlas_page_pixels");
+    return page->data;
+}
+
+/* View of mip `level` of page `index`, or NULL when either is out of range. */
+static pr_atlas_page_view_t *pr_atlas_page_level(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level
+)
+{
+    pr_atlas_page_view_t *page;
+
+    if (
+        package == NULL ||
+        index >= package->atlas_page_count ||
+        package->atlas_pages == NULL
+    ) {
+        return NULL;
+    }
+    page = &package->atlas_pages[index];
+    if (level >= page->level_count) {
+        return NULL;
+    }
+    return (level == 0u) ? page : &package->atlas_mips[page->first_mip + level - 1u];
+}
+
+static void pr_atlas_page_fill_info(
+    const pr_atlas_page_view_t *page,
+    const pr_atlas_page_view_t *level,
+    pr_atlas_page_info_t *out_info
+)
+{
+    out_info->width = level->width;
+    out_info->height = level->height;
+    out_info->format = level->format;
+    out_info->row_bytes = level->row_bytes;
+    out_info->data_size = (size_t)level->data_bytes;
+    out_info->compression = level->compression;
+    out_info->stored_size = (size_t)level->stored_bytes;
+    out_info->tile_size = level->tile_size;
+    out_info->level_count = page->level_count;
+    out_info->color_space = page->color_space;
+    out_info->alpha_mode = page->alpha_mode;
+    out_info->palette_count = page->palette_count;
+}
+
+const void *pr_package_atlas_page_data(
+    const pr_package_t *package,
+    unsigned int index,
+    pr_atlas_page_info_t *out_info
+)
+{
+    const pr_atlas_page_view_t *page;
+
+    page = pr_atlas_page_level(package, index, 0u);
+    if (page == NULL) {
+        return NULL;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_atlas_page_data");
+    PR_PACKAGE_COUNT(package, atlas_page_accesses);
+    if (out_info != NULL) {
+        pr_atlas_page_fill_info(page, page, out_info);
+    }
+    PR_PROFILE_END("pr_package_atlas_page_data");
+    return page->data;
+}
+
+const void *pr_package_atlas_page_level_data(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    pr_atlas_page_info_t *out_info
+)
+{
+    const pr_atlas_page_view_t *view;
+
+    view = pr_atlas_page_level(package, index, level);
+    if (view == NULL) {
+        return NULL;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_atlas_page_level_data");
+    PR_PACKAGE_COUNT(package, atlas_page_accesses);
+    if (out_info != NULL) {
+        pr_atlas_page_fill_info(&package->atlas_pages[index], view, out_info);
+    }
+    PR_PROFILE_END("pr_package_atlas_page_level_data");
+    return view->data;
+}
+
+const unsigned char *pr_package_atlas_page_indexed(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    const unsigned char **out_palette,
+    unsigned int *out_palette_count,
+    pr_atlas_page_info_t *out_info
+)
+{
+    const pr_atlas_page_view_t *page;
+    const pr_atlas_page_view_t *view;
+
+    view = pr_atlas_page_level(package, index, level);
+    if (view == NULL || view->format != PR_PAGE_FORMAT_INDEXED8) {
+        return NULL;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_atlas_page_indexed");
+    PR_PACKAGE_COUNT(package, atlas_page_accesses);
+    page = &package->atlas_pages[index];
+    if (out_palette != NULL) {
+        *out_palette = page->palette;
+    }
+    if (out_palette_count != NULL) {
+        *out_palette_count = page->palette_count;
+    }
+    if (out_info != NULL) {
+        pr_atlas_page_fill_info(page, view, out_info);
     }
-    return page->pixels;
+    PR_PROFILE_END("pr_package_atlas_page_indexed");
+    return view->data;
+}
+
+void pr_indexed_expand_rgba(
+    const unsigned char *indices,
+    size_t count,
+    const unsigned char *palette,
+    unsigned int palette_count,
+    unsigned char *dst
+)
+{
+    unsigned char lut[256u * 4u];
+    size_t i;
+
+    if (indices == NULL || dst == NULL || (palette == NULL && palette_count > 0u)) {
+        return;
+    }
+    if (palette_count > 256u) {
+        palette_count = 256u;
+    }
+    memset(lut, 0, sizeof(lut));
+    if (palette_count > 0u) {
+        memcpy(lut, palette, (size_t)palette_count * 4u);
+    }
+    for (i = 0u; i < count; ++i) {
+        memcpy(dst + i * 4u, lut + (size_t)indices[i] * 4u, 4u);
+    }
+}
+
+/* Decodes one tile of a tiled page into `dst`, packed at the tile's own
+ * `row_bytes`. The offset table was checked when the package was opened.
+ */
+static int pr_atlas_page_decode_tile(
+    const pr_atlas_page_view_t *page,
+    uint32_t tile_x,
+    uint32_t tile_y,
+    unsigned char *dst,
+    pr_page_tile_t *out_tile
+)
+{
+    const unsigned char *tile_data;
+    size_t table_bytes;
+    size_t raw_bytes;
+    uint32_t start;
+    uint32_t end;
+    size_t k;
+
+    if (!pr_page_tile_at(page->format, page->width, page->height, page->tile_size, tile_x, tile_y, out_tile)) {
+        return 0;
+    }
+    table_bytes = ((size_t)page->tiles_x * page->tiles_y + 1u) * 4u;
+    k = (size_t)tile_y * page->tiles_x + tile_x;
+    if (
+        !pr_read_u32_le(page->stored, page->stored_bytes, k * 4u, &start) ||
+        !pr_read_u32_le(page->stored, page->stored_bytes, k * 4u + 4u, &end)
+    ) {
+        return 0;
+    }
+
+    tile_data = page->stored + table_bytes + start;
+    raw_bytes = (size_t)out_tile->rows * out_tile->row_bytes;
+    if ((size_t)(end - start) == raw_bytes) {
+        memcpy(dst, tile_data, raw_bytes);
+        return 1;
+    }
+    return pr_lz_decompress(tile_data, (size_t)(end - start), dst, raw_bytes);
+}
+
+static pr_status_t pr_atlas_page_decode(const pr_atlas_page_view_t *page, unsigned char *dst)
+{
+    unsigned char *scratch;
+    uint32_t tile_x;
+    uint32_t tile_y;
+
+    if (page->tile_size != 0u) {
+        scratch = (unsigned char *)malloc((size_t)page->tile_size * page->tile_size * 4u);
+        if (scratch == NULL) {
+            return PR_STATUS_ALLOCATION_FAILED;
+        }
+        for (tile_y = 0u; tile_y < page->tiles_y; ++tile_y) {
+            for (tile_x = 0u; tile_x < page->tiles_x; ++tile_x) {
+                pr_page_tile_t tile;
+                uint32_t row;
+
+                if (!pr_atlas_page_decode_tile(page, tile_x, tile_y, scratch, &tile)) {
+                    free(scratch);
+                    return PR_STATUS_PARSE_ERROR;
+                }
+                for (row = 0u; row < tile.rows; ++row) {
+                    memcpy(
+                        dst + (size_t)(tile.row + row) * page->row_bytes + tile.offset,
+                        scratch + (size_t)row * tile.row_bytes,
+                        tile.row_bytes
+                    );
+                }
+            }
+        }
+        free(scratch);
+        return PR_STATUS_OK;
+    }
+    if (page->compression == PR_PAGE_COMPRESSION_LZ) {
+        return pr_lz_decompress(page->stored, page->stored_bytes, dst, page->data_bytes) ?
+            PR_STATUS_OK : PR_STATUS_PARSE_ERROR;
+    }
+    if (page->data_bytes > 0u) {
+        memcpy(dst, page->stored, page->data_bytes);
+    }
+    return PR_STATUS_OK;
+}
+
+/* Runs over every page, then every mip level after the first. */
+typedef struct pr_page_decompress_batch {
+    pr_package_t *package;
+    pr_status_t *statuses;
+} pr_page_decompress_batch_t;
+
+static pr_atlas_page_view_t *pr_atlas_view_at(pr_package_t *package, size_t index)
+{
+    if (index < package->atlas_page_count) {
+        return &package->atlas_pages[index];
+    }
+    return &package->atlas_mips[index - package->atlas_page_count];
+}
+
+static void pr_page_decompress_batch_run(void *user_data, size_t index)
+{
+    pr_page_decompress_batch_t *batch;
+    pr_atlas_page_view_t *page;
+
+    batch = (pr_page_decompress_batch_t *)user_data;
+    page = pr_atlas_view_at(batch->package, index);
+    if (page->decoded == NULL || page->data != NULL) {
+        return;
+    }
+    batch->statuses[index] = pr_atlas_page_decode(page, page->decoded);
+}
+
+pr_status_t pr_package_decompress_pages(pr_package_t *package)
+{
+    pr_page_decompress_batch_t batch;
+    pr_status_t status;
+    size_t view_count;
+    size_t i;
+
+    if (package == NULL) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    if (package->atlas_pages == NULL || package->atlas_page_count == 0u) {
+        return PR_STATUS_OK;
+    }
+
+    view_count = (size_t)package->atlas_page_count + package->atlas_mip_count;
+    batch.package = package;
+    batch.statuses = (pr_status_t *)calloc(view_count, sizeof(batch.statuses[0]));
+    if (batch.statuses == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    /* Buffers are allocated up front so the workers only decode. */
+    status = PR_STATUS_OK;
+    for (i = 0u; i < view_count; ++i) {
+        pr_atlas_page_view_t *page;
+
+        page = pr_atlas_view_at(package, i);
+        if (page->data != NULL || page->data_bytes == 0u || page->decoded != NULL) {
+            continue;
+        }
+        page->decoded = (unsigned char *)malloc(page->data_bytes);
+        if (page->decoded == NULL) {
+            status = PR_STATUS_ALLOCATION_FAILED;
+            break;
+        }
+    }
+
+    if (status == PR_STATUS_OK) {
+        PR_PROFILE_BEGIN("pr_package_decompress_pages");
+        pr_parallel_for(view_count, pr_page_decompress_batch_run, &batch);
+        PR_PROFILE_END("pr_package_decompress_pages");
+    }
+
+    for (i = 0u; i < view_count; ++i) {
+        pr_atlas_page_view_t *page;
+
+        page = pr_atlas_view_at(package, i);
+        if (page->decoded == NULL || page->data != NULL) {
+            continue;
+        }
+        if (status != PR_STATUS_OK || batch.statuses[i] != PR_STATUS_OK) {
+            if (status == PR_STATUS_OK) {
+                status = batch.statuses[i];
+            }
+            free(page->decoded);
+            page->decoded = NULL;
+            continue;
+        }
+        page->data = page->decoded;
+    }
+
+    free(batch.statuses);
+    return status;
+}
+
+pr_status_t pr_package_read_page_data(
+    const pr_package_t *package,
+    unsigned int index,
+    void *dst,
+    size_t dst_size
+)
+{
+    return pr_package_read_page_level_data(package, index, 0u, dst, dst_size);
+}
+
+pr_status_t pr_package_read_page_level_data(
+    const pr_package_t *package,
+    unsigned int index,
+    unsigned int level,
+    void *dst,
+    size_t dst_size
+)
+{
+    const pr_atlas_page_view_t *page;
+    pr_status_t status;
+
+    page = pr_atlas_page_level(package, index, level);
+    if (page == NULL || dst == NULL || dst_size < (size_t)page->data_bytes) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_read_page_data");
+    if (page->data != NULL) {
+        memcpy(dst, page->data, page->data_bytes);
+        status = PR_STATUS_OK;
+    } else {
+        status = pr_atlas_page_decode(page, (unsigned char *)dst);
+    }
+    PR_PROFILE_END("pr_package_read_page_data");
+    return status;
+}
+
+/* One layer per page, each written to its own slice of `dst`. */
+typedef struct pr_atlas_array_batch {
+    const pr_package_t *package;
+    unsigned int level;
+    unsigned char *dst;
+    size_t layer_bytes;
+    pr_status_t *statuses;
+} pr_atlas_array_batch_t;
+
+static void pr_atlas_array_batch_run(void *user_data, size_t index)
+{
+    pr_atlas_array_batch_t *batch;
+    const pr_atlas_page_view_t *page;
+
+    batch = (pr_atlas_array_batch_t *)user_data;
+    page = pr_atlas_page_level(batch->package, (unsigned int)index, batch->level);
+    if (page->data != NULL) {
+        memcpy(batch->dst + index * batch->layer_bytes, page->data, batch->layer_bytes);
+        batch->statuses[index] = PR_STATUS_OK;
+    } else {
+        batch->statuses[index] = pr_atlas_page_decode(page, batch->dst + index * batch->layer_bytes);
+    }
+}
+
+pr_status_t pr_package_read_atlas_array(
+    const pr_package_t *package,
+    unsigned int level,
+    void *dst,
+    size_t dst_size
+)
+{
+    pr_atlas_array_batch_t batch;
+    const pr_atlas_page_view_t *first;
+    pr_status_t status;
+    size_t i;
+
+    if (package == NULL || dst == NULL || package->atlas_layout != PR_ATLAS_LAYOUT_ARRAY) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    if (package->atlas_page_count == 0u) {
+        return PR_STATUS_OK;
+    }
+    first = pr_atlas_page_level(package, 0u, level);
+    if (first == NULL || dst_size / package->atlas_page_count < (size_t)first->data_bytes) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    batch.package = package;
+    batch.level = level;
+    batch.dst = (unsigned char *)dst;
+    batch.layer_bytes = (size_t)first->data_bytes;
+    batch.statuses = (pr_status_t *)calloc(package->atlas_page_count, sizeof(batch.statuses[0]));
+    if (batch.statuses == NULL) {
+        return PR_STATUS_ALLOCATION_FAILED;
+    }
+
+    PR_PROFILE_BEGIN("pr_package_read_atlas_array");
+    pr_parallel_for(package->atlas_page_count, pr_atlas_array_batch_run, &batch);
+    PR_PROFILE_END("pr_package_read_atlas_array");
+    status = PR_STATUS_OK;
+    for (i = 0u; i < package->atlas_page_count; ++i) {
+        if (batch.statuses[i] != PR_STATUS_OK) {
+            status = batch.statuses[i];
+            break;
+        }
+    }
+    free(batch.statuses);
+    return status;
+}
+
+pr_status_t pr_package_read_frame_pixels(
+    const pr_package_t *package,
+    const pr_sprite_frame_t *frame,
+    void *dst,
+    size_t dst_stride
+)
+{
+    const pr_atlas_page_view_t *page;
+    const unsigned char *source;
+    unsigned char *decoded;
+    unsigned char *out;
+    pr_status_t status;
+    uint32_t pixel_bytes;
+    uint32_t row;
+
+    if (package == NULL || frame == NULL || dst == NULL || package->atlas_pages == NULL) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    if (frame->atlas_page >= package->atlas_page_count) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    page = &package->atlas_pages[frame->atlas_page];
+    pixel_bytes = pr_page_format_pixel_bytes(page->format);
+    if (
+        pixel_bytes == 0u ||
+        page->data_bytes == 0u ||
+        frame->x > page->width ||
+        frame->w > page->width - frame->x ||
+        frame->y > page->height ||
+        frame->h > page->height - frame->y ||
+        dst_stride < (size_t)frame->w * pixel_bytes
+    ) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    out = (unsigned char *)dst;
+    PR_PROFILE_BEGIN("pr_package_read_frame_pixels");
+    status = PR_STATUS_OK;
+    if (page->data != NULL || page->tile_size == 0u) {
+        /* Compressed pages without tiles have to be decoded whole. */
+        decoded = NULL;
+        source = page->data;
+        if (source == NULL) {
+            decoded = (unsigned char *)malloc(page->data_bytes);
+            status = (decoded != NULL) ?
+                pr_atlas_page_decode(page, decoded) : PR_STATUS_ALLOCATION_FAILED;
+            source = decoded;
+        }
+        for (row = 0u; status == PR_STATUS_OK && row < frame->h; ++row) {
+            memcpy(
+                out + (size_t)row * dst_stride,
+                source + (size_t)(frame->y + row) * page->row_bytes + (size_t)frame->x * pixel_bytes,
+                (size_t)frame->w * pixel_bytes
+            );
+        }
+        free(decoded);
+    } else if (frame->w > 0u && frame->h > 0u) {
+        uint32_t tile_x;
+        uint32_t tile_y;
+
+        decoded = (unsigned char *)malloc((size_t)page->tile_size * page->tile_size * pixel_bytes);
+        if (decoded == NULL) {
+            status = PR_STATUS_ALLOCATION_FAILED;
+        }
+        for (
+            tile_y = frame->y / page->tile_size;
+            status == PR_STATUS_OK && tile_y <= (frame->y + frame->h - 1u) / page->tile_size;
+            ++tile_y
+        ) {
+            for (
+                tile_x = frame->x / page->tile_size;
+                status == PR_STATUS_OK && tile_x <= (frame->x + frame->w - 1u) / page->tile_size;
+                ++tile_x
+            ) {
+                pr_page_tile_t tile;
+                uint32_t first_x;
+                uint32_t first_y;
+                uint32_t last_x;
+                uint32_t last_y;
+
+                if (!pr_atlas_page_decode_tile(page, tile_x, tile_y, decoded, &tile)) {
+                    status = PR_STATUS_PARSE_ERROR;
+                    break;
+                }
+                /* Overlap of the frame and the tile, in page pixels. */
+                first_x = (frame->x > tile_x * page->tile_size) ? frame->x : tile_x * page->tile_size;
+                first_y = (frame->y > tile.row) ? frame->y : tile.row;
+                last_x = tile_x * page->tile_size + tile.row_bytes / pixel_bytes;
+                last_x = (frame->x + frame->w < last_x) ? frame->x + frame->w : last_x;
+                last_y = tile.row + tile.rows;
+                last_y = (frame->y + frame->h < last_y) ? frame->y + frame->h : last_y;
+                for (row = first_y; row < last_y; ++row) {
+                    memcpy(
+                        out + (size_t)(row - frame->y) * dst_stride +
+                            (size_t)(first_x - frame->x) * pixel_bytes,
+                        decoded + (size_t)(row - tile.row) * tile.row_bytes +
+                            (size_t)(first_x - tile_x * page->tile_size) * pixel_bytes,
+                        (size_t)(last_x - first_x) * pixel_bytes
+                    );
+                }
+            }
+        }
+        free(decoded);
+    }
+    PR_PROFILE_END("pr_package_read_frame_pixels");
+    return status;
 }
 
 unsigned int pr_package_sprite_count(const pr_package_t *package)
@@ -1274,3 +2348,230 @@ const pr_animation_t *pr_package_animation_at(
     }
     return &package->animations[index];
 }
+
+static int pr_offset_list_push(size_t **offsets, size_t *count, size_t *capacity, size_t value)
+{
+    if (*count == *capacity) {
+        size_t grown_capacity;
+        size_t *grown;
+
+        grown_capacity = (*capacity > 0u) ? *capacity * 2u : 64u;
+        grown = (size_t *)realloc(*offsets, grown_capacity * sizeof(grown[0]));
+        if (grown == NULL) {
+            return 0;
+        }
+        *offsets = grown;
+        *capacity = grown_capacity;
+    }
+    (*offsets)[(*count)++] = value;
+    return 1;
+}
+
+static int pr_offset_compare(const void *lhs, const void *rhs)
+{
+    size_t a;
+    size_t b;
+
+    a = *(const size_t *)lhs;
+    b = *(const size_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+/* Offsets inside one stored page level: its ends, each tile of a tiled
+ * level, each band of rows of an uncompressed one.
+ */
+static int pr_level_part_offsets(
+    const pr_package_t *package,
+    const pr_atlas_page_view_t *level,
+    size_t **offsets,
+    size_t *count,
+    size_t *capacity
+)
+{
+    size_t start;
+    size_t k;
+
+    if (level->stored == NULL || level->stored_bytes == 0u) {
+        return 1;
+    }
+    start = (size_t)(level->stored - package->bytes);
+    if (
+        !pr_offset_list_push(offsets, count, capacity, start) ||
+        !pr_offset_list_push(offsets, count, capacity, start + level->stored_bytes)
+    ) {
+        return 0;
+    }
+
+    if (level->tile_size != 0u) {
+        size_t tile_count;
+        size_t table_bytes;
+
+        tile_count = (size_t)level->tiles_x * level->tiles_y;
+        table_bytes = (tile_count + 1u) * 4u;
+        for (k = 0u; k <= tile_count; ++k) {
+            uint32_t tile_offset;
+
+            /* The tile table was bounds-checked when the package was opened. */
+            tile_offset = 0u;
+            (void)pr_read_u32_le(level->stored, level->stored_bytes, k * 4u, &tile_offset);
+            if (!pr_offset_list_push(offsets, count, capacity, start + table_bytes + tile_offset)) {
+                return 0;
+            }
+        }
+    } else if (level->compression == PR_PAGE_COMPRESSION_NONE && level->row_bytes > 0u) {
+        size_t band_bytes;
+
+        band_bytes = (size_t)level->row_bytes *
+            ((level->row_bytes < PR_PATCH_BAND_BYTES) ? PR_PATCH_BAND_BYTES / level->row_bytes : 1u);
+        for (k = band_bytes; k < level->stored_bytes; k += band_bytes) {
+            if (!pr_offset_list_push(offsets, count, capacity, start + k)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+pr_status_t pr_package_part_offsets(
+    const pr_package_t *package,
+    size_t **out_offsets,
+    size_t *out_count
+)
+{
+    pr_chunk_entry_t *chunks;
+    uint32_t chunk_count;
+    size_t *offsets;
+    size_t count;
+    size_t capacity;
+    size_t unique_count;
+    size_t i;
+    unsigned int page_index;
+    unsigned int level_index;
+    pr_status_t status;
+
+    if (package == NULL || out_offsets == NULL || out_count == NULL) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+    *out_offsets = NULL;
+    *out_count = 0u;
+
+    status = pr_parse_chunk_table(package->bytes, package->size, &chunks, &chunk_count);
+    if (status != PR_STATUS_OK) {
+        return status;
+    }
+
+    offsets = NULL;
+    count = 0u;
+    capacity = 0u;
+    if (
+        !pr_offset_list_push(&offsets, &count, &capacity, 0u) ||
+        !pr_offset_list_push(&offsets, &count, &capacity, package->size)
+    ) {
+        goto fail;
+    }
+    for (i = 0u; i < chunk_count; ++i) {
+        if (
+            !pr_offset_list_push(&offsets, &count, &capacity, chunks[i].offset) ||
+            !pr_offset_list_push(&offsets, &count, &capacity, chunks[i].offset + chunks[i].size)
+        ) {
+            goto fail;
+        }
+    }
+    for (page_index = 0u; page_index < package->atlas_page_count; ++page_index) {
+        for (level_index = 0u; level_index < package->atlas_pages[page_index].level_count; ++level_index) {
+            if (!pr_level_part_offsets(
+                    package,
+                    pr_atlas_page_level(package, page_index, level_index),
+                    &offsets,
+                    &count,
+                    &capacity
+                )) {
+                goto fail;
+            }
+        }
+    }
+    free(chunks);
+
+    qsort(offsets, count, sizeof(offsets[0]), pr_offset_compare);
+    unique_count = 1u;
+    for (i = 1u; i < count; ++i) {
+        if (offsets[i] != offsets[unique_count - 1u]) {
+            offsets[unique_count++] = offsets[i];
+        }
+    }
+
+    *out_offsets = offsets;
+    *out_count = unique_count;
+    return PR_STATUS_OK;
+
+fail:
+    free(chunks);
+    free(offsets);
+    return PR_STATUS_ALLOCATION_FAILED;
+}
+
+pr_status_t pr_package_get_stats(
+    const pr_package_t *package,
+    pr_package_stats_t *out_stats
+)
+{
+    unsigned int i;
+
+    if (package == NULL || out_stats == NULL) {
+        return PR_STATUS_INVALID_ARGUMENT;
+    }
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    out_stats->file_bytes = (unsigned long long)package->size;
+    out_stats->metadata_bytes = (unsigned long long)(
+        sizeof(*package) +
+        (size_t)package->string_count * sizeof(package->strings[0]) +
+        (size_t)package->atlas_page_count * sizeof(package->atlas_pages[0]) +
+        (size_t)package->atlas_mip_count * sizeof(package->atlas_mips[0]) +
+        (size_t)package->sprite_count * sizeof(package->sprites[0]) +
+        (size_t)package->sprite_frame_count * sizeof(package->sprite_frames[0]) +
+        (size_t)package->animation_count * sizeof(package->animations[0]) +
+        (size_t)package->animation_frame_count * sizeof(package->animation_frames[0])
+    );
+    for (i = 0u; package->atlas_pages != NULL && i < package->atlas_page_count + package->atlas_mip_count; ++i) {
+        const pr_atlas_page_view_t *view;
+
+        view = (i < package->atlas_page_count) ?
+            &package->atlas_pages[i] : &package->atlas_mips[i - package->atlas_page_count];
+        out_stats->pixel_bytes += (unsigned long long)view->stored_bytes;
+        if (view->decoded != NULL) {
+            out_stats->decompressed_bytes += (unsigned long long)view->data_bytes;
+        }
+    }
+    out_stats->total_bytes = out_stats->file_bytes +
+        out_stats->metadata_bytes +
+        out_stats->decompressed_bytes;
+
+    out_stats->read_ms = package->read_ms;
+    out_stats->parse_ms = package->parse_ms;
+    out_stats->open_ms = package->read_ms + package->parse_ms;
+    out_stats->chunk_count = package->chunk_stats_count;
+    memcpy(out_stats->chunks, package->chunk_stats, sizeof(package->chunk_stats));
+
+#ifdef PACKRAT_RUNTIME_COUNTERS
+    out_stats->counters_enabled = 1;
+    out_stats->sprite_lookups = package->counters.sprite_lookups;
+    out_stats->sprite_misses = package->counters.sprite_misses;
+    out_stats->sprite_hits = package->counters.sprite_lookups - package->counters.sprite_misses;
+    out_stats->animation_lookups = package->counters.animation_lookups;
+    out_stats->animation_misses = package->counters.animation_misses;
+    out_stats->animation_hits = package->counters.animation_lookups - package->counters.animation_misses;
+    out_stats->atlas_page_accesses = package->counters.atlas_page_accesses;
+#endif
+    return PR_STATUS_OK;
+}
+
+void pr_package_reset_counters(pr_package_t *package)
+{
+    if (package == NULL) {
+        return;
+    }
+#ifdef PACKRAT_RUNTIME_COUNTERS
+    memset(&package->counters, 0, sizeof(package->counters));
+#endif
+}
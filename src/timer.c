@@ -0,0 +1,13 @@
+#include "timer.h"
+
+#include <time.h>
+
+double pr_timer_now_ms(void)
+{
+    struct timespec ts;
+
+    if (timespec_get(&ts, TIME_UTC) != TIME_UTC) {
+        return 0.0;
+    }
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
@@ -0,0 +1,9 @@
+#ifndef PACKRAT_TIMER_H
+#define PACKRAT_TIMER_H
+
+/* Wall-clock milliseconds for stage and open timing. Only differences
+ * between two readings are meaningful.
+ */
+double pr_timer_now_ms(void);
+
+#endif